@@ -485,9 +485,15 @@ inolog("num_params=%d,%d\n", stmt->num_params, stmt->proc_return);
 	else
 	{
 		po_ind_t multi = FALSE, proc_return = 0;
+		const QueryTokens	*qt;
 
 		stmt->proc_return = 0;
-		SC_scanQueryAndCountParams(stmt->statement, SC_get_conn(stmt), NULL, pcpar, &multi, &proc_return);
+		if (qt = SC_get_tokens(stmt), NULL == qt)
+		{
+			SC_set_error(stmt, STMT_NO_MEMORY_ERROR, "Couldn't scan the statement", func);
+			return SQL_ERROR;
+		}
+		QT_scanQueryAndCountParams(qt, 0, NULL, pcpar, &multi, &proc_return);
 		stmt->num_params = *pcpar;
 		stmt->proc_return = proc_return;
 		stmt->multi_statement = multi;
@@ -881,6 +887,7 @@ inolog("GDATA_unbind_cols freeall=%d allocated=%d gdata=%p", freeall, self->allo
 void GetDataInfoInitialize(GetDataInfo *gdata_info)
 {
 	gdata_info->fdata.data_left = -1;
+	gdata_info->fdata.src_pos = 0;
 	gdata_info->fdata.ttlbuf = NULL;
 	gdata_info->fdata.ttlbuflen = gdata_info->fdata.ttlbufused = 0;
 	gdata_info->allocated = 0;
@@ -899,6 +906,7 @@ create_empty_gdata(int num_columns)
 	for (i = 0; i < num_columns; i++)
 	{
 		new_gdata[i].data_left = -1;
+		new_gdata[i].src_pos = 0;
 		new_gdata[i].ttlbuf = NULL;
 		new_gdata[i].ttlbuflen = 0;
 		new_gdata[i].ttlbufused = 0;
@@ -37,6 +37,8 @@ typedef struct
 	SQLLEN	ttlbufused;		/* used length of the buffer */
 	SQLLEN	data_left;		/* amount of data left to read
 					 * (SQLGetData) */
+	SQLLEN	src_pos;		/* position in the field value of the
+					 * data left (bytea SQLGetData) */
 }	GetDataClass;
 
 /*
@@ -29,6 +29,9 @@
 #else
 #include <errno.h>
 #endif /* WIN32 */
+#ifdef	WIN_MULTITHREAD_SUPPORT
+#include <process.h>
+#endif /* WIN_MULTITHREAD_SUPPORT */
 #ifdef	USE_KRB5
 #include "krb5svcs.h"
 #endif /* USE_KRB5 */
@@ -58,6 +61,7 @@ static void CC_lookup_pg_version(ConnectionClass *self);
 static void CC_lookup_lo(ConnectionClass *self);
 static char *CC_create_errormsg(ConnectionClass *self);
 static int  CC_close_eof_cursors(ConnectionClass *self);
+static void CC_release_replica(ConnectionClass *self);
 
 extern GLOBAL_VALUES globals;
 
@@ -483,6 +487,10 @@ char
 CC_begin(ConnectionClass *self)
 {
 	char	ret = TRUE;
+
+	/* the rest of the batch may change the transaction status */
+	if (NULL != self->stmt_in_lazyquery)
+		CC_finish_lazy_query(self, FALSE);
 	if (!CC_is_in_trans(self))
 	{
 		QResultClass *res = CC_send_query(self, bgncmd, NULL, 0, NULL);
@@ -503,6 +511,10 @@ char
 CC_commit(ConnectionClass *self)
 {
 	char	ret = TRUE;
+
+	/* the rest of the batch may change the transaction status */
+	if (NULL != self->stmt_in_lazyquery)
+		CC_finish_lazy_query(self, FALSE);
 	if (CC_is_in_trans(self))
 	{
 		if (!CC_is_in_error_trans(self))
@@ -527,6 +539,10 @@ char
 CC_abort(ConnectionClass *self)
 {
 	char	ret = TRUE;
+
+	/* the rest of the batch may change the transaction status */
+	if (NULL != self->stmt_in_lazyquery)
+		CC_finish_lazy_query(self, FALSE);
 	if (CC_is_in_trans(self))
 	{
 		QResultClass *res = CC_send_query(self, rbkcmd, NULL, 0, NULL);
@@ -549,6 +565,9 @@ CC_set_autocommit(ConnectionClass *self, BOOL on)
 	    (!on && !currsts))
 		return on;
 	mylog("%s: %d->%d\n", func, currsts, on);
+	/* the rest of the batch may change the transaction status */
+	if (NULL != self->stmt_in_lazyquery)
+		CC_finish_lazy_query(self, FALSE);
 	if (CC_is_in_trans(self))
 		CC_commit(self);
 	if (on)
@@ -592,6 +611,45 @@ CC_clear_col_info(ConnectionClass *self, BOOL destroy)
 	}
 }
 
+/* Forget the prepared catalog queries, see info.c */
+void
+CC_clear_catalog_plans(ConnectionClass *self)
+{
+	int	i;
+
+	CONNLOCK_ACQUIRE(self);
+	for (i = 0; i < self->num_catalog_plans; i++)
+		free(self->catalog_plans[i].shape);
+	self->num_catalog_plans = 0;
+	if (self->catalog_plans)
+	{
+		free(self->catalog_plans);
+		self->catalog_plans = NULL;
+	}
+	CONNLOCK_RELEASE(self);
+}
+
+/* Drop the cached catalog results, see info.c */
+void
+CC_clear_catalog_cache(ConnectionClass *self)
+{
+	int	i;
+
+	CONNLOCK_ACQUIRE(self);
+	for (i = 0; i < self->num_catalog_cache; i++)
+	{
+		free(self->catalog_cache[i].key);
+		QR_Destructor(self->catalog_cache[i].res);
+	}
+	self->num_catalog_cache = 0;
+	if (self->catalog_cache)
+	{
+		free(self->catalog_cache);
+		self->catalog_cache = NULL;
+	}
+	CONNLOCK_RELEASE(self);
+}
+
 /* This is called by SQLDisconnect also */
 char
 CC_cleanup(ConnectionClass *self)
@@ -618,6 +676,7 @@ CC_cleanup(ConnectionClass *self)
 		SOCK_Destructor(self->sock);
 		self->sock = NULL;
 	}
+	CC_release_replica(self);
 
 	mylog("after SOCK destructor\n");
 
@@ -661,6 +720,7 @@ CC_cleanup(ConnectionClass *self)
 	self->status = CONN_NOT_CONNECTED;
 	self->transact_status = CONN_IN_AUTOCOMMIT;
 	self->stmt_in_extquery = NULL;
+	self->stmt_in_lazyquery = NULL;
 	CC_conninfo_init(&(self->connInfo));
 	if (self->original_client_encoding)
 	{
@@ -680,6 +740,8 @@ CC_cleanup(ConnectionClass *self)
 	reset_current_schema(self);
 	/* Free cached table info */
 	CC_clear_col_info(self, TRUE);
+	CC_clear_catalog_plans(self);
+	CC_clear_catalog_cache(self);
 	if (self->num_discardp > 0 && self->discardp)
 	{
 		for (i = 0; i < self->num_discardp; i++)
@@ -811,10 +873,28 @@ EatReadyForQuery(ConnectionClass *conn)
 				break;	
 		}
 		conn->stmt_in_extquery = NULL;
+		conn->stmt_in_lazyquery = NULL;
+		conn->num_queued_cmds = 0;
+		SOCK_shrink_buffer(conn->sock);
 	}
 	return id;	
 }
 
+/*
+ *	The buffer size requested by SQL_ATTR_PACKET_SIZE takes precedence
+ *	over the DSN setting.
+ */
+static void
+CC_set_sock_buffer_size(ConnectionClass *self, SocketClass *sock)
+{
+	ConnInfo	*ci = &(self->connInfo);
+	int		size = ci->drivers.socket_buffersize;
+
+	if (self->packet_size > 0)
+		size = (int) self->packet_size;
+	SOCK_set_buffer_size(sock, size, ci->drivers.socket_buffermax, ci->drivers.kernel_buffersize);
+}
+
 int
 handle_error_message(ConnectionClass *self, char *msgbuf, size_t buflen, char *sqlstate, const char *comment, QResultClass *res)
 {
@@ -1059,9 +1139,9 @@ static int	protocol3_opts_array(ConnectionClass *self, const char *opts[], const
 	int	cnt;
 
 	cnt = 0;
-	if (libpqopt && ci->server[0])
+	if (libpqopt && CC_get_server_list(self)[0])
 	{
-		opts[cnt] = "host";		vals[cnt++] = ci->server;
+		opts[cnt] = "host";		vals[cnt++] = CC_get_server_list(self);
 	}
 	if (libpqopt && ci->port[0])
 	{
@@ -1311,9 +1391,12 @@ static char CC_initial_log(ConnectionClass *self, const char *func)
 		);
 	qlog(vermsg);
 	mylog(vermsg);
-	qlog("Global Options: fetch=%d, socket=%d, unknown_sizes=%d, max_varchar_size=%d, max_longvarchar_size=%d\n",
+	qlog("Global Options: fetch=%d, socket=%d, max_socket=%d, kernel_socket=%d, driver_ssl=%d, unknown_sizes=%d, max_varchar_size=%d, max_longvarchar_size=%d\n",
 		 ci->drivers.fetch_max,
 		 ci->drivers.socket_buffersize,
+		 ci->drivers.socket_buffermax,
+		 ci->drivers.kernel_buffersize,
+		 ci->drivers.driver_ssl,
 		 ci->drivers.unknown_sizes,
 		 ci->drivers.max_varchar_size,
 		 ci->drivers.max_longvarchar_size);
@@ -1402,11 +1485,13 @@ LIBPQ_CC_connect(ConnectionClass *self, char password_req, char *salt_para)
 /*
  *	Callee should free hte returned pointer.
  */
-static char *MakePrincHint(ConnInfo *ci, BOOL sspi)
+static char *MakePrincHint(ConnectionClass *self, BOOL sspi)
 {
+	ConnInfo	*ci = &(self->connInfo);
 	size_t len;
 	char	*svcprinc;
 	char	*svcname;
+	const char	*server = ci->server;
 	BOOL	attrFound = FALSE;
 
 	svcname = extract_extra_attribute_setting(ci->conn_settings, "krbsrvname");
@@ -1416,13 +1501,16 @@ mylog("!!! %s settings=%s svcname=%p\n", __FUNCTION__, ci->conn_settings, svcnam
 		attrFound = TRUE;
 	else if (svcname = getenv("PGKRBSRVNAME"), NULL == svcname)
 		svcname = "postgres";
-	len = strlen(svcname) + 1 + strlen(ci->server) + 1;
+	/* the host connected to out of the Servername list */
+	if (self->sock && self->sock->hostname)
+		server = self->sock->hostname;
+	len = strlen(svcname) + 1 + strlen(server) + 1;
 	if (NULL != (svcprinc = malloc(len)))
 	{
 		if (sspi)
-			snprintf(svcprinc, len, "%s/%s", svcname, ci->server);
+			snprintf(svcprinc, len, "%s/%s", svcname, server);
 		else
-			snprintf(svcprinc, len, "%s@%s", svcname, ci->server);
+			snprintf(svcprinc, len, "%s@%s", svcname, server);
 	}
 	if (attrFound)
 		free(svcname);
@@ -1444,10 +1532,11 @@ original_CC_connect(ConnectionClass *self, char password_req, char *salt_para)
 	char		salt[5], notice[512];
 	CSTR		func = "original_CC_connect";
 	BOOL	startPacketReceived = FALSE, anotherVersionRetry;
-#ifdef	USE_SSPI
-	int	ssl_try_count, ssl_try_no;
-	char	ssl_call[2];
-#endif /* USE_SSPI */
+#if defined(USE_SSPI) || defined(USE_SSL)
+	/* set below unless reauthenticating, which may retry all the same */
+	int	ssl_try_count = 0, ssl_try_no = 0;
+	char	ssl_call[2] = {'n', 'n'};
+#endif /* USE_SSPI || USE_SSL */
 
 	mylog("%s: entering...\n", func);
 
@@ -1465,7 +1554,7 @@ original_CC_connect(ConnectionClass *self, char password_req, char *salt_para)
 		if (0 == CC_initial_log(self, func))
 			goto error_proc;
 
-#ifdef	USE_SSPI
+#if defined(USE_SSPI) || defined(USE_SSL)
 		ssl_try_count = 0;
 		switch (self->connInfo.sslmode[0])
 		{
@@ -1486,14 +1575,14 @@ original_CC_connect(ConnectionClass *self, char password_req, char *salt_para)
 				break;
 		}
 		ssl_try_no = 0;
-#endif /* USE_SSPI */
+#endif /* USE_SSPI || USE_SSL */
 		anotherVersionRetry = FALSE;
 
 another_version_retry:
 
 		if (anotherVersionRetry)
 		{
-#ifdef	USE_SSPI
+#if defined(USE_SSPI) || defined(USE_SSL)
 			if (PROTOCOL_74(ci) || PROTOCOL_64(ci))
 			{
 				if (ssl_try_no < ssl_try_count)
@@ -1503,7 +1592,7 @@ another_version_retry:
 				ssl_try_no = ssl_try_count;
 			if (ssl_try_no >= ssl_try_count)
 			{
-#endif /* USE_SSPI */
+#endif /* USE_SSPI || USE_SSL */
 				/* retry older version */
 				if (PROTOCOL_62(ci))
 				{
@@ -1516,10 +1605,10 @@ another_version_retry:
 					strncpy_null(ci->protocol, PG63, sizeof(ci->protocol));
 				else 
 					strncpy_null(ci->protocol, PG64, sizeof(ci->protocol));
-#ifdef	USE_SSPI
+#if defined(USE_SSPI) || defined(USE_SSL)
 				ssl_try_no = 0;
 			}
-#endif /* USE_SSPI */
+#endif /* USE_SSPI || USE_SSL */
 			if (self->sock)
 			{
 				SOCK_Destructor(self->sock);
@@ -1544,10 +1633,11 @@ another_version_retry:
 		}
 
 		sock = self->sock;
+		CC_set_sock_buffer_size(self, sock);
 
 		mylog("connecting to the server socket...\n");
 
-		SOCK_connect_to(sock, (short) atoi(ci->port), ci->server, self->login_timeout);
+		SOCK_connect_to(sock, (short) atoi(ci->port), CC_get_server_list(self), self->login_timeout);
 		if (SOCK_get_errcode(sock) != 0)
 		{
 			CC_set_error(self, CONNECTION_SERVER_NOT_REACHED, "Could not connect to the server", func);
@@ -1556,7 +1646,7 @@ another_version_retry:
 		mylog("connection to the server socket succeeded.\n");
 
 inolog("protocol=%s version=%d,%d\n", ci->protocol, self->pg_version_major, self->pg_version_minor);
-#ifdef	USE_SSPI
+#if defined(USE_SSPI) || defined(USE_SSL)
 		if ('y' == ssl_call[ssl_try_no])
 		{
 			struct {
@@ -1581,11 +1671,19 @@ inolog("protocol=%s version=%d,%d\n", ci->protocol, self->pg_version_major, self
 			switch (rnego)
 			{
 				case 'S':
+#ifdef	USE_SSPI
 					if (!StartupSspiService(sock, SchannelService, NULL))
 					{
 						CC_set_error(self, CONN_INVALID_AUTHENTICATION, "Service negotation failed", func);
 						goto error_proc;
 					}
+#else
+					if (!SOCK_start_ssl(sock, ci->sslmode, ci->port, ci->username))
+					{
+						CC_set_error(self, CONNECTION_SERVER_NOT_REACHED, SOCK_get_errmsg(sock), func);
+						goto error_proc;
+					}
+#endif /* USE_SSPI */
 					break;
 				case 'N':
 					ssl_try_no++;
@@ -1602,7 +1700,7 @@ inolog("protocol=%s version=%d,%d\n", ci->protocol, self->pg_version_major, self
 					goto error_proc;
 			}
 		}
-#endif /* USE_SSPI */
+#endif /* USE_SSPI || USE_SSL */
 		if (PROTOCOL_62(ci))
 		{
 			sock->reverse = TRUE;		/* make put_int and get_int work
@@ -1711,11 +1809,14 @@ inolog("Ekita retry=%d\n", retry);
 						const char *emsg = msgbuffer + 8;
 						if (0 == strnicmp(emsg, "unsupported frontend protocol", 29))
 							retry = TRUE;
-#ifdef	USE_SSPI
-						else if ('y' != ssl_call[ssl_try_no] &&
-							 ssl_try_no + 1 < ssl_try_count)
+#if defined(USE_SSPI) || defined(USE_SSL)
+						/*
+						 * e.g. no pg_hba.conf entry for the connection:
+						 * sslmode allow or prefer tries the other way
+						 */
+						else if (ssl_try_no + 1 < ssl_try_count)
 							retry = TRUE;
-#endif /* USE_SSPI */
+#endif /* USE_SSPI || USE_SSL */
 					}
 					else if (strnicmp(msgbuffer, "Unsupported frontend protocol", 29) == 0)
 						retry = TRUE;
@@ -1821,7 +1922,7 @@ inolog("Ekita retry=%d\n", retry);
 							if (!ci->gssauth_use_gssapi)
 							{
 								self->auth_svcs = KerberosService;
-								authRet = StartupSspiService(sock, self->auth_svcs, MakePrincHint(ci, TRUE));
+								authRet = StartupSspiService(sock, self->auth_svcs, MakePrincHint(self, TRUE));
 								if (!authRet)
 								{
 									CC_set_error(self, CONN_INVALID_AUTHENTICATION, "Service negotation failed", func);
@@ -1836,7 +1937,7 @@ inolog("Ekita retry=%d\n", retry);
 #endif /* USE_SSPI */
 							{
                                 				// pglock_thread();
-                                				authRet = pg_GSS_startup(self, MakePrincHint(ci, FALSE));
+                                				authRet = pg_GSS_startup(self, MakePrincHint(self, FALSE));
                                 				// pgunlock_thread();
                                 				if (authRet != 0)
 								{
@@ -1882,7 +1983,7 @@ inolog("Ekita retry=%d\n", retry);
 							mylog("in AUTH_REQ_SSPI\n");
 #if	defined(USE_SSPI)
 							self->auth_svcs = ci->gssauth_use_gssapi ? KerberosService : NegotiateService;
-							if (!StartupSspiService(sock, self->auth_svcs, MakePrincHint(ci, TRUE)))
+							if (!StartupSspiService(sock, self->auth_svcs, MakePrincHint(self, TRUE)))
 							{
 								CC_set_error(self, CONN_INVALID_AUTHENTICATION, "Service negotation failed", func);
 								goto error_proc;
@@ -1953,6 +2054,10 @@ error_proc:
 	}
 
 	CC_clear_error(self);		/* clear any password error */
+#if defined(USE_SSL) && !defined(USE_SSPI)
+	/* The TLS 1.3 session tickets come after the handshake */
+	SOCK_cache_ssl_session(sock);
+#endif /* USE_SSL && !USE_SSPI */
 
 	/*
 	 * send an empty query in order to find out whether the specified
@@ -1988,6 +2093,190 @@ inolog("CC_lookup_pg_version\n");
 	return 1;
 }	
 
+/*
+ *	Read-only load balancing.
+ *
+ *	The ReadOnly connections of a DSN with ReplicaServers are made to
+ *	the replica having the fewest connections of this process.  The
+ *	other replicas and then the primary (Servername) follow in the host
+ *	list given to SOCK_connect_to(), which tries them in turn.  A replica
+ *	which failed to connect, or lost the race to a host after it, goes
+ *	to the end of the replicas for REPLICA_RETRY_INTERVAL seconds.
+ */
+#if defined(WIN_MULTITHREAD_SUPPORT)
+extern  CRITICAL_SECTION        common_cs;
+#elif defined(POSIX_MULTITHREAD_SUPPORT)
+extern  pthread_mutex_t         common_cs;
+#endif /* WIN_MULTITHREAD_SUPPORT */
+#define	REPLICA_RETRY_INTERVAL	30	/* seconds */
+#define	MAX_REPLICAS		64
+
+typedef struct
+{
+	char	host[128];
+	char	port[SMALL_REGISTRY_LEN];
+	int	nconns;
+	time_t	down_until;
+} REPLICA_INFO;
+
+static REPLICA_INFO	replicas[MAX_REPLICAS];	/* protected by COMMON_CS */
+static int	num_replicas = 0;
+
+/* The entry of the replica, added if add is set.  -1 if not found. */
+static int
+replica_lookup(const char *host, size_t hlen, const char *port, BOOL add)
+{
+	int	i;
+
+	if (hlen >= sizeof(replicas[0].host))
+		return -1;
+	for (i = 0; i < num_replicas; i++)
+	{
+		if (strncmp(replicas[i].host, host, hlen) == 0 &&
+		    '\0' == replicas[i].host[hlen] &&
+		    strcmp(replicas[i].port, port) == 0)
+			return i;
+	}
+	if (!add || num_replicas >= MAX_REPLICAS)
+		return -1;
+	memcpy(replicas[i].host, host, hlen);
+	replicas[i].host[hlen] = '\0';
+	strncpy_null(replicas[i].port, port, sizeof(replicas[i].port));
+	replicas[i].nconns = 0;
+	replicas[i].down_until = 0;
+	return num_replicas++;
+}
+
+/* the next host of the comma separated list, *hlen is set to its length */
+static const char *
+next_host(const char *list, const char **host, size_t *hlen)
+{
+	const char	*hend;
+
+	if (NULL == (hend = strchr(list, ',')))
+		hend = list + strlen(list);
+	while (list < hend && isspace((UCHAR) *list))
+		list++;
+	for (*hlen = hend - list; *hlen > 0 && isspace((UCHAR) list[*hlen - 1]); (*hlen)--)
+		;
+	*host = list;
+	return *hend ? hend + 1 : hend;
+}
+
+/*
+ * Set server_list to the hosts a ReadOnly connection should try in
+ * order, or NULL to connect to Servername as usual.
+ */
+static void
+CC_choose_servers(ConnectionClass *self)
+{
+	ConnInfo	*ci = &(self->connInfo);
+	int	order[MAX_REPLICAS], rnd[MAX_REPLICAS];
+	int	i, j, idx, n = 0;
+	const char	*list, *host;
+	size_t	hlen, len;
+	time_t	now = time(NULL);
+
+	if (self->server_list)
+	{
+		free(self->server_list);
+		self->server_list = NULL;
+	}
+	if (!CC_is_onlyread(self) || '\0' == ci->replica_servers[0])
+		return;
+	ENTER_COMMON_CS;
+	for (list = ci->replica_servers; *list;)
+	{
+		list = next_host(list, &host, &hlen);
+		if (0 == hlen ||
+		    (idx = replica_lookup(host, hlen, ci->port, TRUE)) < 0)
+			continue;
+		for (i = 0; i < n && order[i] != idx; i++)
+			;
+		if (i < n)
+			continue;
+		/* insertion sort, healthy first, then the fewest connections */
+		rnd[idx] = rand();
+		for (i = n; i > 0; i--)
+		{
+			REPLICA_INFO	*a = replicas + order[i - 1], *b = replicas + idx;
+			BOOL	adown = a->down_until > now, bdown = b->down_until > now;
+
+			if (adown != bdown ? !adown :
+			    (a->nconns != b->nconns ? a->nconns < b->nconns : rnd[order[i - 1]] <= rnd[idx]))
+				break;
+			order[i] = order[i - 1];
+		}
+		order[i] = idx;
+		n++;
+	}
+	for (i = 0, len = strlen(ci->server) + 1; i < n; i++)
+		len += strlen(replicas[order[i]].host) + 1;
+	if (n > 0 && NULL != (self->server_list = malloc(len)))
+	{
+		for (i = 0, j = 0; i < n; i++)
+			j += sprintf(self->server_list + j, "%s,", replicas[order[i]].host);
+		strcpy(self->server_list + j, ci->server);
+	}
+	LEAVE_COMMON_CS;
+	mylog("%s: server list=%s\n", __FUNCTION__, self->server_list ? self->server_list : "(null)");
+}
+
+/*
+ * Count the connection to the replica, and mark the replicas tried in
+ * vain as down.
+ */
+static void
+CC_account_replicas(ConnectionClass *self, BOOL connected)
+{
+	ConnInfo	*ci = &(self->connInfo);
+	const char	*list, *host, *winner = NULL;
+	size_t	hlen;
+	int	idx;
+	time_t	now = time(NULL);
+
+	if (!self->server_list)
+		return;
+	if (connected && self->sock)
+		winner = self->sock->hostname;
+	ENTER_COMMON_CS;
+	for (list = self->server_list; *list;)
+	{
+		list = next_host(list, &host, &hlen);
+		if (winner && strncmp(host, winner, hlen) == 0 && '\0' == winner[hlen])
+		{
+			if ((idx = replica_lookup(host, hlen, ci->port, FALSE)) >= 0)
+			{
+				replicas[idx].nconns++;
+				replicas[idx].down_until = 0;
+				self->replica_no = idx + 1;
+			}
+			break;
+		}
+		if ((idx = replica_lookup(host, hlen, ci->port, FALSE)) >= 0)
+			replicas[idx].down_until = now + REPLICA_RETRY_INTERVAL;
+	}
+	LEAVE_COMMON_CS;
+}
+
+/* The connection to the replica is closed */
+static void
+CC_release_replica(ConnectionClass *self)
+{
+	if (self->replica_no > 0)
+	{
+		ENTER_COMMON_CS;
+		replicas[self->replica_no - 1].nconns--;
+		LEAVE_COMMON_CS;
+		self->replica_no = 0;
+	}
+	if (self->server_list)
+	{
+		free(self->server_list);
+		self->server_list = NULL;
+	}
+}
+
 char
 CC_connect(ConnectionClass *self, char password_req, char *salt_para)
 {
@@ -2001,6 +2290,7 @@ CC_connect(ConnectionClass *self, char password_req, char *salt_para)
 	mylog("%s: entering...\n", func);
 
 	mylog("sslmode=%s\n", self->connInfo.sslmode);
+	CC_choose_servers(self);
 #ifndef	NOT_USE_LIBPQ
 #ifdef	USE_SSPI
 	if (0 != self->svcs_allowed)
@@ -2009,8 +2299,18 @@ CC_connect(ConnectionClass *self, char password_req, char *salt_para)
 #endif /* USE_SSPI */
 	if (self->connInfo.username[0] == '\0')
 		call_libpq = TRUE;
+	/*
+	 * let libpq negotiate SSL unless original_CC_connect can and is
+	 * asked to, it falls back to libpq for the authentications it lacks
+	 */
+#if defined(USE_SSPI) || !defined(USE_SSL)
 	else if (self->connInfo.sslmode[0] != SSLLBYTE_DISABLE) 
 		call_libpq = TRUE;
+#else
+	else if (self->connInfo.sslmode[0] != SSLLBYTE_DISABLE &&
+		 !self->connInfo.drivers.driver_ssl) 
+		call_libpq = TRUE;
+#endif /* USE_SSPI || !USE_SSL */
 	if (call_libpq)
 	{
 		ret = LIBPQ_CC_connect(self, password_req, salt_para);
@@ -2038,6 +2338,8 @@ CC_connect(ConnectionClass *self, char password_req, char *salt_para)
 		}
 #endif /* NOT_USE_LIBPQ */
 	}
+	if (ret > 0 || CONNECTION_SERVER_NOT_REACHED == CC_get_errornumber(self))
+		CC_account_replicas(self, ret > 0);
 	if (ret <= 0)
 		return ret;
 
@@ -2453,6 +2755,7 @@ void	CC_on_commit(ConnectionClass *conn)
 		CC_set_no_trans(conn);
 		CC_set_no_manual_trans(conn);
 	}
+	conn->pending_svp[0] = '\0';
 	CC_clear_cursors(conn, FALSE);
 	CONNLOCK_RELEASE(conn);
 	CC_discard_marked_objects(conn);
@@ -2474,6 +2777,10 @@ mylog("CC_on_abort in\n");
 	CONNLOCK_ACQUIRE(conn);
 	if (0 != (opt & CONN_DEAD)) /* CONN_DEAD implies NO_TRANS also */
 		opt |= NO_TRANS;
+	if (0 != (opt & NO_TRANS))
+		conn->pending_svp[0] = '\0';
+	if (0 != (opt & CONN_DEAD))
+		conn->num_queued_cmds = 0;
 	if (CC_is_in_trans(conn))
 	{
 		if (0 != (opt & NO_TRANS))
@@ -2487,6 +2794,7 @@ mylog("CC_on_abort in\n");
 	if (0 != (opt & CONN_DEAD))
 	{
 		conn->status = CONN_DOWN;
+		conn->stmt_in_lazyquery = NULL;
 		if (conn->sock)
 		{
 			CONNLOCK_RELEASE(conn);
@@ -2537,6 +2845,27 @@ is_setting_search_path(const UCHAR* query)
 	return FALSE;
 }
 
+/*
+ *	Called with the tag of a completed command and the query (NULL if
+ *	unknown).  The current schema and the cached catalog results of the
+ *	unqualified lookups depend on search_path.
+ */
+void
+CC_on_set_command(ConnectionClass *self, const char *cmd, const char *query)
+{
+	if (strnicmp(cmd, "SET", 3) == 0)
+	{
+		if (NULL != query && !is_setting_search_path((const UCHAR *) query))
+			return;
+	}
+	else if (strnicmp(cmd, "RESET", 5) != 0 &&
+		 strnicmp(cmd, "DISCARD", 7) != 0)
+		return;
+	reset_current_schema(self);
+	if (self->num_catalog_cache > 0)
+		CC_clear_catalog_cache(self);
+}
+
 BOOL static
 CC_fetch_tuples(QResultClass *res, ConnectionClass *conn, const char *cursor, BOOL *ReadyToReturn, BOOL *kill_conn)
 {
@@ -2582,6 +2911,150 @@ CC_fetch_tuples(QResultClass *res, ConnectionClass *conn, const char *cursor, BO
 	return success;
 }
 
+/*
+ *	The per statement SAVEPOINT and RELEASE commands are not sent
+ *	immediately but kept in pending_svp and prepended to the next
+ *	simple query, so that they cost no extra round trip.
+ */
+BOOL
+CC_add_pending_svp(ConnectionClass *self, const char *cmd)
+{
+	size_t	len = strlen(self->pending_svp);
+
+	if (len + 1 + strlen(cmd) >= sizeof(self->pending_svp))
+	{
+		if (!CC_send_pending_svp(self))
+			return FALSE;
+		len = 0;
+	}
+	if (len > 0)
+		self->pending_svp[len++] = ';';
+	strcpy(self->pending_svp + len, cmd);
+	return TRUE;
+}
+
+/*
+ *	Send the pending SAVEPOINT/RELEASE commands now, as a query of
+ *	their own.  Needed before a fastpath function call, the extended
+ *	queries carry them with CC_queue_pending_svp() instead.
+ */
+BOOL
+CC_send_pending_svp(ConnectionClass *self)
+{
+	char	cmd[sizeof(self->pending_svp)];
+	QResultClass	*res, *tres;
+	BOOL	ret;
+
+	if ('\0' == self->pending_svp[0])
+		return TRUE;
+	strcpy(cmd, self->pending_svp);
+	self->pending_svp[0] = '\0';
+	res = CC_send_query(self, cmd, NULL, IGNORE_ABORT_ON_CONN, NULL);
+	ret = (NULL != res);
+	for (tres = res; NULL != tres; tres = tres->next)
+	{
+		if (!QR_command_maybe_successful(tres))
+			ret = FALSE;
+	}
+	QR_Destructor(res);
+	return ret;
+}
+
+/*
+ *	Send the command as Parse, Bind and Execute requests ahead of the
+ *	extended query requests which follow it and share its Sync, so that
+ *	it costs no round trip of its own.  SendSyncAndReceive() discards
+ *	its responses, but an error is reported as the one of the query,
+ *	which the server then skips.  The command must be a single one
+ *	without parameters.
+ *	It's parsed as QUEUED_PLAN_NAME, closed first in case an error left
+ *	it, rather than as the unnamed statement which the query may use.
+ */
+#define	QUEUED_PLAN_NAME	"_PLAN_QUEUED"
+BOOL
+CC_queue_command(ConnectionClass *self, const char *cmd)
+{
+	CSTR	func = "CC_queue_command";
+	SocketClass	*sock = self->sock;
+	size_t	len = strlen(cmd), plen = strlen(QUEUED_PLAN_NAME);
+
+	mylog("%s: %s\n", func, cmd);
+	qlog("%s: %s\n", func, cmd);
+	/* Close */
+	SOCK_put_char(sock, 'C');
+	SOCK_put_int(sock, (Int4) (4 + 1 + plen + 1), 4);
+	SOCK_put_char(sock, 'S');
+	SOCK_put_string(sock, QUEUED_PLAN_NAME);
+	/* Parse: without parameter types */
+	SOCK_put_char(sock, 'P');
+	SOCK_put_int(sock, (Int4) (4 + plen + 1 + len + 1 + 2), 4);
+	SOCK_put_string(sock, QUEUED_PLAN_NAME);
+	SOCK_put_string(sock, cmd);
+	SOCK_put_int(sock, 0, 2);
+	/* Bind: the unnamed portal, no parameters and text results */
+	SOCK_put_char(sock, 'B');
+	SOCK_put_int(sock, (Int4) (4 + 1 + plen + 1 + 2 + 2 + 2), 4);
+	SOCK_put_string(sock, NULL_STRING);
+	SOCK_put_string(sock, QUEUED_PLAN_NAME);
+	SOCK_put_int(sock, 0, 2);
+	SOCK_put_int(sock, 0, 2);
+	SOCK_put_int(sock, 0, 2);
+	/* Execute: all the rows */
+	SOCK_put_char(sock, 'E');
+	SOCK_put_int(sock, 4 + 1 + 4, 4);
+	SOCK_put_string(sock, NULL_STRING);
+	SOCK_put_int(sock, 0, 4);
+	if (0 != SOCK_get_errcode(sock))
+	{
+		CC_set_error(self, CONNECTION_COULD_NOT_SEND, "Could not send the queued command to backend", func);
+		CC_on_abort(self, CONN_DEAD);
+		return FALSE;
+	}
+	self->num_queued_cmds++;
+	return TRUE;
+}
+
+/*
+ *	Queue the pending SAVEPOINT/RELEASE commands ahead of an extended
+ *	query.  Like with a simple query, they are useless out of a healthy
+ *	transaction.
+ */
+BOOL
+CC_queue_pending_svp(ConnectionClass *self)
+{
+	char	cmd[sizeof(self->pending_svp)], *ptr, *next;
+
+	if ('\0' == self->pending_svp[0])
+		return TRUE;
+	strcpy(cmd, self->pending_svp);
+	self->pending_svp[0] = '\0';
+	if (!CC_is_in_trans(self) || CC_is_in_error_trans(self))
+		return TRUE;
+	/* one command per Parse request */
+	for (ptr = cmd; NULL != ptr; ptr = next)
+	{
+		if (NULL != (next = strchr(ptr, ';')))
+			*next++ = '\0';
+		if (!CC_queue_command(self, ptr))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ *	Queue a BEGIN ahead of an extended query instead of sending it
+ *	with CC_begin().  The connection is regarded as in a transaction
+ *	from now on, ReadyForQuery tells the truth after the Sync.
+ */
+BOOL
+CC_queue_begin(ConnectionClass *self)
+{
+	if (!CC_queue_command(self, bgncmd))
+		return FALSE;
+	CC_set_in_trans(self);
+	return TRUE;
+}
+
 /*
  *	The "result_in" is only used by QR_next_tuple() to fetch another group of rows into
  *	the same existing QResultClass (this occurs when the tuple cache is depleted and
@@ -2600,7 +3073,7 @@ CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UD
 			   *res = NULL;
 	BOOL	ignore_abort_on_conn = ((flag & IGNORE_ABORT_ON_CONN) != 0),
 		create_keyset = ((flag & CREATE_KEYSET) != 0),
-		issue_begin = ((flag & GO_INTO_TRANSACTION) != 0 && !CC_is_in_trans(self)),
+		issue_begin = FALSE,
 		rollback_on_error, query_rollback, end_with_commit;
 
 	const char	*wq;
@@ -2623,7 +3096,11 @@ CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UD
 			discard_next_begin = FALSE,
 			kill_conn = FALSE,
 			discard_next_savepoint = FALSE,
-			consider_rollback;
+			consider_rollback,
+			lazy = FALSE,
+			resume = FALSE;
+	int		discard_pending_svp = 0;
+	size_t		lenpendsvp = 0;
 	Int4		response_length;
 	UInt4		leng;
 	ConnInfo	*ci = &(self->connInfo);
@@ -2636,7 +3113,9 @@ CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UD
 	char		cmdbuffer[ERROR_MSG_LENGTH + 1];
 	BOOL		reduce_round_trip_time = !(flag & IGNORE_ROUND_TRIP);
 
-	if (appendq)
+	if (NULL == query)
+		mylog("%s: conn=%p, the rest of the batch\n", func, self);
+	else if (appendq)
 	{
 		mylog("%s_append: conn=%p, query='%s'+'%s'\n", func, self, query, appendq);
 		qlog("conn=%p, query='%s'+'%s'\n", self, query, appendq);
@@ -2665,6 +3144,31 @@ CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UD
 			return NULL;
 		}
 	}
+	if (NULL == query)
+	{
+		if (NULL == self->stmt_in_lazyquery)
+		{
+			CLEANUP_FUNC_CONN_CS(func_cs_count, self);
+			return NULL;
+		}
+		/*
+		 *	Read the next result of the batch, see the suspension at
+		 *	the end of the receiving loop.
+		 */
+		resume = TRUE;
+		self->stmt_in_lazyquery = NULL;
+		rollback_on_error = query_rollback = FALSE;
+		lazy = TRUE;
+		empty_reqs = 0;
+		goto receive_results;
+	}
+	/*
+	 * and the results of the batch left unread, which may change the
+	 * transaction status
+	 */
+	if (NULL != self->stmt_in_lazyquery)
+		CC_finish_lazy_query(self, FALSE);
+	issue_begin = ((flag & GO_INTO_TRANSACTION) != 0 && !CC_is_in_trans(self));
 	/* Indicate that we are sending a query to the backend */
 	maxlen = CC_get_max_query_len(self);
 	qrylen = strlen(query);
@@ -2719,6 +3223,14 @@ CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UD
 	if (rollback_on_error)
 		rollback_on_error = consider_rollback;
 	query_rollback = (rollback_on_error && !end_with_commit && PG_VERSION_GE(self, 8.0));
+	/*
+	 *	The results of a batch may be left on the socket until
+	 *	SQLMoreResults asks for them. Not when the driver has to
+	 *	look at the whole of them to roll back the query.
+	 */
+	lazy = (0 != (flag & LAZY_RESULTS) && NULL != stmt &&
+		NULL == qi && NULL == appendq && !create_keyset &&
+		!rollback_on_error && PROTOCOL_74(ci));
 	if (!query_rollback && consider_rollback && !end_with_commit)
 	{
 		if (stmt)
@@ -2735,6 +3247,22 @@ CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UD
 		}
 	}
 
+	/*
+	 *	The pending SAVEPOINT/RELEASE commands are sent ahead of
+	 *	the query. They are useless out of a healthy transaction.
+	 */
+	if (self->pending_svp[0])
+	{
+		if (CC_is_in_trans(self) && !CC_is_in_error_trans(self))
+		{
+			lenpendsvp = strlen(self->pending_svp);
+			for (ptr = self->pending_svp; NULL != ptr; ptr = strchr(ptr + 1, ';'))
+				discard_pending_svp++;
+		}
+		else
+			self->pending_svp[0] = '\0';
+	}
+
 	SOCK_put_char(sock, 'Q');
 	if (SOCK_get_errcode(sock) != 0)
 	{
@@ -2755,6 +3283,8 @@ CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UD
 	if (PROTOCOL_74(ci))
 	{
 		leng = (UInt4) qrylen;
+		if (lenpendsvp > 0)
+			leng += (UInt4) (lenpendsvp + 1);
 		if (appendq)
 			leng += (UInt4) (strlen(appendq) + 1);
 		if (issue_begin)
@@ -2768,6 +3298,12 @@ CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UD
 		SOCK_put_int(sock, leng + 4, 4);
 inolog("leng=%d\n", leng);
 	}
+	if (lenpendsvp > 0)
+	{
+		SOCK_put_n_char(sock, self->pending_svp, lenpendsvp);
+		SOCK_put_n_char(sock, semi_colon, 1);
+		self->pending_svp[0] = '\0';
+	}
 	if (issue_begin)
 	{
 		SOCK_put_n_char(sock, bgncmd, lenbgncmd);
@@ -2811,6 +3347,7 @@ inolog("leng=%d\n", leng);
 		;
 	if (*wq == '\0')
 		empty_reqs = 1;
+receive_results:
 	cmdres = qi ? qi->result_in : NULL;
 	if (cmdres)
 		used_passed_result_object = TRUE;
@@ -2864,6 +3401,12 @@ inolog("send_query response_length=%d\n", response_length);
 				{
 					mylog("send_query: ok - 'C' - %s\n", cmdbuffer);
 
+					if (discard_pending_svp > 0) /* discard the prepended SAVEPOINT/RELEASE */
+					{
+						discard_pending_svp--;
+						continue;
+					}
+
 					if (query_completed)	/* allow for "show" style notices */
 					{
 						res->next = QR_Constructor();
@@ -2894,6 +3437,8 @@ inolog("Discarded the first SAVEPOINT\n");
 					else if (strnicmp(cmdbuffer, rbkcmd, lenrbkcmd) == 0)
 					{
 						CC_mark_cursors_doubtful(self);
+						/* the rollback may undo some DDL */
+						CC_clear_catalog_cache(self);
 						if (PROTOCOL_74(&(self->connInfo)))
 							CC_set_in_error_trans(self); /* mark the transaction error in case of manual rollback */
 						else
@@ -2915,14 +3460,7 @@ inolog("Discarded the first SAVEPOINT\n");
 						else
 							res->recent_processed_row_count = -1;
 						if (PROTOCOL_74(&(self->connInfo)))
-						{
-							if (NULL != self->current_schema &&
-							    strnicmp(cmdbuffer, "SET", 3) == 0)
-							{
-								if (is_setting_search_path(query))
-									reset_current_schema(self);
-							}
-						}
+							CC_on_set_command(self, cmdbuffer, query);
 						else
 						{
 							if (strnicmp(cmdbuffer, cmtcmd, 6) == 0)
@@ -2964,6 +3502,8 @@ inolog("Discarded the first SAVEPOINT\n");
 					ReadyToReturn = TRUE;
 					if (aborted || query_completed)
 						retres = cmdres;
+					else if (resume)
+						retres = NULL;	/* no more results */
 					else
 						ReadyToReturn = FALSE;
 				}
@@ -3040,6 +3580,9 @@ inolog("Discarded the first SAVEPOINT\n");
 				if (!used_passed_result_object)
 				{
 					const char *cursor = qi ? qi->cursor : NULL;
+
+					if (qi)
+						res->max_rows = qi->max_rows;
 					if (create_keyset)
 					{
 						QR_set_haskeyset(res);
@@ -3194,6 +3737,22 @@ mylog("!!! copydata len=%d\n", response_length);
 			if (empty_reqs == 0 && query_completed)
 				break;
 		}
+		/*
+		 * Hand out the result and leave the rest of the batch unread
+		 * unless the end of it is already at hand.
+		 */
+		if (lazy && query_completed && !aborted && !ReadyToReturn &&
+		    'Z' != SOCK_peek_id(sock))
+		{
+			mylog("send_query: leaving the rest of the batch unread\n");
+			if (!resume)
+			{
+				self->lazy_head = cmdres;
+				self->lazy_flag = flag;
+			}
+			self->stmt_in_lazyquery = stmt;
+			break;
+		}
 	}
 
 cleanup:
@@ -3289,6 +3848,55 @@ cleanup:
 	return retres;
 }
 
+/*
+ *	Read the next result of the batch whose results were left unread
+ *	(see LAZY_RESULTS). NULL means there are no more results.
+ */
+QResultClass *
+CC_next_lazy_result(ConnectionClass *self)
+{
+	if (NULL == self->stmt_in_lazyquery)
+		return NULL;
+	return CC_send_query_append(self, NULL, NULL, self->lazy_flag, self->stmt_in_lazyquery, NULL);
+}
+
+/*
+ *	Read the rest of the batch before the connection is used for
+ *	anything else. The results are appended to the statement which
+ *	executed the batch unless it has given up the results already.
+ */
+void
+CC_finish_lazy_query(ConnectionClass *self, BOOL discard)
+{
+	StatementClass	*stmt;
+	QResultClass	*res, *last;
+
+	while (stmt = self->stmt_in_lazyquery, NULL != stmt)
+	{
+		/* the errors belong to the statement, not to the connection */
+		res = CC_send_query_append(self, NULL, NULL, self->lazy_flag | IGNORE_ABORT_ON_CONN, stmt, NULL);
+		if (NULL == res)
+			continue;
+		last = NULL;
+		if (!discard)
+		{
+			for (last = SC_get_Result(stmt); NULL != last; last = last->next)
+			{
+				if (last == self->lazy_head)
+					break;
+			}
+		}
+		if (NULL != last)
+		{
+			while (NULL != last->next)
+				last = last->next;
+			last->next = res;
+		}
+		else
+			QR_Destructor(res);
+	}
+}
+
 
 int
 CC_send_function(ConnectionClass *self, int fnid, void *result_buf, int *actual_result_len, int result_is_int, LO_ARG *args, int nargs)
@@ -3333,6 +3941,16 @@ CC_send_function(ConnectionClass *self, int fnid, void *result_buf, int *actual_
 			return FALSE;
 		}
 	}
+	/* and the results of the batch left unread */
+	if (NULL != self->stmt_in_lazyquery)
+		CC_finish_lazy_query(self, FALSE);
+	/* a function call can't carry the SAVEPOINT/RELEASE, send it now */
+	if (!CC_send_pending_svp(self))
+	{
+		if (CC_get_errornumber(self) <= 0)
+			CC_set_error(self, CONN_EXEC_ERROR, "internal savepoint error in CC_send_function()", func);
+		return FALSE;
+	}
 #define	return DONT_CALL_RETURN_FROM_HERE???
 	ENTER_INNER_CONN_CS(self, func_cs_count);
 	ci = &(self->connInfo);
@@ -3501,6 +4119,184 @@ cleanup:
 }
 
 
+/*
+ *	Send the same function call ncalls times without waiting for
+ *	each result so that the calls are processed in one round trip.
+ *	The (non-integer) results are stored one after another in
+ *	result_buf and their total length is set to *actual_result_len.
+ *	Before protocol 3.0 the calls are sent one by one.
+ */
+int
+CC_send_function_pipelined(ConnectionClass *self, int fnid, void *result_buf, int result_buf_len, int *actual_result_len, LO_ARG *args, int nargs, int ncalls)
+{
+	CSTR	func = "CC_send_function_pipelined";
+	char		id;
+	SocketClass *sock = self->sock;
+
+	/* ERROR_MSG_LENGTH is sufficient */
+	char msgbuffer[ERROR_MSG_LENGTH + 1];
+	int			i, icall, ncompleted;
+	int			ret = TRUE;
+	UInt4			leng;
+	Int4			response_length, rlen;
+	int			func_cs_count = 0;
+
+	mylog("%s: conn=%p, fnid=%d, nargs=%d, ncalls=%d\n", func, self, fnid, nargs, ncalls);
+
+	*actual_result_len = 0;
+	if (!PROTOCOL_74(&(self->connInfo)))
+	{
+		for (icall = 0; icall < ncalls; icall++)
+		{
+			if (!CC_send_function(self, fnid, (char *) result_buf + *actual_result_len, &rlen, 0, args, nargs))
+				return FALSE;
+			if (rlen <= 0)
+				break;
+			*actual_result_len += rlen;
+		}
+		return TRUE;
+	}
+	if (!self->sock)
+	{
+		CC_set_error(self, CONNECTION_COULD_NOT_SEND, "Could not send function(connection dead)", func);
+		CC_on_abort(self, CONN_DEAD);
+		return FALSE;
+	}
+	if (SOCK_get_errcode(sock) != 0)
+	{
+		CC_set_error(self, CONNECTION_COULD_NOT_SEND, "Could not send function to backend", func);
+		CC_on_abort(self, CONN_DEAD);
+		return FALSE;
+	}
+
+	/* Finish the pending extended query first */
+	if (!SyncParseRequest(self))
+	{
+		if (CC_get_errornumber(self) <= 0)
+		{
+			CC_set_error(self, CONN_EXEC_ERROR, "error occured while calling SyncParseRequest() in CC_send_function_pipelined()", func);
+			return FALSE;
+		}
+	}
+	/* and the results of the batch left unread */
+	if (NULL != self->stmt_in_lazyquery)
+		CC_finish_lazy_query(self, FALSE);
+	/* a function call can't carry the SAVEPOINT/RELEASE, send it now */
+	if (!CC_send_pending_svp(self))
+	{
+		if (CC_get_errornumber(self) <= 0)
+			CC_set_error(self, CONN_EXEC_ERROR, "internal savepoint error in CC_send_function_pipelined()", func);
+		return FALSE;
+	}
+#define	return DONT_CALL_RETURN_FROM_HERE???
+	ENTER_INNER_CONN_CS(self, func_cs_count);
+	leng = 4 + sizeof(uint32) + 2 + 2 + sizeof(uint16);
+	for (i = 0; i < nargs; i++)
+	{
+		leng += 4;
+		if (args[i].len >= 0)
+		{
+			if (args[i].isint)
+				leng += 4;
+			else
+				leng += args[i].len;
+		}
+	}
+	leng += 2;
+	for (icall = 0; icall < ncalls; icall++)
+	{
+		SOCK_put_char(sock, 'F');
+		SOCK_put_int(sock, leng, 4);
+		SOCK_put_int(sock, fnid, 4);
+		SOCK_put_int(sock, 1, 2); /* # of formats */
+		SOCK_put_int(sock, 1, 2); /* the format is binary */
+		SOCK_put_int(sock, nargs, 2);
+		for (i = 0; i < nargs; ++i)
+		{
+			SOCK_put_int(sock, args[i].len, 4);
+			if (args[i].isint)
+				SOCK_put_int(sock, args[i].u.integer, 4);
+			else
+				SOCK_put_n_char(sock, (char *) args[i].u.ptr, args[i].len);
+		}
+		SOCK_put_int(sock, 1, 2); /* result format is binary */
+	}
+	SOCK_flush_output(sock);
+	if (SOCK_get_errcode(sock) != 0)
+	{
+		CC_set_error(self, CONNECTION_COULD_NOT_SEND, "Could not send function to backend", func);
+		CC_on_abort(self, CONN_DEAD);
+		ret = FALSE;
+		goto cleanup;
+	}
+	mylog("  after flush output\n");
+
+	/* Each call is answered by FunctionCallResponse and ReadyForQuery */
+	for (ncompleted = 0; ncompleted < ncalls;)
+	{
+		id = SOCK_get_id(sock);
+		response_length = SOCK_get_response_length(sock);
+		if (SOCK_get_errcode(sock) != 0)
+		{
+			CC_set_error(self, CONNECTION_NO_RESPONSE, "No response from the backend", func);
+			CC_on_abort(self, CONN_DEAD);
+			ret = FALSE;
+			break;
+		}
+inolog("%s: got id=%c response_length=%d\n", func, id, response_length);
+
+		switch (id)
+		{
+			case 'V':
+				rlen = SOCK_get_int(sock, 4);
+				if (rlen > 0)
+				{
+					if (*actual_result_len + rlen > result_buf_len)
+					{
+						CC_set_error(self, CONNECTION_BACKEND_CRAZY, "The function result is longer than requested", func);
+						CC_on_abort(self, CONN_DEAD);
+						ret = FALSE;
+						goto cleanup;
+					}
+					SOCK_get_n_char(sock, (char *) result_buf + *actual_result_len, rlen);
+					*actual_result_len += rlen;
+				}
+				break;
+
+			case 'N':
+				handle_notice_message(self, msgbuffer, sizeof(msgbuffer), NULL, "send_function", NULL);
+				/* continue reading */
+				break;
+
+			case 'E':
+				handle_error_message(self, msgbuffer, sizeof(msgbuffer), NULL, "send_function", NULL); 
+				CC_set_errormsg(self, msgbuffer);
+				qlog("ERROR from backend during send_function: '%s'\n", CC_get_errormsg(self));
+				ret = FALSE;
+				break;
+
+			case 'Z':
+				EatReadyForQuery(self);
+				ncompleted++;
+				break;
+
+			default:
+				/* skip the unexpected response if possible */
+				if (response_length >= 0)
+					break;
+				CC_set_error(self, CONNECTION_BACKEND_CRAZY, "Unexpected protocol character from backend (send_function, args)", func);
+				CC_on_abort(self, CONN_DEAD);
+				ret = FALSE;
+				goto cleanup;
+		}
+	}
+
+cleanup:
+#undef	return
+	CLEANUP_FUNC_CONN_CS(func_cs_count, self);
+	return ret;
+}
+
 static	char
 CC_setenv(ConnectionClass *self)
 {
@@ -3954,6 +4750,241 @@ CC_send_cancel_request(const ConnectionClass *conn)
 	return ret;
 }
 
+/*
+ *	SQL_QUERY_TIMEOUT support.
+ *
+ *	A single driver-wide thread watches the deadlines of the running
+ *	queries and sends a cancel request when one of them passes. The
+ *	armed connections are kept in a timer wheel of one second slots
+ *	indexed by the deadline, so that each tick only looks at the
+ *	connections which may expire in that second. The thread exits
+ *	when no timer is armed and is started again on demand.
+ */
+#define	QUERY_TIMER_SLOTS	64	/* must be a power of 2 */
+#define	QUERY_CANCEL_GRACE	10	/* seconds allowed for a cancel to take effect */
+
+static ConnectionClass	*query_timer_wheel[QUERY_TIMER_SLOTS];
+static int	query_timer_count = 0;
+static BOOL	query_timer_running = FALSE;
+
+#if defined(WIN_MULTITHREAD_SUPPORT)
+static CRITICAL_SECTION	query_timer_cs;
+#define	ENTER_QUERY_TIMER_CS	EnterCriticalSection(&query_timer_cs)
+#define	LEAVE_QUERY_TIMER_CS	LeaveCriticalSection(&query_timer_cs)
+#elif defined(POSIX_MULTITHREAD_SUPPORT)
+static pthread_mutex_t	query_timer_cs = PTHREAD_MUTEX_INITIALIZER;
+#define	ENTER_QUERY_TIMER_CS	pthread_mutex_lock(&query_timer_cs)
+#define	LEAVE_QUERY_TIMER_CS	pthread_mutex_unlock(&query_timer_cs)
+#endif /* WIN_MULTITHREAD_SUPPORT */
+
+void
+InitializeQueryTimer(void)
+{
+#if defined(WIN_MULTITHREAD_SUPPORT)
+	InitializeCriticalSection(&query_timer_cs);
+#endif /* WIN_MULTITHREAD_SUPPORT */
+}
+
+#if defined(WIN_MULTITHREAD_SUPPORT) || defined(POSIX_MULTITHREAD_SUPPORT)
+/*
+ *	Take the connections whose deadline passed out of the wheel and
+ *	chain them to *expired. Called holding query_timer_cs.
+ *	The connections are marked timer_cancelling so that
+ *	CC_reset_query_timer() waits for the cancel request sent after
+ *	the lock is released and they stay alive until then.
+ */
+static void
+fire_query_timers(time_t tick, time_t now, ConnectionClass **expired)
+{
+	ConnectionClass	**pconn, *conn;
+
+	for (pconn = &query_timer_wheel[tick & (QUERY_TIMER_SLOTS - 1)]; NULL != (conn = *pconn);)
+	{
+		if (conn->timer_deadline > now)	/* a later round */
+		{
+			pconn = &conn->timer_next;
+			continue;
+		}
+		*pconn = conn->timer_next;
+		query_timer_count--;
+		mylog("query timeout expired conn=%p\n", conn);
+		conn->timer_fired = TRUE;
+		conn->timer_cancelling = TRUE;
+		conn->timer_next = *expired;
+		*expired = conn;
+	}
+}
+
+#if defined(WIN_MULTITHREAD_SUPPORT)
+static unsigned __stdcall
+query_timer_thread(void *arg)
+#else
+static void *
+query_timer_thread(void *arg)
+#endif /* WIN_MULTITHREAD_SUPPORT */
+{
+	time_t	tick = time(NULL), now;
+	ConnectionClass	*expired, *conn;
+
+	for (;;)
+	{
+#ifdef	WIN32
+		Sleep(1000);
+#else
+		sleep(1);
+#endif /* WIN32 */
+		ENTER_QUERY_TIMER_CS;
+		now = time(NULL);
+		/* a slot is never visited twice in a tick */
+		if (now - tick >= QUERY_TIMER_SLOTS)
+			tick = now - QUERY_TIMER_SLOTS + 1;
+		for (expired = NULL; tick <= now; tick++)
+			fire_query_timers(tick, now, &expired);
+		if (NULL != expired)
+		{
+			/*
+			 * Sending a cancel request opens a new connection to
+			 * the server. Don't block the other threads meanwhile.
+			 */
+			LEAVE_QUERY_TIMER_CS;
+			for (conn = expired; NULL != conn; conn = conn->timer_next)
+			{
+				if (!CC_send_cancel_request(conn))
+					mylog("query timer couldn't send the cancel request conn=%p\n", conn);
+			}
+			ENTER_QUERY_TIMER_CS;
+			while (NULL != (conn = expired))
+			{
+				expired = conn->timer_next;
+				conn->timer_next = NULL;
+				conn->timer_cancelling = FALSE;
+			}
+		}
+		if (0 == query_timer_count)
+		{
+			query_timer_running = FALSE;
+			LEAVE_QUERY_TIMER_CS;
+			break;
+		}
+		LEAVE_QUERY_TIMER_CS;
+	}
+	mylog("query timer thread exiting\n");
+	return 0;
+}
+
+static BOOL
+start_query_timer_thread(void)
+{
+#if defined(WIN_MULTITHREAD_SUPPORT)
+	HANDLE	th;
+
+	if (th = (HANDLE) _beginthreadex(NULL, 0, query_timer_thread, NULL, 0, NULL), NULL == th)
+		return FALSE;
+	CloseHandle(th);
+#else
+	pthread_t	th;
+	pthread_attr_t	attr;
+	int	ret;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&th, &attr, query_timer_thread, NULL);
+	pthread_attr_destroy(&attr);
+	if (0 != ret)
+		return FALSE;
+#endif /* WIN_MULTITHREAD_SUPPORT */
+	return TRUE;
+}
+#endif /* WIN_MULTITHREAD_SUPPORT || POSIX_MULTITHREAD_SUPPORT */
+
+/*
+ *	Arm the query timer of the connection. The query is cancelled
+ *	unless CC_reset_query_timer() is called within timeout seconds.
+ *	The socket waits also end at the deadline (plus the grace period
+ *	for the cancel), see SOCK_wait_for_ready().
+ */
+void
+CC_set_query_timer(ConnectionClass *self, SQLULEN timeout)
+{
+#if defined(WIN_MULTITHREAD_SUPPORT) || defined(POSIX_MULTITHREAD_SUPPORT)
+	time_t	deadline;
+	int	slot;
+
+	if (0 == timeout || 0 != self->timer_deadline)
+		return;
+	/*
+	 * time() truncates to the second, so that time(NULL) + timeout may
+	 * be as much as a second short of the timeout. Round it up; a query
+	 * is never cancelled before its timeout, at most a second after it.
+	 */
+	deadline = time(NULL) + timeout + 1;
+	slot = (int) (deadline & (QUERY_TIMER_SLOTS - 1));
+	ENTER_QUERY_TIMER_CS;
+	self->timer_deadline = deadline;
+	self->timer_fired = FALSE;
+	self->timer_next = query_timer_wheel[slot];
+	query_timer_wheel[slot] = self;
+	query_timer_count++;
+	if (!query_timer_running)
+	{
+		if (start_query_timer_thread())
+			query_timer_running = TRUE;
+		else
+			mylog("couldn't start the query timer thread\n");
+	}
+	LEAVE_QUERY_TIMER_CS;
+	/* don't wait for the server forever if the cancel is ignored */
+	if (self->sock)
+		self->sock->wait_deadline = deadline + QUERY_CANCEL_GRACE;
+#endif /* WIN_MULTITHREAD_SUPPORT || POSIX_MULTITHREAD_SUPPORT */
+}
+
+/*
+ *	Disarm the query timer of the connection.
+ *	Returns TRUE if the timeout expired and the query was cancelled.
+ */
+BOOL
+CC_reset_query_timer(ConnectionClass *self)
+{
+	BOOL	fired = FALSE;
+
+#if defined(WIN_MULTITHREAD_SUPPORT) || defined(POSIX_MULTITHREAD_SUPPORT)
+	ConnectionClass	**pconn;
+
+	if (0 == self->timer_deadline)
+		return FALSE;
+	ENTER_QUERY_TIMER_CS;
+	/* the timer thread may be sending the cancel request now */
+	while (self->timer_cancelling)
+	{
+		LEAVE_QUERY_TIMER_CS;
+#ifdef	WIN32
+		Sleep(10);
+#else
+		usleep(10000);
+#endif /* WIN32 */
+		ENTER_QUERY_TIMER_CS;
+	}
+	for (pconn = &query_timer_wheel[self->timer_deadline & (QUERY_TIMER_SLOTS - 1)]; NULL != *pconn; pconn = &(*pconn)->timer_next)
+	{
+		if (*pconn == self)
+		{
+			*pconn = self->timer_next;
+			query_timer_count--;
+			break;
+		}
+	}
+	self->timer_next = NULL;
+	self->timer_deadline = 0;
+	fired = self->timer_fired;
+	self->timer_fired = FALSE;
+	LEAVE_QUERY_TIMER_CS;
+	if (self->sock)
+		self->sock->wait_deadline = 0;
+#endif /* WIN_MULTITHREAD_SUPPORT || POSIX_MULTITHREAD_SUPPORT */
+	return fired;
+}
+
 int	CC_mark_a_object_to_discard(ConnectionClass *conn, int type, const char *plan)
 {
 	int	cnt = conn->num_discardp + 1;
@@ -4082,6 +5113,7 @@ cleanup1:
 	socket = PQsocket(pqconn);
 inolog("socket=%d\n", socket);
 	sock->socket = socket;
+	CC_set_sock_buffer_size(self, sock);
 #ifdef USE_SSL
 	sock->ssl = PQgetssl(pqconn);
 inolog("ssl=%p\n", sock->ssl);
@@ -4134,7 +5166,11 @@ if (TRUE)
 	ret = 1;
 	if (ret)
 	{
+		const char	*host = PQhost(pqconn);
+
 		self->sock = sock;
+		if (host && NULL == sock->hostname)
+			sock->hostname = strdup(host);
 		if (!CC_get_username(self)[0])
 		{
 			mylog("PQuser=%s\n", PQuser(pqconn));
@@ -77,6 +77,7 @@ enum
 
 #define CONN_OPTION_NOT_FOR_THE_DRIVER					216
 #define CONN_EXEC_ERROR							217
+#define CONN_OPTION_CANNOT_BE_SET_NOW					218
 
 /* Conn_status defines */
 #define CONN_IN_AUTOCOMMIT		1L 
@@ -283,6 +284,7 @@ typedef struct
 	char		desc[MEDIUM_REGISTRY_LEN];
 	char		drivername[MEDIUM_REGISTRY_LEN];
 	char		server[MEDIUM_REGISTRY_LEN];
+	char		replica_servers[MEDIUM_REGISTRY_LEN];
 	char		database[MEDIUM_REGISTRY_LEN];
 	char		username[MEDIUM_REGISTRY_LEN];
 	char		password[MEDIUM_REGISTRY_LEN];
@@ -398,6 +400,25 @@ struct col_info
 }
 #define col_info_initialize(coli) (memset(coli, 0, sizeof(COL_INFO)))
 
+/* A prepared catalog query, see info.c */
+typedef struct
+{
+	char		*shape;		/* the query with its search arguments as $n */
+	Int4		id;		/* of the statement name, never reused */
+	char		state;		/* CATALOG_PLAN_xxxx */
+} CATALOG_PLAN;
+#define	CATALOG_PLAN_PREPARING	0	/* being prepared by another call */
+#define	CATALOG_PLAN_READY	1
+#define	CATALOG_PLAN_FAILED	2	/* PREPARE failed, don't try again */
+
+/* An entry of the catalog result cache, see info.c */
+typedef struct
+{
+	char		*key;		/* function name and arguments */
+	time_t		stamp;		/* when the result was stored */
+	QResultClass	*res;
+} CATALOG_CACHE;
+
  /* Translation DLL entry points */
 #ifdef WIN32
 #define DLLHANDLE HINSTANCE
@@ -420,6 +441,7 @@ struct ConnectionClass_
 	HENV		henv;		/* environment this connection was
 					 * created on */
 	SQLUINTEGER	login_timeout;
+	SQLUINTEGER	packet_size;	/* SQL_ATTR_PACKET_SIZE, 0 means the DSN setting */
 	StatementOptions stmtOptions;
 	ARDFields	ardOptions;
 	APDFields	apdOptions;
@@ -467,9 +489,28 @@ struct ConnectionClass_
 	UInt4		isolation;
 	char		*current_schema;
 	StatementClass	*stmt_in_extquery;
+	/* the batch whose remaining results are left unread, see CC_send_query_append() */
+	StatementClass	*stmt_in_lazyquery;
+	QResultClass	*lazy_head;	/* the first result handed to the statement */
+	UDWORD		lazy_flag;
+	char		pending_svp[128];	/* SAVEPOINT/RELEASE commands sent with the next query */
+	Int2		num_queued_cmds;	/* sent ahead of the extended query, see CC_queue_command() */
+	/* SQL_QUERY_TIMEOUT, see CC_set_query_timer() */
+	ConnectionClass	*timer_next;
+	time_t		timer_deadline;	/* 0 means not armed */
+	char		timer_fired;
+	char		timer_cancelling;	/* the timer thread is sending the cancel */
 	Int2		max_identifier_length;
 	Int2		num_discardp;
 	char		**discardp;
+	Int2		num_catalog_plans;
+	CATALOG_PLAN	*catalog_plans;	/* the prepared catalog queries */
+	Int4		catalog_plan_seq;	/* not reset by CC_clear_catalog_plans() */
+	Int2		num_catalog_cache;
+	CATALOG_CACHE	*catalog_cache;
+	/* ReplicaServers, see CC_choose_servers() */
+	char		*server_list;	/* the hosts to try in order */
+	Int2		replica_no;	/* 1 + the index of the replica connected to */
 #if (ODBCVER >= 0x0300)
 	int		num_descs;
 	DescriptorClass	**descs;
@@ -501,6 +542,7 @@ struct ConnectionClass_
 #define CC_get_DSN(x)				(x->connInfo.dsn)
 #define CC_get_username(x)			(x->connInfo.username)
 #define CC_is_onlyread(x)			(x->connInfo.onlyread[0] == '1')
+#define CC_get_server_list(x)			(x->server_list ? x->server_list : x->connInfo.server)
 #define CC_get_escape(x)			(x->escape_in_literal)
 #define CC_fake_mss(x)	(/* 0 != (x)->ms_jet && */ 0 < (x)->connInfo.fake_mss)
 #define CC_accessible_only(x)	(0 < (x)->connInfo.accessible_only && PG_VERSION_GE((x), 7.2))
@@ -534,8 +576,14 @@ void		CC_set_errormsg(ConnectionClass *self, const char *message);
 char		CC_get_error(ConnectionClass *self, int *number, char **message);
 QResultClass *CC_send_query_append(ConnectionClass *self, const char *query, QueryInfo *qi, UDWORD flag, StatementClass *stmt, const char *appendq);
 #define CC_send_query(self, query, qi, flag, stmt) CC_send_query_append(self, query, qi, flag, stmt, NULL)
+BOOL		CC_add_pending_svp(ConnectionClass *self, const char *cmd);
+BOOL		CC_send_pending_svp(ConnectionClass *self);
+BOOL		CC_queue_command(ConnectionClass *self, const char *cmd);
+BOOL		CC_queue_pending_svp(ConnectionClass *self);
+BOOL		CC_queue_begin(ConnectionClass *self);
 void		CC_clear_error(ConnectionClass *self);
 int		CC_send_function(ConnectionClass *conn, int fnid, void *result_buf, int *actual_result_len, int result_is_int, LO_ARG *argv, int nargs);
+int		CC_send_function_pipelined(ConnectionClass *conn, int fnid, void *result_buf, int result_buf_len, int *actual_result_len, LO_ARG *argv, int nargs, int ncalls);
 char		CC_send_settings(ConnectionClass *self);
 /*
 char		*CC_create_errormsg(ConnectionClass *self);
@@ -546,6 +594,8 @@ void		CC_initialize_pg_version(ConnectionClass *conn);
 void		CC_log_error(const char *func, const char *desc, const ConnectionClass *self);
 int		CC_get_max_query_len(const ConnectionClass *self);
 int		CC_send_cancel_request(const ConnectionClass *conn);
+void		CC_set_query_timer(ConnectionClass *self, SQLULEN timeout);
+BOOL		CC_reset_query_timer(ConnectionClass *self);
 void		CC_on_commit(ConnectionClass *conn);
 void		CC_on_abort(ConnectionClass *conn, UDWORD opt);
 void		CC_on_abort_partial(ConnectionClass *conn);
@@ -553,6 +603,11 @@ void		ProcessRollback(ConnectionClass *conn, BOOL undo, BOOL partial);
 const char	*CC_get_current_schema(ConnectionClass *conn);
 int             CC_mark_a_object_to_discard(ConnectionClass *conn, int type, const char *plan);
 int             CC_discard_marked_objects(ConnectionClass *conn);
+void		CC_clear_catalog_plans(ConnectionClass *self);
+void		CC_clear_catalog_cache(ConnectionClass *self);
+void		CC_on_set_command(ConnectionClass *self, const char *cmd, const char *query);
+QResultClass	*CC_next_lazy_result(ConnectionClass *self);
+void		CC_finish_lazy_query(ConnectionClass *self, BOOL discard);
 
 int	handle_error_message(ConnectionClass *self, char *msgbuf, size_t buflen,
 		 char *sqlstate, const char *comment, QResultClass *res);
@@ -575,6 +630,7 @@ enum {
 	,ROLLBACK_ON_ERROR	= (1L << 3) /* rollback the query when an error occurs */
 	,END_WITH_COMMIT	= (1L << 4) /* the query ends with COMMMIT command */
 	,IGNORE_ROUND_TRIP	= (1L << 5) /* the commincation round trip time is considered ignorable */
+	,LAZY_RESULTS		= (1L << 6) /* leave the results of a batch unread until SQLMoreResults */
 };
 /* CC_on_abort options */
 #define	NO_TRANS		1L
@@ -35,6 +35,9 @@
 #endif
 #include <math.h>
 #include <stdlib.h>
+#ifdef	USE_SSE2
+#include <emmintrin.h>
+#endif /* USE_SSE2 */
 #include "statement.h"
 #include "qresult.h"
 #include "bind.h"
@@ -142,10 +145,9 @@ char	   *mapFuncs[][2] = {
 
 static const char *mapFunction(const char *func, int param_count);
 static int conv_from_octal(const UCHAR *s);
-static SQLLEN pg_bin2hex(const UCHAR *src, UCHAR *dst, SQLLEN length);
-#ifdef	UNICODE_SUPPORT
-static SQLLEN pg_bin2whex(const UCHAR *src, SQLWCHAR *dst, SQLLEN length);
-#endif /* UNICODE_SUPPORT */
+static SQLLEN hex_pairs_to_bin(const UCHAR *src, UCHAR *dst, SQLLEN nbytes);
+static SQLLEN decode_pgbinary_piece(const UCHAR *value, SQLLEN *src_pos, UCHAR *out, SQLLEN outlen);
+static SQLLEN pgbinary_hex_piece(const UCHAR *value, BOOL hex_format, SQLLEN *src_pos, BOOL low_first, char *out, SQLLEN ochars, BOOL wide);
 
 /*---------
  *			A Guide for date/time/timestamp conversions
@@ -214,16 +216,139 @@ static unsigned ODBCINT64 ATOI64U(const char *val)
 #endif /* WIN32 */
 #endif /* ODBCINT64 */
 
+/*
+ *	Parsers of the ISO style date/time output of the server.
+ *	Unlike sscanf() and atof() they never look at the locale, and
+ *	they return NULL for anything out of the fixed layout so that the
+ *	callers can fall back to the general routines.
+ */
+static const char *
+get_digits(const char *str, int maxlen, int *val)
+{
+	int	i, v = 0;
+
+	for (i = 0; i < maxlen && str[i] >= '0' && str[i] <= '9'; i++)
+		v = v * 10 + (str[i] - '0');
+	if (0 == i)
+		return NULL;
+	*val = v;
+	return str + i;
+}
+
+/* YYYY-MM-DD */
+const char *
+parse_iso_date(const char *str, SIMPLE_TIME *st)
+{
+	if (NULL == (str = get_digits(str, 4, &st->y)) || '-' != *str ||
+	    NULL == (str = get_digits(str + 1, 2, &st->m)) || '-' != *str ||
+	    NULL == (str = get_digits(str + 1, 2, &st->d)))
+		return NULL;
+	return str;
+}
+
+/* HH:MM:SS, the fraction isn't included */
+const char *
+parse_iso_time(const char *str, SIMPLE_TIME *st)
+{
+	if (NULL == (str = get_digits(str, 2, &st->hh)) || ':' != *str ||
+	    NULL == (str = get_digits(str + 1, 2, &st->mm)) || ':' != *str ||
+	    NULL == (str = get_digits(str + 1, 2, &st->ss)))
+		return NULL;
+	return str;
+}
+
+/* the next word, as sscanf("%s") would get it */
+static const char *
+get_word(const char *str, char *buf, size_t size)
+{
+	size_t	i;
+
+	while (isspace((UCHAR) *str))
+		str++;
+	for (i = 0; i + 1 < size && '\0' != *str && !isspace((UCHAR) *str); i++)
+		buf[i] = *str++;
+	buf[i] = '\0';
+	return str;
+}
+
+/*
+ *	[-]digits[.digits][e[+-]digits] which can be converted exactly, i.e.
+ *	at most 15 significant digits and a power of ten up to 22.
+ */
+BOOL
+parse_iso_double(const char *str, double *val)
+{
+	static const double	pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+		1e21, 1e22};
+	double	mant = 0;
+	int	ndigits = 0, exp10 = 0, eval;
+	BOOL	neg = FALSE, digits = FALSE;
+
+	if ('-' == *str)
+	{
+		neg = TRUE;
+		str++;
+	}
+	for (; *str >= '0' && *str <= '9'; str++)
+	{
+		digits = TRUE;
+		if (0 == ndigits && '0' == *str)
+			continue;
+		mant = mant * 10 + (*str - '0');
+		ndigits++;
+	}
+	if ('.' == *str)
+	{
+		for (str++; *str >= '0' && *str <= '9'; str++)
+		{
+			digits = TRUE;
+			exp10--;
+			if (0 == ndigits && '0' == *str)
+				continue;
+			mant = mant * 10 + (*str - '0');
+			ndigits++;
+		}
+	}
+	if (!digits || ndigits > 15)
+		return FALSE;
+	if ('e' == *str || 'E' == *str)
+	{
+		BOOL	eneg = FALSE;
+
+		str++;
+		if ('-' == *str || '+' == *str)
+			eneg = ('-' == *str++);
+		if (NULL == (str = get_digits(str, 3, &eval)))
+			return FALSE;
+		exp10 += (eneg ? -eval : eval);
+	}
+	if ('\0' != *str)
+		return FALSE;
+	if (0 == ndigits)
+		exp10 = 0;
+	if (exp10 > 22 || exp10 < -22)
+		return FALSE;
+	if (exp10 >= 0)
+		mant *= pow10[exp10];
+	else
+		mant /= pow10[-exp10];
+	*val = (neg ? -mant : mant);
+	return TRUE;
+}
+
 /*
  *	TIMESTAMP <-----> SIMPLE_TIME
  *		precision support since 7.2.
  *		time zone support is unavailable(the stuff is unreliable)
  */
-static BOOL
+BOOL
 timestamp2stime(const char *str, SIMPLE_TIME *st, BOOL *bZone, int *zone)
 {
 	char		rest[64], bc[16],
 			   *ptr;
+	const char	*cp;
 	int			scnt,
 				i;
 #ifdef	TIMEZONE_GLOBAL
@@ -237,9 +362,18 @@ timestamp2stime(const char *str, SIMPLE_TIME *st, BOOL *bZone, int *zone)
 	st->infinity = 0;
 	rest[0] = '\0';
 	bc[0] = '\0';
-	if ((scnt = sscanf(str, "%4d-%2d-%2d %2d:%2d:%2d%32s %16s", &st->y, &st->m, &st->d, &st->hh, &st->mm, &st->ss, rest, bc)) < 6)
+	if (NULL != (cp = parse_iso_date(str, st)) && ' ' == *cp &&
+	    NULL != (cp = parse_iso_time(cp + 1, st)))
+	{
+		if ('\0' == *cp)
+			return TRUE;
+		cp = get_word(cp, rest, 33);
+		get_word(cp, bc, 17);
+		scnt = ('\0' == rest[0] ? 6 : 7);
+	}
+	else if ((scnt = sscanf(str, "%4d-%2d-%2d %2d:%2d:%2d%32s %16s", &st->y, &st->m, &st->d, &st->hh, &st->mm, &st->ss, rest, bc)) < 6)
 		return FALSE;
-	else if (scnt == 6)
+	if (scnt == 6)
 		return TRUE;
 	switch (rest[0])
 	{
@@ -264,15 +398,11 @@ timestamp2stime(const char *str, SIMPLE_TIME *st, BOOL *bZone, int *zone)
 				*zone = -atoi(&ptr[1]);
 				*ptr = '\0';
 			}
-			for (i = 1; i < 10; i++)
-			{
-				if (!isdigit((UCHAR) rest[i]))
-					break;
-			}
+			/* nanoseconds from at most 9 digits */
+			for (i = 1; i < 10 && isdigit((UCHAR) rest[i]); i++)
+				st->fr = st->fr * 10 + (rest[i] - '0');
 			for (; i < 10; i++)
-				rest[i] = '0';
-			rest[i] = '\0';
-			st->fr = atoi(&rest[1]);
+				st->fr *= 10;
 			break;
 		case 'B':
 			if (stricmp(rest, "BC") == 0)
@@ -478,6 +608,57 @@ static int getPrecisionPart(int precision, const char * precPart)
 	return atoi(fraction);
 }
 
+/*
+ *	[D day[s]][ HH:MM:SS[.fraction]], the usual output of a positive
+ *	day-time interval.
+ */
+static BOOL
+get_day_second(SQLINTERVAL itype, int precision, const char *str, SQL_INTERVAL_STRUCT *st)
+{
+	SIMPLE_TIME	stm;
+	const char	*cp, *tp = str, *frac = NULL;
+	int		days = 0;
+
+	if (NULL != (cp = get_digits(str, 9, &days)) && ' ' == *cp)
+	{
+		if (0 != strncmp(cp + 1, "day", 3))
+			return FALSE;
+		cp += 4;
+		if ('s' == *cp)
+			cp++;
+		if ('\0' == *cp)
+			tp = NULL;
+		else if (' ' != *cp)
+			return FALSE;
+		else
+			tp = cp + 1;
+	}
+	else
+		days = 0;
+	stm.hh = stm.mm = stm.ss = 0;
+	if (NULL != tp)
+	{
+		if (NULL == (cp = parse_iso_time(tp, &stm)))
+			return FALSE;
+		if ('.' == *cp)
+		{
+			for (frac = ++cp; isdigit((UCHAR) *cp); cp++)
+				;
+		}
+		if ('\0' != *cp)
+			return FALSE;
+	}
+	st->interval_type = itype;
+	st->interval_sign = SQL_FALSE;
+	st->intval.day_second.day = days;
+	st->intval.day_second.hour = stm.hh;
+	st->intval.day_second.minute = stm.mm;
+	st->intval.day_second.second = stm.ss;
+	if (NULL != frac)
+		st->intval.day_second.fraction = getPrecisionPart(precision, frac);
+	return TRUE;
+}
+
 static BOOL
 interval2istruct(SQLSMALLINT ctype, int precision, const char *str, SQL_INTERVAL_STRUCT *st)
 {
@@ -487,6 +668,12 @@ interval2istruct(SQLSMALLINT ctype, int precision, const char *str, SQL_INTERVAL
 	SQLINTERVAL	itype = interval2itype(ctype);
 
 	memset(st, 0, sizeof(SQL_INTERVAL_STRUCT));
+	if (0 != itype &&
+	    SQL_IS_YEAR != itype &&
+	    SQL_IS_MONTH != itype &&
+	    SQL_IS_YEAR_TO_MONTH != itype &&
+	    get_day_second(itype, precision, str, st))
+		return TRUE;
 	if ((scnt = sscanf(str, "%d-%d", &years, &mons)) >=2)
 	{
 		if (SQL_IS_YEAR_TO_MONTH == itype)
@@ -680,8 +867,14 @@ copy_and_convert_field_bindinfo(StatementClass *stmt, OID field_type, int atttyp
 		LENADDR_SHIFT(bic->used, offset), LENADDR_SHIFT(bic->indicator, offset));
 }
 
-static double get_double_value(const char *str)
+static double get_double_value(char *str)
 {
+	double	dval;
+
+	/* the plain decimal notation of the server */
+	if (parse_iso_double(str, &dval))
+		return dval;
+	set_client_decimal_point(str);
 	if (stricmp(str, NAN_STRING) == 0)
 #ifdef	NAN
 		return (double) NAN;
@@ -931,11 +1124,13 @@ mylog("null_cvt_date_string=%d\n", conn->connInfo.cvt_null_date_string);
 			 * PG_TYPE_CHAR,VARCHAR $$$
 			 */
 		case PG_TYPE_DATE:
-			sscanf(value, "%4d-%2d-%2d", &std_time.y, &std_time.m, &std_time.d);
+			if (NULL == parse_iso_date(value, &std_time))
+				sscanf(value, "%4d-%2d-%2d", &std_time.y, &std_time.m, &std_time.d);
 			break;
 
 		case PG_TYPE_TIME:
-			sscanf(value, "%2d:%2d:%2d", &std_time.hh, &std_time.mm, &std_time.ss);
+			if (NULL == parse_iso_time(value, &std_time))
+				sscanf(value, "%2d:%2d:%2d", &std_time.hh, &std_time.mm, &std_time.ss);
 			break;
 
 		case PG_TYPE_ABSTIME:
@@ -1247,25 +1442,66 @@ inolog("2stime fr=%d\n", std_time.fr);
 				if (fCType == SQL_C_WCHAR)
 					wconverted = TRUE;
 #endif /* UNICODE_SUPPORT */
-				if (pgdc->data_left < 0)
+				if (PG_TYPE_BYTEA == field_type)
 				{
-					BOOL lf_conv = conn->connInfo.lf_conversion;
-					if (PG_TYPE_BYTEA == field_type)
+					/*
+					 * The hex string is generated piece by piece from
+					 * the value, without a buffer for the whole string.
+					 */
+					BOOL	wide = FALSE;
+					int	unitlen = 1;
+
+#ifdef	UNICODE_SUPPORT
+					if (fCType == SQL_C_WCHAR)
+					{
+						wide = TRUE;
+						unitlen = WCLEN;
+					}
+#endif /* UNICODE_SUPPORT */
+					if (pgdc->data_left < 0)
 					{
 						if (hex_bin_format)
 							len = strlen(neut_str);
 						else
+							len = 2 * convert_from_pgbinary(neut_str, NULL, 0);
+						len *= unitlen;
+						if (cbValueMax == 0)		/* just returns length
+													 * info */
 						{
-							len = convert_from_pgbinary(neut_str, NULL, 0);
-							len *= 2;
+							result = COPY_RESULT_TRUNCATED;
+							break;
 						}
-						changed = TRUE;
-#ifdef	UNICODE_SUPPORT
-						if (fCType == SQL_C_WCHAR)
-							len *= WCLEN;
-#endif /* UNICODE_SUPPORT */
+						pgdc->src_pos = 0;
+						if (stmt->current_col >= 0)
+							pgdc->data_left = len;
 					}
 					else
+						len = pgdc->data_left;
+
+					if (cbValueMax > 0)
+					{
+						copy_len = (len >= cbValueMax) ? (cbValueMax - 1) : len;
+						copy_len /= unitlen;
+						/*
+						 * The count of the remaining digits is odd if the
+						 * previous call stopped in the middle of a byte.
+						 */
+						copy_len = unitlen * pgbinary_hex_piece(neut_str, hex_bin_format, &pgdc->src_pos, 0 != (len / unitlen) % 2, rgbValueBindRow, copy_len, wide);
+						/* Add null terminator */
+						if (copy_len + unitlen <= cbValueMax)
+							memset(rgbValueBindRow + copy_len, 0, unitlen);
+						/* Adjust data_left for next time */
+						if (stmt->current_col >= 0)
+							pgdc->data_left -= copy_len;
+					}
+					if (cbValueMax > 0 && len + unitlen > cbValueMax)
+						result = COPY_RESULT_TRUNCATED;
+					mylog("    bytea, default: len = %d, cbValueMax = %d, copy_len = %d\n", len, cbValueMax, copy_len);
+					break;
+				}
+				if (pgdc->data_left < 0)
+				{
+					BOOL lf_conv = conn->connInfo.lf_conversion;
 #ifdef	UNICODE_SUPPORT
 					if (fCType == SQL_C_WCHAR)
 					{
@@ -1322,31 +1558,9 @@ inolog("2stime fr=%d\n", std_time.fr);
 						}
 #ifdef	UNICODE_SUPPORT
 						if (fCType == SQL_C_WCHAR)
-						{
-							if (PG_TYPE_BYTEA == field_type && !hex_bin_format)
-							{
-								len = convert_from_pgbinary(neut_str, pgdc->ttlbuf, pgdc->ttlbuflen);
-								len = pg_bin2whex(pgdc->ttlbuf, (SQLWCHAR *) pgdc->ttlbuf, len);
-							}
-							else
-								utf8_to_ucs2_lf(neut_str, SQL_NTS, lf_conv, (SQLWCHAR *) pgdc->ttlbuf, len / WCLEN);
-						}
+							utf8_to_ucs2_lf(neut_str, SQL_NTS, lf_conv, (SQLWCHAR *) pgdc->ttlbuf, len / WCLEN);
 						else
 #endif /* UNICODE_SUPPORT */
-						if (PG_TYPE_BYTEA == field_type)
-						{
-							if (hex_bin_format)
-							{
-								len = strlen(neut_str);
-								strncpy_null(pgdc->ttlbuf, neut_str, pgdc->ttlbuflen);
-							}
-							else
-							{
-								len = convert_from_pgbinary(neut_str, pgdc->ttlbuf, pgdc->ttlbuflen);
-								len = pg_bin2hex(pgdc->ttlbuf, pgdc->ttlbuf, len);
-							} 
-						}
-						else
 #ifdef	WIN_UNICODE_SUPPORT
 						if (localize_needed)
 						{
@@ -1576,96 +1790,36 @@ inolog("2stime fr=%d\n", std_time.fr);
 				break;
 
 			case SQL_C_FLOAT:
-				set_client_decimal_point((char *) neut_str);
 				len = 4;
 				if (bind_size > 0)
-					*((SFLOAT *) rgbValueBindRow) = (float) get_double_value(neut_str);
+					*((SFLOAT *) rgbValueBindRow) = (float) get_double_value((char *) neut_str);
 				else
-					*((SFLOAT *) rgbValue + bind_row) = (float) get_double_value(neut_str);
+					*((SFLOAT *) rgbValue + bind_row) = (float) get_double_value((char *) neut_str);
 				break;
 
 			case SQL_C_DOUBLE:
-				set_client_decimal_point((char *) neut_str);
 				len = 8;
 				if (bind_size > 0)
-					*((SDOUBLE *) rgbValueBindRow) = get_double_value(neut_str);
+					*((SDOUBLE *) rgbValueBindRow) = get_double_value((char *) neut_str);
 				else
-					*((SDOUBLE *) rgbValue + bind_row) = get_double_value(neut_str);
+					*((SDOUBLE *) rgbValue + bind_row) = get_double_value((char *) neut_str);
 				break;
 
 #if (ODBCVER >= 0x0300)
                         case SQL_C_NUMERIC:
 			{
 			SQL_NUMERIC_STRUCT      *ns;
-			int	i, nlen, bit, hval, tv, dig, sta, olen;
-			char	calv[SQL_MAX_NUMERIC_LEN * 3];
-			const char *wv;
-			BOOL	dot_exist;
 
 			len = sizeof(SQL_NUMERIC_STRUCT);
 			if (bind_size > 0)
 				ns = (SQL_NUMERIC_STRUCT *) rgbValueBindRow;
 			else
 				ns = (SQL_NUMERIC_STRUCT *) rgbValue + bind_row;
-			for (wv = neut_str; *wv && isspace(*wv); wv++)
-				;
-			ns->sign = 1;
-			if (*wv == '-')
-			{
-				ns->sign = 0;
-				wv++;
-			}
-			else if (*wv == '+')
-				wv++;
-			while (*wv == '0') wv++;
-			ns->precision = 0;
-			ns->scale = 0;
-			for (nlen = 0, dot_exist = FALSE;; wv++) 
-			{
-				if (*wv == '.')
-				{
-					if (dot_exist)
-						break;
-					dot_exist = TRUE;
-				}
-				else if (!isdigit(*wv))
-						break;
-				else
-				{
-					if (dot_exist)
-						ns->scale++;
-					ns->precision++;
-					calv[nlen++] = *wv;
-				}
-			}
-			memset(ns->val, 0, sizeof(ns->val));
-			for (hval = 0, bit = 1L, sta = 0, olen = 0; sta < nlen;)
+			if (!string_to_numeric(neut_str, ns))
 			{
-				for (dig = 0, i = sta; i < nlen; i++)
-				{
-					tv = dig * 10 + calv[i] - '0';
-					dig = tv % 2;
-					calv[i] = tv / 2 + '0';
-					if (i == sta && tv < 2)
-						sta++;
-				}
-				if (dig > 0)
-					hval |= bit;
-				bit <<= 1;
-				if (bit >= (1L << 8))
-				{
-					ns->val[olen++] = hval;
-					hval = 0;
-					bit = 1L;
-					if (olen >= SQL_MAX_NUMERIC_LEN - 1)
-					{
-						ns->scale = sta - ns->precision;
-						break;
-					}
-				} 
+				SC_set_error(stmt, STMT_VALUE_OUT_OF_RANGE, "The numeric value doesn't fit in SQL_NUMERIC_STRUCT", func);
+				return COPY_GENERAL_ERROR;
 			}
-			if (hval && olen < SQL_MAX_NUMERIC_LEN - 1)
-				ns->val[olen++] = hval;
 			}
 			break;
 #endif /* ODBCVER */
@@ -1789,7 +1943,10 @@ inolog("SQL_C_VARBOOKMARK value=%d\n", ival);
 					return COPY_UNSUPPORTED_TYPE;
 				}
 				/* truncate if necessary */
-				/* convert octal escapes to bytes */
+				/*
+				 * convert octal escapes to bytes, only the piece
+				 * returned by this call
+				 */
 
 				if (stmt->current_col < 0)
 				{
@@ -1798,52 +1955,28 @@ inolog("SQL_C_VARBOOKMARK value=%d\n", ival);
 				}
 				else
 					pgdc = &gdata->gdata[stmt->current_col];
-				if (!pgdc->ttlbuf)
-					pgdc->ttlbuflen = 0;
 				if (pgdc->data_left < 0)
 				{
+					len = convert_from_pgbinary(neut_str, NULL, 0);
 					if (cbValueMax <= 0)
 					{
-						len = convert_from_pgbinary(neut_str, NULL, 0);
 						result = COPY_RESULT_TRUNCATED;
 						break;
 					}
-					if (len = strlen(neut_str), len >= (int) pgdc->ttlbuflen)
-					{
-						pgdc->ttlbuf = realloc(pgdc->ttlbuf, len + 1);
-						pgdc->ttlbuflen = len + 1;
-					}
-					len = convert_from_pgbinary(neut_str, pgdc->ttlbuf, pgdc->ttlbuflen);
-					pgdc->ttlbufused = len;
-				}
-				else
-					len = pgdc->ttlbufused;
-				ptr = pgdc->ttlbuf;
-
-				if (stmt->current_col >= 0)
-				{
-					/*
-					 * Second (or more) call to SQLGetData so move the
-					 * pointer
-					 */
-					if (pgdc->data_left > 0)
-					{
-						ptr += len - pgdc->data_left;
-						len = pgdc->data_left;
-					}
-
+					pgdc->src_pos = 0;
 					/* First call to SQLGetData so initialize data_left */
-					else
+					if (stmt->current_col >= 0)
 						pgdc->data_left = len;
-
 				}
+				else
+					len = pgdc->data_left;
 
 				if (cbValueMax > 0)
 				{
 					copy_len = (len > cbValueMax) ? cbValueMax : len;
 
-					/* Copy the data */
-					memcpy(rgbValueBindRow, ptr, copy_len);
+					/* Decode the data */
+					decode_pgbinary_piece(neut_str, &pgdc->src_pos, rgbValueBindRow, copy_len);
 
 					/* Adjust data_left for next time */
 					if (stmt->current_col >= 0)
@@ -1856,11 +1989,6 @@ inolog("SQL_C_VARBOOKMARK value=%d\n", ival);
 				 */
 				if (len > cbValueMax)
 					result = COPY_RESULT_TRUNCATED;
-				else if (pgdc->ttlbuf)
-				{
-					free(pgdc->ttlbuf);
-					pgdc->ttlbuf = NULL;
-				}
 				mylog("SQL_C_BINARY: len = %d, copy_len = %d\n", len, copy_len);
 				break;
 #if (ODBCVER >= 0x0350)
@@ -1945,10 +2073,12 @@ typedef struct _QueryParse {
 	size_t		declare_pos;
 	UInt4		flags, comment_level;
 	encoded_str	encstr;
+	const QueryTokens	*tokens;	/* of the statement if lexed */
+	Int4		tokidx;
 }	QueryParse;
 
 static void
-QP_initialize(QueryParse *q, const StatementClass *stmt)
+QP_initialize(QueryParse *q, StatementClass *stmt)
 {
 	q->statement = stmt->execute_statement ? stmt->execute_statement : stmt->statement;
 	q->statement_type = stmt->statement_type;
@@ -1967,6 +2097,39 @@ QP_initialize(QueryParse *q, const StatementClass *stmt)
 	q->flags = 0;
 	q->comment_level = 0;
 	make_encoded_str(&q->encstr, SC_get_conn(stmt), q->statement);
+	q->tokens = (q->statement == stmt->statement) ? SC_get_tokens(stmt) : NULL;
+	q->tokidx = 0;
+}
+
+/*
+ *	The token starting at the current position if it's a literal, a
+ *	quoted identifier or a comment, which are copied as they are.
+ */
+static const QueryToken *
+QP_verbatim_token(QueryParse *qp)
+{
+	const QueryTokens	*qt = qp->tokens;
+	const QueryToken	*tok;
+	Int4	opos = (Int4) qp->opos;
+
+	if (NULL == qt ||
+	    qp->in_literal || qp->in_identifier || qp->in_escape ||
+	    qp->in_dollar_quote || qp->in_line_comment ||
+	    qp->comment_level > 0)
+		return NULL;
+	/* the position mostly moves forward token by token */
+	if (qp->tokidx >= qt->ntokens ||
+	    qt->tokens[qp->tokidx].pos > opos)
+		qp->tokidx = QT_token_at(qt, opos);
+	while (qp->tokidx < qt->ntokens &&
+	       qt->tokens[qp->tokidx].pos + qt->tokens[qp->tokidx].len <= opos)
+		qp->tokidx++;
+	if (qp->tokidx >= qt->ntokens)
+		return NULL;
+	tok = qt->tokens + qp->tokidx;
+	if (tok->pos != opos || tok->type < QTOK_LITERAL)
+		return NULL;
+	return tok;
 }
 
 #define	FLGB_PRE_EXECUTING	1L
@@ -2742,8 +2905,10 @@ RETCODE	prep_params(StatementClass *stmt, QueryParse *qp, QueryBuild *qb, BOOL s
 	char		plan_name[32];
 	po_ind_t	multi;
 	int		func_cs_count = 0;
-	const char	*orgquery = NULL, *srvquery = NULL;
-	Int4		endp1, endp2;
+	const char	*srvquery = NULL;
+	const QueryTokens	*orgtokens = NULL;
+	QueryTokens	*srvtokens = NULL;
+	Int4		orgpos = 0, srvpos = 0, endp1, endp2;
 	SQLSMALLINT	num_pa = 0, num_p1, num_p2;
 
 inolog("prep_params\n");
@@ -2771,12 +2936,32 @@ inolog("prep_params\n");
 
 	stmt->current_exec_param = 0;
 	multi = stmt->multi_statement;
+	if (multi > 0 && !sync)
+	{
+		/*
+		 * SC_execute() pipelines Parse, Bind, Describe and Execute
+		 * requests of all the commands, keep the converted query for it.
+		 */
+		stmt->stmt_with_params = qb->query_statement;
+		qb->query_statement = NULL;
+		SC_set_planname(stmt, NULL_STRING);
+		SC_set_prepared(stmt, PREPARING_TEMPORARILY);
+		retval = SQL_SUCCESS;
+		goto cleanup;
+	}
 	if (multi > 0)
 	{
-		orgquery = stmt->statement;
-		SC_scanQueryAndCountParams(orgquery, conn, &endp1, &num_p1, NULL, NULL);
+		/* split both the original and the converted queries into commands */
+		orgtokens = SC_get_tokens(stmt);
+		srvtokens = QT_lex(qb->query_statement, conn->ccsc, CC_get_escape(conn));
+		if (NULL == orgtokens || NULL == srvtokens)
+		{
+			SC_set_error(stmt, STMT_NO_MEMORY_ERROR, "Couldn't scan the statement", func);
+			goto cleanup;
+		}
+		QT_scanQueryAndCountParams(orgtokens, orgpos, &endp1, &num_p1, NULL, NULL);
 		srvquery = qb->query_statement;
-		SC_scanQueryAndCountParams(srvquery, conn, &endp2, NULL, NULL, NULL);
+		QT_scanQueryAndCountParams(srvtokens, srvpos, &endp2, NULL, NULL, NULL);
 		mylog("%s:SendParseRequest for the first command length=%d(%d) num_p=%d\n", func, endp2, endp1, num_p1);
 		ret = SendParseRequest(stmt, plan_name, srvquery, endp2, num_p1);
 	}
@@ -2793,12 +2978,38 @@ inolog("prep_params\n");
 		retval = SQL_SUCCESS;
 		goto cleanup;
 	}
+	/* pipeline the subsequent commands, all are described by one Sync */
+	while (multi > 0)
+	{
+		orgpos += (endp1 + 1);
+		srvpos += (endp2 + 1);
+		srvquery = qb->query_statement + srvpos;
+		num_pa += num_p1;
+		QT_scanQueryAndCountParams(orgtokens, orgpos, &endp1, &num_p1, &multi, NULL);
+		QT_scanQueryAndCountParams(srvtokens, srvpos, &endp2, &num_p2, NULL, NULL);
+		mylog("%s:SendParseRequest for the subsequent command length=%d(%d) num_p=%d\n", func, endp2, endp1, num_p1);
+		if (num_p2 > 0)
+		{
+			stmt->current_exec_param = num_pa;
+			ret = SendParseRequest(stmt, plan_name, srvquery, endp2 < 0 ? SQL_NTS : endp2, num_p1);
+			if (!ret)	goto cleanup;
+			if (!once_descr && !SendDescribeRequest(stmt, plan_name, TRUE))
+				goto cleanup;
+		}
+	}
+	stmt->current_exec_param = 0;
 	if (!(res = SendSyncAndReceive(stmt, NULL, "prepare_and_describe")))
 	{
 		SC_set_error(stmt, STMT_NO_RESPONSE, "commnication error while preapreand_describe", func);
 		CC_on_abort(conn, CONN_DEAD);
 		goto cleanup;
 	}
+	/* keep the description of the first command only */
+	if (NULL != res->next)
+	{
+		QR_Destructor(res->next);
+		res->next = NULL;
+	}
 	if (once_descr)
 		dest_res = res;
 	else
@@ -2808,40 +3019,12 @@ inolog("prep_params\n");
 		SC_set_error(stmt, STMT_EXEC_ERROR, "Error while preparing parameters", func);
 		goto cleanup;
 	}
-	if (stmt->multi_statement <= 0)
-	{
-		retval = SQL_SUCCESS;
-		goto cleanup;
-	}
-	while (multi > 0)
-	{
-		orgquery += (endp1 + 1);
-		srvquery += (endp2 + 1);
-		num_pa += num_p1;
-		SC_scanQueryAndCountParams(orgquery, conn, &endp1, &num_p1, &multi, NULL);
-		SC_scanQueryAndCountParams(srvquery, conn, &endp2, &num_p2, NULL, NULL);
-		mylog("%s:SendParseRequest for the subsequent command length=%d(%d) num_p=%d\n", func, endp2, endp1, num_p1);
-		if (num_p2 > 0)
-		{
-			stmt->current_exec_param = num_pa;
-			ret = SendParseRequest(stmt, plan_name, srvquery, endp2 < 0 ? SQL_NTS : endp2, num_p1);
-			if (!ret)	goto cleanup;
-			if (!once_descr && !SendDescribeRequest(stmt, plan_name, TRUE))
-				goto cleanup;
-			if (!(res = SendSyncAndReceive(stmt, NULL, "prepare_and_describe")))
-			{
-				SC_set_error(stmt, STMT_NO_RESPONSE, "commnication error while preapreand_describe", func);
-				CC_on_abort(conn, CONN_DEAD);
-				goto cleanup;
-			}
-			QR_Destructor(res);
-		}
-	}
 	retval = SQL_SUCCESS;
 cleanup:
 #undef	return
 	if (dest_res)
 		QR_Destructor(dest_res);
+	QT_Destructor(srvtokens);
 	CLEANUP_FUNC_CONN_CS(func_cs_count, conn);
 	stmt->current_exec_param = -1;
 	QB_Destructor(qb);
@@ -3283,6 +3466,7 @@ inner_process_tokens(QueryParse *qp, QueryBuild *qb)
 	char	   oldchar;
 	StatementClass	*stmt = qb->stmt;
 	char	literal_quote = LITERAL_QUOTE, dollar_quote = DOLLAR_QUOTE, escape_in_literal = '\0';
+	const QueryToken	*tok;
 
 	if (stmt && stmt->ntab > 0)
 		bestitem = GET_NAME(stmt->ti[0]->bestitem);
@@ -3324,6 +3508,14 @@ inner_process_tokens(QueryParse *qp, QueryBuild *qb)
 			CVT_APPEND_DATA(qb, qp->statement + qp->from_pos + 5, qp->where_pos - qp->from_pos - 5);
 		}
 	}
+	/* Copy the quoted stuff and the comments at once */
+	if (tok = QP_verbatim_token(qp), NULL != tok)
+	{
+		CVT_APPEND_DATA(qb, F_OldPtr(qp), tok->len);
+		qp->opos += (tok->len - 1);
+		qp->encstr.ccst = 0;
+		return SQL_SUCCESS;
+	}
 	oldchar = encoded_byte_check(&qp->encstr, qp->opos);
 	if (ENCODE_STATUS(qp->encstr) != 0)
 	{
@@ -3650,7 +3842,7 @@ cleanup:
 }
 
 #define	MIN_ALC_SIZE	128
-BOOL	BuildBindRequest(StatementClass *stmt, const char *plan_name)
+BOOL	BuildBindRequest(StatementClass *stmt, const char *plan_name, Int2 num_bind)
 {
 	CSTR func = "BuildBindRequest";
 	QueryBuild	qb;
@@ -3658,12 +3850,13 @@ BOOL	BuildBindRequest(StatementClass *stmt, const char *plan_name)
 	UInt4		netleng;
 	SQLSMALLINT	num_p;
 	Int2		netnum_p;
-	int		i, num_params;
+	int		i, num_params, sta_pidx, end_pidx;
 	char		*bindreq;
 	ConnectionClass	*conn = SC_get_conn(stmt);
 	BOOL		ret = TRUE, sockerr = FALSE, discard_output;
 	RETCODE		retval;
 	const		IPDFields *ipdopts = SC_get_IPDF(stmt);
+	const		APDFields *apdopts = SC_get_APDF(stmt);
 
 	num_params = stmt->num_params;
 	if (num_params < 0)
@@ -3676,6 +3869,16 @@ BOOL	BuildBindRequest(StatementClass *stmt, const char *plan_name)
 		SC_set_error(stmt, STMT_COUNT_FIELD_INCORRECT, "The # of binded parameters < the # of parameter markers", func);
 		return FALSE;
 	}
+	/* bind all the parameters or num_bind ones from current_exec_param */
+	sta_pidx = 0;
+	end_pidx = num_params - 1;
+	if (num_bind >= 0)
+	{
+		sta_pidx = stmt->current_exec_param;
+		end_pidx = sta_pidx + num_bind - 1;
+		if (end_pidx >= num_params)
+			end_pidx = num_params - 1;
+	}
         plen = strlen(plan_name);
 	netleng = sizeof(netleng)	/* length fields */
 		  + 2 * (plen + 1)	/* portal name/plan name */
@@ -3696,6 +3899,18 @@ BOOL	BuildBindRequest(StatementClass *stmt, const char *plan_name)
         leng += (plen + 1);
 inolog("num_params=%d proc_return=%d\n", num_params, stmt->proc_return);
         num_p = num_params - qb.num_discard_params;
+	if (num_bind >= 0)
+	{
+		int	pidx;
+
+		for (num_p = 0, pidx = sta_pidx - 1;;)
+		{
+			SC_param_next(stmt, &pidx, NULL, NULL);
+			if (pidx > end_pidx)
+				break;
+			num_p++;
+		}
+	}
 inolog("num_p=%d\n", num_p);
 	discard_output = (0 != (qb.flags & FLGB_DISCARD_OUTPUT));
         netnum_p = htons(num_p);	/* Network byte order */
@@ -3710,7 +3925,7 @@ inolog("num_p=%d\n", num_p);
         	leng += sizeof(Int2);
 		if (num_p > 0)
         		memset(bindreq + leng, 0, sizeof(Int2) * num_p);  /* initialize by text format */
-		for (i = stmt->proc_return, j = 0; i < num_params; i++)
+		for (i = sta_pidx > stmt->proc_return ? sta_pidx : stmt->proc_return, j = 0; i <= end_pidx; i++)
 		{
 inolog("%dth parameter type oid is %u\n", i, PIC_dsp_pgtype(conn, parameters[i]));
 			if (discard_output &&
@@ -3722,6 +3937,20 @@ inolog("%dth parameter type oid is %u\n", i, PIC_dsp_pgtype(conn, parameters[i])
 				memcpy(bindreq + leng + sizeof(Int2) * j,
         			&net_one, sizeof(net_one));  /* binary */
 			}
+#if (ODBCVER >= 0x0300)
+			/*
+			 * SQL_NUMERIC_STRUCT maps to the binary numeric directly,
+			 * provided the server described the parameter as numeric.
+			 */
+			else if (PG_TYPE_NUMERIC == PIC_get_pgtype(parameters[i]) &&
+				 i < apdopts->allocated &&
+				 SQL_C_NUMERIC == apdopts->parameters[i].CType)
+			{
+				mylog("%dth parameter is of binary numeric format\n", j);
+				memcpy(bindreq + leng + sizeof(Int2) * j,
+        			&net_one, sizeof(net_one));  /* binary */
+			}
+#endif /* ODBCVER */
 			j++; 
 		}
 		leng += sizeof(Int2) * num_p;
@@ -3734,7 +3963,8 @@ inolog("%dth parameter type oid is %u\n", i, PIC_dsp_pgtype(conn, parameters[i])
         memcpy(bindreq + leng, &netnum_p, sizeof(netnum_p)); /* number of params */
         leng += sizeof(Int2); /* must be 2 */
         qb.npos = leng;
-        for (i = 0; i < stmt->num_params; i++)
+	qb.param_number = sta_pidx - 1;
+        for (i = sta_pidx; i <= end_pidx; i++)
 	{
                 retval = ResolveOneParam(&qb, NULL);
 		if (SQL_ERROR == retval)
@@ -3753,7 +3983,8 @@ inolog("bind leng=%d\n", leng);
         memcpy(qb.query_statement, &netleng, sizeof(netleng));
 	if (CC_is_in_trans(conn) && !SC_accessed_db(stmt))
 	{
-		if (SQL_ERROR == SetStatementSvp(stmt))
+		if (SQL_ERROR == SetStatementSvp(stmt) ||
+		    !CC_queue_pending_svp(conn))
 		{
 			SC_set_error(stmt, STMT_INTERNAL_ERROR, "internal savepoint error in SendBindRequest", func);
 			ret = FALSE;
@@ -3767,6 +3998,7 @@ inolog("bind leng=%d\n", leng);
 		sockerr = TRUE;
 		goto cleanup;
 	}
+	/* the parameter values were copied into qb, see SOCK_put_n_char() */
         SOCK_put_n_char(conn->sock, qb.query_statement, leng);
 	if (SOCK_get_errcode(conn->sock) != 0)
 		sockerr = TRUE;
@@ -3783,136 +4015,282 @@ cleanup:
 }
 
 #if (ODBCVER >= 0x0300)
-static BOOL
-ResolveNumericParam(const SQL_NUMERIC_STRUCT *ns, char *chrform)
+/*
+ *	SQL_NUMERIC_STRUCT conversion.
+ *
+ *	The 128-bit little endian mantissa is handled as 16-bit limbs and
+ *	the decimal side 4 digits at a time, i.e. in base 10000 which is
+ *	also the digit base of the binary format of the numeric type.
+ */
+#define	NUMERIC_LIMBS		(SQL_MAX_NUMERIC_LEN / 2)
+#define	NUMERIC_NBASE		10000
+#define	NUMERIC_MAX_NBASE_DIGITS	10	/* 2^128 < 10000^10 */
+#define	NUMERIC_MAX_DIGITS	39	/* 2^128 < 10^39 */
+#define	NUMERIC_POS		0x0000
+#define	NUMERIC_NEG		0x4000
+
+/* the # of the mantissa bytes which can hold the precision */
+static int
+numeric_val_len(int precision)
 {
 	static const int prec[] = {1, 3, 5, 8, 10, 13, 15, 17, 20, 22, 25, 27, 29, 32, 34, 37, 39};
-	Int4	i, j, k, ival, vlen, len, newlen;
-	UCHAR		calv[40];
-	const UCHAR	*val = (const UCHAR *) ns->val;
-	BOOL	next_figure;
+	int	i;
 
-inolog("C_NUMERIC [prec=%d scale=%d]", ns->precision, ns->scale);
-	if (0 == ns->precision)
+	for (i = 0; i < SQL_MAX_NUMERIC_LEN && prec[i] <= precision; i++)
+		;
+	return i;
+}
+
+/*
+ * Convert the first vlen bytes of the mantissa to base 10000 digits,
+ * the least significant first.  Returns the # of the digits, 0 for zero.
+ */
+static int
+numeric_val_to_nbase(const SQLCHAR *val, int vlen, UInt2 *digits)
+{
+	UInt4	limbs[NUMERIC_LIMBS], cur, rem;
+	int	i, nlimbs, ndigits = 0;
+
+	memset(limbs, 0, sizeof(limbs));
+	for (i = 0; i < vlen; i++)
+		limbs[i / 2] |= ((UInt4) val[i]) << (8 * (i % 2));
+	for (nlimbs = NUMERIC_LIMBS; nlimbs > 0 && 0 == limbs[nlimbs - 1]; nlimbs--)
+		;
+	while (nlimbs > 0)
 	{
-		strcpy(chrform, "0");
-		return TRUE;
+		for (i = nlimbs - 1, rem = 0; i >= 0; i--)
+		{
+			cur = (rem << 16) | limbs[i];
+			limbs[i] = cur / NUMERIC_NBASE;
+			rem = cur % NUMERIC_NBASE;
+		}
+		digits[ndigits++] = (UInt2) rem;
+		if (0 == limbs[nlimbs - 1])
+			nlimbs--;
 	}
-	else if (ns->precision < prec[sizeof(Int4)])
-	{
-		for (i = 0, ival = 0; i < sizeof(Int4) && prec[i] <= ns->precision; i++)
+	return ndigits;
+}
+
+/*
+ * Convert ndigits decimal digit characters to the mantissa.
+ * Returns FALSE if the value doesn't fit in 128 bits.
+ */
+static BOOL
+numeric_digits_to_val(const char *digits, int ndigits, SQLCHAR *val)
+{
+	static const UInt4 pow10[] = {1, 10, 100, 1000, 10000};
+	UInt4	limbs[NUMERIC_LIMBS], cur, carry;
+	int	i, j, n;
+
+	memset(limbs, 0, sizeof(limbs));
+	for (i = 0; i < ndigits; i += n)
+	{
+		/* the first group takes the odd digits */
+		n = (0 == i && 0 != ndigits % 4) ? ndigits % 4 : 4;
+		for (j = 0, carry = 0; j < n; j++)
+			carry = carry * 10 + (digits[i + j] - '0');
+		for (j = 0; j < NUMERIC_LIMBS; j++)
 		{
-inolog("(%d)", val[i]);
-			ival += (val[i] << (8 * i)); /* ns->val is little endian */
+			cur = limbs[j] * pow10[n] + carry;
+			limbs[j] = cur & 0xffff;
+			carry = cur >> 16;
 		}
-inolog(" ival=%d,%d", ival, (val[3] << 24) | (val[2] << 16) | (val[1] << 8) | val[0]);
-		if (0 == ns->scale)
+		if (0 != carry)
+			return FALSE;
+	}
+	for (i = 0; i < SQL_MAX_NUMERIC_LEN; i++)
+		val[i] = (SQLCHAR) (limbs[i / 2] >> (8 * (i % 2)));
+	return TRUE;
+}
+
+/*
+ * Convert the numeric text of the server to SQL_NUMERIC_STRUCT.
+ * The fraction digits which don't fit are dropped, FALSE is returned
+ * if the integral part doesn't fit.
+ */
+BOOL
+string_to_numeric(const char *str, SQL_NUMERIC_STRUCT *ns)
+{
+	char	calv[NUMERIC_MAX_DIGITS + 1];
+	int	nlen, scale;
+	BOOL	dot_exist;
+
+	while (isspace((UCHAR) *str))
+		str++;
+	ns->sign = 1;
+	if ('-' == *str)
+	{
+		ns->sign = 0;
+		str++;
+	}
+	else if ('+' == *str)
+		str++;
+	while ('0' == *str)
+		str++;
+	for (nlen = 0, scale = 0, dot_exist = FALSE;; str++)
+	{
+		if ('.' == *str)
 		{
-			if (0 == ns->sign)
-				ival *= -1;
-			sprintf(chrform, "%d", ival);
+			if (dot_exist)
+				break;
+			dot_exist = TRUE;
 		}
-		else if (ns->scale > 0)
+		else if (!isdigit((UCHAR) *str))
+			break;
+		else if (nlen < sizeof(calv))
 		{
-			Int4	i, div, o1val, o2val;
-
-			for (i = 0, div = 1; i < ns->scale; i++)
-				div *= 10;
-			o1val = ival / div;
-			o2val = ival % div;
-			if (0 == ns->sign)
-				sprintf(chrform, "-%d.%0*d", o1val, ns->scale, o2val);
-			else
-				sprintf(chrform, "%d.%0*d", o1val, ns->scale, o2val);
+			if (dot_exist)
+				scale++;
+			calv[nlen++] = *str;
 		}
-inolog(" convval=%s\n", chrform);
-		return TRUE;
+		else if (!dot_exist)
+			return FALSE;
 	}
+	for (;;)
+	{
+		if (nlen <= NUMERIC_MAX_DIGITS &&
+		    numeric_digits_to_val(calv, nlen, ns->val))
+			break;
+		if (0 == scale)
+			return FALSE;
+		nlen--;
+		scale--;
+	}
+	ns->precision = nlen;
+	ns->scale = scale;
+	return TRUE;
+}
 
-	for (i = 0; i < SQL_MAX_NUMERIC_LEN && prec[i] <= ns->precision; i++)
-		;
-	vlen = i;
+/*
+ * Convert SQL_NUMERIC_STRUCT to the decimal text.  Only the mantissa
+ * bytes the precision requires are looked at.  Returns FALSE if the
+ * result doesn't fit in size bytes.
+ */
+BOOL
+ResolveNumericParam(const SQL_NUMERIC_STRUCT *ns, char *chrform, size_t size)
+{
+	UInt2	digits[NUMERIC_MAX_NBASE_DIGITS];
+	char	calv[NUMERIC_MAX_NBASE_DIGITS * 4];
+	int	i, len, ndigits, scale = ns->scale;
+	size_t	newlen = 0;
+	UInt2	dig;
+
+inolog("C_NUMERIC [prec=%d scale=%d]", ns->precision, ns->scale);
+	if (0 == ns->precision)
+	{
+		strncpy_null(chrform, "0", size);
+		return TRUE;
+	}
+	ndigits = numeric_val_to_nbase(ns->val, numeric_val_len(ns->precision), digits);
+	/* the most significant group has no leading zeros */
 	len = 0;
-	memset(calv, 0, sizeof(calv));
-inolog(" len1=%d", vlen);
-	for (i = vlen - 1; i >= 0; i--)
+	if (0 == ndigits)
+		calv[len++] = '0';
+	else
 	{
-		for (j = len - 1; j >= 0; j--)
-		{
-			if (!calv[j])
-				continue;
-			ival = (((Int4)calv[j]) << 8);
-			calv[j] = (ival % 10);
-			ival /= 10;
-			calv[j + 1] += (ival % 10);
-			ival /= 10;
-			calv[j + 2] += (ival % 10);
-			ival /= 10;
-			calv[j + 3] += ival;
-			for (k = j;; k++)
-			{
-				next_figure = FALSE;
-				if (calv[k] > 0)
-				{
-					if (k >= len)
-						len = k + 1;
-					while (calv[k] > 9)
-					{
-						calv[k + 1]++;
-						calv[k] -= 10;
-						next_figure = TRUE;
-					}
-				}
-				if (k >= j + 3 && !next_figure)
-					break;
-			}
-		}
-		ival = val[i];
-		if (!ival)
-			continue;
-		calv[0] += (ival % 10);
-		ival /= 10;
-		calv[1] += (ival % 10);
-		ival /= 10;
-		calv[2] += ival;
-		for (j = 0;; j++)
-		{
-			next_figure = FALSE;
-			if (calv[j] > 0)
-			{
-				if (j >= len)
-					len = j + 1;
-				while (calv[j] > 9)
-				{
-					calv[j + 1]++;
-					calv[j] -= 10;
-					next_figure = TRUE;
-				}
-			}
-			if (j >= 2 && !next_figure)
-				break;
-		}
+		for (dig = digits[ndigits - 1]; dig > 0; dig /= 10)
+			len++;
+		for (i = len - 1, dig = digits[ndigits - 1]; i >= 0; i--, dig /= 10)
+			calv[i] = '0' + dig % 10;
 	}
-inolog(" len2=%d", len);
-	newlen = 0;
+	for (i = ndigits - 2; i >= 0; i--, len += 4)
+	{
+		dig = digits[i];
+		calv[len + 3] = '0' + dig % 10;
+		dig /= 10;
+		calv[len + 2] = '0' + dig % 10;
+		dig /= 10;
+		calv[len + 1] = '0' + dig % 10;
+		calv[len] = '0' + dig / 10;
+	}
+	/* sign, digits, "0." and zeros the scale requires and '\0' */
+	if (1 + (scale <= 0 ? len - scale : (len > scale ? len : scale + 1) + 1) + 1 > size)
+		return FALSE;
 	if (0 == ns->sign)
 		chrform[newlen++] = '-';
-	if (i = len - 1, i < ns->scale)
-		i = ns->scale;
-	for (; i >= ns->scale; i--)
-		chrform[newlen++] = calv[i] + '0';
-	if (ns->scale > 0)
+	if (scale <= 0)
+	{
+		memcpy(chrform + newlen, calv, len);
+		newlen += len;
+		for (; scale < 0 && ndigits > 0; scale++)
+			chrform[newlen++] = '0';
+	}
+	else if (len > scale)
 	{
+		memcpy(chrform + newlen, calv, len - scale);
+		newlen += len - scale;
 		chrform[newlen++] = '.';
-		for (; i >= 0; i--)
-			chrform[newlen++] = calv[i] + '0';
+		memcpy(chrform + newlen, calv + len - scale, scale);
+		newlen += scale;
 	}
-	if (0 == len)
+	else
+	{
 		chrform[newlen++] = '0';
+		chrform[newlen++] = '.';
+		for (i = len; i < scale; i++)
+			chrform[newlen++] = '0';
+		memcpy(chrform + newlen, calv, len);
+		newlen += len;
+	}
 	chrform[newlen] = '\0';
-inolog(" convval(2) len=%d %s\n", newlen, chrform);
+inolog(" convval=%s\n", chrform);
 	return TRUE;
 }
+
+/*
+ * Convert SQL_NUMERIC_STRUCT to the binary format of the numeric type,
+ * int16 ndigits, weight, sign, dscale and the base 10000 digits, the
+ * most significant first.  binform must have NUMERIC_BINARY_MAXLEN
+ * bytes.  Returns the length.
+ */
+int
+ResolveNumericBinary(const SQL_NUMERIC_STRUCT *ns, char *binform)
+{
+	UInt2	digits[NUMERIC_MAX_NBASE_DIGITS + 1], header[4], dig;
+	UInt4	cur, carry, mul;
+	int	i, ndigits, first, shift, scale = ns->scale, len;
+
+	ndigits = 0;
+	if (0 != ns->precision)
+		ndigits = numeric_val_to_nbase(ns->val, numeric_val_len(ns->precision), digits);
+	header[3] = htons((UInt2) (scale > 0 ? scale : 0));	/* dscale */
+	if (0 == ndigits)
+	{
+		header[0] = header[1] = 0;
+		header[2] = htons(NUMERIC_POS);
+		memcpy(binform, header, sizeof(header));
+		return sizeof(header);
+	}
+	/* multiply by 10^shift so that the decimal point is on a group boundary */
+	shift = ((-scale) % 4 + 4) % 4;
+	if (shift > 0)
+	{
+		for (i = 0, mul = 1; i < shift; i++)
+			mul *= 10;
+		for (i = 0, carry = 0; i < ndigits; i++)
+		{
+			cur = digits[i] * mul + carry;
+			digits[i] = cur % NUMERIC_NBASE;
+			carry = cur / NUMERIC_NBASE;
+		}
+		if (carry > 0)
+			digits[ndigits++] = (UInt2) carry;
+	}
+	header[1] = htons((UInt2) (ndigits - 1 - (scale + shift) / 4));	/* weight */
+	/* trailing zero groups aren't sent */
+	for (first = 0; 0 == digits[first]; first++)
+		;
+	header[0] = htons((UInt2) (ndigits - first));
+	header[2] = htons(0 == ns->sign ? NUMERIC_NEG : NUMERIC_POS);
+	memcpy(binform, header, sizeof(header));
+	len = sizeof(header);
+	for (i = ndigits - 1; i >= first; i--, len += sizeof(dig))
+	{
+		dig = htons(digits[i]);
+		memcpy(binform + len, &dig, sizeof(dig));
+	}
+	return len;
+}
 #endif /* ODBCVER */
 
 /*
@@ -4186,6 +4564,20 @@ inolog("ipara=%p paramType=%d %d proc_return=%d\n", ipara, ipara ? ipara->paramT
 	}
 
 	allocbuf = buf = NULL;
+#if (ODBCVER >= 0x0300)
+	/* BuildBindRequest() chose the binary format for this one */
+	if (req_bind &&
+	    0 != (qb->flags & FLGB_BINARY_AS_POSSIBLE) &&
+	    SQL_C_NUMERIC == apara->CType &&
+	    PG_TYPE_NUMERIC == PIC_get_pgtype(*ipara))
+	{
+		char	binform[NUMERIC_BINARY_MAXLEN];
+		int	binlen = ResolveNumericBinary((SQL_NUMERIC_STRUCT *) buffer, binform);
+
+		CVT_APPEND_DATA(qb, binform, binlen);
+		goto param_built;
+	}
+#endif /* ODBCVER */
 	param_string[0] = '\0';
 	cbuf[0] = '\0';
 	memset(&st, 0, sizeof(st));
@@ -4372,8 +4764,12 @@ mylog("C_WCHAR=%s(%d)\n", buffer, used);
 			}
 #if (ODBCVER >= 0x0300)
 		case SQL_C_NUMERIC:
-			if (ResolveNumericParam((SQL_NUMERIC_STRUCT *) buffer, param_string))
+			if (ResolveNumericParam((SQL_NUMERIC_STRUCT *) buffer, param_string, sizeof(param_string)))
 				break;
+			qb->errormsg = "Could not convert the numeric parameter";
+			qb->errornumber = STMT_EXEC_ERROR;
+			retval = SQL_ERROR;
+			goto cleanup;
 		case SQL_C_INTERVAL_YEAR:
 			ivsign = ivstruct->interval_sign ? "-" : "";
 			sprintf(param_string, "%s%d years", ivsign, ivstruct->intval.year_month.year);
@@ -4789,6 +5185,7 @@ mylog("buf=%p flag=%d\n", buf, qb->flags);
 		if (lastadd)
 			CVT_APPEND_STR(qb, lastadd);
 	}
+param_built:
 	if (req_bind)
 	{
 		UInt4	slen = htonl((UInt4) (qb->npos - npos - 4));
@@ -5586,15 +5983,30 @@ convert_pgbinary_to_char(const char *value, char *rgbValue, ssize_t cbValueMax)
 static int
 conv_from_octal(const UCHAR *s)
 {
-	ssize_t			i;
-	int			y = 0;
+	return ((s[1] - '0') << 6) + ((s[2] - '0') << 3) + (s[3] - '0');
+}
 
-	for (i = 1; i <= 3; i++)
-		y += (s[i] - '0') << (3 * (3 - i));
 
-	return y;
-}
+/*	runs of unescaped bytes shorter than this are copied byte by byte */
+#define	BYTEA_SHORT_RUN	16
 
+/*
+ *	Copy the run of bytes without escapes, at most len bytes, to out (if
+ *	not NULL) and return its length.  Only for the long runs: the short
+ *	ones, frequent in binary data, are faster byte by byte.
+ */
+static size_t
+copy_unescaped_run(const UCHAR *value, size_t len, UCHAR *out)
+{
+	const UCHAR	*esc;
+	size_t		n;
+
+	esc = memchr(value, BYTEA_ESCAPE_CHAR, len);
+	n = esc ? esc - value : len;
+	if (out)
+		memcpy(out, value, n);
+	return n;
+}
 
 /*	convert octal escapes to bytes */
 size_t
@@ -5603,6 +6015,8 @@ convert_from_pgbinary(const UCHAR *value, UCHAR *rgbValue, SQLLEN cbValueMax)
 	size_t		i,
 				ilen = strlen(value);
 	size_t			o = 0;
+	size_t		n;
+	int		plain = 0;	/* the unescaped bytes in a row */
 
 	for (i = 0; i < ilen;)
 	{
@@ -5635,15 +6049,22 @@ convert_from_pgbinary(const UCHAR *value, UCHAR *rgbValue, SQLLEN cbValueMax)
 				i += 4;
 			}
 		}
-		else
+		else if (++plain < BYTEA_SHORT_RUN)
 		{
 			if (rgbValue)
 				rgbValue[o] = value[i];
 			o++;
 			i++;
+			continue;
+		}
+		else
+		{
+			/* copy the rest of a long run of unescaped bytes at once */
+			n = copy_unescaped_run(value + i, ilen - i, rgbValue ? rgbValue + o : NULL);
+			o += n;
+			i += n;
 		}
-		/** if (rgbValue)
-			mylog("convert_from_pgbinary: i=%d, rgbValue[%d] = %d, %c\n", i, o, rgbValue[o], rgbValue[o]); ***/
+		plain = 0;
 	}
 
 	if (rgbValue)
@@ -5655,52 +6076,178 @@ convert_from_pgbinary(const UCHAR *value, UCHAR *rgbValue, SQLLEN cbValueMax)
 }
 
 
-static UInt2
-conv_to_octal(UCHAR val, char *octal, char escape_ch)
+/*
+ *	Decode the bytea text value piece by piece (SQLGetData).
+ *	At most outlen bytes are stored, beginning at the position *src_pos
+ *	of the text, and *src_pos is advanced past the consumed text.
+ *	Unlike convert_from_pgbinary() no terminator is added.
+ */
+static SQLLEN
+decode_pgbinary_piece(const UCHAR *value, SQLLEN *src_pos, UCHAR *out, SQLLEN outlen)
 {
-	int	i, pos = 0, len;
+	const UCHAR	*in;
+	SQLLEN		o = 0, n;
+	int		plain = 0;	/* the unescaped bytes in a row */
 
-	if (escape_ch)
-		octal[pos++] = escape_ch;
-	octal[pos] = BYTEA_ESCAPE_CHAR;
-	len = 4 + pos;
-	octal[len] = '\0';
+	if (BYTEA_ESCAPE_CHAR == value[0] && 'x' == value[1])
+	{
+		/* hex format */
+		if (*src_pos < 2)
+			*src_pos = 2;
+		in = value + *src_pos;
+		o = hex_pairs_to_bin(in, out, outlen);
+		in += 2 * o;
+	}
+	else
+	{
+		for (in = value + *src_pos; o < outlen && *in;)
+		{
+			if (BYTEA_ESCAPE_CHAR != *in)
+			{
+				if (++plain < BYTEA_SHORT_RUN)
+				{
+					out[o++] = *in++;
+					continue;
+				}
+				/*
+				 * Copy the rest of a long run at once, within the text:
+				 * outlen may be larger than what remains of it.
+				 */
+				n = copy_unescaped_run(in, strnlen((const char *) in, outlen - o), out + o);
+				o += n;
+				in += n;
+				plain = 0;
+				continue;
+			}
+			plain = 0;
+			if (BYTEA_ESCAPE_CHAR == in[1])
+			{
+				out[o] = *in;
+				in += 2;
+			}
+			else
+			{
+				out[o] = conv_from_octal(in);
+				in += 4;
+			}
+			o++;
+		}
+	}
+	*src_pos = in - value;
+
+	return o;
+}
 
-	for (i = len - 1; i > pos; i--)
+/*
+ *	Store ochars digits of the hex representation of a bytea value,
+ *	as characters or as SQLWCHARs.  If hex_format is set, value is the
+ *	hex text sent by the server (without the leading \x) and is copied.
+ *	Otherwise value is in escape format and the digits are generated
+ *	from the decoded bytes; low_first means that the high order digit of
+ *	the byte at *src_pos was already returned.  *src_pos is advanced
+ *	past the text which is done with.
+ */
+static SQLLEN
+pgbinary_hex_piece(const UCHAR *value, BOOL hex_format, SQLLEN *src_pos, BOOL low_first, char *out, SQLLEN ochars, BOOL wide)
+{
+	UCHAR		bin[512], hex[2 * sizeof(bin) + 1];
+	const UCHAR	*digits;
+	SQLLEN		o = 0, n, nbytes, pos;
+
+	while (o < ochars)
 	{
-		octal[i] = (val & 7) + '0';
-		val >>= 3;
+		if (hex_format)
+		{
+			digits = value + *src_pos;
+			for (n = 0; n < ochars - o && digits[n]; n++)
+				;
+			*src_pos += n;
+		}
+		else if (low_first)
+		{
+			if (0 == decode_pgbinary_piece(value, src_pos, bin, 1))
+				break;
+			pg_bin2hex(bin, hex, 1);
+			digits = hex + 1;
+			n = 1;
+			low_first = FALSE;
+		}
+		else
+		{
+			nbytes = (ochars - o) / 2;
+			if (nbytes > (SQLLEN) sizeof(bin))
+				nbytes = sizeof(bin);
+			if (0 == nbytes)
+			{
+				/* only the high order digit of the next byte fits */
+				pos = *src_pos;
+				n = decode_pgbinary_piece(value, &pos, bin, 1);
+			}
+			else
+				n = 2 * decode_pgbinary_piece(value, src_pos, bin, nbytes);
+			pg_bin2hex(bin, hex, (n + 1) / 2);
+			digits = hex;
+		}
+		if (0 == n)
+			break;
+#ifdef	UNICODE_SUPPORT
+		if (wide)
+		{
+			SQLLEN	i;
+
+			for (i = 0; i < n; i++)
+				((SQLWCHAR *) out)[o + i] = digits[i];
+		}
+		else
+#endif /* UNICODE_SUPPORT */
+			memcpy(out + o, digits, n);
+		o += n;
 	}
 
-	return (UInt2) len;
+	return o;
 }
 
 
 static char *
 conv_to_octal2(UCHAR val, char *octal)
 {
-	int			i;
-
 	octal[0] = BYTEA_ESCAPE_CHAR;
+	octal[1] = '0' + (val >> 6);
+	octal[2] = '0' + ((val >> 3) & 7);
+	octal[3] = '0' + (val & 7);
 	octal[4] = '\0';
 
-	for (i = 3; i > 0; i--)
-	{
-		octal[i] = (val & 7) + '0';
-		val >>= 3;
-	}
-
 	return octal;
 }
 
 
+static UInt2
+conv_to_octal(UCHAR val, char *octal, char escape_ch)
+{
+	int	pos = 0;
+
+	if (escape_ch)
+		octal[pos++] = escape_ch;
+	conv_to_octal2(val, octal + pos);
+
+	return (UInt2) (4 + pos);
+}
+
+
+/*	bytes sent as they are in the escape format; no locale lookup */
+#define	BYTEA_PLAIN_CHAR(c) \
+	(((c) >= '0' && (c) <= '9') || \
+	 ((c) >= 'a' && (c) <= 'z') || \
+	 ((c) >= 'A' && (c) <= 'Z') || \
+	 (c) == ' ')
+
 /*	convert non-ascii bytes to octal escape sequences */
 static size_t
 convert_to_pgbinary(const UCHAR *in, char *out, size_t len, QueryBuild *qb)
 {
 	CSTR	func = "convert_to_pgbinary";
 	UCHAR	inc;
-	size_t			i, o = 0;
+	size_t			i, n, o = 0;
 	char	escape_in_literal = CC_get_escape(qb->conn);
 	BOOL	esc_double = (0 == (qb->flags & FLGB_BUILDING_BIND_REQUEST) && 0 != escape_in_literal);
 
@@ -5717,9 +6264,15 @@ convert_to_pgbinary(const UCHAR *in, char *out, size_t len, QueryBuild *qb)
 	for (i = 0; i < len; i++)
 	{
 		inc = in[i];
-		inolog("%s: in[%d] = %d, %c\n", func, i, inc, inc);
-		if (inc < 128 && (isalnum(inc) || inc == ' '))
-			out[o++] = inc;
+		if (BYTEA_PLAIN_CHAR(inc))
+		{
+			/* copy the run of bytes which needn't be escaped at once */
+			for (n = i + 1; n < len && BYTEA_PLAIN_CHAR(in[n]); n++)
+				;
+			memcpy(out + o, in + i, n - i);
+			o += n - i;
+			i = n - 1;
+		}
 		else
 		{
 			if (esc_double)
@@ -5742,83 +6295,140 @@ convert_to_pgbinary(const UCHAR *in, char *out, size_t len, QueryBuild *qb)
 
 static const char *hextbl = "0123456789ABCDEF";
 
-#define	def_bin2hex(type) \
-	(const UCHAR *src, type *dst, SQLLEN length) \
-{ \
-	const UCHAR	*src_wk; \
-	UCHAR		chr; \
-	type		*dst_wk; \
-	BOOL		backwards; \
-	int		i; \
- \
-	backwards = FALSE; \
-	if ((UCHAR *)dst < src) \
-	{ \
-		if ((UCHAR *) (dst + 2 * (length - 1)) > src + length - 1) \
-			return -1; \
-	} \
-	else if ((UCHAR *) dst < src + length) \
-		backwards = TRUE; \
-	if (backwards) \
-	{ \
-		for (i = 0, src_wk = src + length - 1, dst_wk = dst + 2 * length - 1; i < length; i++, src_wk--) \
-		{ \
-			chr = *src_wk; \
-			*dst_wk-- = hextbl[chr % 16]; \
-			*dst_wk-- = hextbl[chr >> 4]; \
-		} \
-	} \
-	else \
-	{ \
-		for (i = 0, src_wk = src, dst_wk = dst; i < length; i++, src_wk++) \
-		{ \
-			chr = *src_wk; \
-			*dst_wk++ = hextbl[chr >> 4]; \
-			*dst_wk++ = hextbl[chr % 16]; \
-		} \
-	} \
-	dst[2 * length] = '\0'; \
-	return 2 * length * sizeof(type); \
+#ifdef	USE_SSE2
+/*
+ *	Convert the 16 bytes to 32 (upper case) hex digits.
+ */
+static void
+bin2hex_sse2(const UCHAR *src, UCHAR *dst)
+{
+	__m128i	v = _mm_loadu_si128((const __m128i *) src);
+	__m128i	mask = _mm_set1_epi8(0x0f);
+	__m128i	nine = _mm_set1_epi8(9);
+	__m128i	hi, lo;
+
+	hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+	lo = _mm_and_si128(v, mask);
+	/* '0' + n, plus 7 more for 'A' - 'F' */
+	hi = _mm_add_epi8(hi, _mm_add_epi8(_mm_set1_epi8('0'),
+		_mm_and_si128(_mm_cmpgt_epi8(hi, nine), _mm_set1_epi8(7))));
+	lo = _mm_add_epi8(lo, _mm_add_epi8(_mm_set1_epi8('0'),
+		_mm_and_si128(_mm_cmpgt_epi8(lo, nine), _mm_set1_epi8(7))));
+	_mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi8(hi, lo));
+	_mm_storeu_si128((__m128i *) (dst + 16), _mm_unpackhi_epi8(hi, lo));
 }
-#ifdef	UNICODE_SUPPORT
-static SQLLEN
-pg_bin2whex def_bin2hex(SQLWCHAR)
-#endif /* UNICODE_SUPPORT */
 
-static SQLLEN
-pg_bin2hex def_bin2hex(UCHAR)
+/*
+ *	Convert 16 hex digits to 8 bytes.  Returns FALSE without storing
+ *	anything if the digits contain a null.
+ */
+static BOOL
+hex2bin_sse2(const UCHAR *src, UCHAR *dst)
+{
+	__m128i	v = _mm_loadu_si128((const __m128i *) src);
+	__m128i	val, hi, lo;
+
+	if (0 != _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())))
+		return FALSE;
+	/* fold letters to lower case, then '0' -> 0 ... 'a' -> 10 ... */
+	v = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	val = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+	val = _mm_sub_epi8(val, _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('9')), _mm_set1_epi8('a' - '0' - 10)));
+	/* the high order digit is the lower byte of each 16 bit lane */
+	hi = _mm_and_si128(val, _mm_set1_epi16(0x00ff));
+	lo = _mm_srli_epi16(val, 8);
+	val = _mm_or_si128(_mm_slli_epi16(hi, 4), lo);
+	_mm_storel_epi64((__m128i *) dst, _mm_packus_epi16(val, val));
+	return TRUE;
+}
+#endif /* USE_SSE2 */
 
 SQLLEN
-pg_hex2bin(const UCHAR *src, UCHAR *dst, SQLLEN length)
+pg_bin2hex(const UCHAR *src, UCHAR *dst, SQLLEN length)
 {
-	UCHAR		chr;
 	const UCHAR	*src_wk;
+	UCHAR		chr;
 	UCHAR		*dst_wk;
+	BOOL		backwards;
 	SQLLEN		i;
-	int		val;
-	BOOL		HByte = TRUE;
 
-	for (i = 0, src_wk = src, dst_wk = dst; i < length; i++, src_wk++)
+	backwards = FALSE;
+	if (dst < src)
 	{
-		chr = *src_wk;
-		if (!chr)
-			break;
-		if (chr >= 'a' && chr <= 'f')
-			val = chr - 'a' + 10;
-		else if (chr >= 'A' && chr <= 'F')
-			val = chr - 'A' + 10;
-		else
-			val = chr - '0';
-		if (HByte)
-			*dst_wk = (val << 4);
-		else
+		if (dst + 2 * (length - 1) > src + length - 1)
+			return -1;
+	}
+	else if (dst < src + length)
+		backwards = TRUE;
+	if (backwards)
+	{
+		i = length;
+#ifdef	USE_SSE2
+		/*
+		 * Each block is loaded before it's overwritten, and the output
+		 * never reaches the bytes which are not converted yet.
+		 */
+		for (; i >= 16; i -= 16)
+			bin2hex_sse2(src + i - 16, dst + 2 * (i - 16));
+#endif /* USE_SSE2 */
+		for (src_wk = src + i - 1, dst_wk = dst + 2 * i - 1; i > 0; i--, src_wk--)
+		{
+			chr = *src_wk;
+			*dst_wk-- = hextbl[chr % 16];
+			*dst_wk-- = hextbl[chr >> 4];
+		}
+	}
+	else
+	{
+		i = 0;
+#ifdef	USE_SSE2
+		for (; i + 16 <= length; i += 16)
+			bin2hex_sse2(src + i, dst + 2 * i);
+#endif /* USE_SSE2 */
+		for (src_wk = src + i, dst_wk = dst + 2 * i; i < length; i++, src_wk++)
 		{
-			*dst_wk += val; 
-			dst_wk++;
+			chr = *src_wk;
+			*dst_wk++ = hextbl[chr >> 4];
+			*dst_wk++ = hextbl[chr % 16];
 		}
-		HByte = !HByte;
 	}
-	*dst_wk = '\0';
+	dst[2 * length] = '\0';
+	return 2 * length;
+}
+
+#define	HEX_DIGIT_VALUE(c) \
+	((c) >= 'a' ? (c) - 'a' + 10 : ((c) >= 'A' ? (c) - 'A' + 10 : (c) - '0'))
+
+/*
+ *	Convert at most nbytes pairs of hex digits to bytes, stopping at a
+ *	null.  Returns the count of the converted bytes; no terminator is
+ *	added.
+ */
+static SQLLEN
+hex_pairs_to_bin(const UCHAR *src, UCHAR *dst, SQLLEN nbytes)
+{
+	SQLLEN		o = 0;
+
+#ifdef	USE_SSE2
+	for (; o + 8 <= nbytes; o += 8, src += 16)
+	{
+		if (!hex2bin_sse2(src, dst + o))
+			break;
+	}
+#endif /* USE_SSE2 */
+	for (; o < nbytes && src[0] && src[1]; o++, src += 2)
+		dst[o] = (HEX_DIGIT_VALUE(src[0]) << 4) + HEX_DIGIT_VALUE(src[1]);
+
+	return o;
+}
+
+SQLLEN
+pg_hex2bin(const UCHAR *src, UCHAR *dst, SQLLEN length)
+{
+	SQLLEN	o;
+
+	o = hex_pairs_to_bin(src, dst, length / 2);
+	dst[o] = '\0';
 	return length;
 }
 
@@ -5896,6 +6506,14 @@ convert_lo(StatementClass *stmt, const void *value, SQLSMALLINT fCType, PTR rgbV
 			}
 		}
 
+		/*
+		 * Forget what was read ahead from a large object left partly
+		 * read, so that it doesn't come back as data of this one.
+		 */
+		if (stmt->lobj_fd >= 0)
+			odbc_lo_stream_close(conn, stmt->lobj_fd, &stmt->lobj_stream);
+		else
+			odbc_lo_stream_discard(&stmt->lobj_stream);
 		stmt->lobj_fd = odbc_lo_open(conn, oid, INV_READ);
 		if (stmt->lobj_fd < 0)
 		{
@@ -5903,11 +6521,11 @@ convert_lo(StatementClass *stmt, const void *value, SQLSMALLINT fCType, PTR rgbV
 			return COPY_GENERAL_ERROR;
 		}
 
-		/* Get the size */
+		/* Get the size (lo_lseek returns the new position) */
 		retval = odbc_lo_lseek(conn, stmt->lobj_fd, 0L, SEEK_END);
 		if (retval >= 0)
 		{
-			left = odbc_lo_tell(conn, stmt->lobj_fd);
+			left = retval;
 			if (gdata)
 				gdata->data_left = left;
 
@@ -5928,10 +6546,10 @@ convert_lo(StatementClass *stmt, const void *value, SQLSMALLINT fCType, PTR rgbV
 	if (0 >= cbValueMax)
 		retval = 0;
 	else
-		retval = odbc_lo_read(conn, stmt->lobj_fd, (char *) rgbValue, (Int4) (factor > 1 ? (cbValueMax - 1) / factor : cbValueMax));
+		retval = odbc_lo_stream_read(conn, stmt->lobj_fd, &stmt->lobj_stream, (char *) rgbValue, (Int4) (factor > 1 ? (cbValueMax - 1) / factor : cbValueMax));
 	if (retval < 0)
 	{
-		odbc_lo_close(conn, stmt->lobj_fd);
+		odbc_lo_stream_close(conn, stmt->lobj_fd, &stmt->lobj_stream);
 
 		/* commit transaction if needed */
 		if (!ci->drivers.use_declarefetch && CC_does_autocommit(conn))
@@ -5964,7 +6582,7 @@ convert_lo(StatementClass *stmt, const void *value, SQLSMALLINT fCType, PTR rgbV
 
 	if (!gdata || gdata->data_left == 0)
 	{
-		odbc_lo_close(conn, stmt->lobj_fd);
+		odbc_lo_stream_close(conn, stmt->lobj_fd, &stmt->lobj_stream);
 
 		/* commit transaction if needed */
 		if (!ci->drivers.use_declarefetch && CC_does_autocommit(conn))
@@ -48,12 +48,23 @@ int	copy_and_convert_field(StatementClass *stmt,
 int		copy_statement_with_parameters(StatementClass *stmt, BOOL);
 BOOL		convert_money(const char *s, char *sout, size_t soutmax);
 char		parse_datetime(const char *buf, SIMPLE_TIME *st);
+BOOL		timestamp2stime(const char *str, SIMPLE_TIME *st, BOOL *bZone, int *zone);
+const char	*parse_iso_date(const char *str, SIMPLE_TIME *st);
+const char	*parse_iso_time(const char *str, SIMPLE_TIME *st);
+BOOL		parse_iso_double(const char *str, double *val);
+#if (ODBCVER >= 0x0300)
+#define	NUMERIC_BINARY_MAXLEN	(4 * 2 + 11 * 2)	/* header and base 10000 digits */
+BOOL		string_to_numeric(const char *str, SQL_NUMERIC_STRUCT *ns);
+BOOL		ResolveNumericParam(const SQL_NUMERIC_STRUCT *ns, char *chrform, size_t size);
+int		ResolveNumericBinary(const SQL_NUMERIC_STRUCT *ns, char *binform);
+#endif /* ODBCVER */
 size_t		convert_linefeeds(const char *s, char *dst, size_t max, BOOL convlf, BOOL *changed);
 size_t		convert_special_chars(const char *si, char *dst, SQLLEN used, UInt4 flags,int ccsc, int escape_ch);
 
 int		convert_pgbinary_to_char(const char *value, char *rgbValue, ssize_t cbValueMax);
 size_t		convert_from_pgbinary(const UCHAR *value, UCHAR *rgbValue, SQLLEN cbValueMax);
 SQLLEN		pg_hex2bin(const UCHAR *in, UCHAR *out, SQLLEN len);
+SQLLEN		pg_bin2hex(const UCHAR *src, UCHAR *dst, SQLLEN length);
 int convert_lo(StatementClass *stmt, const void *value, SQLSMALLINT fCType,
 	 PTR rgbValue, SQLLEN cbValueMax, SQLLEN *pcbValue);
 Int4		findTag(const char *str, char dollar_quote, int ccsc);
@@ -217,6 +217,11 @@ inolog("hlen=%d", hlen);
 			INI_CONNSETTINGS "=%s;"
 			INI_FETCH "=%d;"
 			INI_SOCKET "=%d;"
+			INI_SOCKETMAX "=%d;"
+			INI_KERNELSOCKETBUFFER "=%d;"
+			INI_CATALOGCACHETTL "=%d;"
+			INI_LAZYMORERESULTS "=%d;"
+			INI_DRIVERSSL "=%d;"
 			INI_UNKNOWNSIZES "=%d;"
 			INI_MAXVARCHARSIZE "=%d;"
 			INI_MAXLONGVARCHARSIZE "=%d;"
@@ -255,6 +260,11 @@ inolog("hlen=%d", hlen);
 			,encoded_item
 			,ci->drivers.fetch_max
 			,ci->drivers.socket_buffersize
+			,ci->drivers.socket_buffermax
+			,ci->drivers.kernel_buffersize
+			,ci->drivers.catalog_cache_ttl
+			,ci->drivers.lazy_more_results
+			,ci->drivers.driver_ssl
 			,ci->drivers.unknown_sizes
 			,ci->drivers.max_varchar_size
 			,ci->drivers.max_longvarchar_size
@@ -366,6 +376,11 @@ inolog("hlen=%d", hlen);
 				ABBR_CONNSETTINGS "=%s;"
 				ABBR_FETCH "=%d;"
 				ABBR_SOCKET "=%d;"
+				ABBR_SOCKETMAX "=%d;"
+				ABBR_KERNELSOCKETBUFFER "=%d;"
+				ABBR_CATALOGCACHETTL "=%d;"
+				ABBR_LAZYMORERESULTS "=%d;"
+				ABBR_DRIVERSSL "=%d;"
 				ABBR_MAXVARCHARSIZE "=%d;"
 				ABBR_MAXLONGVARCHARSIZE "=%d;"
 				INI_INT8AS "=%d;"
@@ -374,6 +389,11 @@ inolog("hlen=%d", hlen);
 				encoded_item,
 				ci->drivers.fetch_max,
 				ci->drivers.socket_buffersize,
+				ci->drivers.socket_buffermax,
+				ci->drivers.kernel_buffersize,
+				ci->drivers.catalog_cache_ttl,
+				ci->drivers.lazy_more_results,
+				ci->drivers.driver_ssl,
 				ci->drivers.max_varchar_size,
 				ci->drivers.max_longvarchar_size,
 				ci->int8_as,
@@ -409,6 +429,15 @@ inolog("hlen=%d", hlen);
 				flag);
 		}
 	}
+	if (olen < nlen && ci->replica_servers[0])
+	{
+		hlen = strlen(connect_string);
+		nlen = MAX_CONNECT_STRING - hlen;
+		olen = snprintf(&connect_string[hlen], nlen, ";"
+			"%s=%s",
+			abbrev ? ABBR_REPLICASERVERS : INI_REPLICASERVERS,
+			ci->replica_servers);
+	}
 	if (olen < 0 || olen >= nlen) /* failed */
 		connect_string[0] = '\0';
 }
@@ -494,6 +523,9 @@ copyAttributes(ConnInfo *ci, const char *attribute, const char *value)
 	else if (stricmp(attribute, INI_SERVER) == 0 || stricmp(attribute, SPEC_SERVER) == 0)
 		strcpy(ci->server, value);
 
+	else if (stricmp(attribute, INI_REPLICASERVERS) == 0 || stricmp(attribute, ABBR_REPLICASERVERS) == 0)
+		strncpy_null(ci->replica_servers, value, sizeof(ci->replica_servers));
+
 	else if (stricmp(attribute, INI_USERNAME) == 0 || stricmp(attribute, INI_UID) == 0)
 		strcpy(ci->username, value);
 
@@ -645,6 +677,16 @@ copyCommonAttributes(ConnInfo *ci, const char *attribute, const char *value)
 		ci->drivers.fetch_max = atoi(value);
 	else if (stricmp(attribute, INI_SOCKET) == 0 || stricmp(attribute, ABBR_SOCKET) == 0)
 		ci->drivers.socket_buffersize = atoi(value);
+	else if (stricmp(attribute, INI_SOCKETMAX) == 0 || stricmp(attribute, ABBR_SOCKETMAX) == 0)
+		ci->drivers.socket_buffermax = atoi(value);
+	else if (stricmp(attribute, INI_KERNELSOCKETBUFFER) == 0 || stricmp(attribute, ABBR_KERNELSOCKETBUFFER) == 0)
+		ci->drivers.kernel_buffersize = atoi(value);
+	else if (stricmp(attribute, INI_CATALOGCACHETTL) == 0 || stricmp(attribute, ABBR_CATALOGCACHETTL) == 0)
+		ci->drivers.catalog_cache_ttl = atoi(value);
+	else if (stricmp(attribute, INI_LAZYMORERESULTS) == 0 || stricmp(attribute, ABBR_LAZYMORERESULTS) == 0)
+		ci->drivers.lazy_more_results = atoi(value);
+	else if (stricmp(attribute, INI_DRIVERSSL) == 0 || stricmp(attribute, ABBR_DRIVERSSL) == 0)
+		ci->drivers.driver_ssl = atoi(value);
 	else if (stricmp(attribute, INI_DEBUG) == 0 || stricmp(attribute, ABBR_DEBUG) == 0)
 		ci->drivers.debug = atoi(value);
 	else if (stricmp(attribute, INI_COMMLOG) == 0 || stricmp(attribute, ABBR_COMMLOG) == 0)
@@ -824,6 +866,9 @@ getDSNinfo(ConnInfo *ci, char overwrite)
 	if (ci->server[0] == '\0' || overwrite)
 		SQLGetPrivateProfileString(DSN, INI_SERVER, "", ci->server, sizeof(ci->server), ODBC_INI);
 
+	if (ci->replica_servers[0] == '\0' || overwrite)
+		SQLGetPrivateProfileString(DSN, INI_REPLICASERVERS, "", ci->replica_servers, sizeof(ci->replica_servers), ODBC_INI);
+
 	if (ci->database[0] == '\0' || overwrite)
 		SQLGetPrivateProfileString(DSN, INI_DATABASE, "", ci->database, sizeof(ci->database), ODBC_INI);
 
@@ -1124,6 +1169,11 @@ writeDSNinfo(const ConnInfo *ci)
 								 ci->server,
 								 ODBC_INI);
 
+	SQLWritePrivateProfileString(DSN,
+								 INI_REPLICASERVERS,
+								 ci->replica_servers,
+								 ODBC_INI);
+
 	SQLWritePrivateProfileString(DSN,
 								 INI_PORT,
 								 ci->port,
@@ -1278,6 +1328,46 @@ getCommonDefaults(const char *section, const char *filename, ConnInfo *ci)
 	else if (inst_position)
 		comval->socket_buffersize = SOCK_BUFFER_SIZE;
 
+	/* so is the limit of the buffer growth */
+	SQLGetPrivateProfileString(section, INI_SOCKETMAX, "",
+							   temp, sizeof(temp), filename);
+	if (temp[0])
+		comval->socket_buffermax = atoi(temp);
+	else if (inst_position)
+		comval->socket_buffermax = SOCK_BUFFER_MAX_SIZE;
+
+	/* the kernel buffers are left to the OS unless a size is given */
+	SQLGetPrivateProfileString(section, INI_KERNELSOCKETBUFFER, "",
+							   temp, sizeof(temp), filename);
+	if (temp[0])
+		comval->kernel_buffersize = atoi(temp);
+	else if (inst_position)
+		comval->kernel_buffersize = 0;
+
+	/* the catalog result cache is off unless a lifetime is given */
+	SQLGetPrivateProfileString(section, INI_CATALOGCACHETTL, "",
+							   temp, sizeof(temp), filename);
+	if (temp[0])
+		comval->catalog_cache_ttl = atoi(temp);
+	else if (inst_position)
+		comval->catalog_cache_ttl = 0;
+
+	/* the results of a batch are all read by SQLExecute unless this is set */
+	SQLGetPrivateProfileString(section, INI_LAZYMORERESULTS, "",
+							   temp, sizeof(temp), filename);
+	if (temp[0])
+		comval->lazy_more_results = atoi(temp);
+	else if (inst_position)
+		comval->lazy_more_results = 0;
+
+	/* SSL is left to libpq unless this is set */
+	SQLGetPrivateProfileString(section, INI_DRIVERSSL, "",
+							   temp, sizeof(temp), filename);
+	if (temp[0])
+		comval->driver_ssl = atoi(temp);
+	else if (inst_position)
+		comval->driver_ssl = 0;
+
 	/* Debug is stored in the driver section */
 	SQLGetPrivateProfileString(section, INI_DEBUG, "",
 							   temp, sizeof(temp), filename);
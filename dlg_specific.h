@@ -68,6 +68,24 @@ extern "C" {
 #define ABBR_FETCH			"A7"
 #define INI_SOCKET			"Socket"	/* Socket buffer size */
 #define ABBR_SOCKET			"A8"
+#define INI_SOCKETMAX			"MaxSocketBuffer"	/* Limit of the socket
+							 * buffer growth */
+#define ABBR_SOCKETMAX			"D1"
+#define INI_KERNELSOCKETBUFFER		"KernelSocketBuffer"	/* SO_RCVBUF/SO_SNDBUF
+							 * of the socket */
+#define ABBR_KERNELSOCKETBUFFER		"D5"
+#define INI_CATALOGCACHETTL		"CatalogCacheTTL"	/* Lifetime of the cached
+							 * catalog results */
+#define ABBR_CATALOGCACHETTL		"D2"
+#define INI_LAZYMORERESULTS		"LazyMoreResults"	/* Read the results of
+							 * a batch one by one */
+#define ABBR_LAZYMORERESULTS		"D3"
+#define INI_DRIVERSSL			"DriverSSL"	/* SSL by the driver
+							 * instead of libpq */
+#define ABBR_DRIVERSSL			"D6"
+#define INI_REPLICASERVERS		"ReplicaServers"	/* Hosts for the ReadOnly
+							 * connections */
+#define ABBR_REPLICASERVERS		"D4"
 #define INI_READONLY			"ReadOnly"	/* Database is read only */
 #define ABBR_READONLY			"A0"
 #define INI_COMMLOG			"CommLog"	/* Communication to
@@ -386,6 +386,9 @@ PGAPI_ConnectError(	HDBC hdbc,
 			case CONN_VALUE_OUT_OF_RANGE:
 				pg_sqlstate_set(env, szSqlState, "HY019", "22003");
 				break;
+			case CONN_OPTION_CANNOT_BE_SET_NOW:
+				pg_sqlstate_set(env, szSqlState, "HY011", "S1011");
+				break;
 			case CONNECTION_COULD_NOT_SEND:
 			case CONNECTION_COULD_NOT_RECEIVE:
 			case CONNECTION_COMMUNICATION_ERROR:
@@ -231,8 +231,14 @@ inquireHowToPrepare(const StatementClass *stmt)
 		}
 		if (stmt->multi_statement < 0)
 			PGAPI_NumParams((StatementClass *) stmt, &num_params);
-		if (stmt->multi_statement > 0) /* would divide the query into multiple commands and apply V3 parse requests for each of them */
-			ret = PROTOCOL_74(ci) ? PARSE_REQ_FOR_INFO : PREPARE_BY_THE_DRIVER;
+		if (stmt->multi_statement > 0) /* divides the query into multiple commands and pipelines V3 parse requests for each of them */
+		{
+			/* a pipelined batch is read at once, keep LazyMoreResults working */
+			if (ci->drivers.lazy_more_results && !CC_does_autocommit(conn))
+				ret = PREPARE_BY_THE_DRIVER;
+			else
+				ret = PROTOCOL_74(ci) ? PARSE_TO_EXEC_ONCE : PREPARE_BY_THE_DRIVER;
+		}
 		else if (PROTOCOL_74(ci))
 		{
 			if (SC_may_use_cursor(stmt))
@@ -259,7 +265,9 @@ inquireHowToPrepare(const StatementClass *stmt)
 				ret = PREPARE_BY_THE_DRIVER;
 		}
 	}
-	if (SC_is_prepare_statement(stmt) && (PARSE_TO_EXEC_ONCE == ret))
+	/* the commands of a multi-statement query are parsed unnamed each time */
+	if (SC_is_prepare_statement(stmt) && (PARSE_TO_EXEC_ONCE == ret) &&
+	    stmt->multi_statement <= 0)
 		ret = NAMED_PARSE_REQUEST;
 
 	return ret;
@@ -689,7 +697,6 @@ SetStatementSvp(StatementClass *stmt)
 	CSTR	func = "SetStatementSvp";
 	char	esavepoint[32], cmd[64];
 	ConnectionClass	*conn = SC_get_conn(stmt);
-	QResultClass *res;
 	RETCODE	ret = SQL_SUCCESS_WITH_INFO;
 
 	if (CC_is_in_error_trans(conn))
@@ -726,10 +733,13 @@ SetStatementSvp(StatementClass *stmt)
 		}
 		if (need_savep)
 		{
+			/*
+			 *	The SAVEPOINT is sent together with the next query
+			 *	(see CC_send_query_append()).
+			 */
 			sprintf(esavepoint, "_EXEC_SVP_%p", stmt);
 			snprintf(cmd, sizeof(cmd), "SAVEPOINT %s", esavepoint);
-			res = CC_send_query(conn, cmd, NULL, 0, NULL);
-			if (QR_command_maybe_successful(res))
+			if (CC_add_pending_svp(conn, cmd))
 			{
 				SC_set_accessed_db(stmt);
 				SC_start_rbpoint(stmt);
@@ -740,7 +750,6 @@ SetStatementSvp(StatementClass *stmt)
 				SC_set_error(stmt, STMT_INTERNAL_ERROR, "internal SAVEPOINT failed", func);
 				ret = SQL_ERROR;
 			}
-			QR_Destructor(res);
 		}
 		else
 			SC_set_accessed_db(stmt);
@@ -803,11 +812,9 @@ CC_is_in_trans(conn), SC_is_rb_stmt(stmt), SC_is_tc_stmt(stmt));
 inolog("ret=%d\n", ret);
 	if (SQL_NEED_DATA != ret && SC_started_rbpoint(stmt))
 	{
+		/* The RELEASE is sent together with the next query */
 		snprintf(cmd, sizeof(cmd), "RELEASE %s", esavepoint);
-		res = CC_send_query(conn, cmd, NULL, IGNORE_ABORT_ON_CONN, NULL);
-		cmd_success = QR_command_maybe_successful(res);
-		QR_Destructor(res);
-		if (!cmd_success)
+		if (!CC_add_pending_svp(conn, cmd))
 		{
 			SC_set_error(stmt, STMT_INTERNAL_ERROR, "internal RELEASE failed", func);
 			CC_abort(conn);
@@ -1460,7 +1467,13 @@ PGAPI_ParamData(
 	/* close the large object */
 	if (estmt->lobj_fd >= 0)
 	{
-		odbc_lo_close(conn, estmt->lobj_fd);
+		if (odbc_lo_stream_close(conn, estmt->lobj_fd, &estmt->lobj_stream) < 0)
+		{
+			estmt->lobj_fd = -1;
+			SC_set_error(stmt, STMT_EXEC_ERROR, "Error writing to large object.", func);
+			retval = SQL_ERROR;
+			goto cleanup;
+		}
 
 		/* commit transaction if needed */
 		if (!CC_cursor_count(conn) && CC_does_autocommit(conn))
@@ -1567,6 +1580,7 @@ PGAPI_PutData(
 	IPDFields	*ipdopts;
 	PutDataInfo	*pdata;
 	SQLLEN		old_pos;
+	Int4		written;
 	ParameterInfoClass *current_param;
 	ParameterImplClass *current_iparam;
 	PutDataClass	*current_pdata;
@@ -1719,8 +1733,14 @@ PGAPI_PutData(
 				goto cleanup;
 			}
 
-			retval = odbc_lo_write(conn, estmt->lobj_fd, putbuf, (Int4) putlen);
-			mylog("lo_write: cbValue=%d, wrote %d bytes\n", putlen, retval);
+			written = odbc_lo_stream_write(conn, estmt->lobj_fd, &estmt->lobj_stream, putbuf, (Int4) putlen);
+			mylog("lo_write: cbValue=%d, wrote %d bytes\n", putlen, written);
+			if (written < 0)
+			{
+				SC_set_error(stmt, STMT_EXEC_ERROR, "Error writing to large object.", func);
+				retval = SQL_ERROR;
+				goto cleanup;
+			}
 		}
 		else
 		{
@@ -1744,8 +1764,14 @@ PGAPI_PutData(
 		if (handling_lo)
 		{
 			/* the large object fd is in EXEC_buffer */
-			retval = odbc_lo_write(conn, estmt->lobj_fd, putbuf, (Int4) putlen);
-			mylog("lo_write(2): cbValue = %d, wrote %d bytes\n", putlen, retval);
+			written = odbc_lo_stream_write(conn, estmt->lobj_fd, &estmt->lobj_stream, putbuf, (Int4) putlen);
+			mylog("lo_write(2): cbValue = %d, wrote %d bytes\n", putlen, written);
+			if (written < 0)
+			{
+				SC_set_error(stmt, STMT_EXEC_ERROR, "Error writing to large object.", func);
+				retval = SQL_ERROR;
+				goto cleanup;
+			}
 
 			*current_pdata->EXEC_used += putlen;
 		}
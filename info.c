@@ -20,6 +20,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 
 #ifndef WIN32
 #include <ctype.h>
@@ -1509,6 +1510,441 @@ allow_public_schema(ConnectionClass *conn, const char *szSchemaName, SQLSMALLINT
 		stricmp(CC_get_current_schema(conn), pubstr) == 0);
 }
 
+/*
+ *	The catalog queries are executed as named prepared statements so
+ *	that the server needn't parse and plan them on every call.
+ *
+ *	The string and numeric (e.g. OID) literals compared with "=" or
+ *	"like" i.e. the search arguments are replaced by parameters and the
+ *	remaining text (the shape of the query) identifies the statement.
+ *	The literals are passed to EXECUTE as they are, so they keep their
+ *	escaping.  A shape whose PREPARE failed is remembered and sent as
+ *	it is afterwards.  conn->catalog_plans is changed holding CONNLOCK
+ *	but the PREPARE is sent after releasing it.
+ *
+ *	The statement names are numbered by conn->catalog_plan_seq, which
+ *	keeps increasing when the plans are forgotten: a statement which
+ *	still exists on the server (e.g. after an error which only lost
+ *	some of them) is never prepared again under the same name.
+ */
+#define	MAX_CATALOG_PLANS	32
+#define	CATALOG_PLAN_NAME	"_PLAN_CATALOG%d"
+
+static BOOL
+is_search_argument(const char *query, const char *lit)
+{
+	const char	*p = lit;
+
+	while (p > query && isspace((UCHAR) p[-1]))
+		p--;
+	if (p > query && '=' == p[-1])
+		return TRUE;
+	if (p - query >= 4 && 0 == strnicmp(p - 4, "like", 4) &&
+	    (p - query == 4 || !(isalnum((UCHAR) p[-5]) || '_' == p[-5])))
+		return TRUE;
+	return FALSE;
+}
+
+/*
+ *	Returns a malloc'ed EXECUTE command which is equivalent to the
+ *	query, or NULL when the query should be sent as it is.
+ */
+static char *
+catalog_query_to_execute(ConnectionClass *conn, const char *query)
+{
+	CSTR	func = "catalog_query_to_execute";
+	size_t	qlen = strlen(query);
+	char	*shape = NULL, *args = NULL, *execq = NULL;
+	const char	*p, *lit;
+	size_t	spos = 0, apos = 0;
+	int	nparams = 0, i, id;
+	BOOL	backslash_escape, prepared;
+	char	cmd[64];
+	QResultClass	*res;
+
+	if (!conn->connInfo.use_server_side_prepare ||
+	    PG_VERSION_LT(conn, 7.3))
+		return NULL;
+	if (NULL == (shape = malloc(2 * qlen + 1)) ||
+	    NULL == (args = malloc(qlen + 1)))
+		goto cleanup;
+	for (p = query; *p;)
+	{
+		if ('"' == *p)	/* quoted identifier */
+		{
+			do
+			{
+				shape[spos++] = *p++;
+			} while (*p && '"' != *p);
+			if (*p)
+				shape[spos++] = *p++;
+			continue;
+		}
+		lit = p;
+		if (isdigit((UCHAR) *p) &&
+		    (p == query || !(isalnum((UCHAR) p[-1]) || '_' == p[-1] || '$' == p[-1] || '.' == p[-1])))
+		{
+			while (isdigit((UCHAR) *p) || '.' == *p)
+				p++;
+			if (!(isalpha((UCHAR) *p) || '_' == *p) &&
+			    is_search_argument(query, lit))
+			{
+				spos += sprintf(shape + spos, "$%d", ++nparams);
+				if (apos > 0)
+					args[apos++] = ',';
+				memcpy(args + apos, lit, p - lit);
+				apos += (p - lit);
+			}
+			else
+			{
+				memcpy(shape + spos, lit, p - lit);
+				spos += (p - lit);
+			}
+			continue;
+		}
+		backslash_escape = (0 != CC_get_escape(conn));
+		if (('E' == *p || 'e' == *p) && '\'' == p[1] &&
+		    (p == query || !(isalnum((UCHAR) p[-1]) || '_' == p[-1])))
+		{
+			backslash_escape = TRUE;
+			p++;
+		}
+		if ('\'' != *p)
+		{
+			shape[spos++] = *p++;
+			continue;
+		}
+		for (p++; *p; p++)
+		{
+			if (backslash_escape && '\\' == *p && p[1])
+				p++;
+			else if ('\'' == *p)
+			{
+				if ('\'' != p[1])
+					break;
+				p++;
+			}
+		}
+		if (*p)
+			p++;
+		if (is_search_argument(query, lit))
+		{
+			spos += sprintf(shape + spos, "$%d", ++nparams);
+			if (apos > 0)
+				args[apos++] = ',';
+			memcpy(args + apos, lit, p - lit);
+			apos += (p - lit);
+		}
+		else
+		{
+			memcpy(shape + spos, lit, p - lit);
+			spos += (p - lit);
+		}
+	}
+	shape[spos] = '\0';
+	args[apos] = '\0';
+
+	CONNLOCK_ACQUIRE(conn);
+	for (i = 0; i < conn->num_catalog_plans; i++)
+	{
+		if (0 == strcmp(shape, conn->catalog_plans[i].shape))
+			break;
+	}
+	if (i < conn->num_catalog_plans)
+	{
+		prepared = (CATALOG_PLAN_READY == conn->catalog_plans[i].state);
+		id = conn->catalog_plans[i].id;
+		CONNLOCK_RELEASE(conn);
+		if (!prepared)
+			goto cleanup;
+	}
+	else
+	{
+		char	*prepq;
+		CATALOG_PLAN	*plans;
+
+		if (conn->num_catalog_plans >= MAX_CATALOG_PLANS ||
+		    NULL == (prepq = malloc(spos + 64)))
+		{
+			CONNLOCK_RELEASE(conn);
+			goto cleanup;
+		}
+		plans = realloc(conn->catalog_plans, sizeof(CATALOG_PLAN) * (conn->num_catalog_plans + 1));
+		if (!plans)
+		{
+			CONNLOCK_RELEASE(conn);
+			free(prepq);
+			goto cleanup;
+		}
+		conn->catalog_plans = plans;
+		/* the other calls send this shape as it is until it's prepared */
+		plans[i].shape = shape;
+		plans[i].id = id = conn->catalog_plan_seq++;
+		plans[i].state = CATALOG_PLAN_PREPARING;
+		conn->num_catalog_plans++;
+		sprintf(prepq, "PREPARE \"" CATALOG_PLAN_NAME "\" AS %s", id, shape);
+		CONNLOCK_RELEASE(conn);
+
+		res = CC_send_query(conn, prepq, NULL, IGNORE_ABORT_ON_CONN | ROLLBACK_ON_ERROR, NULL);
+		prepared = QR_command_maybe_successful(res);
+		QR_Destructor(res);
+		if (!prepared)
+			mylog("%s: couldn't %s\n", func, prepq);
+		free(prepq);
+
+		CONNLOCK_ACQUIRE(conn);
+		/* CC_clear_catalog_plans() may have freed the entry meanwhile */
+		if (i < conn->num_catalog_plans &&
+		    shape == conn->catalog_plans[i].shape)
+			conn->catalog_plans[i].state = (prepared ? CATALOG_PLAN_READY : CATALOG_PLAN_FAILED);
+		else
+			prepared = FALSE;
+		CONNLOCK_RELEASE(conn);
+		shape = NULL;	/* owned by conn->catalog_plans */
+		if (!prepared)
+			goto cleanup;
+	}
+	snprintf(cmd, sizeof(cmd), "EXECUTE \"" CATALOG_PLAN_NAME "\"", id);
+	if (NULL == (execq = malloc(strlen(cmd) + apos + 3)))
+		goto cleanup;
+	if (nparams > 0)
+		sprintf(execq, "%s(%s)", cmd, args);
+	else
+		strcpy(execq, cmd);
+	mylog("%s: %s\n", func, execq);
+cleanup:
+	if (shape)
+		free(shape);
+	if (args)
+		free(args);
+	return execq;
+}
+
+/*
+ *	Forget the prepared catalog queries when they have been removed
+ *	behind our back (e.g. by DISCARD ALL).
+ */
+static BOOL
+catalog_plan_is_lost(ConnectionClass *conn, const QResultClass *res)
+{
+	if (NULL == res || 0 != strcmp(res->sqlstate, "26000"))
+		return FALSE;
+	CC_clear_catalog_plans(conn);
+	return TRUE;
+}
+
+static RETCODE
+exec_catalog_query(HSTMT hstmt, const char *query)
+{
+	StatementClass	*stmt = (StatementClass *) hstmt;
+	ConnectionClass	*conn = SC_get_conn(stmt);
+	char	*execq;
+	RETCODE	ret;
+
+	if (NULL == (execq = catalog_query_to_execute(conn, query)))
+		return PGAPI_ExecDirect(hstmt, query, SQL_NTS, 0);
+	ret = PGAPI_ExecDirect(hstmt, execq, SQL_NTS, 0);
+	free(execq);
+	if (!SQL_SUCCEEDED(ret) &&
+	    catalog_plan_is_lost(conn, SC_get_Result(stmt)) &&
+	    !CC_is_in_error_trans(conn))
+		ret = PGAPI_ExecDirect(hstmt, query, SQL_NTS, 0);
+	return ret;
+}
+
+static QResultClass *
+send_catalog_query(ConnectionClass *conn, const char *query, StatementClass *stmt)
+{
+	char	*execq;
+	QResultClass	*res;
+
+	if (NULL == (execq = catalog_query_to_execute(conn, query)))
+		return CC_send_query(conn, query, NULL, IGNORE_ABORT_ON_CONN, stmt);
+	res = CC_send_query(conn, execq, NULL, IGNORE_ABORT_ON_CONN, stmt);
+	free(execq);
+	if (!QR_command_maybe_successful(res) &&
+	    catalog_plan_is_lost(conn, res) &&
+	    !CC_is_in_error_trans(conn))
+	{
+		QR_Destructor(res);
+		res = CC_send_query(conn, query, NULL, IGNORE_ABORT_ON_CONN, stmt);
+	}
+	return res;
+}
+
+/*
+ *	The results of SQLTables, SQLColumns, SQLStatistics and SQLPrimaryKeys
+ *	are cached per connection when CatalogCacheTTL is positive.  They are
+ *	keyed by the function and its arguments and are handed out as copies.
+ *	An entry expires after CatalogCacheTTL seconds, and all the entries
+ *	are dropped when CREATE, ALTER, DROP, GRANT or REVOKE is executed
+ *	(see SC_execute()), when a ROLLBACK is issued or when search_path
+ *	changes (see CC_on_set_command()).
+ */
+#define	MAX_CATALOG_CACHE	64
+
+/*
+ *	The variable arguments are nargs pairs of (const SQLCHAR *, SQLSMALLINT).
+ *	Returns a malloc'ed key, or NULL when the cache is disabled.
+ */
+static char *
+catalog_cache_key(const ConnectionClass *conn, const char *func, UInt4 opt1, UInt4 opt2, int nargs, ...)
+{
+	va_list	args;
+	const char	*arg;
+	char	*key, *p;
+	size_t	keylen;
+	int	i, len;
+
+	if (conn->connInfo.drivers.catalog_cache_ttl <= 0)
+		return NULL;
+	keylen = strlen(func) + 24;
+	va_start(args, nargs);
+	for (i = 0; i < nargs; i++)
+	{
+		arg = va_arg(args, const char *);
+		len = va_arg(args, int);
+		if (NULL != arg && SQL_NTS == len)
+			len = (int) strlen(arg);
+		keylen += (len > 0 ? len : 0) + 8;
+	}
+	va_end(args);
+	if (NULL == (key = malloc(keylen)))
+		return NULL;
+
+	p = key + sprintf(key, "%s(%u,%u", func, opt1, opt2);
+	va_start(args, nargs);
+	for (i = 0; i < nargs; i++)
+	{
+		arg = va_arg(args, const char *);
+		len = va_arg(args, int);
+		if (NULL == arg || (len < 0 && SQL_NTS != len))
+		{
+			/* make_string() regards this as NULL */
+			strcpy(p, ",-");
+			p += 2;
+			continue;
+		}
+		if (SQL_NTS == len)
+			len = (int) strlen(arg);
+		else
+		{
+			const char	*eos = memchr(arg, '\0', len);
+
+			if (NULL != eos)
+				len = (int) (eos - arg);
+		}
+		p += sprintf(p, ",%d:", len);
+		memcpy(p, arg, len);
+		p += len;
+	}
+	va_end(args);
+	strcpy(p, ")");
+
+	return key;
+}
+
+/*
+ *	Sets a copy of the cached result to the statement if there is an
+ *	alive one for the key.
+ */
+static BOOL
+catalog_cache_fetch(StatementClass *stmt, const char *key)
+{
+	ConnectionClass	*conn = SC_get_conn(stmt);
+	const CATALOG_CACHE	*entry;
+	QResultClass	*res = NULL;
+	time_t	now;
+	int	i;
+
+	if (NULL == key)
+		return FALSE;
+	now = time(NULL);
+	CONNLOCK_ACQUIRE(conn);
+	for (i = 0; i < conn->num_catalog_cache; i++)
+	{
+		entry = conn->catalog_cache + i;
+		if (0 != strcmp(entry->key, key))
+			continue;
+		if (now >= entry->stamp &&
+		    now - entry->stamp < conn->connInfo.drivers.catalog_cache_ttl)
+			res = QR_copy_manual(entry->res);
+		break;
+	}
+	CONNLOCK_RELEASE(conn);
+	if (NULL == res)
+		return FALSE;
+
+	mylog("catalog_cache_fetch: %s hit\n", key);
+	SC_set_Result(stmt, res);
+	extend_column_bindings(SC_get_ARDF(stmt), QR_NumResultCols(res));
+	stmt->catalog_result = TRUE;
+	return TRUE;
+}
+
+/*
+ *	Keeps a copy of the result, replacing the stale entry for the key
+ *	or the oldest entry when the cache is full.
+ */
+static void
+catalog_cache_store(ConnectionClass *conn, const char *key, const QResultClass *res)
+{
+	CATALOG_CACHE	*entry;
+	QResultClass	*copy;
+	char	*newkey = NULL;
+	int	i;
+
+	if (NULL == key || !QR_command_maybe_successful(res))
+		return;
+	if (NULL == (copy = QR_copy_manual(res)))
+		return;
+	CONNLOCK_ACQUIRE(conn);
+	for (i = 0; i < conn->num_catalog_cache; i++)
+	{
+		if (0 == strcmp(conn->catalog_cache[i].key, key))
+			break;
+	}
+	if (i >= conn->num_catalog_cache &&
+	    NULL == (newkey = strdup(key)))
+		goto cleanup;
+	if (i < conn->num_catalog_cache)
+		entry = conn->catalog_cache + i;
+	else if (conn->num_catalog_cache < MAX_CATALOG_CACHE)
+	{
+		if (NULL == conn->catalog_cache &&
+		    NULL == (conn->catalog_cache = (CATALOG_CACHE *) malloc(sizeof(CATALOG_CACHE) * MAX_CATALOG_CACHE)))
+			goto cleanup;
+		entry = conn->catalog_cache + conn->num_catalog_cache++;
+		entry->key = NULL;
+		entry->res = NULL;
+	}
+	else
+	{
+		entry = conn->catalog_cache;
+		for (i = 1; i < conn->num_catalog_cache; i++)
+		{
+			if (conn->catalog_cache[i].stamp < entry->stamp)
+				entry = conn->catalog_cache + i;
+		}
+	}
+	if (NULL != newkey)
+	{
+		if (entry->key)
+			free(entry->key);
+		entry->key = newkey;
+		newkey = NULL;
+	}
+	QR_Destructor(entry->res);
+	entry->res = copy;
+	copy = NULL;
+	entry->stamp = time(NULL);
+cleanup:
+	CONNLOCK_RELEASE(conn);
+	if (newkey)
+		free(newkey);
+	QR_Destructor(copy);
+}
+
 RETCODE		SQL_API
 PGAPI_Tables(
 			 HSTMT hstmt,
@@ -1541,6 +1977,7 @@ PGAPI_Tables(
 	ConnectionClass *conn;
 	ConnInfo   *ci;
 	char	*escCatName = NULL, *escSchemaName = NULL, *escTableName = NULL;
+	char	*cache_key = NULL;
 	char	   *prefix[32],
 				prefixes[MEDIUM_REGISTRY_LEN];
 	char	   *table_type[32],
@@ -1578,6 +2015,14 @@ PGAPI_Tables(
 	cbSchemaName = cbTableOwner;
 
 #define	return	DONT_CALL_RETURN_FROM_HERE???
+	cache_key = catalog_cache_key(conn, func, flag, 0, 4,
+			szTableQualifier, cbTableQualifier, szTableOwner, cbTableOwner,
+			szTableName, cbTableName, szTableType, cbTableType);
+	if (catalog_cache_fetch(stmt, cache_key))
+	{
+		ret = SQL_SUCCESS;
+		goto cleanup;
+	}
 	search_pattern = (0 == (flag & PODBC_NOT_SEARCH_PATTERN));
 	if (search_pattern) 
 	{
@@ -1781,7 +2226,7 @@ retry_public_schema:
 		strcat(tables_query, " and usesysid = relowner order by relname");
 	}
 
-	result = PGAPI_ExecDirect(htbl_stmt, tables_query, SQL_NTS, 0);
+	result = exec_catalog_query(htbl_stmt, tables_query);
 	if (!SQL_SUCCEEDED(result))
 	{
 		SC_full_error_copy(stmt, htbl_stmt, FALSE);
@@ -1954,6 +2399,7 @@ retry_public_schema:
 		SC_full_error_copy(stmt, htbl_stmt, FALSE);
 		goto cleanup;
 	}
+	catalog_cache_store(conn, cache_key, res);
 	ret = SQL_SUCCESS;
 
 cleanup:
@@ -1972,6 +2418,8 @@ cleanup:
 		free(escTableName);
 	if (tableType)
 		free(tableType);
+	if (cache_key)
+		free(cache_key);
 	/* set up the current tuple pointer for SQLFetch */
 	stmt->currTuple = -1;
 	SC_set_rowset_start(stmt, -1, FALSE);
@@ -2027,6 +2475,7 @@ PGAPI_Columns(
 	char		not_null[MAX_INFO_STRING],
 				relhasrules[MAX_INFO_STRING], relkind[8];
 	char	*escSchemaName = NULL, *escTableName = NULL, *escColumnName = NULL;
+	char	*cache_key = NULL;
 	BOOL	search_pattern = TRUE, search_by_ids, relisaview;
 	ConnInfo   *ci;
 	ConnectionClass *conn;
@@ -2048,6 +2497,14 @@ PGAPI_Columns(
 #endif /* UNICODE_SUPPORT */
 
 #define	return	DONT_CALL_RETURN_FROM_HERE???
+	cache_key = catalog_cache_key(conn, func, flag | ((UInt4) attnum << 16), reloid, 4,
+			szTableQualifier, cbTableQualifier, szTableOwner, cbTableOwner,
+			szTableName, cbTableName, szColumnName, cbColumnName);
+	if (catalog_cache_fetch(stmt, cache_key))
+	{
+		result = SQL_SUCCESS;
+		goto cleanup;
+	}
 	search_by_ids = ((flag & PODBC_SEARCH_BY_IDS) != 0);
 	if (search_by_ids)
 	{
@@ -2162,7 +2619,7 @@ retry_public_schema:
 	mylog("%s: hcol_stmt = %p, col_stmt = %p\n", func, hcol_stmt, col_stmt);
 
 	col_stmt->internal = TRUE;
-	result = PGAPI_ExecDirect(hcol_stmt, columns_query, SQL_NTS, 0);
+	result = exec_catalog_query(hcol_stmt, columns_query);
 	if (!SQL_SUCCEEDED(result))
 	{
 		SC_full_error_copy(stmt, col_stmt, FALSE);
@@ -2707,6 +3164,7 @@ mylog(" and the data=%s\n", attdef);
 		set_tuplefield_int4(&tuple[COLUMNS_ATTTYPMOD], -1);
 		ordinal++;
 	}
+	catalog_cache_store(conn, cache_key, res);
 	result = SQL_SUCCESS;
 
 cleanup:
@@ -2729,6 +3187,8 @@ cleanup:
 		free(escTableName);
 	if (escColumnName)
 		free(escColumnName);
+	if (cache_key)
+		free(cache_key);
 	if (hcol_stmt)
 		PGAPI_FreeStmt(hcol_stmt, SQL_DROP);
 	if (stmt->internal)
@@ -2828,7 +3288,7 @@ retry_public_schema:
 
 	mylog("%s: hcol_stmt = %p, col_stmt = %p\n", func, hcol_stmt, col_stmt);
 
-	result = PGAPI_ExecDirect(hcol_stmt, columns_query, SQL_NTS, 0);
+	result = exec_catalog_query(hcol_stmt, columns_query);
 	if (!SQL_SUCCEEDED(result))
 	{
 		SC_full_error_copy(stmt, col_stmt, FALSE);
@@ -3007,6 +3467,7 @@ PGAPI_Statistics(
 	HSTMT		hcol_stmt = NULL, hindx_stmt = NULL;
 	RETCODE		ret = SQL_ERROR, result;
 	char		*escSchemaName = NULL, *table_name = NULL, *escTableName = NULL;
+	char		*cache_key = NULL;
 	char		index_name[MAX_INFO_STRING];
 	short		fields_vector[INDEX_KEYS_STORAGE_COUNT + 1];
 	short		indopt_vector[INDEX_KEYS_STORAGE_COUNT + 1];
@@ -3086,6 +3547,14 @@ PGAPI_Statistics(
 	QR_set_field_info_v(res, STATS_FILTER_CONDITION, "FILTER_CONDITION", PG_TYPE_VARCHAR, MAX_INFO_STRING);
 
 #define	return	DONT_CALL_RETURN_FROM_HERE???
+	cache_key = catalog_cache_key(conn, func, fUnique, fAccuracy, 3,
+			szTableQualifier, cbTableQualifier, szTableOwner, cbTableOwner,
+			szTableName, cbTableName);
+	if (catalog_cache_fetch(stmt, cache_key))
+	{
+		ret = SQL_SUCCESS;
+		goto cleanup;
+	}
 	szSchemaName = szTableOwner;
 	cbSchemaName = cbTableOwner;
 
@@ -3229,7 +3698,7 @@ PGAPI_Statistics(
 	else
 		strcat(index_query, " i.indisunique, c.relname");
 
-	result = PGAPI_ExecDirect(hindx_stmt, index_query, SQL_NTS, 0);
+	result = exec_catalog_query(hindx_stmt, index_query);
 	if (!SQL_SUCCEEDED(result))
 	{
 		/*
@@ -3466,6 +3935,7 @@ PGAPI_Statistics(
 		SC_full_error_copy(stmt, indx_stmt, FALSE);
 		goto cleanup;
 	}
+	catalog_cache_store(conn, cache_key, res);
 	ret = SQL_SUCCESS;
 
 cleanup:
@@ -3487,6 +3957,8 @@ cleanup:
 		free(escTableName);
 	if (escSchemaName)
 		free(escSchemaName);
+	if (cache_key)
+		free(cache_key);
 	if (column_names)
 	{
 		for (i = 0; i < total_columns; i++)
@@ -3656,6 +4128,7 @@ PGAPI_PrimaryKeys(
 	SQLSMALLINT	internal_asis_type = SQL_C_CHAR, cbSchemaName;
 	const char	*szSchemaName, *eq_string;
 	char	*escSchemaName = NULL, *escTableName = NULL;
+	char	*cache_key = NULL;
 
 	mylog("%s: entering...stmt=%p scnm=%p len=%d\n", func, stmt, szTableOwner, cbTableOwner);
 
@@ -3703,6 +4176,14 @@ PGAPI_PrimaryKeys(
 #endif /* UNICODE_SUPPORT */
 
 #define	return	DONT_CALL_RETURN_FROM_HERE???
+	cache_key = catalog_cache_key(conn, func, 0, reloid, 3,
+			szTableQualifier, cbTableQualifier, szTableOwner, cbTableOwner,
+			szTableName, cbTableName);
+	if (catalog_cache_fetch(stmt, cache_key))
+	{
+		ret = SQL_SUCCESS;
+		goto cleanup;
+	}
 	if (0 != reloid)
 	{
 		szSchemaName = NULL;
@@ -3885,7 +4366,7 @@ retry_public_schema:
 		}
 		mylog("%s: tables_query='%s'\n", func, tables_query);
 
-		result = PGAPI_ExecDirect(htbl_stmt, tables_query, SQL_NTS, 0);
+		result = exec_catalog_query(htbl_stmt, tables_query);
 		if (!SQL_SUCCEEDED(result))
 		{
 			SC_full_error_copy(stmt, tbl_stmt, FALSE);
@@ -3945,6 +4426,7 @@ retry_public_schema:
 		ret = SQL_ERROR;
 		goto cleanup;
 	}
+	catalog_cache_store(conn, cache_key, res);
 	ret = SQL_SUCCESS;
 
 cleanup:
@@ -3964,6 +4446,8 @@ cleanup:
 		free(escSchemaName);
 	if (escTableName)
 		free(escTableName);
+	if (cache_key)
+		free(cache_key);
 	/* set up the current tuple pointer for SQLFetch */
 	stmt->currTuple = -1;
 	SC_set_rowset_start(stmt, -1, FALSE);
@@ -4307,7 +4791,7 @@ PGAPI_ForeignKeys_old(
 				"order by pt.tgconstrname",
 				eq_string, escFkTableName);
 
-		result = PGAPI_ExecDirect(htbl_stmt, tables_query, SQL_NTS, 0);
+		result = exec_catalog_query(htbl_stmt, tables_query);
 
 		if (!SQL_SUCCEEDED(result))
 		{
@@ -4677,7 +5161,7 @@ PGAPI_ForeignKeys_old(
 				" order by pt.tgconstrname",
 				eq_string, escPkTableName);
 
-		result = PGAPI_ExecDirect(htbl_stmt, tables_query, SQL_NTS, 0);
+		result = exec_catalog_query(htbl_stmt, tables_query);
 		if (!SQL_SUCCEEDED(result))
 		{
 			SC_error_copy(stmt, tbl_stmt, TRUE);
@@ -4975,7 +5459,7 @@ PGAPI_ForeignKeys(
 			SQLSMALLINT cbFkTableName)
 {
 	ConnectionClass	*conn = SC_get_conn(((StatementClass *) hstmt));
-	if (PG_VERSION_GE(conn, 8.1))
+	if (PG_VERSION_GE(conn, 7.3))
 		return PGAPI_ForeignKeys_new(hstmt,
 				szPkTableQualifier, cbPkTableQualifier,
 				szPkTableOwner, cbPkTableOwner,
@@ -5103,7 +5587,7 @@ PGAPI_ProcedureColumns(
 			snprintf_add(proc_query, sizeof(proc_query), " and proname %s'%s'", op_string, escProcName);
 		strcat(proc_query, " order by proname, proretset");
 	}
-	if (tres = CC_send_query(conn, proc_query, NULL, IGNORE_ABORT_ON_CONN, stmt), !QR_command_maybe_successful(tres))
+	if (tres = send_catalog_query(conn, proc_query, stmt), !QR_command_maybe_successful(tres))
 	{
 		SC_set_error(stmt, STMT_EXEC_ERROR, "PGAPI_ProcedureColumns query error", func);
 		QR_Destructor(tres);
@@ -5476,7 +5960,7 @@ PGAPI_Procedures(
 		my_strcat1(proc_query, " where proname %s'%.*s'", op_string, escSchemaName, SQL_NTS);
 	}
 
-	if (res = CC_send_query(conn, proc_query, NULL, IGNORE_ABORT_ON_CONN, stmt), !QR_command_maybe_successful(res))
+	if (res = send_catalog_query(conn, proc_query, stmt), !QR_command_maybe_successful(res))
 	{
 		SC_set_error(stmt, STMT_EXEC_ERROR, "PGAPI_Procedures query error", func);
 		QR_Destructor(res);
@@ -5867,7 +6351,9 @@ PGAPI_ForeignKeys_new(
 	char		catName[SCHEMA_NAME_STORAGE_LEN],
 			scmName1[SCHEMA_NAME_STORAGE_LEN],
 			scmName2[SCHEMA_NAME_STORAGE_LEN];
-	const char	*relqual;
+	const char	*relqual, *key_seq, *key_seq_from, *key_seq_qual;
+	char		key_seq_list[INDEX_KEYS_STORAGE_COUNT * 24];
+	int		i;
 	ConnectionClass *conn = SC_get_conn(stmt);
 
 	const char *eq_string;
@@ -5924,6 +6410,25 @@ PGAPI_ForeignKeys_new(
 		strcpy(scmName1, "n2.nspname");
 		strcpy(scmName2, "n1.nspname");
 		escSchemaName = simpleCatalogEscape(schema_needed, SQL_NTS, NULL, conn);
+		/*
+		 *	One row per key column of each constraint. The servers
+		 *	without generate_series() join a list of the key positions.
+		 */
+		if (PG_VERSION_GE(conn, 8.0))
+		{
+			key_seq = "generate_series(array_lower(conkey, 1), array_upper(conkey, 1))";
+			key_seq_from = key_seq_qual = NULL_STRING;
+		}
+		else
+		{
+			strcpy(key_seq_list, ",\n	(select 1 as i");
+			for (i = 2; i <= INDEX_KEYS_STORAGE_COUNT; i++)
+				snprintf_add(key_seq_list, sizeof(key_seq_list), " union all select %d", i);
+			strcat(key_seq_list, ") s");
+			key_seq = "s.i";
+			key_seq_from = key_seq_list;
+			key_seq_qual = "\n   and  conkey[s.i] is not null";
+		}
 
 		snprintf(tables_query, sizeof(tables_query),
 		"select"
@@ -5965,13 +6470,13 @@ PGAPI_ForeignKeys_new(
 		"\n from"
 		"\n ((((((("
 		" (select cn.oid, conrelid, conkey, confrelid, confkey"
-		",\n	 generate_series(array_lower(conkey, 1), array_upper(conkey, 1)) as i"
+		",\n	 %s as i"
 		",\n	 confupdtype, confdeltype, conname"
 		",\n	 condeferrable, condeferred"
 		"\n  from pg_catalog.pg_constraint cn"
 		",\n	pg_catalog.pg_class c"
-		",\n	pg_catalog.pg_namespace n"
-		"\n  where contype = 'f' %s"
+		",\n	pg_catalog.pg_namespace n%s"
+		"\n  where contype = 'f' %s%s"
 		"\n   and  relname %s'%s'"
 		"\n   and  n.oid = c.relnamespace"
 		"\n   and  n.nspname %s'%s'"
@@ -6012,7 +6517,9 @@ PGAPI_ForeignKeys_new(
 		, SQL_INITIALLY_IMMEDIATE
 		, SQL_NOT_DEFERRABLE
 #endif /* ODBCVER */
-		, relqual
+		, key_seq
+		, key_seq_from
+		, relqual, key_seq_qual
 		, eq_string, escTableName
 		, eq_string, escSchemaName);
 
@@ -6113,7 +6620,7 @@ PGAPI_ForeignKeys_new(
 		, relqual, eq_string, escTableName);
 	}
 
-	if (res = CC_send_query(conn, tables_query, NULL, IGNORE_ABORT_ON_CONN, stmt), !QR_command_maybe_successful(res))
+	if (res = send_catalog_query(conn, tables_query, stmt), !QR_command_maybe_successful(res))
 	{
 		SC_set_error(stmt, STMT_EXEC_ERROR, "PGAPI_ForeignKeys query error", func);
 		QR_Destructor(res);
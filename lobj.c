@@ -181,3 +181,164 @@ odbc_lo_unlink(ConnectionClass *conn, OID lobjId)
 	else
 		return retval;
 }
+
+
+/*
+ *	Buffered stream on a large object.
+ */
+void
+odbc_lo_stream_init(LO_STREAM *lst)
+{
+	lst->buffer = NULL;
+	lst->buflen = lst->filled = lst->pos = 0;
+	lst->writing = lst->eof = FALSE;
+}
+
+void
+odbc_lo_stream_discard(LO_STREAM *lst)
+{
+	if (lst->buffer)
+		free(lst->buffer);
+	odbc_lo_stream_init(lst);
+}
+
+static BOOL
+lo_stream_alloc(LO_STREAM *lst)
+{
+	if (NULL == lst->buffer)
+	{
+		if (lst->buffer = malloc(LO_STREAM_BUFSIZE), NULL == lst->buffer)
+			return FALSE;
+		lst->buflen = LO_STREAM_BUFSIZE;
+	}
+	return TRUE;
+}
+
+/*
+ *	Read nchunks chunks of LO_READ_CHUNK_SIZE bytes by pipelined
+ *	lo_read calls.
+ */
+static Int4
+lo_read_chunks(ConnectionClass *conn, int fd, char *buf, int nchunks)
+{
+	LO_ARG		argv[2];
+	Int4		result_len;
+
+	argv[0].isint = 1;
+	argv[0].len = 4;
+	argv[0].u.integer = fd;
+
+	argv[1].isint = 1;
+	argv[1].len = 4;
+	argv[1].u.integer = LO_READ_CHUNK_SIZE;
+
+	if (!CC_send_function_pipelined(conn, LO_READ, buf, nchunks * LO_READ_CHUNK_SIZE, &result_len, argv, 2, nchunks))
+		return -1;
+	return result_len;
+}
+
+Int4
+odbc_lo_stream_read(ConnectionClass *conn, int fd, LO_STREAM *lst, char *buf, Int4 len)
+{
+	Int4	nread = 0, avail, retval;
+
+	if (lst->writing)
+	{
+		if (odbc_lo_stream_flush(conn, fd, lst) < 0)
+			return -1;
+		lst->writing = FALSE;
+	}
+	while (nread < len)
+	{
+		if (lst->pos < lst->filled)
+		{
+			avail = lst->filled - lst->pos;
+			if (avail > len - nread)
+				avail = len - nread;
+			memcpy(buf + nread, lst->buffer + lst->pos, avail);
+			lst->pos += avail;
+			nread += avail;
+			continue;
+		}
+		if (lst->eof)
+			break;
+		if (len - nread >= LO_STREAM_BUFSIZE)
+		{
+			int	nchunks = (len - nread) / LO_READ_CHUNK_SIZE;
+
+			/* large enough to read into the caller's buffer directly */
+			if (retval = lo_read_chunks(conn, fd, buf + nread, nchunks), retval < 0)
+				return -1;
+			nread += retval;
+			if (retval < nchunks * LO_READ_CHUNK_SIZE)
+				lst->eof = TRUE;
+			continue;
+		}
+		if (!lo_stream_alloc(lst))
+			return -1;
+		if (retval = lo_read_chunks(conn, fd, lst->buffer, LO_READAHEAD_REQUESTS), retval < 0)
+			return -1;
+		lst->pos = 0;
+		lst->filled = retval;
+		if (retval < LO_STREAM_BUFSIZE)
+			lst->eof = TRUE;
+	}
+
+	return nread;
+}
+
+Int4
+odbc_lo_stream_write(ConnectionClass *conn, int fd, LO_STREAM *lst, const char *buf, Int4 len)
+{
+	if (len <= 0)
+		return 0;
+	if (!lst->writing)
+	{
+		/* discard the data read ahead */
+		lst->filled = lst->pos = 0;
+		lst->eof = FALSE;
+		lst->writing = TRUE;
+	}
+	if (lst->filled + len > LO_STREAM_BUFSIZE)
+	{
+		if (odbc_lo_stream_flush(conn, fd, lst) < 0)
+			return -1;
+		/* large enough to be sent as it is */
+		if (len >= LO_STREAM_BUFSIZE)
+			return odbc_lo_write(conn, fd, (char *) buf, len);
+	}
+	if (!lo_stream_alloc(lst))
+		return -1;
+	memcpy(lst->buffer + lst->filled, buf, len);
+	lst->filled += len;
+
+	return len;
+}
+
+int
+odbc_lo_stream_flush(ConnectionClass *conn, int fd, LO_STREAM *lst)
+{
+	Int4	retval = 0;
+
+	if (lst->writing && lst->filled > 0)
+	{
+		retval = odbc_lo_write(conn, fd, lst->buffer, lst->filled);
+		if (retval < lst->filled)
+			retval = -1;
+		lst->filled = 0;
+	}
+	return retval;
+}
+
+int
+odbc_lo_stream_close(ConnectionClass *conn, int fd, LO_STREAM *lst)
+{
+	int	retval, flushed;
+
+	flushed = odbc_lo_stream_flush(conn, fd, lst);
+	odbc_lo_stream_discard(lst);
+	retval = odbc_lo_close(conn, fd);
+	if (flushed < 0)
+		return -1;
+	return retval;
+}
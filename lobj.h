@@ -35,6 +35,26 @@ struct lo_arg
 #define INV_WRITE					0x00020000
 #define INV_READ					0x00040000
 
+/*
+ *	Buffered stream on a large object.
+ *	Reads are served from a read-ahead buffer refilled by several
+ *	pipelined lo_read calls and small writes are coalesced into
+ *	one lo_write.
+ */
+struct lo_stream
+{
+	char	*buffer;
+	Int4	buflen;		/* allocated size of the buffer */
+	Int4	filled;		/* bytes read ahead or writes pending */
+	Int4	pos;		/* read position in the buffer */
+	char	writing;
+	char	eof;
+};
+
+#define	LO_READ_CHUNK_SIZE			(64 * 1024)
+#define	LO_READAHEAD_REQUESTS			4
+#define	LO_STREAM_BUFSIZE			(LO_READ_CHUNK_SIZE * LO_READAHEAD_REQUESTS)
+
 OID		odbc_lo_creat(ConnectionClass *conn, int mode);
 int		odbc_lo_open(ConnectionClass *conn, int lobjId, int mode);
 int		odbc_lo_close(ConnectionClass *conn, int fd);
@@ -44,4 +64,11 @@ Int4		odbc_lo_lseek(ConnectionClass *conn, int fd, int offset, Int4 len);
 Int4		odbc_lo_tell(ConnectionClass *conn, int fd);
 int		odbc_lo_unlink(ConnectionClass *conn, OID lobjId);
 
+void		odbc_lo_stream_init(LO_STREAM *lst);
+Int4		odbc_lo_stream_read(ConnectionClass *conn, int fd, LO_STREAM *lst, char *buf, Int4 len);
+Int4		odbc_lo_stream_write(ConnectionClass *conn, int fd, LO_STREAM *lst, const char *buf, Int4 len);
+int		odbc_lo_stream_flush(ConnectionClass *conn, int fd, LO_STREAM *lst);
+int		odbc_lo_stream_close(ConnectionClass *conn, int fd, LO_STREAM *lst);
+void		odbc_lo_stream_discard(LO_STREAM *lst);
+
 #endif
@@ -16,6 +16,9 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef	USE_SSE2
+#include <emmintrin.h>
+#endif /* USE_SSE2 */
 #ifndef	TRUE
 #define	TRUE	1
 #endif
@@ -225,9 +228,48 @@ pg_mb_maxlen(characterset_code)
 	}
 }
 
+/*
+ *	The byte length of a UTF-8 character indexed by its lead byte.
+ *	0 means the byte can't start a multibyte character.
+ */
+static const UCHAR utf8_lead_len[256] =
+{
+	/* 0x00 - 0x7f */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* 0x80 - 0xbf : trailing bytes */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* 0xc0 - 0xdf */
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	/* 0xe0 - 0xef */
+	3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+	/* 0xf0 - 0xf7 */
+	4, 4, 4, 4, 4, 4, 4, 4,
+	/* 0xf8 - 0xfb */
+	5, 5, 5, 5,
+	/* 0xfc - 0xff */
+	6, 6, 6, 6
+};
+
 int
 pg_CS_stat(int stat,unsigned int character,int characterset_code)
 {
+	/*
+	 * An ASCII byte outside of a multibyte character is a character
+	 * by itself in every supported encoding.
+	 */
+	if (stat < 2 && character < 0x80)
+		return 0;
 	if (character == 0)
 		stat = 0;
 	switch (characterset_code)
@@ -237,16 +279,8 @@ pg_CS_stat(int stat,unsigned int character,int characterset_code)
 				if (stat < 2 &&
 					character >= 0x80)
 				{
-					if (character >= 0xfc)
-						stat = 6;
-					else if (character >= 0xf8)
-						stat = 5;
-					else if (character >= 0xf0)
-						stat = 4;
-					else if (character >= 0xe0)
-						stat = 3;
-					else if (character >= 0xc0)
-						stat = 2;
+					if (utf8_lead_len[character & 0xff])
+						stat = utf8_lead_len[character & 0xff];
 				}
 				else if (stat >= 2 &&
 					character > 0x7f)
@@ -414,14 +448,77 @@ pg_CS_stat(int stat,unsigned int character,int characterset_code)
 }
 
 
+/*
+ *	Returns the length of the run of (non-null) ASCII bytes at the
+ *	head of the string.  The bytes are examined 16 at a time with SSE2,
+ *	or a word at a time otherwise, once the pointer is aligned.  An
+ *	aligned load never crosses a page boundary, so reading past the
+ *	terminating null is harmless.
+ */
+#ifdef	USE_SSE2
+#define	ASCII_RUN_ALIGN	sizeof(__m128i)
+#else
+#define	ASCII_RUN_ALIGN	sizeof(size_t)
+#define	ONES_IN_WORD	(((size_t) -1) / 0xff)
+#define	HIGHS_IN_WORD	(ONES_IN_WORD * 0x80)
+#endif /* USE_SSE2 */
+static size_t
+pg_ascii_run(const UCHAR *string)
+{
+	const UCHAR	*s = string;
+#ifdef	USE_SSE2
+	__m128i	v;
+#else
+	size_t	word;
+#endif /* USE_SSE2 */
+
+	for (; 0 != ((size_t) s & (ASCII_RUN_ALIGN - 1)); s++)
+	{
+		if (0 == *s || *s >= 0x80)
+			return s - string;
+	}
+	for (;; s += ASCII_RUN_ALIGN)
+	{
+#ifdef	USE_SSE2
+		v = _mm_load_si128((const __m128i *) s);
+		/* the sign bit of a null byte or a byte >= 0x80 is set */
+		if (0 != _mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, _mm_setzero_si128()))))
+			break;
+#else
+		memcpy(&word, s, sizeof(word));
+		/* a null byte or a byte >= 0x80 sets the high bit */
+		if (0 != ((word | (word - ONES_IN_WORD)) & HIGHS_IN_WORD))
+			break;
+#endif /* USE_SSE2 */
+	}
+	for (; 0 != *s && *s < 0x80; s++)
+		;
+	return s - string;
+}
+
 UCHAR *
 pg_mbschr(int csc, const UCHAR *string, unsigned int character)
 {
 	int			mb_st = 0;
 	const UCHAR *s, *rs = NULL;
+	size_t	alen;
 
+	if (1 == pg_mb_maxlen(csc) && 0 != character && character < 0x100)
+		return (UCHAR *) strchr((const char *) string, character);
 	for(s = string; *s ; s++) 
 	{
+		if (mb_st < 2 && *s < 0x80)
+		{
+			/* look for the character in the ASCII run at once */
+			alen = pg_ascii_run(s);
+			if (character < 0x80 &&
+			    NULL != (rs = memchr(s, character, alen)))
+				break;
+			s += alen;
+			mb_st = 0;
+			if (!*s)
+				break;
+		}
 		mb_st = pg_CS_stat(mb_st, (UCHAR) *s, csc);
 		if (mb_st == 0 && (*s == character))
 		{
@@ -436,10 +533,22 @@ size_t
 pg_mbslen(int csc, const UCHAR *string)
 {
 	UCHAR *s;
-	size_t	len;
+	size_t	len, alen;
 	int	cs_stat;
+
+	if (1 == pg_mb_maxlen(csc))
+		return strlen((const char *) string);
 	for (len = 0, cs_stat = 0, s = (UCHAR *) string; *s != 0; s++)
 	{
+		if (cs_stat < 2 && *s < 0x80)
+		{
+			alen = pg_ascii_run(s);
+			len += alen;
+			s += alen;
+			cs_stat = 0;
+			if (!*s)
+				break;
+		}
 		cs_stat = pg_CS_stat(cs_stat,(unsigned int) *s, csc);
 		if (cs_stat < 2)
 			len++;
@@ -681,7 +790,10 @@ int encoded_nextchar(encoded_str *encstr)
 	int	chr;
 
 	chr = encstr->encstr[++encstr->pos]; 
-	encstr->ccst = pg_CS_stat(encstr->ccst, (unsigned int) chr, encstr->ccsc);
+	if (encstr->ccst < 2 && (UCHAR) chr < 0x80)
+		encstr->ccst = 0;
+	else
+		encstr->ccst = pg_CS_stat(encstr->ccst, (UCHAR) chr, encstr->ccsc);
 	return chr; 
 }
 ssize_t encoded_position_shift(encoded_str *encstr, size_t shift)
@@ -694,6 +806,9 @@ int encoded_byte_check(encoded_str *encstr, size_t abspos)
 	int	chr;
 
 	chr = encstr->encstr[encstr->pos = abspos]; 
-	encstr->ccst = pg_CS_stat(encstr->ccst, (unsigned int) chr, encstr->ccsc);
+	if (encstr->ccst < 2 && (UCHAR) chr < 0x80)
+		encstr->ccst = 0;
+	else
+		encstr->ccst = pg_CS_stat(encstr->ccst, (UCHAR) chr, encstr->ccsc);
 	return chr; 
 }
@@ -20,6 +20,7 @@
 #include "connection.h"
 #include "statement.h"
 #include "qresult.h"
+#include "socket.h"
 #include "pgapifunc.h"
 
 
@@ -158,7 +159,7 @@ set_statement_option(ConnectionClass *conn,
 			}
 			break;
 
-		case SQL_MAX_ROWS:		/* ignored, but saved */
+		case SQL_MAX_ROWS:		/* enforced when executing the query */
 			mylog("SetStmtOption(): SQL_MAX_ROWS, vParam = " FORMAT_LEN "\n", vParam);
 			if (conn)
 				conn->stmtOptions.maxRows = vParam;
@@ -176,9 +177,12 @@ set_statement_option(ConnectionClass *conn,
 			mylog("SetStmtOption: SQL_NOSCAN, vParam = " FORMAT_LEN "\n", vParam);
 			break;
 
-		case SQL_QUERY_TIMEOUT:	/* ignored */
+		case SQL_QUERY_TIMEOUT:
 			mylog("SetStmtOption: SQL_QUERY_TIMEOUT, vParam = " FORMAT_LEN "\n", vParam);
-			/* "0" returned in SQLGetStmtOption */
+			if (conn)
+				conn->stmtOptions.stmt_timeout = (SQLULEN) vParam;
+			if (stmt)
+				stmt->options.stmt_timeout = (SQLULEN) vParam;
 			break;
 
 		case SQL_RETRIEVE_DATA:
@@ -402,7 +406,14 @@ PGAPI_SetConnectOption(
 			conn->login_timeout = (SQLUINTEGER) vParam;
 			break;
 
-		case SQL_PACKET_SIZE:	/* ignored */
+		case SQL_PACKET_SIZE:
+			/* the buffers are sized when the connection is made */
+			if (CONN_NOT_CONNECTED != conn->status)
+			{
+				CC_set_error(conn, CONN_OPTION_CANNOT_BE_SET_NOW, "SQL_PACKET_SIZE can't be set after the connection is made", func);
+				return SQL_ERROR;
+			}
+			conn->packet_size = (SQLUINTEGER) vParam;
 			break;
 
 		case SQL_QUIET_MODE:	/* ignored */
@@ -579,8 +590,13 @@ PGAPI_GetConnectOption(
 			*((SQLUINTEGER *) pvParam) = conn->login_timeout;
 			break;
 
-		case SQL_PACKET_SIZE:	/* NOT SUPPORTED */
-			*((SQLUINTEGER *) pvParam) = ci->drivers.socket_buffersize;
+		case SQL_PACKET_SIZE:
+			if (conn->sock && CONN_NOT_CONNECTED != conn->status)
+				*((SQLUINTEGER *) pvParam) = conn->sock->buffer_size;
+			else if (conn->packet_size > 0)
+				*((SQLUINTEGER *) pvParam) = conn->packet_size;
+			else
+				*((SQLUINTEGER *) pvParam) = ci->drivers.socket_buffersize;
 			break;
 
 		case SQL_QUIET_MODE:	/* NOT SUPPORTED */
@@ -786,7 +802,7 @@ PGAPI_GetStmtOption(
 			*((SQLLEN *) pvParam) = stmt->options.maxLength;
 			break;
 
-		case SQL_MAX_ROWS:		/* NOT SUPPORTED, but saved */
+		case SQL_MAX_ROWS:
 			*((SQLLEN *) pvParam) = stmt->options.maxRows;
 			mylog("GetSmtOption: MAX_ROWS, returning %d\n", stmt->options.maxRows);
 			break;
@@ -795,8 +811,8 @@ PGAPI_GetStmtOption(
 			*((SQLINTEGER *) pvParam) = SQL_NOSCAN_ON;
 			break;
 
-		case SQL_QUERY_TIMEOUT:	/* NOT SUPPORTED */
-			*((SQLINTEGER *) pvParam) = 0;
+		case SQL_QUERY_TIMEOUT:
+			*((SQLULEN *) pvParam) = stmt->options.stmt_timeout;
 			break;
 
 		case SQL_RETRIEVE_DATA:
@@ -36,13 +36,14 @@
 #include "catfunc.h"
 
 #include "multibyte.h"
+#include "convert.h"
 
 #define FLD_INCR	32
 #define TAB_INCR	8
 #define COLI_INCR	16
 #define COLI_RECYCLE	128
 
-static	char	*getNextToken(int ccsc, char escape_in_literal, char *s, char *token, int smax, char *delim, char *quote, char *dquote, char *numeric);
+static	char	*getNextToken(const QueryTokens *qt, char *s, char *token, int smax, char *delim, char *quote, char *dquote, char *numeric);
 static	void	getColInfo(COL_INFO *col_info, FIELD_INFO *fi, int k);
 static	char	searchColInfo(COL_INFO *col_info, FIELD_INFO *fi);
 static	BOOL	getColumnsInfo(ConnectionClass *, TABLE_INFO *, OID, StatementClass *);
@@ -77,18 +78,23 @@ Int4 FI_scale(const FIELD_INFO *fi)
 	return 0;
 }
 
+/*
+ *	Get the next token for the parser from the tokens of the statement.
+ *	s points to the rest of the statement.  The commas and the spaces
+ *	delimit the tokens, and the comments are skipped.  The quotes are
+ *	removed from the quoted tokens.
+ */
 static char *
 getNextToken(
-	int ccsc, /* client encoding */
-	char escape_ch,
+	const QueryTokens *qt,
 	char *s, char *token, int smax, char *delim, char *quote, char *dquote, char *numeric)
 {
-	int			i = 0;
-	int		out = 0, taglen;
-	char		qc, in_quote, in_dollar_quote, in_escape;
-	const	char	*tag, *tagend;
+	char		*query = (char *) qt->query;
+	const char	*src;
+	const QueryToken	*tok;
+	Int4		i, out = 0, len;
+	char		in_escape;
 	encoded_str	encstr;
-	char	literal_quote = LITERAL_QUOTE, identifier_quote = IDENTIFIER_QUOTE, dollar_quote = DOLLAR_QUOTE, escape_in_literal;
 
 	if (smax <= 1)
 		return NULL;
@@ -96,13 +102,16 @@ getNextToken(
 	smax--;
 
 	/* skip leading delimiters */
-	while (isspace((UCHAR) s[i]) || s[i] == ',')
+	for (i = QT_token_at(qt, (Int4) (s - query)); i < qt->ntokens; i++)
 	{
-		/* mylog("skipping '%c'\n", s[i]); */
-		i++;
+		tok = qt->tokens + i;
+		if (QTOK_SPACE != tok->type &&
+		    QTOK_COMMENT != tok->type &&
+		    !(QTOK_PUNCT == tok->type && ',' == query[tok->pos]))
+			break;
 	}
 
-	if (s[i] == '\0')
+	if (i >= qt->ntokens)
 	{
 		token[0] = '\0';
 		return NULL;
@@ -115,159 +124,86 @@ getNextToken(
 	if (numeric)
 		*numeric = FALSE;
 
-	encoded_str_constr(&encstr, ccsc, &s[i]);
-	/* get the next token */
-	while (s[i] != '\0' && out < smax)
+	src = query + tok->pos;
+	len = tok->len;
+	switch (tok->type)
 	{
-		encoded_nextchar(&encstr);
-		if (ENCODE_STATUS(encstr) != 0)
-		{
-			token[out++] = s[i++];
-			continue;
-		}
-		if (isspace((UCHAR) s[i]) || s[i] == ',')
-			break;
-		/* Handle quoted stuff */
-		in_quote = in_dollar_quote = FALSE;
-		taglen = 0;
-		tag = NULL;
-		escape_in_literal = '\0';
-		if (out == 0)
-		{
-			qc = s[i];
-			if (qc == dollar_quote)
+		case QTOK_LITERAL:
+		case QTOK_IDENT:
+		case QTOK_DOLLAR:
+			if (QTOK_IDENT == tok->type)
 			{
-				in_quote = in_dollar_quote = TRUE;
-				tag = s + i;
-				taglen = 1;
-				if (tagend = strchr(s + i + 1, dollar_quote), NULL != tagend)
-					taglen = tagend - s - i + 1;
-				i += (taglen - 1);
-				encoded_position_shift(&encstr, taglen - 1);
-				if (quote)
-					*quote = TRUE;
+				if (dquote)
+					*dquote = TRUE;
 			}
-			else if (qc == literal_quote)
+			else if (quote)
+				*quote = TRUE;
+			/* dont return the quotes */
+			if (QTOK_DOLLAR == tok->type)
 			{
-				in_quote = TRUE;
-				if (quote)
-					*quote = TRUE;
-				escape_in_literal = escape_ch;
-				if (!escape_in_literal)
-				{
-					if (LITERAL_EXT == s[i - 1])
-						escape_in_literal = ESCAPE_IN_LITERAL;
-				}
+				Int4	taglen = findTag(src, DOLLAR_QUOTE, qt->ccsc);
+
+				src += taglen;
+				len -= taglen;
+				if (len >= taglen && strncmp(src + len - taglen, src - taglen, taglen) == 0)
+					len -= taglen;
 			}
-			else if (qc == identifier_quote)
+			else
 			{
-				in_quote = TRUE;
-				if (dquote)
-					*dquote = TRUE;
+				src++;
+				len--;
+				if (len > 0 && src[len - 1] == query[tok->pos])
+					len--;
 			}
-		}
-		if (in_quote)
-		{
-			i++;				/* dont return the quote */
 			in_escape = FALSE;
-			while (s[i] != '\0' && out != smax)
+			encoded_str_constr(&encstr, qt->ccsc, src);
+			for (i = 0; i < len && out < smax; i++)
 			{
 				encoded_nextchar(&encstr);
 				if (ENCODE_STATUS(encstr) != 0)
-				{
-					token[out++] = s[i++];
-					continue;
-				}
-				if (in_escape)
+					token[out++] = src[i];
+				else if (in_escape)
 					in_escape = FALSE;
-				else if (s[i] == qc)
-				{
-					if (!in_dollar_quote)
-						break;
-					if (strncmp(s + i, tag, taglen) == 0)
-					{
-						i += (taglen - 1);
-						encoded_position_shift(&encstr, taglen - 1);
-						break;
-					}
-					token[out++] = s[i];
-				}
-				else if (literal_quote == qc && s[i] == escape_in_literal)
-				{
+				else if ('\0' != tok->escape && tok->escape == src[i])
 					in_escape = TRUE;
-				}
 				else
-				{
-					token[out++] = s[i];
-				}
-				i++;
+					token[out++] = src[i];
 			}
-			if (s[i] == qc)
-				i++;
 			break;
-		}
-
-		/* Check for numeric literals */
-		if (out == 0 && isdigit((UCHAR) s[i]))
-		{
+		case QTOK_NUMBER:
 			if (numeric)
 				*numeric = TRUE;
-			token[out++] = s[i++];
-			while (isalnum((UCHAR) s[i]) || s[i] == '.')
-				token[out++] = s[i++];
-
+			/* fall through */
+		default:
+			if (len > smax)
+				len = smax;
+			memcpy(token, src, len);
+			out = len;
 			break;
-		}
-
-		if (ispunct((UCHAR) s[i]) && s[i] != '_')
-		{
-			mylog("got ispunct: s[%d] = '%c'\n", i, s[i]);
-
-			if (out == 0)
-			{
-				token[out++] = s[i++];
-				break;
-			}
-			else
-				break;
-		}
-
-		if (out != smax)
-			token[out++] = s[i];
-
-		i++;
 	}
-
-	/* mylog("done -- s[%d] = '%c'\n", i, s[i]); */
-
 	token[out] = '\0';
 
-	/* find the delimiter  */
-	while (isspace((UCHAR) s[i]))
-		i++;
-
-	/* return the most priority delimiter */
-	if (s[i] == ',')
+	/* find the delimiter, and skip trailing blanks */
+	for (i = tok - qt->tokens + 1; i < qt->ntokens; i++)
 	{
-		if (delim)
-			*delim = s[i];
+		if (QTOK_SPACE != qt->tokens[i].type &&
+		    QTOK_COMMENT != qt->tokens[i].type)
+			break;
 	}
-	else if (s[i] == '\0')
+
+	/* return the most priority delimiter */
+	if (i >= qt->ntokens)
 	{
 		if (delim)
 			*delim = '\0';
+		tok = qt->tokens + qt->ntokens - 1;
+		return query + tok->pos + tok->len;
 	}
-	else
-	{
-		if (delim)
-			*delim = ' ';
-	}
-
-	/* skip trailing blanks  */
-	while (isspace((UCHAR) s[i]))
-		i++;
+	tok = qt->tokens + i;
+	if (delim)
+		*delim = (QTOK_PUNCT == tok->type && ',' == query[tok->pos]) ? ',' : ' ';
 
-	return &s[i];
+	return query + tok->pos;
 }
 
 static void
@@ -1225,6 +1161,7 @@ parse_the_statement(StatementClass *stmt, BOOL check_hasoids, BOOL sqlsvr_check)
 				unquoted;
 	char	   *ptr,
 			   *pptr = NULL;
+	const QueryTokens	*qt;
 	char		in_select = FALSE,
 				in_distinct = FALSE,
 				in_on = FALSE,
@@ -1283,9 +1220,14 @@ parse_the_statement(StatementClass *stmt, BOOL check_hasoids, BOOL sqlsvr_check)
 	}
 #define	return	DONT_CALL_RETURN_FROM_HERE???
 
+	if (qt = SC_get_tokens(stmt), NULL == qt)
+	{
+		SC_set_parse_status(stmt, STMT_PARSE_FATAL);
+		goto cleanup;
+	}
 	delim = '\0';
 	token[0] = '\0';
-	while (pptr = ptr, (delim != ',') ? strcpy(btoken, token) : (btoken[0] = '\0', NULL), (ptr = getNextToken(conn->ccsc, CC_get_escape(conn), pptr, token, sizeof(token), &delim, &quote, &dquote, &numeric)) != NULL)
+	while (pptr = ptr, (delim != ',') ? strcpy(btoken, token) : (btoken[0] = '\0', NULL), (ptr = getNextToken(qt, pptr, token, sizeof(token), &delim, &quote, &dquote, &numeric)) != NULL)
 	{
 		unquoted = !(quote || dquote);
 
@@ -1429,10 +1371,16 @@ mylog("blevel=%d btoken=%s in_dot=%d in_field=%d tbname=%s\n", blevel, btoken, i
 					if (NULL != wfi)
 						STRX_TO_NAME(wfi->column_alias, token);
 					news = insert_as_to_the_statement(stmt->statement, &pptr, &ptr);
-					if (news != stmt->statement)
+					if (NULL != news)
 					{
-						free(stmt->statement);
+						/* realloc()ed, and the tokens moved */
 						stmt->statement = news;
+						SC_forget_tokens(stmt);
+						if (qt = SC_get_tokens(stmt), NULL == qt)
+						{
+							SC_set_parse_status(stmt, STMT_PARSE_FATAL);
+							goto cleanup;
+						}
 					}
 				}
 			}
@@ -420,6 +420,16 @@ PGAPI_GetConnectAttr(HDBC ConnectionHandle,
 		case SQL_ATTR_METADATA_ID:
 			*((SQLUINTEGER *) Value) = conn->stmtOptions.metadata_id;
 			break;
+		case SQL_ATTR_PGOPT_SSL_SESSION_HITS:
+		case SQL_ATTR_PGOPT_SSL_SESSION_MISSES:
+			{
+				UInt4	hits, misses;
+
+				/* driver-wide, see SOCK_cache_ssl_session() */
+				SOCK_get_ssl_session_stats(&hits, &misses);
+				*((SQLUINTEGER *) Value) = (SQL_ATTR_PGOPT_SSL_SESSION_HITS == Attribute ? hits : misses);
+			}
+			break;
 		default:
 			ret = PGAPI_GetConnectOption(ConnectionHandle, (UWORD) Attribute, Value, &len, BufferLength);
 	}
@@ -1662,6 +1672,8 @@ PGAPI_SetConnectAttr(HDBC ConnectionHandle,
 		case SQL_ATTR_ASYNC_ENABLE:
 		case SQL_ATTR_CONNECTION_DEAD:
 		case SQL_ATTR_CONNECTION_TIMEOUT:
+		case SQL_ATTR_PGOPT_SSL_SESSION_HITS:
+		case SQL_ATTR_PGOPT_SSL_SESSION_MISSES:
 			unsupported = TRUE;
 			break;
 		case SQL_ATTR_PGOPT_DEBUG:
@@ -1943,6 +1955,7 @@ typedef struct
 	SQLSMALLINT	operation;
 	char		need_data_callback;
 	char		auto_commit_needed;
+	char		add_row_by_row;
 	ARDFields	*opts;
 	int		idx, processed;
 }	bop_cdata;
@@ -1984,6 +1997,25 @@ RETCODE	bulk_ope_callback(RETCODE retcode, void *para)
 		switch (s->operation)
 		{
 			case SQL_ADD:
+				if (!s->add_row_by_row)
+				{
+					SQLSETPOSIROW	nrow = s->opts->size_of_rowset - s->idx;
+
+					/* insert as many rows as possible at a time */
+					ret = SC_pos_add_rowset(s->stmt, (SQLSETPOSIROW) s->idx, &nrow);
+					if (SQL_NO_DATA_FOUND != ret)
+					{
+						/*
+						 * On error nrow is the number of rows actually
+						 * added (possibly 0); the increment below makes
+						 * up for the - 1.
+						 */
+						s->idx += (int) nrow - 1;
+						s->processed += (int) nrow - 1;
+						break;
+					}
+					s->add_row_by_row = TRUE;
+				}
 				ret = SC_pos_add(s->stmt, (UWORD) s->idx);
 				break;
 			case SQL_UPDATE_BY_BOOKMARK:
@@ -2052,6 +2084,7 @@ PGAPI_BulkOperations(HSTMT hstmt, SQLSMALLINT operationX)
 
 	/* StartRollbackState(s.stmt); */
 	s.need_data_callback = FALSE;
+	s.add_row_by_row = FALSE;
 	ret = bulk_ope_callback(SQL_SUCCESS, &s);
 	if (s.stmt->internal)
 		ret = DiscardStatementSvp(s.stmt, ret, FALSE);
@@ -307,6 +307,8 @@ enum {
 	,SQL_ATTR_PGOPT_USE_DECLAREFETCH
 	,SQL_ATTR_PGOPT_SERVER_SIDE_PREPARE
 	,SQL_ATTR_PGOPT_FETCH
+	,SQL_ATTR_PGOPT_SSL_SESSION_HITS	/* read only */
+	,SQL_ATTR_PGOPT_SSL_SESSION_MISSES	/* read only */
 };
 RETCODE SQL_API PGAPI_SetConnectAttr(HDBC ConnectionHandle,
 			SQLINTEGER Attribute, PTR Value,
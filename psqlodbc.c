@@ -86,6 +86,7 @@ int	initialize_global_cs(void)
 	getMutexAttr();
 #endif /* POSIX_THREADMUTEX_SUPPORT */
 	InitializeLogging();
+	InitializeQueryTimer();
 	INIT_CONNS_CS;
 	INIT_COMMON_CS;
 
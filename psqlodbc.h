@@ -55,6 +55,11 @@
 #ifndef	WIN32
 #undef	WIN_MULTITHREAD_SUPPORT
 #endif
+
+/* SSE2 is available on every x86-64 processor */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define	USE_SSE2
+#endif
 #if defined(WIN32) || defined(WITH_UNIXODBC) || defined(WITH_IODBC)
 #include <sql.h>
 #include <sqlext.h>
@@ -291,6 +296,8 @@ BOOL isSqlServr();
 #define TUPLE_MALLOC_INC			100
 #define SOCK_BUFFER_SIZE			4096		/* default socket buffer
 												 * size */
+#define SOCK_BUFFER_MAX_SIZE		262144		/* default limit of the
+												 * socket buffer growth */
 #define MAX_CONNECTIONS				128 /* conns per environment
 										 * (arbitrary)	*/
 #define MAX_FIELDS					512
@@ -378,11 +385,15 @@ typedef struct IPDFields_ IPDFields;
 
 typedef struct col_info COL_INFO;
 typedef struct lo_arg LO_ARG;
+typedef struct lo_stream LO_STREAM;
 
 typedef struct GlobalValues_
 {
 	int			fetch_max;
 	int			socket_buffersize;
+	int			socket_buffermax;
+	int			kernel_buffersize;	/* 0 leaves SO_RCVBUF/SO_SNDBUF to the OS */
+	int			catalog_cache_ttl;	/* seconds, 0 disables the cache */
 	int			unknown_sizes;
 	int			max_varchar_size;
 	int			max_longvarchar_size;
@@ -400,6 +411,8 @@ typedef struct GlobalValues_
 	char		lie;
 	char		parse;
 	char		cancel_as_freestmt;
+	char		lazy_more_results;	/* read the results of a batch on SQLMoreResults */
+	char		driver_ssl;	/* negotiate SSL without libpq, see SOCK_start_ssl() */
 	char		extra_systable_prefixes[MEDIUM_REGISTRY_LEN];
 	char		conn_settings[LARGE_REGISTRY_LEN];
 	char		protocol[SMALL_REGISTRY_LEN];
@@ -415,6 +428,7 @@ typedef struct StatementOptions_
 	SQLUINTEGER		retrieve_data;
 	SQLUINTEGER		use_bookmarks;
 	void			*bookmark_ptr;
+	SQLULEN			stmt_timeout;	/* SQL_QUERY_TIMEOUT in seconds */
 #if (ODBCVER >= 0x0300)
 	SQLUINTEGER		metadata_id;
 #endif /* ODBCVER */
@@ -426,6 +440,7 @@ typedef struct QueryInfo_
 	SQLLEN		row_size;
 	QResultClass	*result_in;
 	const char	*cursor;
+	SQLLEN		max_rows;	/* SQL_MAX_ROWS, 0 means no limit */
 } QueryInfo;
 
 /*	Used to save the error information */
@@ -472,6 +487,7 @@ void		logs_on_off(int cnopen, int, int);
 #define	LENADDR_SHIFT(x, sft)	((x) ? (SQLLEN *)((char *)(x) + (sft)) : NULL)
 
 int	initialize_global_cs(void);
+void	InitializeQueryTimer(void);
 #ifdef	POSIX_MULTITHREAD_SUPPORT
 #if	!defined(HAVE_ECO_THREAD_LOCKS)
 #define	POSIX_THREADMUTEX_SUPPORT
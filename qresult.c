@@ -216,6 +216,7 @@ QR_Constructor()
 		rv->aborted = FALSE;
 
 		rv->cache_size = 0;
+		rv->max_rows = 0;
 		rv->rowset_size_include_ommitted = 1;
 		rv->move_direction = 0;
 		rv->keyset = NULL;
@@ -449,6 +450,70 @@ inolog("QR_AddNew %dth row(%d fields) alloc=%d\n", self->num_cached_rows, QR_Num
 	return self->backend_tuples + num_fields * (self->num_cached_rows - 1);
 }
 
+/*
+ *	Copy a manual result set. The columninfo is copied as well because
+ *	its reference count isn't protected against the other threads.
+ *	Used by the catalog result cache (see info.c).
+ */
+QResultClass *
+QR_copy_manual(const QResultClass *self)
+{
+	QResultClass	*rv;
+	ColumnInfoClass	*fields;
+	const ColumnInfoClass	*ofields;
+	TupleField	*tuple;
+	const TupleField	*orig;
+	SQLLEN		i;
+	int		j, num_fields;
+
+	if (!self)	return NULL;
+	if (rv = QR_Constructor(), NULL == rv)
+		return NULL;
+	ofields = QR_get_fields(self);
+	fields = QR_get_fields(rv);
+	num_fields = CI_get_num_fields(ofields);
+	CI_set_num_fields(fields, num_fields, FALSE);
+	if (num_fields > 0 && NULL == fields->coli_array)
+	{
+		QR_Destructor(rv);
+		return NULL;
+	}
+	for (j = 0; j < num_fields; j++)
+	{
+		const struct srvr_info	*ocoli = ofields->coli_array + j;
+
+		fields->coli_array[j] = *ocoli;
+		if (NULL != ocoli->name &&
+		    NULL == (fields->coli_array[j].name = strdup(ocoli->name)))
+		{
+			QR_Destructor(rv);
+			return NULL;
+		}
+	}
+	QR_set_rstatus(rv, QR_get_rstatus(self));
+	for (i = 0; i < (SQLLEN) self->num_cached_rows; i++)
+	{
+		if (tuple = QR_AddNew(rv), NULL == tuple)
+		{
+			QR_Destructor(rv);
+			return NULL;
+		}
+		orig = self->backend_tuples + i * num_fields;
+		for (j = 0; j < num_fields; j++)
+		{
+			tuple[j].len = orig[j].len;
+			if (NULL != orig[j].value &&
+			    NULL == (tuple[j].value = strdup(orig[j].value)))
+			{
+				QR_Destructor(rv);
+				return NULL;
+			}
+		}
+	}
+
+	return rv;
+}
+
 void
 QR_free_memory(QResultClass *self)
 {
@@ -892,7 +957,7 @@ QR_next_tuple(QResultClass *self, StatementClass *stmt, int *LastMessageType)
 	SQLLEN		num_total_rows;
 	SQLLEN		num_backend_rows = self->num_cached_rows, num_rows_in;
 	Int4		num_fields = self->num_fields, fetch_size, req_size;
-	SQLLEN		offset = 0, end_tuple;
+	SQLLEN		offset = 0, end_tuple, rows_left = 0;
 	char		boundary_adjusted = FALSE;
 	TupleField *the_tuples = self->backend_tuples;
 
@@ -1126,6 +1191,18 @@ inolog("tupleField=%p\n", self->tupleField);
 			QR_set_reached_eof(self);
 			RETURN(-1)		/* end of tuples */
 		}
+		/* Don't fetch beyond SQL_MAX_ROWS */
+		if (stmt && stmt->options.maxRows > 0 && !QR_is_moving(self))
+		{
+			rows_left = stmt->options.maxRows - (SQLLEN) self->num_total_read;
+			if (rows_left <= 0)
+			{
+				mylog("%s: reached max_rows=%d\n", func, stmt->options.maxRows);
+				self->tupleField = NULL;
+				QR_set_reached_eof(self);
+				RETURN(-1)	/* end of tuples */
+			}
+		}
 
 		if (QR_get_rowstart_in_cache(self) >= num_backend_rows ||
 		    QR_is_moving(self))
@@ -1141,6 +1218,8 @@ inolog("tupleField=%p\n", self->tupleField);
 				fetch_size = (ci->drivers.fetch_max / req_size) * req_size;
 			else
 				fetch_size = req_size;
+			if (rows_left > 0 && fetch_size > rows_left)
+				fetch_size = (Int4) rows_left;
 
 			self->cache_size = fetch_size;
 			/* clear obsolete tuples */
@@ -1165,6 +1244,8 @@ inolog("clear obsolete %d tuples\n", num_backend_rows);
 				mylog("corrupted fetch_size end_tuple=%d <= cached_rows=%d\n", end_tuple, num_backend_rows);
 				RETURN(-1)
 			}
+			if (rows_left > 0 && fetch_size > rows_left)
+				fetch_size = (Int4) rows_left;
 			/* and enlarge the cache size */
 			self->cache_size += fetch_size;
 			offset = self->fetch_number;
@@ -1196,6 +1277,7 @@ inolog("clear obsolete %d tuples\n", num_backend_rows);
 			qi.row_size = self->cache_size;
 			qi.result_in = self;
 			qi.cursor = NULL;
+			qi.max_rows = 0;
 			res = CC_send_query(conn, fetch, &qi, 0, stmt);
 			if (!QR_command_maybe_successful(res))
 			{
@@ -1273,6 +1355,7 @@ inolog("id='%c' response_length=%d\n", id, response_length);
 					RETURN(FALSE)
 				}
 				QR_set_cache_size(self->next, self->cache_size);
+				self->next->max_rows = self->max_rows;
 				self = self->next;
 				if (!QR_fetch_tuples(self, conn, NULL, LastMessageType))
 				{
@@ -1286,6 +1369,16 @@ inolog("id='%c' response_length=%d\n", id, response_length);
 			case 'B':			/* Tuples in binary format */
 			case 'D':			/* Tuples in ASCII format  */
 
+				/*
+				 *	The server doesn't know SQL_MAX_ROWS for a simple
+				 *	query. Don't keep the rows beyond it. SOCK_get_id()
+				 *	eats the unread tuple data.
+				 */
+				if (self->max_rows > 0 &&
+				    !QR_get_cursor(self) &&
+				    response_length >= 0 &&
+				    QR_get_num_cached_tuples(self) >= (SQLULEN) self->max_rows)
+					break;
 				if (!QR_get_tupledata(self, id == 'B'))
 				{
 					ret = FALSE;
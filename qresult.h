@@ -69,6 +69,7 @@ struct QResultClass_
 	UInt2		num_fields;	/* number of fields in the result */
 	UInt2		num_key_fields;	/* number of key fields in the result */
 	SQLULEN		cache_size;
+	SQLLEN		max_rows;	/* rows beyond it are discarded, 0 means no limit */
 	UInt4		rowset_size_include_ommitted; /* PG restriction */
 	SQLLEN		recent_processed_row_count;
 
@@ -222,6 +223,7 @@ do { \
 QResultClass	*QR_Constructor(void);
 void		QR_Destructor(QResultClass *self);
 TupleField	*QR_AddNew(QResultClass *self);
+QResultClass	*QR_copy_manual(const QResultClass *self);
 BOOL		QR_get_tupledata(QResultClass *self, BOOL binary);
 int		QR_next_tuple(QResultClass *self, StatementClass *, int *LastMessageType);
 int			QR_close(QResultClass *self);
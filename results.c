@@ -1924,7 +1924,14 @@ PGAPI_MoreResults(
 
 	mylog("%s: entering...\n", func);
 	if (stmt && (res = SC_get_Curres(stmt)))
+	{
+		ConnectionClass	*conn = SC_get_conn(stmt);
+
+		/* the rest of the batch may be still unread */
+		if (NULL == res->next && stmt == conn->stmt_in_lazyquery)
+			res->next = CC_next_lazy_result(conn);
 		SC_set_Curres(stmt, res->next);
+	}
 	if (res = SC_get_Curres(stmt), res)
 	{
 		SQLSMALLINT	num_p;
@@ -1945,6 +1952,12 @@ PGAPI_MoreResults(
 		stmt->diag_row_count = res->recent_processed_row_count;
 		SC_set_rowset_start(stmt, -1, FALSE);
 		stmt->currTuple = -1;
+		/* a statement of the batch read lazily may have failed */
+		if (!QR_command_maybe_successful(res))
+		{
+			SC_set_errornumber(stmt, STMT_ERROR_TAKEN_FROM_BACKEND);
+			ret = SQL_ERROR;
+		}
 	}
 	else
 	{
@@ -3349,11 +3362,100 @@ SC_pos_reload_needed(StatementClass *stmt, SQLULEN req_size, UDWORD flag)
 	return ret;
 }
 
+/*
+ *	Append a tuple loaded by positioned_load() to the result
+ *	as an added row. The field values of tuple_new are moved
+ *	to the result.
+ */
+static RETCODE
+AppendAddedTuple(StatementClass *stmt, QResultClass *res, TupleField *tuple_new, int num_fields_new)
+{
+	int	i, effective_fields = res->num_fields;
+	ssize_t	tuple_size;
+	SQLLEN	num_total_rows, num_cached_rows, kres_ridx;
+	BOOL	appendKey = FALSE, appendData = FALSE;
+	TupleField *tuple_old;
+
+	num_total_rows = QR_get_num_total_tuples(res);
+
+	AddAdded(stmt, res, num_total_rows, tuple_new);
+	num_cached_rows = QR_get_num_cached_tuples(res);
+	kres_ridx = GIdx2KResIdx(num_total_rows, stmt, res);
+	if (QR_haskeyset(res))
+	{	if (!QR_get_cursor(res))
+		{
+			appendKey = TRUE;
+			if (num_total_rows == CacheIdx2GIdx(num_cached_rows, stmt, res))
+				appendData = TRUE;
+			else
+			{
+inolog("total %d <> backend %d - base %d + start %d cursor_type=%d\n", 
+num_total_rows, num_cached_rows,
+QR_get_rowstart_in_cache(res), SC_get_rowset_start(stmt), stmt->options.cursor_type);
+			}
+		}
+		else if (kres_ridx >= 0 && kres_ridx < res->cache_size)
+		{
+			appendKey = TRUE;
+			appendData = TRUE;
+		}
+	}
+	if (appendKey)
+	{
+	    	if (res->num_cached_keys >= res->count_keyset_allocated)
+		{
+			if (!res->count_keyset_allocated)
+				tuple_size = TUPLE_MALLOC_INC;
+			else
+				tuple_size = res->count_keyset_allocated * 2;
+			QR_REALLOC_return_with_error(res->keyset, KeySet, sizeof(KeySet) * tuple_size, res, "pos_newload failed", SQL_ERROR);	
+			res->count_keyset_allocated = tuple_size;
+		}
+		KeySetSet(tuple_new, num_fields_new, res->num_key_fields, res->keyset + kres_ridx);
+		res->num_cached_keys++;
+	}
+	if (appendData)
+	{
+inolog("total %d == backend %d - base %d + start %d cursor_type=%d\n", 
+num_total_rows, num_cached_rows,
+QR_get_rowstart_in_cache(res), SC_get_rowset_start(stmt), stmt->options.cursor_type);
+		if (num_cached_rows >= res->count_backend_allocated)
+		{
+			if (!res->count_backend_allocated)
+				tuple_size = TUPLE_MALLOC_INC;
+			else
+				tuple_size = res->count_backend_allocated * 2;
+			QR_REALLOC_return_with_error(res->backend_tuples, TupleField, res->num_fields * sizeof(TupleField) * tuple_size, res, "SC_pos_newload failed", SQL_ERROR);
+			/*
+			res->backend_tuples = (TupleField *) realloc(
+				res->backend_tuples,
+				res->num_fields * sizeof(TupleField) * tuple_size);
+			if (!res->backend_tuples)
+			{
+				SC_set_error(stmt, QR_set_rstatus(res, PORES_FATAL_ERROR), "Out of memory while reading tuples.", func);
+				QR_Destructor(qres);
+				return SQL_ERROR;
+			}
+			*/
+			res->count_backend_allocated = tuple_size;
+		}
+		tuple_old = res->backend_tuples + res->num_fields * num_cached_rows;
+		for (i = 0; i < effective_fields; i++)
+		{
+			tuple_old[i].len = tuple_new[i].len;
+			tuple_new[i].len = -1;
+			tuple_old[i].value = tuple_new[i].value;
+			tuple_new[i].value = NULL;
+		}
+		res->num_cached_rows++;
+	}
+	return SQL_SUCCESS;
+}
+
 static RETCODE	SQL_API
 SC_pos_newload(StatementClass *stmt, const UInt4 *oidint, BOOL tidRef, const char *tidval)
 {
 	CSTR	func = "SC_pos_newload";
-	int			i;
 	QResultClass *res, *qres;
 	RETCODE		ret = SQL_ERROR;
 
@@ -3383,87 +3485,7 @@ SC_pos_newload(StatementClass *stmt, const UInt4 *oidint, BOOL tidRef, const cha
 		QR_set_position(qres, 0);
 		if (count == 1)
 		{
-			int	effective_fields = res->num_fields;
-			ssize_t	tuple_size;
-			SQLLEN	num_total_rows, num_cached_rows, kres_ridx;
-			BOOL	appendKey = FALSE, appendData = FALSE;
-			TupleField *tuple_old, *tuple_new;
-
-			tuple_new = qres->tupleField;
-			num_total_rows = QR_get_num_total_tuples(res);
-
-			AddAdded(stmt, res, num_total_rows, tuple_new);
-			num_cached_rows = QR_get_num_cached_tuples(res);
-			kres_ridx = GIdx2KResIdx(num_total_rows, stmt, res);
-			if (QR_haskeyset(res))
-			{	if (!QR_get_cursor(res))
-				{
-					appendKey = TRUE;
-					if (num_total_rows == CacheIdx2GIdx(num_cached_rows, stmt, res))
-						appendData = TRUE;
-					else
-					{
-inolog("total %d <> backend %d - base %d + start %d cursor_type=%d\n", 
-num_total_rows, num_cached_rows,
-QR_get_rowstart_in_cache(res), SC_get_rowset_start(stmt), stmt->options.cursor_type);
-					}
-				}
-				else if (kres_ridx >= 0 && kres_ridx < res->cache_size)
-				{
-					appendKey = TRUE;
-					appendData = TRUE;
-				}
-			}
-			if (appendKey)
-			{
-			    	if (res->num_cached_keys >= res->count_keyset_allocated)
-				{
-					if (!res->count_keyset_allocated)
-						tuple_size = TUPLE_MALLOC_INC;
-					else
-						tuple_size = res->count_keyset_allocated * 2;
-					QR_REALLOC_return_with_error(res->keyset, KeySet, sizeof(KeySet) * tuple_size, res, "pos_newload failed", SQL_ERROR);	
-					res->count_keyset_allocated = tuple_size;
-				}
-				KeySetSet(tuple_new, qres->num_fields, res->num_key_fields, res->keyset + kres_ridx);
-				res->num_cached_keys++;
-			}
-			if (appendData)
-			{
-inolog("total %d == backend %d - base %d + start %d cursor_type=%d\n", 
-num_total_rows, num_cached_rows,
-QR_get_rowstart_in_cache(res), SC_get_rowset_start(stmt), stmt->options.cursor_type);
-				if (num_cached_rows >= res->count_backend_allocated)
-				{
-					if (!res->count_backend_allocated)
-						tuple_size = TUPLE_MALLOC_INC;
-					else
-						tuple_size = res->count_backend_allocated * 2;
-					QR_REALLOC_return_with_error(res->backend_tuples, TupleField, res->num_fields * sizeof(TupleField) * tuple_size, res, "SC_pos_newload failed", SQL_ERROR);
-					/*
-					res->backend_tuples = (TupleField *) realloc(
-						res->backend_tuples,
-						res->num_fields * sizeof(TupleField) * tuple_size);
-					if (!res->backend_tuples)
-					{
-						SC_set_error(stmt, QR_set_rstatus(res, PORES_FATAL_ERROR), "Out of memory while reading tuples.", func);
-						QR_Destructor(qres);
-						return SQL_ERROR;
-					}
-					*/
-					res->count_backend_allocated = tuple_size;
-				}
-				tuple_old = res->backend_tuples + res->num_fields * num_cached_rows;
-				for (i = 0; i < effective_fields; i++)
-				{
-					tuple_old[i].len = tuple_new[i].len;
-					tuple_new[i].len = -1;
-					tuple_old[i].value = tuple_new[i].value;
-					tuple_new[i].value = NULL;
-				}
-				res->num_cached_rows++;
-			}
-			ret = SQL_SUCCESS;
+			ret = AppendAddedTuple(stmt, res, qres->tupleField, qres->num_fields);
 		}
 		else if (0 == count)
 			ret = SQL_NO_DATA_FOUND;
@@ -3899,6 +3921,51 @@ inolog(".status[%d]=%x\n", global_ridx, res->keyset[kres_ridx].status);
 	return ret;
 }
 
+static void
+SetAddedBookmark(StatementClass *stmt, SQLLEN addpos)
+{
+	ARDFields	*opts = SC_get_ARDF(stmt);
+	BindInfoClass	*bookmark = opts->bookmark;
+
+	if (bookmark && bookmark->buffer)
+	{
+		char	buf[32];
+		SQLULEN	offset = opts->row_offset_ptr ? *opts->row_offset_ptr : 0;
+
+		snprintf(buf, sizeof(buf), FORMAT_LEN, SC_make_bookmark(addpos));
+		SC_set_current_col(stmt, -1);
+		copy_and_convert_field(stmt,
+			PG_TYPE_INT4,
+			PG_UNSPECIFIED,
+			buf,
+                 	bookmark->returntype,
+			0,
+			bookmark->buffer + offset,
+			bookmark->buflen,
+			LENADDR_SHIFT(bookmark->used, offset),
+			LENADDR_SHIFT(bookmark->used, offset));
+	}
+}
+
+static void
+SetAddedKeysetStatus(StatementClass *stmt, QResultClass *res)
+{
+	SQLLEN	global_ridx = QR_get_num_total_tuples(res) - 1;
+	ConnectionClass	*conn = SC_get_conn(stmt);
+	SQLLEN	kres_ridx;
+	UWORD	status = SQL_ROW_ADDED;
+
+	if (CC_is_in_trans(conn))
+		status |= CURS_SELF_ADDING;
+	else
+		status |= CURS_SELF_ADDED;
+	kres_ridx = GIdx2KResIdx(global_ridx, stmt, res);
+	if (kres_ridx >= 0 || kres_ridx < res->num_cached_keys)
+	{
+		res->keyset[kres_ridx].status = status;
+	}
+}
+
 static RETCODE SQL_API
 irow_insert(RETCODE ret, StatementClass *stmt, StatementClass *istmt, SQLLEN addpos)
 {
@@ -3908,10 +3975,8 @@ irow_insert(RETCODE ret, StatementClass *stmt, StatementClass *istmt, SQLLEN add
 	{
 		int		addcnt;
 		OID		oid, *poid = NULL;
-		ARDFields	*opts = SC_get_ARDF(stmt);
 		QResultClass	*ires = SC_get_Curres(istmt), *tres;
 		const char *cmdstr;
-		BindInfoClass	*bookmark;
 
 		tres = (ires->next ? ires->next : ires);
 		cmdstr = QR_get_command(tres);
@@ -3942,25 +4007,7 @@ irow_insert(RETCODE ret, StatementClass *stmt, StatementClass *istmt, SQLLEN add
 				if (SQL_ERROR == qret)
 					return qret;
 			}
-			bookmark = opts->bookmark;
-			if (bookmark && bookmark->buffer)
-			{
-				char	buf[32];
-				SQLULEN	offset = opts->row_offset_ptr ? *opts->row_offset_ptr : 0;
-
-				snprintf(buf, sizeof(buf), FORMAT_LEN, SC_make_bookmark(addpos));
-				SC_set_current_col(stmt, -1);
-				copy_and_convert_field(stmt,
-					PG_TYPE_INT4,
-					PG_UNSPECIFIED,
-					buf,
-                         		bookmark->returntype,
-					0,
-					bookmark->buffer + offset,
-					bookmark->buflen,
-					LENADDR_SHIFT(bookmark->used, offset),
-					LENADDR_SHIFT(bookmark->used, offset));
-			}
+			SetAddedBookmark(stmt, addpos);
 		}
 		else
 		{
@@ -4008,22 +4055,7 @@ pos_add_callback(RETCODE retcode, void *para)
 	PGAPI_FreeStmt((HSTMT) s->qstmt, SQL_DROP);
 	s->qstmt = NULL;
 	if (SQL_SUCCESS == ret && s->res->keyset)
-	{
-		SQLLEN	global_ridx = QR_get_num_total_tuples(s->res) - 1;
-		ConnectionClass	*conn = SC_get_conn(s->stmt);
-		SQLLEN	kres_ridx;
-		UWORD	status = SQL_ROW_ADDED;
-
-		if (CC_is_in_trans(conn))
-			status |= CURS_SELF_ADDING;
-		else
-			status |= CURS_SELF_ADDED;
-		kres_ridx = GIdx2KResIdx(global_ridx, s->stmt, s->res);
-		if (kres_ridx >= 0 || kres_ridx < s->res->num_cached_keys)
-		{
-			s->res->keyset[kres_ridx].status = status;
-		}
-	}
+		SetAddedKeysetStatus(s->stmt, s->res);
 #if (ODBCVER >= 0x0300)
 	if (s->irdflds->rowStatusArray)
 	{
@@ -4186,6 +4218,358 @@ cleanup:
 	return ret;
 }
 
+/*
+ *	The max number of parameters of a multi-row insert.
+ *	The Bind message can't have more than 32767 parameters.
+ */
+#define	MAX_ROWSET_ADD_PARAMS	32767
+
+static SQLLEN *
+bindings_used_in_row(const BindInfoClass *binding, Int4 bind_size, SQLSETPOSIROW irow)
+{
+	if (bind_size > 0)
+		return LENADDR_SHIFT(binding->used, bind_size * irow);
+	return LENADDR_SHIFT(binding->used, irow * sizeof(SQLLEN));
+}
+
+static char *
+bindings_buffer_in_row(const BindInfoClass *binding, Int4 bind_size, SQLSETPOSIROW irow)
+{
+	Int4	ctypelen;
+
+	if (!binding->buffer)
+		return NULL;
+	if (bind_size > 0)
+		return binding->buffer + bind_size * irow;
+	if (ctypelen = ctype_length(binding->returntype), ctypelen > 0)
+		return binding->buffer + ctypelen * irow;
+	return binding->buffer + binding->buflen * irow;
+}
+
+/*
+ *	Multi-row version of SC_pos_add for SQLBulkOperations(SQL_ADD).
+ *
+ *	The rows [start_row, start_row + *nrow) are inserted by one
+ *	"insert .. values (..), (..), .. returning ctid" and loaded back
+ *	by one "select .. where ctid in (..)" instead of an insert and a
+ *	reload per row. *nrow is set to the number of rows processed, or
+ *	to the number of rows actually added when SQL_ERROR is returned.
+ *	SQL_NO_DATA_FOUND is returned when the rows can't be handled this
+ *	way (data-at-exec values, old servers etc) and the caller should
+ *	fall back to SC_pos_add.
+ */
+RETCODE
+SC_pos_add_rowset(StatementClass *stmt, SQLSETPOSIROW start_row, SQLSETPOSIROW *nrow)
+{
+	CSTR	func = "SC_pos_add_rowset";
+	QResultClass	*res, *ires, *tres, *qres = NULL;
+	StatementClass	*qstmt;
+	ConnectionClass	*conn;
+	ConnInfo	*ci;
+	ARDFields	*opts = SC_get_ARDF(stmt);
+	IRDFields	*irdflds;
+	APDFields	*apdopts;
+	IPDFields	*ipdopts;
+	BindInfoClass	*bindings = opts->bindings;
+	FIELD_INFO	**fi;
+	HSTMT		hstmt;
+	RETCODE		ret;
+	SQLULEN		offset;
+	SQLLEN		*used;
+	SQLSETPOSIROW	irow, rows, added = 0;
+	Int4		bind_size = opts->bind_size;
+	int		num_cols, add_cols, nparams, row_params, i, j, tidcol;
+	char		*addstr = NULL, *selstr = NULL, *included = NULL;
+	const char	*cmdstr, *tidval;
+	size_t		alloclen, pos;
+	OID		oid, fieldtype;
+	int		addcnt, func_cs_count = 0;
+
+	mylog("%s: start=%d nrow=%d\n", func, start_row, *nrow);
+	if (!(res = SC_get_Curres(stmt)))
+	{
+		SC_set_error(stmt, STMT_INVALID_CURSOR_STATE_ERROR, "Null statement result in SC_pos_add_rowset.", func);
+		*nrow = 0;
+		return SQL_ERROR;
+	}
+	conn = SC_get_conn(stmt);
+	if (PG_VERSION_LT(conn, 8.2) || *nrow < 2)
+		return SQL_NO_DATA_FOUND;
+	if (SC_update_not_ready(stmt))
+		parse_statement(stmt, TRUE);	/* not preferable */
+	if (!SC_is_updatable(stmt) || !stmt->load_statement)
+		return SQL_NO_DATA_FOUND;	/* SC_pos_add reports the error */
+	irdflds = SC_get_IRDF(stmt);
+	fi = irdflds->fi;
+	num_cols = irdflds->nfields;
+	if (opts->row_offset_ptr)
+		offset = *opts->row_offset_ptr;
+	else
+		offset = 0;
+
+	/*
+	 *	Determine the insert list and the number of rows.
+	 *	A column ignored in some rows is inserted as DEFAULT there.
+	 */
+	if (included = (char *) calloc(num_cols > 0 ? num_cols : 1, sizeof(char)), NULL == included)
+	{
+		SC_set_error(stmt, STMT_NO_MEMORY_ERROR, "Couldn't alloc included", func);
+		*nrow = 0;
+		return SQL_ERROR;
+	}
+	for (rows = 0, nparams = 0; rows < *nrow; rows++)
+	{
+		irow = start_row + rows;
+		for (i = row_params = 0; i < num_cols; i++)
+		{
+			if (!bindings[i].used || !fi[i] || !fi[i]->updatable)
+				continue;
+			used = LENADDR_SHIFT(bindings_used_in_row(bindings + i, bind_size, irow), offset);
+			if (SQL_DATA_AT_EXEC == *used ||
+			    *used <= SQL_LEN_DATA_AT_EXEC_OFFSET)
+			{
+				free(included);
+				return SQL_NO_DATA_FOUND;
+			}
+			if (SQL_IGNORE != *used)
+				row_params++;
+		}
+		if (nparams + row_params > MAX_ROWSET_ADD_PARAMS)
+			break;
+		nparams += row_params;
+		for (i = 0; i < num_cols; i++)
+		{
+			if (!bindings[i].used || !fi[i] || !fi[i]->updatable)
+				continue;
+			used = LENADDR_SHIFT(bindings_used_in_row(bindings + i, bind_size, irow), offset);
+			if (SQL_IGNORE != *used)
+				included[i] = 1;
+		}
+	}
+	for (i = add_cols = 0; i < num_cols; i++)
+	{
+		if (included[i])
+			add_cols++;
+	}
+	if (0 == add_cols || rows < 2)
+	{
+		free(included);
+		return SQL_NO_DATA_FOUND;
+	}
+	mylog("%s: rows=%d add_cols=%d nparams=%d\n", func, rows, add_cols, nparams);
+
+	alloclen = 64 + strlen(SAFE_NAME(stmt->ti[0]->schema_name)) + strlen(SAFE_NAME(stmt->ti[0]->table_name));
+	for (i = 0; i < num_cols; i++)
+	{
+		if (included[i])
+			alloclen += strlen(GET_NAME(fi[i]->column_name)) + 4;
+	}
+	alloclen += rows * (add_cols * 9 + 4);
+	if (addstr = malloc(alloclen), NULL == addstr)
+	{
+		free(included);
+		SC_set_error(stmt, STMT_NO_MEMORY_ERROR, "Couldn't alloc addstr", func);
+		*nrow = 0;
+		return SQL_ERROR;
+	}
+	if (NAME_IS_VALID(stmt->ti[0]->schema_name))
+		snprintf(addstr, alloclen, "insert into \"%s\".\"%s\" (", SAFE_NAME(stmt->ti[0]->schema_name), SAFE_NAME(stmt->ti[0]->table_name));
+	else
+		snprintf(addstr, alloclen, "insert into \"%s\" (", SAFE_NAME(stmt->ti[0]->table_name));
+	for (i = j = 0; i < num_cols; i++)
+	{
+		if (!included[i])
+			continue;
+		snprintf_add(addstr, alloclen, "%s\"%s\"", j++ ? ", " : "", GET_NAME(fi[i]->column_name));
+	}
+	strcat(addstr, ") values ");
+
+	if (PGAPI_AllocStmt(conn, &hstmt, 0) != SQL_SUCCESS)
+	{
+		free(included);
+		free(addstr);
+		SC_set_error(stmt, STMT_NO_MEMORY_ERROR, "internal AllocStmt error", func);
+		*nrow = 0;
+		return SQL_ERROR;
+	}
+	qstmt = (StatementClass *) hstmt;
+	apdopts = SC_get_APDF(qstmt);
+	apdopts->param_bind_type = 0;
+	apdopts->param_offset_ptr = opts->row_offset_ptr;
+	ipdopts = SC_get_IPDF(qstmt);
+	SC_set_delegate(stmt, qstmt);
+	ci = &(conn->connInfo);
+	extend_iparameter_bindings(ipdopts, nparams);
+
+	/*
+	 *	Each parameter points to the bound buffer of its own row
+	 *	so that the whole rowset is sent as one parameter set.
+	 */
+	pos = strlen(addstr);
+	for (irow = start_row, nparams = 0; irow < start_row + rows; irow++)
+	{
+		if (irow > start_row)
+			addstr[pos++] = ',';
+		addstr[pos++] = '(';
+		for (i = j = 0; i < num_cols; i++)
+		{
+			if (!included[i])
+				continue;
+			if (j++)
+			{
+				addstr[pos++] = ',';
+				addstr[pos++] = ' ';
+			}
+			used = bindings_used_in_row(bindings + i, bind_size, irow);
+			if (SQL_IGNORE == *LENADDR_SHIFT(used, offset))
+			{
+				memcpy(addstr + pos, "DEFAULT", 7);
+				pos += 7;
+				continue;
+			}
+			addstr[pos++] = '?';
+			fieldtype = getEffectiveOid(conn, fi[i]);
+			PIC_set_pgtype(ipdopts->parameters[nparams], fieldtype);
+			PGAPI_BindParameter(hstmt,
+				(SQLUSMALLINT) ++nparams,
+				SQL_PARAM_INPUT,
+				bindings[i].returntype,
+				pgtype_to_concise_type(stmt, fieldtype, i),
+				fi[i]->column_size > 0 ? fi[i]->column_size : pgtype_column_size(stmt, fieldtype, i, ci->drivers.unknown_sizes),
+				(SQLSMALLINT) fi[i]->decimal_digits,
+				bindings_buffer_in_row(bindings + i, bind_size, irow),
+				bindings[i].buflen,
+				used);
+		}
+		addstr[pos++] = ')';
+	}
+	addstr[pos] = '\0';
+	strcat(addstr, " returning ctid");
+	free(included);
+	mylog("addstr=%s\n", addstr);
+
+#define	return	DONT_CALL_RETURN_FROM_HERE???
+	ENTER_INNER_CONN_CS(conn, func_cs_count);
+	qstmt->exec_start_row = qstmt->exec_end_row = 0;
+	ret = PGAPI_ExecDirect(hstmt, addstr, SQL_NTS, 0);
+	if (SQL_ERROR == ret || SQL_NEED_DATA == ret)
+	{
+		ret = SQL_ERROR;
+		goto cleanup;
+	}
+	ires = SC_get_Curres(qstmt);
+	tres = (ires->next ? ires->next : ires);
+	cmdstr = QR_get_command(tres);
+	if (!cmdstr ||
+	    sscanf(cmdstr, "INSERT %u %d", &oid, &addcnt) != 2 ||
+	    addcnt != rows ||
+	    NULL == tres->backend_tuples ||
+	    QR_get_num_cached_tuples(tres) != rows)
+	{
+		SC_set_error(qstmt, STMT_ERROR_TAKEN_FROM_BACKEND, "SetPos insert return error", func);
+		ret = SQL_ERROR;
+		goto cleanup;
+	}
+
+	/*
+	 *	Load the inserted rows back by one query.
+	 */
+	alloclen = strlen(stmt->load_statement) + 20 + rows * 26;
+	if (selstr = malloc(alloclen), NULL == selstr)
+	{
+		SC_set_error(qstmt, STMT_NO_MEMORY_ERROR, "Couldn't alloc selstr", func);
+		ret = SQL_ERROR;
+		goto cleanup;
+	}
+	snprintf(selstr, alloclen, "%s where ctid in (", stmt->load_statement);
+	for (j = 0; j < (int) rows; j++)
+	{
+		tidval = QR_get_value_backend_text(tres, j, 0);
+		if (!tidval || strlen(tidval) > 23)
+		{
+			SC_set_error(qstmt, STMT_ERROR_TAKEN_FROM_BACKEND, "SetPos insert returned an invalid ctid", func);
+			ret = SQL_ERROR;
+			goto cleanup;
+		}
+		snprintf_add(selstr, alloclen, "%s'%s'", j ? "," : "", tidval);
+	}
+	strcat(selstr, ")");
+	mylog("selstr=%s\n", selstr);
+	qres = CC_send_query(conn, selstr, NULL, 0, stmt);
+	if (!QR_command_maybe_successful(qres))
+	{
+		SC_set_error(qstmt, STMT_ERROR_TAKEN_FROM_BACKEND, "positioned_load in pos_add_rowset failed", func);
+		ret = SQL_ERROR;
+		goto cleanup;
+	}
+
+	/*
+	 *	Append the loaded rows in the order of insertion.
+	 *	They are usually returned in the same order, so the search
+	 *	starts from the row next to the previously found one.
+	 */
+	tidcol = qres->num_fields - res->num_key_fields;
+	for (j = -1, added = 0; added < rows; added++)
+	{
+		int	k, cnt = (int) QR_get_num_cached_tuples(qres);
+		SQLLEN	addpos;
+		SQLSETPOSIROW	brow_save;
+
+		tidval = QR_get_value_backend_text(tres, added, 0);
+		for (k = 0; k < cnt; k++)
+		{
+			j = (j + 1) % cnt;
+			if (QR_get_value_backend_text(qres, j, tidcol) &&
+			    0 == strcmp(QR_get_value_backend_text(qres, j, tidcol), tidval))
+				break;
+		}
+		if (k >= cnt)
+		{
+			SC_set_error(qstmt, STMT_ROW_VERSION_CHANGED, "the driver cound't identify inserted rows", func);
+			ret = SQL_ERROR;
+			break;
+		}
+		if (QR_get_cursor(res))
+			addpos = -(SQLLEN)(res->ad_count + 1);
+		else
+			addpos = QR_get_num_total_tuples(res);
+		if (ret = AppendAddedTuple(stmt, res, qres->backend_tuples + qres->num_fields * j, qres->num_fields), SQL_ERROR == ret)
+			break;
+		brow_save = stmt->bind_row;
+		stmt->bind_row = start_row + added;
+		SetAddedBookmark(stmt, addpos);
+		stmt->bind_row = brow_save;
+		if (res->keyset)
+			SetAddedKeysetStatus(stmt, res);
+#if (ODBCVER >= 0x0300)
+		if (irdflds->rowStatusArray)
+			irdflds->rowStatusArray[start_row + added] = SQL_ROW_ADDED;
+#endif /* ODBCVER */
+	}
+
+cleanup:
+#undef	return
+	SC_setInsertedTable(qstmt, ret);
+	if (ret != SQL_SUCCESS)
+		SC_error_copy(stmt, qstmt, TRUE);
+#if (ODBCVER >= 0x0300)
+	if (SQL_ERROR == ret && irdflds->rowStatusArray)
+	{
+		for (irow = start_row + added; irow < start_row + rows; irow++)
+			irdflds->rowStatusArray[irow] = SQL_ROW_ERROR;
+	}
+#endif /* ODBCVER */
+	PGAPI_FreeStmt(hstmt, SQL_DROP);
+	QR_Destructor(qres);
+	if (addstr)
+		free(addstr);
+	if (selstr)
+		free(selstr);
+	CLEANUP_FUNC_CONN_CS(func_cs_count, conn);
+	*nrow = (SQL_ERROR == ret ? added : rows);
+	return ret;
+}
+
 /*
  *	Stuff for updatable cursors end.
  */
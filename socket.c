@@ -13,6 +13,7 @@
  */
 
 #include "socket.h"
+#include <ctype.h>
 
 #ifdef	USE_SSPI
 #include "sspisvcs.h"
@@ -24,11 +25,14 @@
 #include <libpq-fe.h>
 #ifdef USE_SSL
 #include <openssl/ssl.h>
+#include <openssl/err.h>
 #endif /* USE_SSL */
 #endif /* NOT_USE_LIBPQ */
 #include "loadlib.h"
 
 #include "connection.h"
+#include "environ.h"
+#include "dlg_specific.h"
 
 #ifdef WIN32
 #include <time.h>
@@ -51,6 +55,7 @@
 extern GLOBAL_VALUES globals;
 
 static int SOCK_get_next_n_bytes(SocketClass *s, int n, char *buf);
+static void SOCK_set_kernel_buffer(SocketClass *s, int optname);
 
 static void SOCK_set_error(SocketClass *s, int _no, const char *_msg)
 {
@@ -102,6 +107,7 @@ SOCK_Constructor(const ConnectionClass *conn)
 #endif /* NOT_USE_LIBPQ */
 		rv->pversion = 0;
 		rv->reslen = 0;
+		rv->wait_deadline = 0;
 		rv->buffer_filled_in = 0;
 		rv->buffer_filled_out = 0;
 		rv->buffer_read_in = 0;
@@ -110,7 +116,9 @@ SOCK_Constructor(const ConnectionClass *conn)
 			rv->buffer_size = conn->connInfo.drivers.socket_buffersize;
 		else
 			rv->buffer_size = globals.socket_buffersize;
-		rv->buffer_in = (UCHAR *) malloc(rv->buffer_size);
+		rv->buffer_in_size = rv->buffer_init_size = rv->buffer_max_size = rv->buffer_size;
+		rv->buffer_full_reads = rv->buffer_peak_in = 0;
+		rv->buffer_in = (UCHAR *) malloc(rv->buffer_in_size);
 		if (!rv->buffer_in)
 		{
 			free(rv);
@@ -126,7 +134,11 @@ SOCK_Constructor(const ConnectionClass *conn)
 		}
 		rv->_errormsg_ = NULL;
 		rv->errornumber = 0;
+		rv->hostname = NULL;
 		rv->reverse = FALSE;
+#ifdef	USE_SSL
+		rv->ssl_session_key = NULL;
+#endif /* USE_SSL */
 	}
 	return rv;
 }
@@ -160,6 +172,14 @@ SOCK_Destructor(SocketClass *self)
 			if (PG_PROTOCOL_74 == self->pversion)
 				SOCK_put_int(self, 4, 4);
 			SOCK_flush_output(self);
+#ifdef USE_SSL
+			if (self->ssl)
+			{
+				SSL_shutdown(self->ssl);
+				SSL_free(self->ssl);
+				self->ssl = NULL;
+			}
+#endif /* USE_SSL */
 			closesocket(self->socket);
 		}
 #ifdef	USE_SSPI
@@ -183,6 +203,12 @@ SOCK_Destructor(SocketClass *self)
 		free(self->buffer_out);
 	if (self->_errormsg_)
 		free(self->_errormsg_);
+	if (self->hostname)
+		free(self->hostname);
+#ifdef	USE_SSL
+	if (self->ssl_session_key)
+		free(self->ssl_session_key);
+#endif /* USE_SSL */
 
 	free(self);
 }
@@ -239,13 +265,188 @@ static BOOL format_sockerr(char *errmsg, size_t buflen, int errnum, const char *
 	return ret;
 }
  
+/*
+ *	Servername may be a comma separated list of hosts.  The addresses of
+ *	all of them are tried in order, and a new attempt is started as soon
+ *	as the previous one fails or has been pending for CONNECT_ATTEMPT_DELAY
+ *	msec, without giving up the attempts in progress (Happy Eyeballs, see
+ *	RFC 8305).  The first connection established is used and the others
+ *	are closed.
+ */
+#define	CONNECT_ATTEMPT_DELAY	250	/* msec */
+#define	MAX_CONNECT_HOSTS	16
+
+typedef struct
+{
+	SOCKETFD	fd;
+	const struct addrinfo	*adr;
+	const char	*host;
+} ConnectAttempt;
+
+/* a clock in msec, only the differences are meaningful */
+static UInt4
+get_msec(void)
+{
+#ifdef	WIN32
+	return (UInt4) GetTickCount();
+#elif	defined(TIME_WITH_SYS_TIME) || defined(HAVE_SYS_TIME_H)
+	struct timeval	tv;
+
+	gettimeofday(&tv, NULL);
+	return (UInt4) tv.tv_sec * 1000 + (UInt4) (tv.tv_usec / 1000);
+#else
+	return (UInt4) time(NULL) * 1000;
+#endif /* WIN32 */
+}
+
+/*
+ * Start a non-blocking connect() to the address.  Returns the socket,
+ * or -1 with the error set.  *connected tells if the connection was
+ * established immediately.
+ */
+static SOCKETFD
+SOCK_start_connect(SocketClass *self, const struct addrinfo *adr, BOOL *connected)
+{
+	SOCKETFD	fd;
+	int	gerrno;
+
+	*connected = FALSE;
+	self->socket = socket(adr->ai_family, SOCK_STREAM, 0);
+	if (self->socket == (SOCKETFD) -1)
+	{
+		SOCK_set_error(self, SOCKET_COULD_NOT_CREATE_SOCKET, "Could not create Socket.");
+		return (SOCKETFD) -1;
+	}
+#ifdef	TCP_NODELAY
+	if (adr->ai_family != AF_UNIX)
+	{
+		int i;
+		socklen_t	len;
+
+		i = 1;
+		len = sizeof(i);
+		if (setsockopt(self->socket, IPPROTO_TCP, TCP_NODELAY, (char *) &i, len) < 0)
+		{
+			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not set socket to NODELAY.");
+			goto cleanup;
+		}
+	}
+#endif /* TCP_NODELAY */
+	SOCK_set_kernel_buffer(self, SO_RCVBUF);
+	SOCK_set_kernel_buffer(self, SO_SNDBUF);
+#ifdef	WIN32
+	{
+		long	ioctlsocket_ret = 1;
+
+		/* Returns non-0 on failure, while fcntl() returns -1 on failure */
+		ioctlsocket(self->socket, FIONBIO, &ioctlsocket_ret);
+	}
+#else
+        fcntl(self->socket, F_SETFL, O_NONBLOCK);
+#endif
+
+	if (connect(self->socket, adr->ai_addr, (socklen_t) adr->ai_addrlen) < 0)
+	{
+		gerrno = SOCK_ERRNO;
+		switch (gerrno)
+		{
+			case 0:
+			case EINPROGRESS:
+			case EINTR:
+#ifdef EAGAIN
+			case EAGAIN:
+#endif /* EAGAIN */
+#if defined(EWOULDBLOCK) && (!defined(EAGAIN) || (EWOULDBLOCK != EAGAIN))
+			case EWOULDBLOCK:
+#endif /* EWOULDBLOCK */
+		    		break;
+			default:
+				SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect to remote socket immedaitely");
+				goto cleanup;
+		}
+	}
+	else
+		*connected = TRUE;
+	fd = self->socket;
+	self->socket = (SOCKETFD) -1;
+	return fd;
+
+cleanup:
+	closesocket(self->socket);
+	self->socket = (SOCKETFD) -1;
+	return (SOCKETFD) -1;
+}
+
+/* Set the error of a failed attempt */
+static void
+SOCK_set_connect_error(SocketClass *self, const struct addrinfo *adr, int optval, unsigned short port)
+{
+	char	errmsg[256], host[64];
+
+	host[0] = '\0';
+#if defined(_MSC_VER) && (_MSC_VER < 1300)
+	getnameinfo_ptr
+#else
+	getnameinfo
+#endif
+		(adr->ai_addr, (socklen_t) adr->ai_addrlen, host, sizeof(host),
+			NULL, 0, NI_NUMERICHOST);
+	format_sockerr(errmsg, sizeof(errmsg), optval, "connect", host, port);
+	mylog(errmsg);
+	SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, errmsg);
+}
+
+/*
+ * Put the addresses of each host in the order they are tried, the two
+ * address families alternating.
+ */
+static int
+order_addresses(struct addrinfo *addrs, const struct addrinfo **ordered, int count)
+{
+	const struct addrinfo	*cur, *first[2];
+	int	i, fidx, n = 0;
+
+	first[0] = addrs;
+	for (first[1] = addrs; first[1] && first[1]->ai_family == addrs->ai_family; first[1] = first[1]->ai_next)
+		;
+	for (fidx = 0; n < count && (first[0] || first[1]); fidx = 1 - fidx)
+	{
+		if (!first[fidx])
+			continue;
+		ordered[n++] = cur = first[fidx];
+		/* the next one of the same family */
+		for (cur = cur->ai_next; cur; cur = cur->ai_next)
+		{
+			if (0 == fidx ? cur->ai_family == addrs->ai_family : cur->ai_family != addrs->ai_family)
+				break;
+		}
+		first[fidx] = cur;
+	}
+	for (i = n; i < count; i++)
+		ordered[i] = NULL;
+	return n;
+}
+
 char
 SOCK_connect_to(SocketClass *self, unsigned short port, char *hostname, long timeout)
 {
-	struct addrinfo	rest, *addrs = NULL, *curadr = NULL;
-	int	family = 0; 
+	struct addrinfo	rest, *addrs[MAX_CONNECT_HOSTS], *adr, unix_adr;
+	char	*hosts[MAX_CONNECT_HOSTS];
+	const struct addrinfo	**cands = NULL;
+	const char	**cand_hosts = NULL;
+	ConnectAttempt	*attempts = NULL;
+#ifdef	HAVE_POLL
+	struct pollfd	*fds = NULL;
+#else
+	fd_set	fds, except_fds;
+	struct	timeval	tm;
+	SOCKETFD	maxfd;
+#endif /* HAVE_POLL */
+	int	nhosts = 0, ncands = 0, nattempts = 0, next = 0;
+	int	i, j, ret, gerrno, wait_msec;
 	char	retval = 0;
-	int	gerrno;
+	UInt4	t_now, t_next = 0, t_finish = 0;
+	BOOL	connected = FALSE;
 
 	if (self->socket != (SOCKETFD) -1)
 	{
@@ -272,33 +473,67 @@ SOCK_connect_to(SocketClass *self, unsigned short port, char *hostname, long tim
 #endif /* WIN32 */
 	   )
 	{
-		char	portstr[16];
-		int	ret;
+		char	portstr[16], host[MEDIUM_REGISTRY_LEN];
+		const char	*hptr, *hend;
+		size_t	hlen;
 
-		memset(&rest, 0, sizeof(rest));
-		rest.ai_socktype = SOCK_STREAM;
-		rest.ai_family = AF_UNSPEC;
 		snprintf(portstr, sizeof(portstr), "%d", port);
-		if (inet_addr(hostname) != INADDR_NONE)
-			rest.ai_flags |= AI_NUMERICHOST;	
-		ret = getaddrinfo_ptr(hostname, portstr, &rest, &addrs);
-		if (ret || !addrs)
+		for (hptr = hostname; *hptr && nhosts < MAX_CONNECT_HOSTS; hptr = *hend ? hend + 1 : hend)
+		{
+			if (NULL == (hend = strchr(hptr, ',')))
+				hend = hptr + strlen(hptr);
+			while (hptr < hend && isspace((UCHAR) *hptr))
+				hptr++;
+			for (hlen = hend - hptr; hlen > 0 && isspace((UCHAR) hptr[hlen - 1]); hlen--)
+				;
+			if (0 == hlen || hlen >= sizeof(host))
+				continue;
+			memcpy(host, hptr, hlen);
+			host[hlen] = '\0';
+			memset(&rest, 0, sizeof(rest));
+			rest.ai_socktype = SOCK_STREAM;
+			rest.ai_family = AF_UNSPEC;
+			if (inet_addr(host) != INADDR_NONE)
+				rest.ai_flags |= AI_NUMERICHOST;	
+			adr = NULL;
+			ret = getaddrinfo_ptr(host, portstr, &rest, &adr);
+			if (ret || !adr)
+			{
+				mylog("could not resolve hostname %s\n", host);
+				if (adr)
+					freeaddrinfo_ptr(adr);
+				continue;
+			}
+			if (NULL == (hosts[nhosts] = strdup(host)))
+			{
+				freeaddrinfo_ptr(adr);
+				continue;
+			}
+			addrs[nhosts++] = adr;
+			for (; adr; adr = adr->ai_next)
+				ncands++;
+		}
+		if (0 == ncands)
 		{
 			SOCK_set_error(self, SOCKET_HOST_NOT_FOUND, "Could not resolve hostname.");
-			if (addrs)
-				freeaddrinfo_ptr(addrs);
-			return 0;
+			goto cleanup;
 		}
-		curadr = addrs;
 	}
 	else
 #ifdef	HAVE_UNIX_SOCKETS
 	{
 		struct sockaddr_un *un = (struct sockaddr_un *) &(self->sadr_area);
-		family = un->sun_family = AF_UNIX;
+
+		un->sun_family = AF_UNIX;
 		/* passing NULL or '' means pg default "/tmp" */
 		UNIXSOCK_PATH(un, port, hostname);
 		self->sadr_len = UNIXSOCK_LEN(un);
+		memset(&unix_adr, 0, sizeof(unix_adr));
+		unix_adr.ai_family = AF_UNIX;
+		unix_adr.ai_socktype = SOCK_STREAM;
+		unix_adr.ai_addr = (struct sockaddr *) un;
+		unix_adr.ai_addrlen = self->sadr_len;
+		ncands = 1;
 	}
 #else
 	{
@@ -307,178 +542,188 @@ SOCK_connect_to(SocketClass *self, unsigned short port, char *hostname, long tim
 	}
 #endif /* HAVE_UNIX_SOCKETS */
 
-retry:
-	if (curadr)
-		family = curadr->ai_family;
-	self->socket = socket(family, SOCK_STREAM, 0);
-	if (self->socket == (SOCKETFD) -1)
+	cands = (const struct addrinfo **) malloc(sizeof(*cands) * ncands);
+	cand_hosts = (const char **) malloc(sizeof(*cand_hosts) * ncands);
+	attempts = (ConnectAttempt *) malloc(sizeof(*attempts) * ncands);
+#ifdef	HAVE_POLL
+	fds = (struct pollfd *) malloc(sizeof(*fds) * ncands);
+	if (NULL == fds)
+		ncands = 0;
+#endif /* HAVE_POLL */
+	if (NULL == cands || NULL == cand_hosts || NULL == attempts || 0 == ncands)
 	{
-		SOCK_set_error(self, SOCKET_COULD_NOT_CREATE_SOCKET, "Could not create Socket.");
+		SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not allocate memory for the connection attempts.");
 		goto cleanup;
 	}
-#ifdef	TCP_NODELAY
-	if (family != AF_UNIX)
+	if (0 == nhosts)
 	{
-		int i;
-		socklen_t	len;
-
-		i = 1;
-		len = sizeof(i);
-		if (setsockopt(self->socket, IPPROTO_TCP, TCP_NODELAY, (char *) &i, len) < 0)
-		{
-			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not set socket to NODELAY.");
-			goto cleanup;
-		}
+		cands[0] = &unix_adr;
+		cand_hosts[0] = hostname;
 	}
-#endif /* TCP_NODELAY */
-#ifdef	WIN32
+	else
 	{
-		long	ioctlsocket_ret = 1;
+		for (i = 0, j = 0; i < nhosts; i++)
+		{
+			int	n = order_addresses(addrs[i], cands + j, ncands - j);
 
-		/* Returns non-0 on failure, while fcntl() returns -1 on failure */
-		ioctlsocket(self->socket, FIONBIO, &ioctlsocket_ret);
+			for (; n > 0; n--)
+				cand_hosts[j++] = hosts[i];
+		}
 	}
-#else
-        fcntl(self->socket, F_SETFL, O_NONBLOCK);
-#endif
 
-	if (curadr)
+	t_now = get_msec();
+	if (timeout > 0)
+		t_finish = t_now + (UInt4) timeout * 1000;
+	for (;;)
 	{
-		struct sockaddr *in = (struct sockaddr *) &(self->sadr_area);
-		memset((char *) in, 0, sizeof(self->sadr_area));
-		memcpy(in, curadr->ai_addr, curadr->ai_addrlen);
-		self->sadr_len = (int) curadr->ai_addrlen;
-	}
-	if (connect(self->socket, (struct sockaddr *) &(self->sadr_area), self->sadr_len) < 0)
-	{
-		int	ret, optval;
-		int	wait_sec = 0;
-#ifdef	HAVE_POLL
-		struct pollfd	fds;
-#else
-		fd_set	fds, except_fds;
-		struct	timeval	tm;
-#endif /* HAVE_POLL */
-		socklen_t	optlen = sizeof(optval);
-		time_t	t_now, t_finish = 0;
-		BOOL	tm_exp = FALSE;
-
-		gerrno = SOCK_ERRNO;
-		switch (gerrno)
+		/* start the next attempt when it's time */
+		if (next < ncands &&
+		    (0 == nattempts || (Int4) (t_now - t_next) >= 0))
 		{
-			case 0:
-			case EINPROGRESS:
-			case EINTR:
-#ifdef EAGAIN
-			case EAGAIN:
-#endif /* EAGAIN */
-#if defined(EWOULDBLOCK) && (!defined(EAGAIN) || (EWOULDBLOCK != EAGAIN))
-			case EWOULDBLOCK:
-#endif /* EWOULDBLOCK */
-		    		break;
-			default:
-				SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect to remote socket immedaitely");
-				goto cleanup;
+			attempts[nattempts].adr = cands[next];
+			attempts[nattempts].host = cand_hosts[next++];
+			attempts[nattempts].fd = SOCK_start_connect(self, attempts[nattempts].adr, &connected);
+			if (attempts[nattempts].fd != (SOCKETFD) -1)
+			{
+				if (connected)
+				{
+					i = nattempts++;
+					break;
+				}
+				nattempts++;
+				t_next = t_now + CONNECT_ATTEMPT_DELAY;
+			}
+			continue;
 		}
-		if (timeout > 0)
+		if (0 == nattempts)
+			break;	/* all failed */
+
+		if (timeout > 0 && (Int4) (t_finish - t_now) <= 0)
 		{
-			t_now = time(NULL);
-			t_finish = t_now + timeout;
-			wait_sec = timeout;
+			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect .. timeout occured.");
+			break;
 		}
-		do {
+		wait_msec = -1;
+		if (next < ncands)
+			wait_msec = (Int4) (t_next - t_now);
+		if (timeout > 0 &&
+		    (wait_msec < 0 || (Int4) (t_finish - t_now) < wait_msec))
+			wait_msec = (Int4) (t_finish - t_now);
 #ifdef	HAVE_POLL
-			fds.fd = self->socket;
-			fds.events = POLLOUT;
-			fds.revents = 0;
-			ret = poll(&fds, 1, timeout > 0 ? wait_sec * 1000 : -1);
+		for (i = 0; i < nattempts; i++)
+		{
+			fds[i].fd = attempts[i].fd;
+			fds[i].events = POLLOUT;
+			fds[i].revents = 0;
+		}
+		ret = poll(fds, nattempts, wait_msec);
 #else
-			tm.tv_sec = wait_sec;
-			tm.tv_usec = 0;
-			FD_ZERO(&fds);
-			FD_ZERO(&except_fds);
-			FD_SET(self->socket, &fds);
-			FD_SET(self->socket, &except_fds);
-			ret = select((int) self->socket + 1, NULL, &fds, &except_fds, timeout > 0 ? &tm : NULL);
-#endif /* HAVE_POLL */
-			gerrno = SOCK_ERRNO;
-			if (0 < ret)
-				break;
-			else if (0 == ret)
-				tm_exp = TRUE;
-			else if (EINTR != gerrno)
-				break;
-			else if (timeout > 0)
-			{
-				if (t_now = time(NULL), t_now >= t_finish)
-					tm_exp = TRUE;
-				else
-					wait_sec = (int) (t_finish - t_now);
-			}
-		} while (!tm_exp);
-		if (tm_exp)
+		FD_ZERO(&fds);
+		FD_ZERO(&except_fds);
+		for (i = 0, maxfd = 0; i < nattempts; i++)
 		{
-			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect .. timeout occured.");
-			goto cleanup;
+			FD_SET(attempts[i].fd, &fds);
+			FD_SET(attempts[i].fd, &except_fds);
+			if (attempts[i].fd > maxfd)
+				maxfd = attempts[i].fd;
 		}
-		else if (0 > ret)
+		if (wait_msec >= 0)
 		{
-			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect .. select error occured.");
-			mylog("select error ret=%d ERROR=%d\n", ret, gerrno);
-			goto cleanup;
+			tm.tv_sec = wait_msec / 1000;
+			tm.tv_usec = (wait_msec % 1000) * 1000;
 		}
-		if (getsockopt(self->socket, SOL_SOCKET, SO_ERROR,
-				(char *) &optval, &optlen) == -1)
+		ret = select((int) maxfd + 1, NULL, &fds, &except_fds, wait_msec >= 0 ? &tm : NULL);
+#endif /* HAVE_POLL */
+		gerrno = SOCK_ERRNO;
+		t_now = get_msec();
+		if (0 > ret)
 		{
-			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect .. getsockopt error.");
+			if (EINTR == gerrno)
+				continue;
+			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect .. select error occured.");
+			mylog("select error ret=%d ERROR=%d\n", ret, gerrno);
+			break;
 		}
-		else if (optval != 0)
+		/* look at the finished attempts, the failed ones are removed */
+		for (i = 0; ret > 0 && i < nattempts;)
 		{
-			char	errmsg[256], host[64];
+			int	optval;
+			socklen_t	optlen = sizeof(optval);
 
-			host[0] = '\0';
-#if defined(_MSC_VER) && (_MSC_VER < 1300)
-			getnameinfo_ptr
+#ifdef	HAVE_POLL
+			if (0 == fds[i].revents)
 #else
-			getnameinfo
-#endif
-				((struct sockaddr *) &(self->sadr_area),
-					self->sadr_len, host, sizeof(host),
-					NULL, 0, NI_NUMERICHOST);
-			/* snprintf(errmsg, sizeof(errmsg), "connect getsockopt val %d addr=%s\n", optval, host); */
-			format_sockerr(errmsg, sizeof(errmsg), optval, "connect", host, port);
-			mylog(errmsg);
-			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, errmsg);
+			if (!FD_ISSET(attempts[i].fd, &fds) &&
+			    !FD_ISSET(attempts[i].fd, &except_fds))
+#endif /* HAVE_POLL */
+			{
+				i++;
+				continue;
+			}
+			if (getsockopt(attempts[i].fd, SOL_SOCKET, SO_ERROR,
+					(char *) &optval, &optlen) == -1)
+				SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect .. getsockopt error.");
+			else if (optval != 0)
+				SOCK_set_connect_error(self, attempts[i].adr, optval, port);
+			else
+			{
+				connected = TRUE;
+				break;
+			}
+			closesocket(attempts[i].fd);
+			nattempts--;
+			attempts[i] = attempts[nattempts];
+#ifdef	HAVE_POLL
+			fds[i] = fds[nattempts];
+#endif /* HAVE_POLL */
+			/* try the next address at once */
+			t_next = t_now;
 		}
-		else
-			retval = 1;
+		if (connected)
+			break;
 	}
-	else
-		retval = 1;
 
-cleanup:
-	if (0 == retval)
+	if (connected)
 	{
-		if (self->socket >= 0)
+		self->socket = attempts[i].fd;
+		if (attempts[i].adr != &unix_adr)
 		{
-			closesocket(self->socket);
-			self->socket = (SOCKETFD) -1;
+			memset(&(self->sadr_area), 0, sizeof(self->sadr_area));
+			memcpy(&(self->sadr_area), attempts[i].adr->ai_addr, attempts[i].adr->ai_addrlen);
+			self->sadr_len = (int) attempts[i].adr->ai_addrlen;
 		}
-		if (curadr && curadr->ai_next)
-		{
-			curadr = curadr->ai_next;
-			goto retry;
-		}
-	}
-	else
+		if (self->hostname)
+			free(self->hostname);
+		self->hostname = attempts[i].host ? strdup(attempts[i].host) : NULL;
+		/* abandon the others */
+		attempts[i] = attempts[--nattempts];
+		retval = 1;
 		SOCK_set_error(self, 0, NULL);
-	
-	if (addrs)
-		freeaddrinfo_ptr(addrs);
+	}
+	else if (0 == self->errornumber)
+		SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "Could not connect to remote socket");
+
+cleanup:
+	for (i = 0; i < nattempts; i++)
+		closesocket(attempts[i].fd);
+	if (cands)
+		free(cands);
+	if (cand_hosts)
+		free(cand_hosts);
+	if (attempts)
+		free(attempts);
+#ifdef	HAVE_POLL
+	if (fds)
+		free(fds);
+#endif /* HAVE_POLL */
+	for (i = 0; i < nhosts; i++)
+	{
+		freeaddrinfo_ptr(addrs[i]);
+		free(hosts[i]);
+	}
 	return retval;
 }
 
-
 /*
  *	To handle EWOULDBLOCK etc (mainly for libpq non-blocking connection).
  */
@@ -494,6 +739,7 @@ static int SOCK_wait_for_ready(SocketClass *sock, BOOL output, int retry_count)
 	struct	timeval	tm;
 #endif /* HAVE_POLL */
 	BOOL	no_timeout = TRUE;
+	int	timeout;
 
 	if (0 == retry_count)
 		no_timeout = FALSE;
@@ -504,29 +750,49 @@ static int SOCK_wait_for_ready(SocketClass *sock, BOOL output, int retry_count)
 		no_timeout = TRUE;
 #endif /* USE_SSL */
 	do {
+		timeout = no_timeout ? -1 : retry_count;
+		/*
+		 * Don't wait beyond the deadline set by CC_set_query_timer().
+		 * now is truncated to the second, so that the wait may end up
+		 * to a second after the deadline but never before it.
+		 */
+		if (0 != sock->wait_deadline)
+		{
+			time_t	now = time(NULL);
+			int	left = sock->wait_deadline > now ? (int) (sock->wait_deadline - now) : 0;
+
+			if (timeout < 0 || timeout > left)
+				timeout = left;
+		}
 #ifdef	HAVE_POLL
 		fds.fd = sock->socket;
 		fds.events = output ? POLLOUT : POLLIN;
 		fds.revents = 0;
-		ret = poll(&fds, 1, no_timeout ? -1 : retry_count * 1000);
+		ret = poll(&fds, 1, timeout < 0 ? -1 : timeout * 1000);
 mylog("!!!  poll ret=%d revents=%x\n", ret, fds.revents);
 #else
 		FD_ZERO(&fds);
 		FD_ZERO(&except_fds);
 		FD_SET(sock->socket, &fds);
 		FD_SET(sock->socket, &except_fds);
-		if (!no_timeout)
+		if (timeout >= 0)
 		{
-			tm.tv_sec = retry_count;
+			tm.tv_sec = timeout;
 			tm.tv_usec = 0;
 		}
-		ret = select((int) sock->socket + 1, output ? NULL : &fds, output ? &fds : NULL, &except_fds, no_timeout ? NULL : &tm);
+		ret = select((int) sock->socket + 1, output ? NULL : &fds, output ? &fds : NULL, &except_fds, timeout < 0 ? NULL : &tm);
 #endif /* HAVE_POLL */
 		gerrno = SOCK_ERRNO;
 	} while (ret < 0 && EINTR == gerrno);
 	if (retry_count < 0)
 		retry_count *= -1;
-	if (0 == ret && retry_count > MAX_RETRY_COUNT)
+	if (0 == ret && 0 != sock->wait_deadline &&
+	    time(NULL) >= sock->wait_deadline)
+	{
+		ret = -1;
+		SOCK_set_error(sock, output ? SOCKET_WRITE_TIMEOUT : SOCKET_READ_TIMEOUT, "The server didn't respond to the query cancel");
+	}
+	else if (0 == ret && retry_count > MAX_RETRY_COUNT)
 	{
 		ret = -1;
 		SOCK_set_error(sock, output ? SOCKET_WRITE_TIMEOUT : SOCKET_READ_TIMEOUT, "SOCK_wait_for_ready timeout");
@@ -554,7 +820,112 @@ static int SOCK_SSPI_send(SocketClass *self, const void *buffer, int len)
 	return send(self->socket, (char *) buffer, len, SEND_FLAG);
 }
 
+/*
+ *	Send the pending output followed by the caller's buffer with a
+ *	scatter-gather write (sendmsg or WSASend).  Returns FALSE without
+ *	sending anything when the stream is encrypted, the caller should
+ *	copy the data into buffer_out in that case.
+ */
+#ifdef	WIN32
+typedef	WSABUF	SOCK_IOVEC;
+#define	IOV_BASE(v)	((v).buf)
+#define	IOV_LEN(v)	((v).len)
+#else
+typedef	struct iovec	SOCK_IOVEC;
+#define	IOV_BASE(v)	((v).iov_base)
+#define	IOV_LEN(v)	((v).iov_len)
+#endif /* WIN32 */
+
+static BOOL SOCK_put_vectored(SocketClass *self, const char *buffer, size_t len)
+{
+	SOCK_IOVEC	iov[2], *vp;
+	int		cnt, retry_count = 0, gerrno;
+	size_t		written;
+
+#ifdef	USE_SSL
+	if (self->ssl)
+		return FALSE;
+#endif /* USE_SSL */
+#ifdef	USE_SSPI
+	if (self->sspisvcs && self->ssd)
+		return FALSE;
+#endif /* USE_SSPI */
+	IOV_BASE(iov[0]) = (char *) self->buffer_out;
+	IOV_LEN(iov[0]) = self->buffer_filled_out;
+	IOV_BASE(iov[1]) = (char *) buffer;
+	IOV_LEN(iov[1]) = len;
+	for (vp = iov, cnt = 2; cnt > 0;)
+	{
+		if (0 == IOV_LEN(*vp))
+		{
+			vp++;
+			cnt--;
+			continue;
+		}
+#ifdef	WIN32
+		{
+			DWORD	sent;
+
+			if (0 == WSASend(self->socket, vp, cnt, &sent, 0, NULL, NULL))
+				written = sent;
+			else
+				written = (size_t) -1;
+		}
+#else
+		{
+			struct msghdr	msg;
+			ssize_t	sent;
+
+			memset(&msg, 0, sizeof(msg));
+			msg.msg_iov = vp;
+			msg.msg_iovlen = cnt;
+			sent = sendmsg(self->socket, &msg, SEND_FLAG);
+			written = sent < 0 ? (size_t) -1 : (size_t) sent;
+		}
+#endif /* WIN32 */
+		if ((size_t) -1 == written)
+		{
+			gerrno = SOCK_ERRNO;
+			switch (gerrno)
+			{
+				case EINTR:
+					continue;
+#ifdef EAGAIN
+				case EAGAIN:
+#endif /* EAGAIN */
+#if defined(EWOULDBLOCK) && (!defined(EAGAIN) || (EWOULDBLOCK != EAGAIN))
+				case EWOULDBLOCK:
+#endif /* EWOULDBLOCK */
+					retry_count++;
+					if (SOCK_wait_for_ready(self, TRUE, retry_count) >= 0)
+						continue;
+					break;
+			}
+			SOCK_set_error(self, SOCKET_WRITE_ERROR, "Error while writing to the socket.");
+			break;
+		}
+		retry_count = 0;
+		/* skip what was sent */
+		for (; cnt > 0 && written >= IOV_LEN(*vp); vp++, cnt--)
+			written -= IOV_LEN(*vp);
+		if (cnt > 0)
+		{
+			IOV_BASE(*vp) = (char *) IOV_BASE(*vp) + written;
+			IOV_LEN(*vp) -= written;
+		}
+	}
+	self->buffer_filled_out = 0;
+	return TRUE;
+}
+
 #ifdef USE_SSL
+/*	commonly used for short term lock */
+#if defined(WIN_MULTITHREAD_SUPPORT)
+extern  CRITICAL_SECTION        common_cs;
+#elif defined(POSIX_MULTITHREAD_SUPPORT)
+extern  pthread_mutex_t         common_cs;
+#endif /* WIN_MULTITHREAD_SUPPORT */
+
 /*
  *	The stuff for SSL.
  */
@@ -572,6 +943,10 @@ static int SOCK_SSPI_send(SocketClass *self, const void *buffer, int len)
 
 /*
  *	recv more than 1 bytes using SSL.
+ *
+ *	SSL_read() returns at most one TLS record (16kB), so keep reading
+ *	while the records are at hand to fill the buffer as a plain recv()
+ *	would.
  */
 static int SOCK_SSL_recv(SocketClass *sock, void *buffer, int len)
 {
@@ -580,12 +955,24 @@ static int SOCK_SSL_recv(SocketClass *sock, void *buffer, int len)
 
 retry:
 	n = SSL_read(sock->ssl, buffer, len);
-	err = SSL_get_error(sock->ssl, len);
+	err = SSL_get_error(sock->ssl, n);
 	gerrno = SOCK_ERRNO;
 inolog("%s: %d get_error=%d Lasterror=%d\n", func, n, err, gerrno);
 	switch (err)
 	{
 		case	SSL_ERROR_NONE:
+			while (n < len)
+			{
+				int	rn = SSL_read(sock->ssl, (char *) buffer + n, len - n);
+
+				if (rn <= 0)
+				{
+					/* the error, if any, is seen by the next call */
+					ERR_clear_error();
+					break;
+				}
+				n += rn;
+			}
 			break;
 		case	SSL_ERROR_WANT_READ:
 			retry_count++;
@@ -625,7 +1012,7 @@ static int SOCK_SSL_send(SocketClass *sock, void *buffer, int len)
 
 retry:
 	n = SSL_write(sock->ssl, buffer, len);
-	err = SSL_get_error(sock->ssl, len);
+	err = SSL_get_error(sock->ssl, n);
 	gerrno = SOCK_ERRNO;
 inolog("%s: %d get_error=%d Lasterror=%d\n", func,  n, err, gerrno);
 	switch (err)
@@ -658,8 +1045,368 @@ inolog("%s: %d get_error=%d Lasterror=%d\n", func,  n, err, gerrno);
 	return n;
 }
 
+/*
+ *	TLS session cache.
+ *
+ *	The session of the last connection to each server is kept here and
+ *	handed to the next handshake to the same server, which can then
+ *	resume it.  Only the driver's own SSL connections use it (see
+ *	SOCK_start_ssl()); libpq gives us no SSL object before its handshake
+ *	and, since version 10, creates an SSL_CTX per connection, so there
+ *	is no way to hand a session to it.
+ *
+ *	The sessions are keyed by the server, the user, the sslmode and the
+ *	certificate files in use, so that e.g. a session negotiated under
+ *	sslmode=require is never resumed by a verify-ca connection, and
+ *	only the sessions whose certificate verification succeeded are kept.
+ */
+#define	MAX_SSL_SESSIONS	64
+
+typedef struct
+{
+	char		*key;		/* see ssl_session_key() */
+	SSL_SESSION	*session;
+	time_t		used;
+} SSL_SESSION_ENTRY;
+
+/*	protected by COMMON_CS */
+static SSL_SESSION_ENTRY	ssl_sessions[MAX_SSL_SESSIONS];
+static UInt4	ssl_session_hits = 0, ssl_session_misses = 0;
+/*	the certificate files loaded in ssl_ctx, see ssl_get_context() */
+static char	ssl_root_path[MAXPGPATH] = "", ssl_cert_path[MAXPGPATH] = "";
+
+/*
+ *	Returns a malloc'ed host:port:user:sslmode:root cert:client cert.
+ */
+static char *
+ssl_session_key(const char *host, const char *port, const char *user, const char *sslmode)
+{
+	char	*key;
+	size_t	keylen;
+
+	if (NULL == host)	host = "";
+	if (NULL == port)	port = "";
+	if (NULL == user)	user = "";
+	keylen = strlen(host) + strlen(port) + strlen(user) + strlen(sslmode)
+		+ strlen(ssl_root_path) + strlen(ssl_cert_path) + 6;
+	if (NULL != (key = malloc(keylen)))
+		snprintf(key, keylen, "%s:%s:%s:%s:%s:%s", host, port, user, sslmode, ssl_root_path, ssl_cert_path);
+	return key;
+}
+
+static SSL_SESSION_ENTRY *
+ssl_session_lookup(const char *key)
+{
+	int	i;
+
+	for (i = 0; i < MAX_SSL_SESSIONS; i++)
+	{
+		if (ssl_sessions[i].key && strcmp(ssl_sessions[i].key, key) == 0)
+			return ssl_sessions + i;
+	}
+	return NULL;
+}
+
+/*
+ *	Called when the SSL connection of SOCK_start_ssl() is established.
+ *	Counts the resumed handshakes and keeps the session for the next
+ *	connection if its certificate was verified.
+ */
+void
+SOCK_cache_ssl_session(SocketClass *self)
+{
+	SSL		*ssl = self->ssl;
+	SSL_SESSION	*session = NULL;
+	SSL_SESSION_ENTRY	*entry;
+	const char	*key = self->ssl_session_key;
+	BOOL	reused;
+	long	vres;
+	int	i;
+
+	if (NULL == ssl || NULL == key)
+		return;
+	reused = (0 != SSL_session_reused(ssl));
+	if (X509_V_OK == (vres = SSL_get_verify_result(ssl)))
+		session = SSL_get1_session(ssl);
+	ENTER_COMMON_CS;
+	if (reused)
+		ssl_session_hits++;
+	else
+		ssl_session_misses++;
+	if (NULL != session)
+	{
+		if (NULL == (entry = ssl_session_lookup(key)))
+		{
+			/* an empty or the least recently used slot */
+			for (i = 0, entry = ssl_sessions; i < MAX_SSL_SESSIONS; i++)
+			{
+				if (NULL == ssl_sessions[i].key)
+				{
+					entry = ssl_sessions + i;
+					break;
+				}
+				if (ssl_sessions[i].used < entry->used)
+					entry = ssl_sessions + i;
+			}
+			if (entry->key)
+				free(entry->key);
+			entry->key = strdup(key);
+		}
+		else if (entry->session == session)
+		{
+			/* resumed, already cached */
+			SSL_SESSION_free(session);
+			session = NULL;
+		}
+		if (NULL != session)
+		{
+			if (entry->session)
+				SSL_SESSION_free(entry->session);
+			entry->session = session;
+		}
+		entry->used = time(NULL);
+		if (NULL == entry->key)
+		{
+			SSL_SESSION_free(entry->session);
+			entry->session = NULL;
+		}
+	}
+	LEAVE_COMMON_CS;
+	mylog("SSL session %s for %s verify=%ld hits=%u misses=%u\n", reused ? "resumed" : "negotiated", key, vres, ssl_session_hits, ssl_session_misses);
+}
+
+/*
+ *	The SSL negotiation of the driver's own connections, used instead of
+ *	libpq's only with the DriverSSL option.
+ *
+ *	The certificate files are looked up where libpq looks for them by
+ *	default: root.crt for the verify modes, and postgresql.crt and
+ *	postgresql.key for the client certificate, in ~/.postgresql or
+ *	%APPDATA%\postgresql.  They are loaded once for the process, and
+ *	neither the sslrootcert/sslcert/sslkey settings of a connection nor
+ *	a CRL (PGSSLCRL) are supported.
+ */
+#ifdef	WIN32
+#define	SSL_CERT_DIR_ENV	"APPDATA"
+#define	SSL_CERT_DIR		"\\postgresql\\"
+#else
+#define	SSL_CERT_DIR_ENV	"HOME"
+#define	SSL_CERT_DIR		"/.postgresql/"
+#endif /* WIN32 */
+#define	SSL_READ_BUFFER_LEN	(64 * 1024)
+
+static SSL_CTX	*ssl_ctx = NULL;	/* protected by COMMON_CS */
+static BOOL	ssl_root_loaded = FALSE;
+
+static const char *
+ssl_cert_file(char *path, size_t pathlen, const char *envname, const char *fname)
+{
+	const char	*dir;
+	FILE	*fp;
+
+	if (NULL != envname && NULL != (dir = getenv(envname)) && dir[0])
+		strncpy_null(path, dir, pathlen);
+	else if (NULL != (dir = getenv(SSL_CERT_DIR_ENV)))
+		snprintf(path, pathlen, "%s" SSL_CERT_DIR "%s", dir, fname);
+	else
+		return NULL;
+	if (NULL == (fp = fopen(path, "r")))
+		return NULL;
+	fclose(fp);
+	return path;
+}
+
+static SSL_CTX *
+ssl_get_context(void)
+{
+	char	path[MAXPGPATH], keypath[MAXPGPATH];
+
+	ENTER_COMMON_CS;
+	if (NULL == ssl_ctx)
+	{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+		SSL_library_init();
+		SSL_load_error_strings();
+#endif /* OPENSSL_VERSION_NUMBER */
+		if (NULL != (ssl_ctx = SSL_CTX_new(SSLv23_client_method())))
+		{
+			SSL_CTX_set_options(ssl_ctx, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
+			SSL_CTX_set_mode(ssl_ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef	SSL_OP_ENABLE_KTLS
+			/* let the kernel do the record crypto if it can */
+			SSL_CTX_set_options(ssl_ctx, SSL_OP_ENABLE_KTLS);
+#else
+			/* read as much as the socket has in one call */
+			SSL_CTX_set_read_ahead(ssl_ctx, 1);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+			SSL_CTX_set_default_read_buffer_len(ssl_ctx, SSL_READ_BUFFER_LEN);
+#endif /* OPENSSL_VERSION_NUMBER */
+#endif /* SSL_OP_ENABLE_KTLS */
+			if (NULL != ssl_cert_file(path, sizeof(path), "PGSSLROOTCERT", "root.crt") &&
+			    1 == SSL_CTX_load_verify_locations(ssl_ctx, path, NULL))
+			{
+				ssl_root_loaded = TRUE;
+				strncpy_null(ssl_root_path, path, sizeof(ssl_root_path));
+			}
+			if (NULL != ssl_cert_file(path, sizeof(path), "PGSSLCERT", "postgresql.crt") &&
+			    NULL != ssl_cert_file(keypath, sizeof(keypath), "PGSSLKEY", "postgresql.key"))
+			{
+				if (1 != SSL_CTX_use_certificate_chain_file(ssl_ctx, path) ||
+				    1 != SSL_CTX_use_PrivateKey_file(ssl_ctx, keypath, SSL_FILETYPE_PEM))
+					mylog("could not load the client certificate %s\n", path);
+				else
+					strncpy_null(ssl_cert_path, path, sizeof(ssl_cert_path));
+			}
+		}
+	}
+	LEAVE_COMMON_CS;
+	return ssl_ctx;
+}
+
+static void
+SOCK_set_ssl_error(SocketClass *self, const char *msg)
+{
+	char	errmsg[256];
+	unsigned long	ecode = ERR_get_error();
+
+	if (0 != ecode)
+	{
+		snprintf(errmsg, sizeof(errmsg), "%s: %s", msg, ERR_reason_error_string(ecode));
+		ERR_clear_error();
+		msg = errmsg;
+	}
+	SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, msg);
+}
+
+/*
+ *	Do the SSL handshake after the server accepted the SSL request.
+ *	The session of the previous connection to the same server with the
+ *	same settings is resumed if possible, the caller caches the new one
+ *	with SOCK_cache_ssl_session() once the connection is established.
+ */
+BOOL
+SOCK_start_ssl(SocketClass *self, const char *sslmode, const char *port, const char *user)
+{
+	CSTR	func = "SOCK_start_ssl";
+	SSL_CTX	*ctx;
+	SSL	*ssl;
+	SSL_SESSION_ENTRY	*entry;
+	long	vres;
+	int	ret, err, retry_count = 0;
+
+	/* a man in the middle could have sent the data before the handshake */
+	if (self->buffer_read_in < self->buffer_filled_in)
+	{
+		SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "received unencrypted data after the SSL response");
+		return FALSE;
+	}
+	if (NULL == (ctx = ssl_get_context()) ||
+	    NULL == (ssl = SSL_new(ctx)))
+	{
+		SOCK_set_ssl_error(self, "could not create the SSL context");
+		return FALSE;
+	}
+	if (1 != SSL_set_fd(ssl, (int) self->socket))
+	{
+		SOCK_set_ssl_error(self, "could not set the SSL socket");
+		goto cleanup;
+	}
+	if (SSLLBYTE_VERIFY == sslmode[0])
+	{
+		if (!ssl_root_loaded)
+		{
+			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "root certificate file \"root.crt\" does not exist");
+			goto cleanup;
+		}
+		SSL_set_verify(ssl, SSL_VERIFY_PEER, NULL);
+		if (0 == stricmp(sslmode, SSLMODE_VERIFY_FULL))
+		{
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+			X509_VERIFY_PARAM_set1_host(SSL_get0_param(ssl), self->hostname, 0);
+#else
+			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "verify-full is not supported by this OpenSSL version");
+			goto cleanup;
+#endif /* OPENSSL_VERSION_NUMBER */
+		}
+	}
+
+	if (NULL != self->ssl_session_key)
+		free(self->ssl_session_key);
+	if (NULL != (self->ssl_session_key = ssl_session_key(self->hostname, port, user, sslmode)))
+	{
+		ENTER_COMMON_CS;
+		if (NULL != (entry = ssl_session_lookup(self->ssl_session_key)))
+		{
+			SSL_set_session(ssl, entry->session);
+			entry->used = time(NULL);
+		}
+		LEAVE_COMMON_CS;
+	}
+
+	while ((ret = SSL_connect(ssl)) <= 0)
+	{
+		err = SSL_get_error(ssl, ret);
+		if (SSL_ERROR_WANT_READ == err || SSL_ERROR_WANT_WRITE == err)
+		{
+			retry_count++;
+			if (SOCK_wait_for_ready(self, SSL_ERROR_WANT_WRITE == err, retry_count) >= 0)
+				continue;
+			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, "SSL handshake timeout");
+			goto cleanup;
+		}
+		if (X509_V_OK != SSL_get_verify_result(ssl))
+		{
+			char	errmsg[256];
+
+			snprintf(errmsg, sizeof(errmsg), "certificate verify failed: %s", X509_verify_cert_error_string(SSL_get_verify_result(ssl)));
+			ERR_clear_error();
+			SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, errmsg);
+		}
+		else
+			SOCK_set_ssl_error(self, "SSL handshake failed");
+		goto cleanup;
+	}
+	/* a resumed handshake doesn't verify the certificate again */
+	if (SSLLBYTE_VERIFY == sslmode[0] &&
+	    X509_V_OK != (vres = SSL_get_verify_result(ssl)))
+	{
+		char	errmsg[256];
+
+		snprintf(errmsg, sizeof(errmsg), "certificate verify failed: %s", X509_verify_cert_error_string(vres));
+		SOCK_set_error(self, SOCKET_COULD_NOT_CONNECT, errmsg);
+		goto cleanup;
+	}
+	self->ssl = ssl;
+#ifdef	SSL_OP_ENABLE_KTLS
+	mylog("%s: %s ktls send=%d recv=%d\n", func, SSL_get_version(ssl), (int) BIO_get_ktls_send(SSL_get_wbio(ssl)), (int) BIO_get_ktls_recv(SSL_get_rbio(ssl)));
+#else
+	mylog("%s: %s\n", func, SSL_get_version(ssl));
+#endif /* SSL_OP_ENABLE_KTLS */
+	return TRUE;
+
+cleanup:
+	SSL_free(ssl);
+	return FALSE;
+}
 #endif /* USE_SSL */
 
+/*
+ *	The number of the SSL handshakes which resumed a cached session and
+ *	of those which didn't.
+ */
+void
+SOCK_get_ssl_session_stats(UInt4 *hits, UInt4 *misses)
+{
+#ifdef USE_SSL
+	ENTER_COMMON_CS;
+	*hits = ssl_session_hits;
+	*misses = ssl_session_misses;
+	LEAVE_COMMON_CS;
+#else
+	*hits = *misses = 0;
+#endif /* USE_SSL */
+}
+
 int
 SOCK_get_id(SocketClass *self)
 {
@@ -685,6 +1432,20 @@ SOCK_get_id(SocketClass *self)
 	return id;
 }
 
+/*
+ *	The id of the next message if it's already in the input buffer,
+ *	0 otherwise. Never waits for the server.
+ */
+int
+SOCK_peek_id(SocketClass *self)
+{
+	if (0 != self->errornumber || self->reslen > 0)
+		return 0;
+	if (self->buffer_read_in >= self->buffer_filled_in)
+		return 0;
+	return self->buffer_in[self->buffer_read_in];
+}
+
 void
 SOCK_get_n_char(SocketClass *self, char *buffer, Int4 len)
 {
@@ -721,11 +1482,30 @@ SOCK_put_n_char(SocketClass *self, const char *buffer, size_t len)
 		return;
 	}
 
-	for (lf = 0; lf < len; lf++)
+	/*
+	 * A single piece at least as large as buffer_out is sent directly
+	 * from the caller's buffer together with the pending output instead
+	 * of being copied into buffer_out.  Smaller pieces are always copied;
+	 * in particular the parameter values of a Bind message were already
+	 * copied into the query buffer by BuildBindRequest().
+	 */
+	if (0 == self->errornumber &&
+	    len >= (size_t) self->buffer_size &&
+	    SOCK_put_vectored(self, buffer, len))
+		return;
+	for (lf = 0; lf < len;)
 	{
+		size_t	clen = self->buffer_size - self->buffer_filled_out;
+
 		if (0 != self->errornumber)
 			break;
-		SOCK_put_next_byte(self, (UCHAR) buffer[lf]);
+		if (clen > len - lf)
+			clen = len - lf;
+		memcpy(self->buffer_out + self->buffer_filled_out, buffer + lf, clen);
+		self->buffer_filled_out += (int) clen;
+		lf += clen;
+		if (self->buffer_filled_out == self->buffer_size)
+			SOCK_flush_output(self);
 	}
 }
 
@@ -752,16 +1532,7 @@ SOCK_get_string(SocketClass *self, char *buffer, Int4 bufsize)
 void
 SOCK_put_string(SocketClass *self, const char *string)
 {
-	size_t	lf, len;
-
-	len = strlen(string) + 1;
-
-	for (lf = 0; lf < len; lf++)
-	{
-		if (0 != self->errornumber)
-			break;
-		SOCK_put_next_byte(self, (UCHAR) string[lf]);
-	}
+	SOCK_put_n_char(self, string, strlen(string) + 1);
 }
 
 #define	REVERSE_SHORT(val)	((val & 0xff) << 8) | (val >> 8)
@@ -884,6 +1655,143 @@ SOCK_flush_output(SocketClass *self)
 	return ttlsnd;
 }
 
+/*
+ *	Set the kernel buffer of the socket to the KernelSocketBuffer size.
+ *	Nothing is done by default because setting SO_RCVBUF/SO_SNDBUF
+ *	turns off the automatic tuning of the buffers on e.g. Linux.
+ */
+static void
+SOCK_set_kernel_buffer(SocketClass *self, int optname)
+{
+	int		size = self->kernel_buffer_size;
+
+	if (size <= 0 || self->socket == (SOCKETFD) -1)
+		return;
+	if (setsockopt(self->socket, SOL_SOCKET, optname, (char *) &size, sizeof(size)) < 0)
+		mylog("setsockopt(%d, %d) failed errno=%d\n", optname, size, SOCK_ERRNO);
+}
+
+/*
+ *	Replace the (empty) input buffer by a larger one.  The buffer is
+ *	doubled when the last reads all filled it up, or grown up to "wanted"
+ *	bytes when the caller is about to read a value of that size, but
+ *	never beyond buffer_max_size.
+ */
+static void
+SOCK_grow_buffer_in(SocketClass *self, int wanted)
+{
+	int	newsize;
+	UCHAR	*newbuf;
+
+	if (self->buffer_in_size >= self->buffer_max_size)
+		return;
+	if (self->buffer_full_reads >= 2 && wanted < self->buffer_in_size * 2)
+		wanted = self->buffer_in_size * 2;
+	if (wanted <= self->buffer_in_size)
+		return;
+	for (newsize = self->buffer_in_size; newsize < wanted && newsize < self->buffer_max_size; newsize *= 2)
+		;
+	if (newsize > self->buffer_max_size)
+		newsize = self->buffer_max_size;
+	if (newbuf = (UCHAR *) malloc(newsize), NULL == newbuf)
+		return;
+	mylog("%s: %d -> %d\n", __FUNCTION__, self->buffer_in_size, newsize);
+	free(self->buffer_in);
+	self->buffer_in = newbuf;
+	self->buffer_in_size = newsize;
+	self->buffer_filled_in = self->buffer_read_in = 0;
+	self->buffer_full_reads = 0;
+}
+
+static void
+SOCK_count_read(SocketClass *self)
+{
+	if (self->buffer_filled_in <= 0)
+		return;
+	if (self->buffer_filled_in >= self->buffer_in_size)
+		self->buffer_full_reads++;
+	else
+		self->buffer_full_reads = 0;
+	if (self->buffer_filled_in > self->buffer_peak_in)
+		self->buffer_peak_in = self->buffer_filled_in;
+}
+
+/*
+ *	Give back the memory of a grown input buffer when the last
+ *	request/response cycle used only a small part of it.  Called when the
+ *	backend is idle (ReadyForQuery), the buffer is halved each time until
+ *	it is back to its initial size.
+ */
+void
+SOCK_shrink_buffer(SocketClass *self)
+{
+	int	newsize;
+	UCHAR	*newbuf;
+
+	if (!self)
+		return;
+	newsize = self->buffer_in_size / 2;
+	if (newsize >= self->buffer_init_size &&
+	    self->buffer_read_in >= self->buffer_filled_in &&
+	    self->buffer_peak_in < newsize / 2 &&
+	    NULL != (newbuf = (UCHAR *) malloc(newsize)))
+	{
+		mylog("%s: %d -> %d\n", __FUNCTION__, self->buffer_in_size, newsize);
+		free(self->buffer_in);
+		self->buffer_in = newbuf;
+		self->buffer_in_size = newsize;
+		self->buffer_filled_in = self->buffer_read_in = 0;
+	}
+	self->buffer_peak_in = 0;
+}
+
+/*
+ *	Set the initial size of the i/o buffers, the limit of the input
+ *	buffer growth and the size of the kernel buffers (0 leaves them
+ *	alone).  The buffers must be empty i.e. this is to be called
+ *	before the connection starts.
+ */
+void
+SOCK_set_buffer_size(SocketClass *self, int size, int max_size, int kernel_size)
+{
+	UCHAR	*newin, *newout;
+
+	if (!self)
+		return;
+	if (size <= 0)
+		size = SOCK_BUFFER_SIZE;
+	if (max_size < size)
+		max_size = size;
+	mylog("%s: size=%d max_size=%d\n", __FUNCTION__, size, max_size);
+	if (size != self->buffer_in_size ||
+	    size != self->buffer_size)
+	{
+		if (self->buffer_read_in < self->buffer_filled_in ||
+		    0 != self->buffer_filled_out)
+			return;
+		newin = (UCHAR *) malloc(size);
+		newout = (UCHAR *) malloc(size);
+		if (!newin || !newout)
+		{
+			free(newin);
+			free(newout);
+			return;
+		}
+		free(self->buffer_in);
+		free(self->buffer_out);
+		self->buffer_in = newin;
+		self->buffer_out = newout;
+		self->buffer_in_size = self->buffer_size = size;
+		self->buffer_filled_in = self->buffer_read_in = 0;
+	}
+	self->buffer_init_size = size;
+	self->buffer_max_size = max_size;
+	self->kernel_buffer_size = kernel_size;
+	self->buffer_full_reads = self->buffer_peak_in = 0;
+	SOCK_set_kernel_buffer(self, SO_RCVBUF);
+	SOCK_set_kernel_buffer(self, SO_SNDBUF);
+}
+
 
 UCHAR
 SOCK_get_next_byte(SocketClass *self, BOOL peek)
@@ -899,16 +1807,18 @@ SOCK_get_next_byte(SocketClass *self, BOOL peek)
 		 * there are no more bytes left in the buffer so reload the buffer
 		 */
 		self->buffer_read_in = 0;
+		SOCK_grow_buffer_in(self, 0);
 retry:
 #ifdef USE_SSL 
 		if (self->ssl)
-			self->buffer_filled_in = SOCK_SSL_recv(self, (char *) self->buffer_in, self->buffer_size);
+			self->buffer_filled_in = SOCK_SSL_recv(self, (char *) self->buffer_in, self->buffer_in_size);
 		else
 #endif /* USE_SSL */
-			self->buffer_filled_in = SOCK_SSPI_recv(self, (char *) self->buffer_in, self->buffer_size);
+			self->buffer_filled_in = SOCK_SSPI_recv(self, (char *) self->buffer_in, self->buffer_in_size);
 		gerrno = SOCK_ERRNO;
 
-		mylog("read %d, global_socket_buffersize=%d\n", self->buffer_filled_in, self->buffer_size);
+		mylog("read %d, global_socket_buffersize=%d\n", self->buffer_filled_in, self->buffer_in_size);
+		SOCK_count_read(self);
 
 		if (self->buffer_filled_in < 0)
 		{
@@ -982,16 +1892,18 @@ SOCK_get_next_n_bytes(SocketClass *self, int n, char *buf)
 		 * there are no more bytes left in the buffer so reload the buffer
 		 */
 		self->buffer_read_in = 0;
+		SOCK_grow_buffer_in(self, rest);
 retry:
 #ifdef USE_SSL 
 		if (self->ssl)
-			self->buffer_filled_in = SOCK_SSL_recv(self, (char *) self->buffer_in, self->buffer_size);
+			self->buffer_filled_in = SOCK_SSL_recv(self, (char *) self->buffer_in, self->buffer_in_size);
 		else
 #endif /* USE_SSL */
-			self->buffer_filled_in = SOCK_SSPI_recv(self, (char *) self->buffer_in, self->buffer_size);
+			self->buffer_filled_in = SOCK_SSPI_recv(self, (char *) self->buffer_in, self->buffer_in_size);
 		gerrno = SOCK_ERRNO;
 
-		mylog("read %d, global_socket_buffersize=%d\n", self->buffer_filled_in, self->buffer_size);
+		mylog("read %d, global_socket_buffersize=%d\n", self->buffer_filled_in, self->buffer_in_size);
+		SOCK_count_read(self);
 
 		if (self->buffer_filled_in < 0)
 		{
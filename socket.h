@@ -26,6 +26,7 @@
 #endif /* HAVE_POLL */
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -146,7 +147,13 @@ typedef int (WSAAPI *getnameinfo_func) (const struct sockaddr *,
 struct SocketClass_
 {
 
-	int			buffer_size;
+	int			buffer_size;	/* size of buffer_out */
+	int			buffer_in_size;	/* current size of buffer_in */
+	int			buffer_init_size;	/* buffer_in shrinks back to this */
+	int			buffer_max_size;	/* buffer_in never grows beyond this */
+	int			buffer_full_reads;	/* successive reads filling buffer_in */
+	int			buffer_peak_in;	/* largest read since the last shrink */
+	int			kernel_buffer_size;	/* SO_RCVBUF/SO_SNDBUF, 0 means the OS default */
 	int			buffer_filled_in;
 	int			buffer_filled_out;
 	int			buffer_read_in;
@@ -156,18 +163,21 @@ struct SocketClass_
 	SOCKETFD	socket;
 	unsigned int	pversion;
 	int		reslen;
+	time_t		wait_deadline;	/* don't wait for the server after it, 0 means no limit */
 
 	char		*_errormsg_;
 	int		errornumber;
 	int		sadr_len;
 	struct sockaddr_storage sadr_area; /* Used for various connections */
+	char		*hostname;	/* the one of the Servername list connected to */
 #ifdef	USE_SSPI
 	UInt4		sspisvcs;
 	void		*ssd;
 #endif /* USE_SSPI */
 #ifdef	USE_SSL
 	/* SSL stuff */
-	void		*ssl;		/* libpq ssl */
+	void		*ssl;		/* libpq's or our own ssl */
+	char		*ssl_session_key;	/* of our own ssl, see SOCK_start_ssl() */
 #endif /* USE_SSL */
 #ifndef	NOT_USE_LIBPQ
 	void		*pqconn;	/* libpq PGConn */
@@ -226,6 +236,7 @@ SocketClass *SOCK_Constructor(const ConnectionClass *conn);
 void		SOCK_Destructor(SocketClass *self);
 char		SOCK_connect_to(SocketClass *self, unsigned short port, char *hostname, long timeout);
 int		SOCK_get_id(SocketClass *self);
+int		SOCK_peek_id(SocketClass *self);
 void		SOCK_get_n_char(SocketClass *self, char *buffer, Int4 len);
 void		SOCK_put_n_char(SocketClass *self, const char *buffer, size_t len);
 BOOL		SOCK_get_string(SocketClass *self, char *buffer, Int4 bufsize);
@@ -238,5 +249,12 @@ void		SOCK_put_next_byte(SocketClass *self, UCHAR next_byte);
 Int4		SOCK_get_response_length(SocketClass *self);
 void		SOCK_clear_error(SocketClass *self);
 UInt4		SOCK_skip_n_bytes(SocketClass *self, UInt4 skip_length);
+void		SOCK_set_buffer_size(SocketClass *self, int size, int max_size, int kernel_size);
+void		SOCK_shrink_buffer(SocketClass *self);
+void		SOCK_get_ssl_session_stats(UInt4 *hits, UInt4 *misses);
+#ifdef USE_SSL
+void		SOCK_cache_ssl_session(SocketClass *self);
+BOOL		SOCK_start_ssl(SocketClass *self, const char *sslmode, const char *port, const char *user);
+#endif /* USE_SSL */
 
 #endif /* __SOCKET_H__ */
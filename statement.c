@@ -400,6 +400,7 @@ SC_Constructor(ConnectionClass *conn)
 		rv->pgerror = NULL;
 
 		rv->statement = NULL;
+		rv->tokens = NULL;
 		rv->stmt_with_params = NULL;
 		rv->load_statement = NULL;
 		rv->execute_statement = NULL;
@@ -428,6 +429,7 @@ SC_Constructor(ConnectionClass *conn)
 		SC_init_parse_method(rv);
 
 		rv->lobj_fd = -1;
+		odbc_lo_stream_init(&rv->lobj_stream);
 		INIT_NAME(rv->cursor_name);
 
 		/* Parse Stuff */
@@ -469,6 +471,19 @@ SC_Constructor(ConnectionClass *conn)
 	return rv;
 }
 
+/*
+ *	The statement gives up the results of the batch it executed, so
+ *	the unread ones are of no use.
+ */
+static void
+SC_discard_lazy_results(StatementClass *self)
+{
+	ConnectionClass	*conn = SC_get_conn(self);
+
+	if (NULL != conn && self == conn->stmt_in_lazyquery)
+		CC_finish_lazy_query(conn, TRUE);
+}
+
 char
 SC_Destructor(StatementClass *self)
 {
@@ -484,6 +499,7 @@ SC_Destructor(StatementClass *self)
 		return FALSE;
 	}
 
+	SC_discard_lazy_results(self);
 	if (res)
 	{
 		if (!self->hdbc)
@@ -505,6 +521,7 @@ SC_Destructor(StatementClass *self)
 	DC_Destructor((DescriptorClass *) SC_get_IPDi(self));
 	GDATA_unbind_cols(SC_get_GDTI(self), TRUE);
 	PDATA_free_params(SC_get_PDTI(self), STMT_FREE_PARAMS_ALL);
+	odbc_lo_stream_discard(&self->lobj_stream);
 	
 	if (self->__error_message)
 		free(self->__error_message);
@@ -525,6 +542,7 @@ SC_Destructor(StatementClass *self)
 void
 SC_init_Result(StatementClass *self)
 {
+	SC_discard_lazy_results(self);
 	self->result = self->curres = NULL;
 	self->curr_param_result = 0;
 	mylog("SC_init_Result(%x)", self);
@@ -536,6 +554,8 @@ SC_set_Result(StatementClass *self, QResultClass *res)
 	if (res != self->result)
 	{
 		mylog("SC_set_Result(%x, %x)", self, res);
+		if (NULL != self->result)
+			SC_discard_lazy_results(self);
 		QR_Destructor(self->result);
 		self->result = self->curres = res;
 		if (NULL != res)
@@ -714,6 +734,7 @@ SC_initialize_stmts(StatementClass *self, BOOL initializeOriginal)
 	}
 	if (initializeOriginal)
 	{
+		SC_forget_tokens(self);
 		if (self->statement)
 		{
 			free(self->statement);
@@ -893,6 +914,7 @@ inolog("%s statement=%p ommitted=0\n", func, self);
 	self->__error_number = 0;
 
 	self->lobj_fd = -1;
+	odbc_lo_stream_discard(&self->lobj_stream);
 
 	/*
 	 * Free any data at exec params before the statement is executed
@@ -915,165 +937,272 @@ inolog("%s statement=%p ommitted=0\n", func, self);
 	return TRUE;
 }
 
+#define	QT_INCREMENT	64
+
+static BOOL
+QT_add_token(QueryTokens *self, const char *tstart, const char *tend, char type, char escape)
+{
+	QueryToken	*tok;
+
+	if (self->ntokens >= self->allocated)
+	{
+		Int4		new_alloc = self->allocated > 0 ? 2 * self->allocated : QT_INCREMENT;
+
+		tok = (QueryToken *) realloc(self->tokens, sizeof(QueryToken) * new_alloc);
+		if (!tok)
+			return FALSE;
+		self->tokens = tok;
+		self->allocated = new_alloc;
+	}
+	tok = self->tokens + self->ntokens++;
+	tok->pos = (Int4) (tstart - self->query);
+	tok->len = (Int4) (tend - tstart + 1);
+	tok->type = type;
+	tok->escape = escape;
+	return TRUE;
+}
+
+#define	IS_WORD_CHAR(c)	(isalnum((UCHAR) (c)) || '_' == (c))
+
 /*
- *	Scan the query wholly or partially (if the next_cmd param specified).
- *	Also count the number of parameters respectviely.
+ *	Split the query into tokens in one pass.  Only the quotes, the
+ *	comments and the characters which matter to the scanners are told
+ *	apart; the tokens don't depend on the kind of the statement.
  */
-void
-SC_scanQueryAndCountParams(const char *query, const ConnectionClass *conn,
-		Int4 *next_cmd, SQLSMALLINT * pcpar,
-		po_ind_t *multi_st, po_ind_t *proc_return)
+QueryTokens *
+QT_lex(const char *query, int ccsc, char escape_in_literal)
 {
-	CSTR func = "SC_scanQueryAndCountParams";
-	char	literal_quote = LITERAL_QUOTE, identifier_quote = IDENTIFIER_QUOTE, dollar_quote = DOLLAR_QUOTE;
-	const	char *sptr, *tstr, *tag = NULL;
-	size_t	taglen = 0;
-	char	tchar, bchar, escape_in_literal = '\0';
-	char	in_literal = FALSE, in_identifier = FALSE,
-		in_dollar_quote = FALSE, in_escape = FALSE,
-		in_line_comment = FALSE, del_found = FALSE;
-	int	comment_level = 0;
-	po_ind_t multi = FALSE;
-	SQLSMALLINT	num_p;
-	encoded_str	encstr;
+	CSTR func = "QT_lex";
+	QueryTokens	*self;
+	encoded_str	encstr, save;
+	const char	*sptr, *tstart, *tag;
+	char		tchar, type, escape, quote, in_escape;
+	Int4		taglen;
+	int		comment_level;
 
 	mylog("%s: entering...\n", func);
-	num_p = 0;
-	if (proc_return)
-		*proc_return = 0;
-	if (next_cmd)
-		*next_cmd = -1;
-	tstr = query;
-	make_encoded_str(&encstr, conn, tstr);
-	for (sptr = tstr, bchar = '\0'; *sptr; sptr++)
-	{
+	self = (QueryTokens *) calloc(1, sizeof(QueryTokens));
+	if (!self)
+		return NULL;
+	self->query = query;
+	self->ccsc = ccsc;
+	self->escape_in_literal = escape_in_literal;
+	encoded_str_constr(&encstr, ccsc, query);
+	for (sptr = query; *sptr; sptr++)
+	{
+		tstart = sptr;
+		escape = '\0';
 		tchar = encoded_nextchar(&encstr);
-		if (ENCODE_STATUS(encstr) != 0) /* multibyte char */
+		if (ENCODE_STATUS(encstr) != 0 || IS_WORD_CHAR(tchar))
 		{
-			if ((UCHAR) tchar >= 0x80)
-				bchar = tchar;
-			continue;
+			type = isdigit((UCHAR) tchar) ? QTOK_NUMBER : QTOK_WORD;
+			while ('\0' != sptr[1])
+			{
+				save = encstr;
+				tchar = encoded_nextchar(&encstr);
+				if (QTOK_NUMBER == type ?
+				    (ENCODE_STATUS(encstr) == 0 && (isalnum((UCHAR) tchar) || '.' == tchar)) :
+				    (ENCODE_STATUS(encstr) != 0 || IS_WORD_CHAR(tchar)))
+					sptr++;
+				else
+				{
+					encstr = save;
+					break;
+				}
+			}
 		}
-		if (!multi && del_found)
+		else if (isspace((UCHAR) tchar))
 		{
-			if (!isspace(tchar))
+			type = QTOK_SPACE;
+			while (isspace((UCHAR) sptr[1]))
 			{
-				multi = TRUE;
-				if (next_cmd)
+				encoded_nextchar(&encstr);
+				sptr++;
+			}
+		}
+		else if (LITERAL_QUOTE == tchar || IDENTIFIER_QUOTE == tchar)
+		{
+			quote = tchar;
+			if (LITERAL_QUOTE == quote)
+			{
+				type = QTOK_LITERAL;
+				escape = escape_in_literal;
+				if (!escape && sptr > query && LITERAL_EXT == sptr[-1])
+					escape = ESCAPE_IN_LITERAL;
+			}
+			else
+				type = QTOK_IDENT;
+			in_escape = FALSE;
+			while ('\0' != sptr[1])
+			{
+				sptr++;
+				tchar = encoded_nextchar(&encstr);
+				if (ENCODE_STATUS(encstr) != 0)
+					continue;
+				if (in_escape)
+					in_escape = FALSE;
+				else if ('\0' != escape && escape == tchar)
+					in_escape = TRUE;
+				else if (quote == tchar)
 					break;
 			}
 		}
-		if (in_dollar_quote)
+		else if (DOLLAR_QUOTE == tchar &&
+			 (taglen = findTag(sptr, DOLLAR_QUOTE, ccsc)) > 0)
 		{
-			if (tchar == dollar_quote)
+			type = QTOK_DOLLAR;
+			tag = sptr;
+			sptr += (taglen - 1);
+			encoded_position_shift(&encstr, taglen - 1);
+			while ('\0' != sptr[1])
 			{
-				if (strncmp(sptr, tag, taglen) == 0)
+				sptr++;
+				tchar = encoded_nextchar(&encstr);
+				if (ENCODE_STATUS(encstr) != 0)
+					continue;
+				if (DOLLAR_QUOTE == tchar &&
+				    strncmp(sptr, tag, taglen) == 0)
 				{
-					in_dollar_quote = FALSE;
-					tag = NULL;
-					sptr += taglen;
-					sptr--;
+					sptr += (taglen - 1);
 					encoded_position_shift(&encstr, taglen - 1);
+					break;
 				}
 			}
 		}
-		else if (in_literal)
-		{
-			if (in_escape)
-				in_escape = FALSE;
-			else if (tchar == escape_in_literal)
-				in_escape = TRUE;
-			else if (tchar == literal_quote)
-				in_literal = FALSE;
-		}
-		else if (in_identifier)
+		else if ('-' == tchar && '-' == sptr[1])
 		{
-			if (tchar == identifier_quote)
-				in_identifier = FALSE;
-		}
-		else if (in_line_comment)
-		{
-			if (PG_LINEFEED == tchar)
-				in_line_comment = FALSE;
-		}
-		else if (comment_level > 0)
-		{
-			if ('/' == tchar && '*' == sptr[1])
+			type = QTOK_COMMENT;
+			while ('\0' != sptr[1] && PG_LINEFEED != sptr[1])
 			{
 				encoded_nextchar(&encstr);
 				sptr++;
-				comment_level++;
 			}
-			else if ('*' == tchar && '/' == sptr[1])
+		}
+		else if ('/' == tchar && '*' == sptr[1])
+		{
+			type = QTOK_COMMENT;
+			encoded_nextchar(&encstr);
+			sptr++;
+			for (comment_level = 1; comment_level > 0 && '\0' != sptr[1];)
 			{
+				sptr++;
+				tchar = encoded_nextchar(&encstr);
+				if (ENCODE_STATUS(encstr) != 0)
+					continue;
+				if ('/' == tchar && '*' == sptr[1])
+					comment_level++;
+				else if ('*' == tchar && '/' == sptr[1])
+					comment_level--;
+				else
+					continue;
 				encoded_nextchar(&encstr);
 				sptr++;
-				comment_level--;
 			}
 		}
+		else if ('?' == tchar)
+			type = QTOK_MARKER;
+		else if (';' == tchar)
+			type = QTOK_DELIM;
 		else
+			type = QTOK_PUNCT;
+		if (!QT_add_token(self, tstart, sptr, type, escape))
 		{
-			if (tchar == '?')
-			{
-				if (0 == num_p && bchar == '{')
+			QT_Destructor(self);
+			return NULL;
+		}
+	}
+	inolog("%s: %d tokens\n", func, self->ntokens);
+
+	return self;
+}
+
+void
+QT_Destructor(QueryTokens *self)
+{
+	if (!self)
+		return;
+	if (self->tokens)
+		free(self->tokens);
+	free(self);
+}
+
+/*
+ *	The index of the token containing the position pos, or ntokens if
+ *	pos is at the end of the query.
+ */
+Int4
+QT_token_at(const QueryTokens *self, Int4 pos)
+{
+	Int4	low = 0, high = self->ntokens - 1, mid;
+
+	while (low <= high)
+	{
+		mid = (low + high) / 2;
+		if (pos < self->tokens[mid].pos)
+			high = mid - 1;
+		else if (pos >= self->tokens[mid].pos + self->tokens[mid].len)
+			low = mid + 1;
+		else
+			return mid;
+	}
+	return low;
+}
+
+/*
+ *	Scan the tokens from the position offset wholly or partially (if the
+ *	next_cmd param specified).  Also count the number of parameters
+ *	respectively.  next_cmd is relative to offset.
+ */
+void
+QT_scanQueryAndCountParams(const QueryTokens *self, Int4 offset,
+		Int4 *next_cmd, SQLSMALLINT * pcpar,
+		po_ind_t *multi_st, po_ind_t *proc_return)
+{
+	const QueryToken	*tok, *prev = NULL;
+	Int4		i;
+	BOOL		del_found = FALSE;
+	po_ind_t	multi = FALSE;
+	SQLSMALLINT	num_p = 0;
+
+	if (proc_return)
+		*proc_return = 0;
+	if (next_cmd)
+		*next_cmd = -1;
+	for (i = QT_token_at(self, offset); i < self->ntokens; i++)
+	{
+		tok = self->tokens + i;
+		if (QTOK_SPACE == tok->type || QTOK_COMMENT == tok->type)
+			continue;
+		if (!multi && del_found)
+		{
+			multi = TRUE;
+			if (next_cmd)
+				break;
+		}
+		switch (tok->type)
+		{
+			case QTOK_MARKER:
+				if (0 == num_p && NULL != prev &&
+				    QTOK_PUNCT == prev->type &&
+				    '{' == self->query[prev->pos])
 				{
 					if (proc_return)
 						*proc_return = 1;
 				}
 				num_p++;
-			}
-			else if (tchar == ';')
-			{
+				break;
+			case QTOK_DELIM:
 				del_found = TRUE;
 				if (next_cmd)
-					*next_cmd = sptr - query;
-			}
-			else if (tchar == dollar_quote)
-			{
-				taglen = findTag(sptr, dollar_quote, encstr.ccsc);
-				if (taglen > 0)
-				{
-					in_dollar_quote = TRUE;
-					tag = sptr;
-					sptr += (taglen - 1);
-					encoded_position_shift(&encstr, taglen - 1);
-				}
-				else
+					*next_cmd = tok->pos - offset;
+				break;
+			case QTOK_PUNCT:
+				/* $n */
+				if (DOLLAR_QUOTE == self->query[tok->pos])
 					num_p++;
-			}
-			else if (tchar == literal_quote)
-			{
-				in_literal = TRUE;
-				escape_in_literal = CC_get_escape(conn);
-				if (!escape_in_literal)
-				{
-					if (LITERAL_EXT == sptr[-1])
-						escape_in_literal = ESCAPE_IN_LITERAL;
-				}
-			}
-			else if (tchar == identifier_quote)
-				in_identifier = TRUE;
-			else if ('-' == tchar)
-			{
-				if ('-' == sptr[1])
-				{
-					encoded_nextchar(&encstr);
-					sptr++;
-					in_line_comment = TRUE;
-				}
-			}
-			else if ('/' == tchar)
-			{
-				if ('*' == sptr[1])
-				{
-					encoded_nextchar(&encstr);
-					sptr++;
-					comment_level++;
-				}
-			}
-			if (!isspace(tchar))
-				bchar = tchar;
+				break;
 		}
+		prev = tok;
 	}
 	if (pcpar)
 		*pcpar = num_p;
@@ -1081,6 +1210,61 @@ SC_scanQueryAndCountParams(const char *query, const ConnectionClass *conn,
 		*multi_st = multi;
 }
 
+/*
+ *	Scan the query wholly or partially (if the next_cmd param specified).
+ *	Also count the number of parameters respectviely.
+ */
+void
+SC_scanQueryAndCountParams(const char *query, const ConnectionClass *conn,
+		Int4 *next_cmd, SQLSMALLINT * pcpar,
+		po_ind_t *multi_st, po_ind_t *proc_return)
+{
+	CSTR func = "SC_scanQueryAndCountParams";
+	QueryTokens	*qt;
+
+	mylog("%s: entering...\n", func);
+	if (qt = QT_lex(query, conn->ccsc, CC_get_escape(conn)), NULL == qt)
+	{
+		if (next_cmd)
+			*next_cmd = -1;
+		if (pcpar)
+			*pcpar = 0;
+		if (multi_st)
+			*multi_st = FALSE;
+		if (proc_return)
+			*proc_return = 0;
+		return;
+	}
+	QT_scanQueryAndCountParams(qt, 0, next_cmd, pcpar, multi_st, proc_return);
+	QT_Destructor(qt);
+}
+
+/*
+ *	The tokens of the statement, lexed once and kept until the statement
+ *	changes.
+ */
+const QueryTokens *
+SC_get_tokens(StatementClass *self)
+{
+	const ConnectionClass	*conn = SC_get_conn(self);
+
+	if (NULL != self->tokens &&
+	    (self->tokens->query != self->statement ||
+	     self->tokens->ccsc != conn->ccsc ||
+	     self->tokens->escape_in_literal != CC_get_escape(conn)))
+		SC_forget_tokens(self);
+	if (NULL == self->tokens && NULL != self->statement)
+		self->tokens = QT_lex(self->statement, conn->ccsc, CC_get_escape(conn));
+	return self->tokens;
+}
+
+void
+SC_forget_tokens(StatementClass *self)
+{
+	QT_Destructor(self->tokens);
+	self->tokens = NULL;
+}
+
 /*
  * Pre-execute a statement (for SQLPrepare/SQLDescribeCol) 
  */
@@ -1259,7 +1443,8 @@ static const struct
 	{ STMT_COUNT_FIELD_INCORRECT, "07002", "07002" },
 	{ STMT_INVALID_NULL_ARG, "HY009", "S1009" },
 	{ STMT_NO_RESPONSE, "08S01", "08S01" },
-	{ STMT_COMMUNICATION_ERROR, "08S01", "08S01" }
+	{ STMT_COMMUNICATION_ERROR, "08S01", "08S01" },
+	{ STMT_QUERY_TIMEOUT, "HYT00", "S1T00" }
 };
 
 static PG_ErrorInfo *
@@ -1359,6 +1544,9 @@ SC_create_errorinfo(const StatementClass *self)
 		}
 		ermsg = msg;
 	}
+	/* the backend reports the cancel, not the timeout */
+	if (STMT_QUERY_TIMEOUT == errornum)
+		sqlstate = NULL;
 	pgerror = ER_Constructor(self->__error_number, ermsg);
 	if (sqlstate)
 		strcpy(pgerror->sqlstate, sqlstate);
@@ -1825,6 +2013,78 @@ inolog("curt=%d\n", curt);
 }
 
 
+/*
+ *	Send Parse, Bind, Describe and Execute requests for each command of
+ *	a multi-statement query, stmt_with_params holds the query converted
+ *	by prep_params().  The commands run through the unnamed statement and
+ *	portal in turn, the caller sends the only Sync and reads the results.
+ */
+static BOOL
+SendPipelinedRequests(StatementClass *self, UInt4 max_rows)
+{
+	CSTR	func = "SendPipelinedRequests";
+	ConnectionClass	*conn = SC_get_conn(self);
+	const char	*srvquery = self->stmt_with_params;
+	const QueryTokens	*orgtokens;
+	QueryTokens	*srvtokens = NULL;
+	Int4		orgpos = 0, srvpos = 0, srvlen, endp1, endp2, i;
+	SQLSMALLINT	num_pa = 0, num_p1;
+	po_ind_t	multi = 1;
+	BOOL		ret = FALSE;
+
+	if (NULL == srvquery)
+	{
+		SC_set_error(self, STMT_INTERNAL_ERROR, "No statement to pipeline", func);
+		return FALSE;
+	}
+	orgtokens = SC_get_tokens(self);
+	srvtokens = QT_lex(srvquery, conn->ccsc, CC_get_escape(conn));
+	if (NULL == orgtokens || NULL == srvtokens)
+	{
+		SC_set_error(self, STMT_NO_MEMORY_ERROR, "Couldn't scan the statement", func);
+		goto cleanup;
+	}
+	srvlen = (Int4) strlen(srvquery);
+	while (multi > 0 && srvpos < srvlen)
+	{
+		QT_scanQueryAndCountParams(orgtokens, orgpos, &endp1, &num_p1, &multi, NULL);
+		QT_scanQueryAndCountParams(srvtokens, srvpos, &endp2, NULL, NULL, NULL);
+		if (endp2 < 0)
+			endp2 = srvlen - srvpos;
+		/*
+		 * skip the commands of spaces and comments only as the simple
+		 * query protocol does, Parse would make an empty query of them
+		 */
+		for (i = QT_token_at(srvtokens, srvpos); i < srvtokens->ntokens && srvtokens->tokens[i].pos < srvpos + endp2; i++)
+		{
+			if (QTOK_SPACE != srvtokens->tokens[i].type &&
+			    QTOK_COMMENT != srvtokens->tokens[i].type)
+				break;
+		}
+		mylog("%s: command at %d length=%d(%d) num_p=%d\n", func, srvpos, endp2, endp1, num_p1);
+		if (i < srvtokens->ntokens && srvtokens->tokens[i].pos < srvpos + endp2)
+		{
+			self->current_exec_param = num_pa;
+			if (!SendParseRequest(self, NULL_STRING, srvquery + srvpos, endp2, num_p1))
+				goto cleanup;
+			if (!SendBindRequest(self, NULL_STRING, num_p1))
+				goto cleanup;
+			if (!SendDescribeRequest(self, NULL_STRING, FALSE))
+				goto cleanup;
+			if (!SendExecuteRequest(self, NULL_STRING, max_rows))
+				goto cleanup;
+		}
+		orgpos += (endp1 + 1);
+		srvpos += (endp2 + 1);
+		num_pa += num_p1;
+	}
+	ret = TRUE;
+cleanup:
+	QT_Destructor(srvtokens);
+	self->current_exec_param = -1;
+	return ret;
+}
+
 #include "dlg_specific.h"
 RETCODE
 SC_execute(StatementClass *self)
@@ -1843,7 +2103,7 @@ SC_execute(StatementClass *self)
 	BOOL		is_in_trans, issue_begin, has_out_para;
 	BOOL		use_extended_protocol;
 	int		func_cs_count = 0, i;
-	BOOL		useCursor, isSelectType;
+	BOOL		useCursor, isSelectType, timed_out = FALSE;
 
 	conn = SC_get_conn(self);
 	ci = &(conn->connInfo);
@@ -1867,6 +2127,9 @@ SC_execute(StatementClass *self)
 		mylog("%s: problem with connection\n", func);
 		goto cleanup;
 	}
+	/* the rest of a batch left unread may change the transaction status */
+	if (NULL != conn->stmt_in_lazyquery)
+		CC_finish_lazy_query(conn, FALSE);
 	is_in_trans = CC_is_in_trans(conn);
 	if ((useCursor = SC_is_fetchcursor(self)))
 	{
@@ -1924,6 +2187,9 @@ SC_execute(StatementClass *self)
 		goto cleanup;
 	}
 	conn->status = CONN_EXECUTING;
+	/* The query is cancelled when SQL_QUERY_TIMEOUT expires */
+	if (self->options.stmt_timeout > 0)
+		CC_set_query_timer(conn, self->options.stmt_timeout);
 
 	/* If it's a SELECT statement, use a cursor. */
 
@@ -1942,7 +2208,8 @@ SC_execute(StatementClass *self)
 			break;
 		case PREPARING_TEMPORARILY:
 		case PREPARED_TEMPORARILY:
-			if (!issue_begin)
+			/* a multi-statement query is pipelined even if BEGIN is needed */
+			if (!issue_begin || self->multi_statement > 0)
 			{
 				switch (SC_get_prepare_method(self))
 				{
@@ -1967,21 +2234,55 @@ SC_execute(StatementClass *self)
 			break;
 	}
 	isSelectType = (SC_may_use_cursor(self) || self->statement_type == STMT_TYPE_PROCCALL);
+	/* CREATE, ALTER, DROP, GRANT or REVOKE may outdate the cached catalog results */
+	if (SC_may_change_catalog(self) && conn->num_catalog_cache > 0)
+		CC_clear_catalog_cache(conn);
+	/*
+	 * let SQLMoreResults read the rest of a batch. Only in manual-commit
+	 * mode: in autocommit mode a failing statement would roll back the
+	 * whole batch, and the error would go unnoticed if the application
+	 * closed the statement before reaching it.
+	 */
+	if (ci->drivers.lazy_more_results && self->multi_statement > 0 &&
+	    !CC_does_autocommit(conn) &&
+	    STMT_TYPE_PROCCALL != self->statement_type &&
+	    !SC_is_concat_prepare_exec(self) && self == SC_get_ancestor(self))
+		qflag |= LAZY_RESULTS;
 	if (use_extended_protocol)
 	{
 		char	*plan_name = self->plan_name;
+		UInt4	max_rows = 0;
 
+		/* BEGIN goes ahead of the requests and shares their Sync */
 		if (issue_begin)
-			CC_begin(conn);
+		{
+			if (!CC_queue_begin(conn))
+			{
+				SC_set_error(self, STMT_EXEC_ERROR, "Could not begin a transaction", func);
+				goto cleanup;
+			}
+		}
 		if (!plan_name)
 			plan_name = "";
-		if (!SendBindRequest(self, plan_name))
+		/* The server stops at SQL_MAX_ROWS with a Portal Suspended */
+		if (isSelectType && !SC_is_fetchcursor(self) && self->options.maxRows > 0)
+			max_rows = (UInt4) self->options.maxRows;
+		if (self->multi_statement > 0 && !self->plan_name)
+		{
+			if (!SendPipelinedRequests(self, max_rows))
+			{
+				if (SC_get_errornumber(self) <= 0)
+					SC_set_error(self, STMT_EXEC_ERROR, "Pipelined request error", func);
+				goto cleanup;
+			}
+		}
+		else if (!SendBindRequest(self, plan_name, -1))
 		{
 			if (SC_get_errornumber(self) <= 0)
 				SC_set_error(self, STMT_EXEC_ERROR, "Bind request error", func);
 			goto cleanup;
 		}
-		if (!SendExecuteRequest(self, plan_name, 0))
+		else if (!SendExecuteRequest(self, plan_name, max_rows))
 		{
 			if (SC_get_errornumber(self) <= 0)
 				SC_set_error(self, STMT_EXEC_ERROR, "Execute request error", func);
@@ -1989,6 +2290,9 @@ SC_execute(StatementClass *self)
 		}
 		for (res = SC_get_Result(self); NULL != res && NULL != res->next; res = res->next) ;
 inolog("get_Result=%p %p %d\n", res, SC_get_Result(self), self->curr_param_result);
+		/* the results of a multi-statement query are appended as with the simple protocol */
+		if (self->multi_statement > 0)
+			res = NULL;
 		if (!(res = SendSyncAndReceive(self, self->curr_param_result ? res : NULL, "bind_and_execute")))
 		{
 			if (SC_get_errornumber(self) <= 0)
@@ -1996,6 +2300,26 @@ inolog("get_Result=%p %p %d\n", res, SC_get_Result(self), self->curr_param_resul
 			CC_on_abort(conn, CONN_DEAD);
 			goto cleanup;
 		}
+		/*
+		 * An error rolls back the commands before it, which are run in
+		 * the same (implicit) transaction up to the Sync.  Discard their
+		 * results so that the error is reported by this call, as
+		 * CC_send_query_append() does with the simple protocol.
+		 */
+		if (self->multi_statement > 0)
+		{
+			QResultClass	*qres;
+
+			for (qres = res; NULL != qres && !QR_get_aborted(qres); qres = qres->next) ;
+			while (NULL != qres && res != qres)
+			{
+				QResultClass	*nres = res->next;
+
+				res->next = NULL;
+				QR_Destructor(res);
+				res = nres;
+			}
+		}
 	}
 	else if (isSelectType)
 	{
@@ -2012,12 +2336,25 @@ inolog("get_Result=%p %p %d\n", res, SC_get_Result(self), self->curr_param_resul
 			qi.result_in = NULL;
 			qi.cursor = SC_cursor_name(self);
 			qi.row_size = ci->drivers.fetch_max;
+			/* don't fetch beyond SQL_MAX_ROWS */
+			if (self->options.maxRows > 0 && qi.row_size > self->options.maxRows)
+				qi.row_size = self->options.maxRows;
+			qi.max_rows = 0;
 			sprintf(fetch, "%s " FORMAT_LEN " in \"%s\"", fetch_cmd, qi.row_size, SC_cursor_name(self));
 			qryi = &qi;
 			appendq = fetch;
 			if (0 != (ci->extra_opts & BIT_IGNORE_ROUND_TRIP_TIME))
 				qflag |= IGNORE_ROUND_TRIP;
 		}
+		else if (self->options.maxRows > 0)
+		{
+			/* don't keep the rows beyond SQL_MAX_ROWS */
+			qi.result_in = NULL;
+			qi.cursor = NULL;
+			qi.row_size = 0;
+			qi.max_rows = self->options.maxRows;
+			qryi = &qi;
+		}
 		res = CC_send_query_append(conn, self->stmt_with_params, qryi, qflag, SC_get_ancestor(self), appendq);
 		if (useCursor && QR_command_maybe_successful(res))
 		{
@@ -2070,6 +2407,7 @@ inolog("get_Result=%p %p %d\n", res, SC_get_Result(self), self->curr_param_resul
 		}
 	}
 	SC_forget_unnamed(self);
+	timed_out = CC_reset_query_timer(conn);
 
 	if (CONN_DOWN != conn->status)
 		conn->status = oldstatus;
@@ -2084,6 +2422,8 @@ inolog("get_Result=%p %p %d\n", res, SC_get_Result(self), self->curr_param_resul
 
 		if (was_ok)
 			SC_set_errornumber(self, STMT_OK);
+		else if (timed_out)
+			SC_set_error(self, STMT_QUERY_TIMEOUT, "Query timeout expired", func);
 		else if (0 < SC_get_errornumber(self))
 			;
 		else if (was_nonfatal)
@@ -2247,6 +2587,9 @@ inolog("!!! numfield=%d field_type=%u\n", QR_NumResultCols(res), QR_get_field_ty
 			qi.result_in = NULL;
 			qi.cursor = SC_cursor_name(self);
 			qi.row_size = ci->drivers.fetch_max;
+			if (self->options.maxRows > 0 && qi.row_size > self->options.maxRows)
+				qi.row_size = self->options.maxRows;
+			qi.max_rows = 0;
 			snprintf(fetch, sizeof(fetch), "%s " FORMAT_LEN " in \"%s\"", fetch_cmd, qi.row_size, SC_cursor_name(self));
 			if (0 != (ci->extra_opts & BIT_IGNORE_ROUND_TRIP_TIME))
 				qflag |= IGNORE_ROUND_TRIP;
@@ -2301,6 +2644,7 @@ inolog("!!SC_fetch return =%d\n", ret);
 	}
 cleanup:
 #undef	return
+	CC_reset_query_timer(conn);
 	SC_SetExecuting(self, FALSE);
 	CLEANUP_FUNC_CONN_CS(func_cs_count, conn);
 	if (CONN_DOWN != conn->status)
@@ -2449,9 +2793,14 @@ RequestStart(StatementClass *stmt, ConnectionClass *conn, const char *func)
 {
 	BOOL	ret = TRUE;
 
+	/* read the rest of the batch left on the socket first */
+	if (NULL != conn->stmt_in_lazyquery)
+		CC_finish_lazy_query(conn, FALSE);
 	if (SC_accessed_db(stmt))
 		return TRUE;
-	if (SQL_ERROR == SetStatementSvp(stmt))
+	/* the SAVEPOINT goes ahead of the first request of the statement */
+	if (SQL_ERROR == SetStatementSvp(stmt) ||
+	    !CC_queue_pending_svp(conn))
 	{
 		char	emsg[128];
 
@@ -2497,15 +2846,15 @@ ReflectColumnsInfo(StatementClass *self, QResultClass *res)
 }
 
 BOOL
-SendBindRequest(StatementClass *stmt, const char *plan_name)
+SendBindRequest(StatementClass *stmt, const char *plan_name, Int2 num_params)
 {
 	CSTR	func = "SendBindRequest";
 	ConnectionClass	*conn = SC_get_conn(stmt);
 
-	mylog("%s: plan_name=%s\n", func, plan_name);
+	mylog("%s: plan_name=%s num_params=%d\n", func, plan_name, num_params);
 	if (!RequestStart(stmt, conn, func))
 		return FALSE;
-	if (!BuildBindRequest(stmt, plan_name))
+	if (!BuildBindRequest(stmt, plan_name, num_params))
 		return FALSE;
 	conn->stmt_in_extquery = stmt;
 
@@ -2523,10 +2872,10 @@ QResultClass *SendSyncAndReceive(StatementClass *stmt, QResultClass *res, const
 	int		num_p, num_io_params;
 	int		i, pidx;
 	Int2		num_discard_params, paramType;
-	BOOL		rcvend = FALSE, loopend = FALSE;
+	BOOL		rcvend = FALSE, loopend = FALSE, parsed = FALSE, completed = FALSE;
 	char		msgbuffer[ERROR_MSG_LENGTH + 1];
 	IPDFields	*ipdopts;
-	QResultClass	*newres = NULL;
+	QResultClass	*newres = NULL, *first;
 
 	if (!RequestStart(stmt, conn, func))
 		return NULL;
@@ -2537,6 +2886,10 @@ QResultClass *SendSyncAndReceive(StatementClass *stmt, QResultClass *res, const
 
 	if (!res)
 		newres = res = QR_Constructor();
+	first = res;
+	pidx = stmt->current_exec_param;
+	if (pidx >= 0)
+		pidx--;
 	for (;!loopend;)
 	{
 		id = SOCK_get_id(sock);
@@ -2547,12 +2900,53 @@ inolog("desc id=%c", id);
 		if (0 != SOCK_get_errcode(sock))
 			break;
 inolog(" response_length=%d\n", response_length);
+		/* the responses of the commands queued ahead of the query */
+		if (conn->num_queued_cmds > 0)
+		{
+			switch (id)
+			{
+				case '1': /* ParseComplete */
+				case '2': /* BindComplete */
+				case '3': /* CloseComplete */
+					continue;
+				case 'C': /* CommandComplete */
+					SOCK_get_string(sock, msgbuffer, sizeof(msgbuffer));
+					mylog("%s: discarded the response of the queued %s\n", func, msgbuffer);
+					conn->num_queued_cmds--;
+					continue;
+				case 'E': /* the rest is skipped up to the Sync */
+					conn->num_queued_cmds = 0;
+					break;
+			}
+		}
+		/*
+		 * Each command of a pipelined multi-statement query has its own
+		 * result, which starts with the ParseComplete or with the error
+		 * following the previous command.
+		 */
+		if (('1' == id && parsed) ||
+		    ('E' == id && completed && stmt->multi_statement > 0))
+		{
+			QResultClass	*nextres = QR_Constructor();
+
+			if (NULL == nextres)
+			{
+				QR_set_rstatus(res, PORES_NO_MEMORY_ERROR);
+				QR_set_messageref(res, "Out of memory while receiving the results");
+				break;
+			}
+			res->next = nextres;
+			res = nextres;
+			completed = FALSE;
+		}
 		switch (id)
 		{
 			case 'C':
+				completed = TRUE;
 				SOCK_get_string(sock, msgbuffer, sizeof(msgbuffer));
 				mylog("command response=%s\n", msgbuffer);
 				QR_set_command(res, msgbuffer);
+				CC_on_set_command(conn, msgbuffer, stmt->stmt_with_params ? stmt->stmt_with_params : stmt->statement);
 				if (QR_is_fetching_tuples(res))
 				{
 					res->dataFilled = TRUE;
@@ -2583,8 +2977,11 @@ inolog(" response_length=%d\n", response_length);
 				handle_notice_message(conn, msgbuffer, sizeof(msgbuffer), res->sqlstate, comment, res);
 				break;
 			case '1': /* ParseComplete */
+				parsed = TRUE;
 				if (stmt->plan_name)
 					SC_set_prepared(stmt, PREPARED_PERMANENTLY);
+				else if (stmt->multi_statement > 0)
+					SC_set_prepared(stmt, ONCE_DESCRIBED); /* the unnamed statement holds the last command only */
 				else
 					SC_set_prepared(stmt, PREPARED_TEMPORARILY);
 				break;
@@ -2640,9 +3037,7 @@ inolog("num_params=%d info=%d\n", stmt->num_params, num_p);
 					}
 				}
 #endif /* NOT_USED */
-				pidx = stmt->current_exec_param;
-				if (pidx >= 0)
-					pidx--;
+				/* the parameters of the pipelined commands follow one another */
 				for (i = 0; i < num_p; i++)
 				{
 					SC_param_next(stmt, &pidx, NULL, NULL);
@@ -2716,9 +3111,16 @@ inolog("!![%d].PGType %u->%u\n", i, PIC_get_pgtype(ipdopts->parameters[i]), CI_g
 			case 'S': /* parameter status */
 				getParameterValues(conn);
 				break;
+			case 'I': /* EmptyQueryResponse */
+				completed = TRUE;
+				break;
 			case 's':	/* portal suspend */
+				completed = TRUE;
 				QR_set_no_fetching_tuples(res);
 				res->dataFilled = TRUE;
+				/* stopped at SQL_MAX_ROWS */
+				if (!QR_get_cursor(res))
+					QR_set_reached_eof(res);
 				break;
 			default:
 				break;
@@ -2748,13 +3150,13 @@ inolog("!![%d].PGType %u->%u\n", i, PIC_get_pgtype(ipdopts->parameters[i]), CI_g
 
 		mylog("%s: 'id' - %s\n", func, SC_get_errormsg(stmt));
 		CC_on_abort(conn, CONN_DEAD);
-		res = NULL;
+		first = NULL;
 	}
-	if (res != newres &&
+	if (first != newres &&
 	    NULL != newres)
 		QR_Destructor(newres);
 	conn->stmt_in_extquery = NULL;
-	return res;
+	return first;
 }
 
 BOOL
@@ -2966,7 +3368,11 @@ SendExecuteRequest(StatementClass *stmt, const char *plan_name, UInt4 count)
 inolog("execute leng=%d\n", leng);
 	SOCK_put_string(sock, plan_name);	/* portal name == plan name */
 	SOCK_put_int(sock, count, sizeof(Int4));
-	if (0 == count) /* will send a Close portal command */
+	/*
+	 *	Will send a Close portal command unless the rest of
+	 *	the portal is to be fetched later.
+	 */
+	if (0 == count || !SC_is_fetchcursor(stmt))
 	{
 		SOCK_put_char(sock, 'C');	/* Close command */
 		if (SOCK_get_errcode(sock) != 0)
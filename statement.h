@@ -15,6 +15,7 @@
 #include "pgtypes.h"
 #include "bind.h"
 #include "descriptor.h"
+#include "lobj.h"
 
 #if defined (POSIX_MULTITHREAD_SUPPORT)
 #include <pthread.h>
@@ -95,6 +96,7 @@ enum {
 	,STMT_INVALID_NULL_ARG
 	,STMT_NO_RESPONSE
 	,STMT_COMMUNICATION_ERROR
+	,STMT_QUERY_TIMEOUT
 };
 
 /* statement types */
@@ -175,6 +177,51 @@ typedef	struct
 	void			*data;
 }	NeedDataCallback;
 
+/*
+ *	The query text split into lexical tokens, once for all the scanners
+ *	of the statement: SC_scanQueryAndCountParams(), the parser and the
+ *	parameter substitution.  The tokens cover the whole text.
+ */
+enum
+{
+	QTOK_SPACE = 0
+	,QTOK_WORD	/* keyword or unquoted identifier */
+	,QTOK_NUMBER
+	,QTOK_PUNCT	/* any other single character */
+	,QTOK_MARKER	/* ? */
+	,QTOK_DELIM	/* ; */
+	/* the following ones are copied as they are */
+	,QTOK_LITERAL	/* '...' */
+	,QTOK_IDENT	/* "..." */
+	,QTOK_DOLLAR	/* $tag$...$tag$ */
+	,QTOK_COMMENT	/* -- ... or a C style comment */
+};
+
+typedef struct
+{
+	Int4	pos;
+	Int4	len;
+	char	type;
+	char	escape;		/* escape character of a literal */
+}	QueryToken;
+
+typedef struct
+{
+	const char	*query;
+	int		ccsc;
+	char		escape_in_literal;
+	Int4		ntokens;
+	Int4		allocated;
+	QueryToken	*tokens;
+}	QueryTokens;
+
+QueryTokens	*QT_lex(const char *query, int ccsc, char escape_in_literal);
+void		QT_Destructor(QueryTokens *self);
+Int4		QT_token_at(const QueryTokens *self, Int4 pos);
+void		QT_scanQueryAndCountParams(const QueryTokens *self, Int4 offset,
+			Int4 *next_cmd, SQLSMALLINT *num_params,
+			po_ind_t *multi, po_ind_t *proc_return);
+
 /********	Statement Handle	***********/
 struct StatementClass_
 {
@@ -215,9 +262,12 @@ struct StatementClass_
 	SQLLEN		last_fetch_count;	/* number of rows retrieved in
 						 * last fetch/extended fetch */
 	int		lobj_fd;		/* fd of the current large object */
+	LO_STREAM	lobj_stream;	/* buffered access to lobj_fd */
 
 	char	   *statement;		/* if non--null pointer to the SQL
 					 * statement that has been executed */
+	QueryTokens	*tokens;	/* the tokens of statement, see
+					 * SC_get_tokens() */
 
 	TABLE_INFO	**ti;
 	Int2		ntab;
@@ -423,6 +473,7 @@ enum
 void SC_forget_unnamed(StatementClass *self);
 #define SC_can_parse_statement(a) (STMT_TYPE_SELECT == (a)->statement_type)
 #define SC_may_use_cursor(a) (STMT_TYPE_SELECT == (a)->statement_type || STMT_TYPE_WITH == (a)->statement_type)
+#define SC_may_change_catalog(a) (STMT_TYPE_CREATE <= (a)->statement_type && STMT_TYPE_REVOKE >= (a)->statement_type)
 #define SC_may_fetch_rows(a) (STMT_TYPE_SELECT == (a)->statement_type || STMT_TYPE_WITH == (a)->statement_type)
 #define SC_can_req_colinfo(a) (STMT_TYPE_SELECT == (a)->statement_type || \
 		 STMT_TYPE_WITH == (a)->statement_type || \
@@ -490,11 +541,14 @@ RETCODE		SC_pos_update(StatementClass *self, SQLSETPOSIROW irow, SQLULEN index);
 RETCODE		SC_pos_delete(StatementClass *self, SQLSETPOSIROW irow, SQLULEN index);
 RETCODE		SC_pos_refresh(StatementClass *self, SQLSETPOSIROW irow, SQLULEN index);
 RETCODE		SC_pos_add(StatementClass *self, SQLSETPOSIROW irow);
+RETCODE		SC_pos_add_rowset(StatementClass *self, SQLSETPOSIROW start_row, SQLSETPOSIROW *nrow);
 int		SC_set_current_col(StatementClass *self, int col);
 void		SC_setInsertedTable(StatementClass *, RETCODE);
 void		SC_scanQueryAndCountParams(const char *, const ConnectionClass *,
 			Int4 *next_cmd, SQLSMALLINT *num_params,
 			po_ind_t *multi, po_ind_t *proc_return);
+const QueryTokens	*SC_get_tokens(StatementClass *self);
+void		SC_forget_tokens(StatementClass *self);
 
 BOOL	SC_IsExecuting(const StatementClass *self);
 BOOL	SC_SetExecuting(StatementClass *self, BOOL on);
@@ -514,8 +568,8 @@ BOOL		SendParseRequest(StatementClass *self, const char *name,
 			const char *query, Int4 qlen, Int2 num_params);
 BOOL		SyncParseRequest(ConnectionClass *conn);
 BOOL		SendDescribeRequest(StatementClass *self, const char *name, BOOL paramAlso);
-BOOL		SendBindRequest(StatementClass *self, const char *name);
-BOOL		BuildBindRequest(StatementClass *stmt, const char *name);
+BOOL		SendBindRequest(StatementClass *self, const char *name, Int2 num_params);
+BOOL		BuildBindRequest(StatementClass *stmt, const char *name, Int2 num_params);
 BOOL		SendExecuteRequest(StatementClass *stmt, const char *portal, UInt4 count);
 QResultClass	*SendSyncAndReceive(StatementClass *stmt, QResultClass *res, const char *comment);
 /*
@@ -0,0 +1,82 @@
+/*
+ * Timing helpers for the microbenchmarks.
+ *
+ * BENCH_LOOP runs an expression repeatedly for at least BENCH_SECONDS,
+ * and prints the time per call and the throughput.
+ */
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdio.h>
+#include <time.h>
+
+#define	BENCH_SECONDS	0.5
+
+typedef struct
+{
+	struct timespec	start;
+	long		iterations;
+	long		countdown;
+	long		batch;
+} BENCH_TIMER;
+
+static double
+bench_elapsed(const BENCH_TIMER *timer)
+{
+	struct timespec	now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - timer->start.tv_sec) +
+		(now.tv_nsec - timer->start.tv_nsec) / 1e9;
+}
+
+static void
+bench_start(BENCH_TIMER *timer)
+{
+	timer->iterations = 0;
+	timer->countdown = timer->batch = 1;
+	clock_gettime(CLOCK_MONOTONIC, &timer->start);
+}
+
+/* Look at the clock only now and then, not to disturb fast operations */
+static int
+bench_done(BENCH_TIMER *timer)
+{
+	double		elapsed;
+
+	if (--timer->countdown > 0)
+		return 0;
+	elapsed = bench_elapsed(timer);
+	if (elapsed >= BENCH_SECONDS)
+		return 1;
+	if (elapsed < BENCH_SECONDS / 100)
+		timer->batch *= 2;
+	timer->countdown = timer->batch;
+	return 0;
+}
+
+/* bytes is the size of the input processed by each call, or 0 */
+static void
+bench_report(const BENCH_TIMER *timer, const char *name, double bytes)
+{
+	double		ns = bench_elapsed(timer) * 1e9 / timer->iterations;
+
+	if (bytes > 0)
+		printf("%-48s %12.1f ns/op %10.1f MB/s\n", name, ns, bytes * 1e3 / ns);
+	else
+		printf("%-48s %12.1f ns/op\n", name, ns);
+	fflush(stdout);
+}
+
+#define	BENCH_LOOP(timer, name, bytes, expr) \
+do { \
+	bench_start(&(timer)); \
+	do \
+	{ \
+		expr; \
+		(timer).iterations++; \
+	} while (!bench_done(&(timer))); \
+	bench_report(&(timer), (name), (bytes)); \
+} while (0)
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,227 @@
+/*
+ * Microbenchmark for the bytea conversion routines of convert.c.
+ *
+ * The driver's routines are compared with the byte-at-a-time versions
+ * they replaced, which are kept here as the reference, and the results
+ * of both are checked to be identical.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "convert.h"
+
+#define	BIN_SIZE	(1024 * 1024)
+
+/*
+ * The previous implementations.
+ */
+static const char *old_hextbl = "0123456789ABCDEF";
+
+static SQLLEN
+old_bin2hex(const UCHAR *src, UCHAR *dst, SQLLEN length)
+{
+	const UCHAR	*src_wk;
+	UCHAR		chr;
+	UCHAR		*dst_wk;
+	int		i;
+
+	for (i = 0, src_wk = src, dst_wk = dst; i < length; i++, src_wk++)
+	{
+		chr = *src_wk;
+		*dst_wk++ = old_hextbl[chr >> 4];
+		*dst_wk++ = old_hextbl[chr % 16];
+	}
+	dst[2 * length] = '\0';
+	return 2 * length;
+}
+
+static SQLLEN
+old_hex2bin(const UCHAR *src, UCHAR *dst, SQLLEN length)
+{
+	UCHAR		chr;
+	const UCHAR	*src_wk;
+	UCHAR		*dst_wk;
+	SQLLEN		i;
+	int		val;
+	BOOL		HByte = TRUE;
+
+	for (i = 0, src_wk = src, dst_wk = dst; i < length; i++, src_wk++)
+	{
+		chr = *src_wk;
+		if (!chr)
+			break;
+		if (chr >= 'a' && chr <= 'f')
+			val = chr - 'a' + 10;
+		else if (chr >= 'A' && chr <= 'F')
+			val = chr - 'A' + 10;
+		else
+			val = chr - '0';
+		if (HByte)
+			*dst_wk = (val << 4);
+		else
+		{
+			*dst_wk += val;
+			dst_wk++;
+		}
+		HByte = !HByte;
+	}
+	*dst_wk = '\0';
+	return length;
+}
+
+static int
+old_conv_from_octal(const UCHAR *s)
+{
+	ssize_t		i;
+	int			y = 0;
+
+	for (i = 1; i <= 3; i++)
+		y += (s[i] - '0') << (3 * (3 - i));
+
+	return y;
+}
+
+static size_t
+old_from_pgbinary(const UCHAR *value, UCHAR *rgbValue, SQLLEN cbValueMax)
+{
+	size_t		i,
+				ilen = strlen(value);
+	size_t		o = 0;
+
+	for (i = 0; i < ilen;)
+	{
+		if (value[i] == '\\')
+		{
+			if (value[i + 1] == '\\')
+			{
+				if (rgbValue)
+					rgbValue[o] = value[i];
+				o++;
+				i += 2;
+			}
+			else if (value[i + 1] == 'x')
+			{
+				i += 2;
+				if (i < ilen)
+				{
+					ilen -= i;
+					if (rgbValue)
+						old_hex2bin(value + i, rgbValue + o, ilen);
+					o += ilen / 2;
+				}
+				break;
+			}
+			else
+			{
+				if (rgbValue)
+					rgbValue[o] = old_conv_from_octal(&value[i]);
+				o++;
+				i += 4;
+			}
+		}
+		else
+		{
+			if (rgbValue)
+				rgbValue[o] = value[i];
+			o++;
+			i++;
+		}
+	}
+
+	if (rgbValue)
+		rgbValue[o] = '\0';
+
+	return o;
+}
+
+/*
+ * Escape format text of the data, as a server sends it.
+ */
+static UCHAR *
+make_escaped(const UCHAR *bin, size_t len)
+{
+	UCHAR	   *text = malloc(4 * len + 1);
+	UCHAR	   *p = text;
+	size_t		i;
+
+	for (i = 0; i < len; i++)
+	{
+		if (bin[i] == '\\')
+		{
+			*p++ = '\\';
+			*p++ = '\\';
+		}
+		else if (bin[i] >= 0x20 && bin[i] < 0x7f)
+			*p++ = bin[i];
+		else
+			p += sprintf((char *) p, "\\%03o", bin[i]);
+	}
+	*p = '\0';
+	return text;
+}
+
+static void
+check_same(const char *what, const UCHAR *a, size_t alen, const UCHAR *b, size_t blen)
+{
+	if (alen != blen || memcmp(a, b, alen + 1) != 0)
+	{
+		fprintf(stderr, "%s: results differ\n", what);
+		exit(1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	UCHAR	   *bin, *ascii, *hex, *hex_old, *out, *out_old;
+	UCHAR	   *esc_bin, *esc_ascii;
+	size_t		i, len, len_old;
+	BENCH_TIMER	timer;
+
+	bin = malloc(BIN_SIZE);
+	ascii = malloc(BIN_SIZE);
+	srand(1);
+	for (i = 0; i < BIN_SIZE; i++)
+	{
+		bin[i] = rand() % 256;
+		ascii[i] = 'a' + rand() % 26;
+	}
+	hex = malloc(2 * BIN_SIZE + 3);
+	hex_old = malloc(2 * BIN_SIZE + 3);
+	out = malloc(BIN_SIZE + 1);
+	out_old = malloc(BIN_SIZE + 1);
+	esc_bin = make_escaped(bin, BIN_SIZE);
+	esc_ascii = make_escaped(ascii, BIN_SIZE);
+
+	/* hex format encoding (sending parameters) */
+	BENCH_LOOP(timer, "pg_bin2hex (old)", BIN_SIZE,
+			   old_bin2hex(bin, hex_old, BIN_SIZE));
+	BENCH_LOOP(timer, "pg_bin2hex", BIN_SIZE,
+			   pg_bin2hex(bin, hex, BIN_SIZE));
+	check_same("pg_bin2hex", hex, 2 * BIN_SIZE, hex_old, 2 * BIN_SIZE);
+
+	/* hex format decoding (fetching results) */
+	memcpy(hex, "\\x", 2);
+	old_bin2hex(bin, hex + 2, BIN_SIZE);
+	BENCH_LOOP(timer, "convert_from_pgbinary hex (old)", 2 * BIN_SIZE,
+			   len_old = old_from_pgbinary(hex, out_old, BIN_SIZE + 1));
+	BENCH_LOOP(timer, "convert_from_pgbinary hex", 2 * BIN_SIZE,
+			   len = convert_from_pgbinary(hex, out, BIN_SIZE + 1));
+	check_same("convert_from_pgbinary hex", out, len, out_old, len_old);
+
+	/* escape format decoding, random bytes and text */
+	BENCH_LOOP(timer, "convert_from_pgbinary escape (old)", strlen((char *) esc_bin),
+			   len_old = old_from_pgbinary(esc_bin, out_old, BIN_SIZE + 1));
+	BENCH_LOOP(timer, "convert_from_pgbinary escape", strlen((char *) esc_bin),
+			   len = convert_from_pgbinary(esc_bin, out, BIN_SIZE + 1));
+	check_same("convert_from_pgbinary escape", out, len, out_old, len_old);
+
+	BENCH_LOOP(timer, "convert_from_pgbinary escape text (old)", BIN_SIZE,
+			   len_old = old_from_pgbinary(esc_ascii, out_old, BIN_SIZE + 1));
+	BENCH_LOOP(timer, "convert_from_pgbinary escape text", BIN_SIZE,
+			   len = convert_from_pgbinary(esc_ascii, out, BIN_SIZE + 1));
+	check_same("convert_from_pgbinary escape text", out, len, out_old, len_old);
+
+	return 0;
+}
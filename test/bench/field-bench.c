@@ -0,0 +1,170 @@
+/*
+ * Microbenchmark for the conversions of the values fetched and sent:
+ * copy_and_convert_field() and, through copy_statement_with_parameters(),
+ * ResolveOneParam() of convert.c.
+ *
+ * The driver's routines are called on a statement of a connection which
+ * is never connected, so that neither a server nor a driver manager is
+ * needed.  The values are synthetic ASCII and multibyte texts, short and
+ * large, and a few other types.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "psqlodbc.h"
+#include "connection.h"
+#include "statement.h"
+#include "convert.h"
+#include "pgtypes.h"
+#include "pgapifunc.h"
+#include "dlg_specific.h"
+#include "multibyte.h"
+
+#define	LARGE_SIZE	(64 * 1024)
+
+static char	outbuf[4 * LARGE_SIZE];
+
+static char *
+repeat(const char *word, size_t size)
+{
+	char	   *buf = malloc(size + 1);
+	size_t		len = 0, wlen = strlen(word);
+
+	if (!buf)
+	{
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	while (len + wlen <= size)
+	{
+		memcpy(buf + len, word, wlen);
+		len += wlen;
+	}
+	buf[len] = '\0';
+	return buf;
+}
+
+static void
+bench_field(StatementClass *stmt, const char *label, OID type, const char *value,
+			SQLSMALLINT fCType)
+{
+	BENCH_TIMER	timer;
+	SQLLEN		len, ind;
+	int			ret;
+
+	if (ret = copy_and_convert_field(stmt, type, -1, (void *) value, fCType, 0,
+									 outbuf, sizeof(outbuf), &len, &ind), COPY_OK != ret)
+	{
+		fprintf(stderr, "copy_and_convert_field, %s: returned %d\n", label, ret);
+		exit(1);
+	}
+	BENCH_LOOP(timer, label, strlen(value),
+			   copy_and_convert_field(stmt, type, -1, (void *) value, fCType, 0,
+									  outbuf, sizeof(outbuf), &len, &ind));
+}
+
+static void
+bind_param(StatementClass *stmt, SQLUSMALLINT ipar, SQLSMALLINT fCType,
+		   SQLSMALLINT fSqlType, SQLULEN size, void *value, SQLLEN *ind)
+{
+	if (!SQL_SUCCEEDED(PGAPI_BindParameter(stmt, ipar, SQL_PARAM_INPUT, fCType, fSqlType, size, 0, value, 0, ind)))
+	{
+		fprintf(stderr, "PGAPI_BindParameter failed\n");
+		exit(1);
+	}
+}
+
+static void
+resolve_params(StatementClass *stmt)
+{
+	if (!SQL_SUCCEEDED(copy_statement_with_parameters(stmt, FALSE)))
+	{
+		fprintf(stderr, "copy_statement_with_parameters failed\n");
+		exit(1);
+	}
+}
+
+static void
+bench_params(ConnectionClass *conn, const char *label, char *text)
+{
+	BENCH_TIMER	timer;
+	HSTMT		hstmt;
+	StatementClass *stmt;
+	static SQLINTEGER	id = 42;
+	static double	val = 3.25;
+	static TIMESTAMP_STRUCT	ts = {2015, 6, 30, 23, 59, 58, 123456000};
+	static SQLLEN	ind, text_ind = SQL_NTS;
+	const char *query = "INSERT INTO bench_tab VALUES (?, ?, ?, ?)";
+
+	if (!SQL_SUCCEEDED(PGAPI_AllocStmt(conn, &hstmt, 0)) ||
+		!SQL_SUCCEEDED(PGAPI_Prepare(hstmt, (const SQLCHAR *) query, SQL_NTS)))
+	{
+		fprintf(stderr, "PGAPI_Prepare failed\n");
+		exit(1);
+	}
+	stmt = (StatementClass *) hstmt;
+	ind = 0;
+	bind_param(stmt, 1, SQL_C_LONG, SQL_INTEGER, 0, &id, &ind);
+	bind_param(stmt, 2, SQL_C_CHAR, SQL_LONGVARCHAR, strlen(text), text, &text_ind);
+	bind_param(stmt, 3, SQL_C_DOUBLE, SQL_DOUBLE, 0, &val, &ind);
+	bind_param(stmt, 4, SQL_C_TIMESTAMP, SQL_TIMESTAMP, 0, &ts, &ind);
+	resolve_params(stmt);
+	BENCH_LOOP(timer, label, strlen(text), resolve_params(stmt));
+	PGAPI_FreeStmt(hstmt, SQL_DROP);
+}
+
+int main(int argc, char **argv)
+{
+	ConnectionClass *conn;
+	HSTMT		hstmt;
+	StatementClass *stmt;
+	char	   *ascii, *mb, *hex;
+
+	conn = CC_Constructor();
+	if (!conn)
+	{
+		fprintf(stderr, "CC_Constructor failed\n");
+		exit(1);
+	}
+	getDSNdefaults(&conn->connInfo);
+	conn->connInfo.use_server_side_prepare = 0;
+	conn->pg_version_major = 9;
+	conn->pg_version_minor = 6;
+	conn->ccsc = UTF8;
+	conn->mb_maxbyte_per_char = 4;
+	if (!SQL_SUCCEEDED(PGAPI_AllocStmt(conn, &hstmt, 0)))
+	{
+		fprintf(stderr, "PGAPI_AllocStmt failed\n");
+		exit(1);
+	}
+	stmt = (StatementClass *) hstmt;
+
+	bench_field(stmt, "int4 to SQL_C_LONG", PG_TYPE_INT4, "1234567", SQL_C_LONG);
+	bench_field(stmt, "int4 to SQL_C_CHAR", PG_TYPE_INT4, "1234567", SQL_C_CHAR);
+	bench_field(stmt, "float8 to SQL_C_DOUBLE", PG_TYPE_FLOAT8, "-1234.5678901", SQL_C_DOUBLE);
+	bench_field(stmt, "timestamp to SQL_C_TIMESTAMP", PG_TYPE_TIMESTAMP_NO_TMZONE, "2015-06-30 23:59:58.123456", SQL_C_TIMESTAMP);
+	bench_field(stmt, "numeric to SQL_C_CHAR", PG_TYPE_NUMERIC, "-12345678901234.5678", SQL_C_CHAR);
+	bench_field(stmt, "short text to SQL_C_CHAR", PG_TYPE_TEXT, "a short text value", SQL_C_CHAR);
+	ascii = repeat("some text\n", LARGE_SIZE);
+	bench_field(stmt, "large text to SQL_C_CHAR", PG_TYPE_TEXT, ascii, SQL_C_CHAR);
+	mb = repeat("\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e caf\xc3\xa9\n", LARGE_SIZE);
+	bench_field(stmt, "large UTF-8 text to SQL_C_CHAR", PG_TYPE_TEXT, mb, SQL_C_CHAR);
+	hex = repeat("0123456789abcdef", LARGE_SIZE);
+	hex[0] = '\\';
+	hex[1] = 'x';
+	bench_field(stmt, "large bytea to SQL_C_BINARY", PG_TYPE_BYTEA, hex, SQL_C_BINARY);
+	PGAPI_FreeStmt(hstmt, SQL_DROP);
+
+	bench_params(conn, "ResolveOneParam, short text", "a short text value");
+	bench_params(conn, "ResolveOneParam, large text", ascii);
+	bench_params(conn, "ResolveOneParam, large UTF-8 text", mb);
+
+	free(ascii);
+	free(mb);
+	free(hex);
+	CC_Destructor(conn);
+
+	return 0;
+}
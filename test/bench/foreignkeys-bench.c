@@ -0,0 +1,147 @@
+/*
+ * Benchmark for SQLForeignKeys against a generated schema.
+ *
+ * Unlike the other benchmarks, this one needs a server and a driver
+ * manager; it connects with the DSN of the regression tests. The
+ * fkbench schema is filled with FKBENCH_TABLES pairs of tables. Each
+ * child table references its parent with a two-column key, and the
+ * previous child with a one-column key.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/common.h"
+
+#define	FKBENCH_TABLES	500
+
+static HSTMT	hstmt = SQL_NULL_HSTMT;
+
+static void
+exec_sql(const char *sql)
+{
+	SQLRETURN	rc;
+
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+static void
+create_schema(void)
+{
+	char	sql[512], prev[64];
+	int	i;
+
+	exec_sql("CREATE SCHEMA fkbench");
+	for (i = 0; i < FKBENCH_TABLES; i++)
+	{
+		snprintf(sql, sizeof(sql),
+				 "CREATE TABLE fkbench.parent%d (a int4, b int4, PRIMARY KEY (a, b))", i);
+		exec_sql(sql);
+		if (i > 0)
+			snprintf(prev, sizeof(prev), " REFERENCES fkbench.child%d", i - 1);
+		else
+			prev[0] = '\0';
+		snprintf(sql, sizeof(sql),
+				 "CREATE TABLE fkbench.child%d (id int4 PRIMARY KEY, a int4, b int4, "
+				 "prev int4%s, FOREIGN KEY (a, b) REFERENCES fkbench.parent%d)",
+				 i, prev, i);
+		exec_sql(sql);
+	}
+}
+
+/* Returns the number of rows */
+static int
+foreign_keys(const char *pktab, const char *fktab)
+{
+	SQLRETURN	rc;
+	int		rows = 0;
+
+	rc = SQLForeignKeys(hstmt,
+						NULL, 0,
+						(SQLCHAR *) (pktab ? "fkbench" : NULL), pktab ? SQL_NTS : 0,
+						(SQLCHAR *) pktab, pktab ? SQL_NTS : 0,
+						NULL, 0,
+						(SQLCHAR *) (fktab ? "fkbench" : NULL), fktab ? SQL_NTS : 0,
+						(SQLCHAR *) fktab, fktab ? SQL_NTS : 0);
+	CHECK_STMT_RESULT(rc, "SQLForeignKeys failed", hstmt);
+	while (SQL_SUCCEEDED(rc = SQLFetch(hstmt)))
+		rows++;
+	if (rc != SQL_NO_DATA)
+	{
+		print_diag("SQLFetch failed", SQL_HANDLE_STMT, hstmt);
+		exit(1);
+	}
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	return rows;
+}
+
+static int
+all_foreign_keys(void)
+{
+	char	table[32];
+	int	i, rows = 0;
+
+	for (i = 0; i < FKBENCH_TABLES; i++)
+	{
+		snprintf(table, sizeof(table), "child%d", i);
+		rows += foreign_keys(NULL, table);
+	}
+	return rows;
+}
+
+int
+main(int argc, char **argv)
+{
+	BENCH_TIMER	timer;
+	char		pktab[32], fktab[32];
+	SQLRETURN	rc;
+	int		rows;
+
+	test_connect();
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	SQLExecDirect(hstmt, (SQLCHAR *) "DROP SCHEMA fkbench CASCADE", SQL_NTS);
+	SQLFreeStmt(hstmt, SQL_CLOSE);
+	create_schema();
+
+	snprintf(pktab, sizeof(pktab), "parent%d", FKBENCH_TABLES / 2);
+	snprintf(fktab, sizeof(fktab), "child%d", FKBENCH_TABLES / 2);
+
+	/* 2 rows for the key to the parent, 1 row for the key to the previous child */
+	rows = foreign_keys(NULL, fktab);
+	if (rows != 3)
+	{
+		printf("SQLForeignKeys(%s) returned %d rows, expected 3\n", fktab, rows);
+		exit(1);
+	}
+	rows = all_foreign_keys();
+	if (rows != 3 * FKBENCH_TABLES - 1)
+	{
+		printf("SQLForeignKeys of all the tables returned %d rows, expected %d\n",
+			   rows, 3 * FKBENCH_TABLES - 1);
+		exit(1);
+	}
+
+	BENCH_LOOP(timer, "SQLForeignKeys, the keys of a table", 0,
+			   foreign_keys(NULL, fktab));
+	BENCH_LOOP(timer, "SQLForeignKeys, the keys referring to a table", 0,
+			   foreign_keys(pktab, NULL));
+	BENCH_LOOP(timer, "SQLForeignKeys, the keys of all the tables", 0,
+			   all_foreign_keys());
+
+	exec_sql("DROP SCHEMA fkbench CASCADE");
+	test_disconnect();
+
+	return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * Check of the SSL fallback of the driver's own connection path, see
+ * the ssl_call attempts of original_CC_connect() in connection.c.
+ *
+ * With sslmode allow or prefer, a connection rejected at startup (e.g.
+ * because pg_hba.conf has no entry for it) is tried again the other
+ * way, as libpq does.  pgmock plays the server rejecting either the SSL
+ * or the other connections (see the hbacheck target of the Makefile).
+ * The driver's routines are called directly through the shared library,
+ * so that neither a driver manager nor a DSN is needed.
+ *
+ * Usage: hba-check <port> <sslmode> ssl|nossl|fail
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "psqlodbc.h"
+#include "connection.h"
+#include "socket.h"
+#include "dlg_specific.h"
+
+int main(int argc, char **argv)
+{
+	ConnectionClass *conn;
+	ConnInfo   *ci;
+	const char *result;
+	char		ret;
+
+	if (argc != 4)
+	{
+		fprintf(stderr, "usage: %s <port> <sslmode> ssl|nossl|fail\n", argv[0]);
+		exit(1);
+	}
+	if (NULL == (conn = CC_Constructor()))
+	{
+		fprintf(stderr, "CC_Constructor failed\n");
+		exit(1);
+	}
+	ci = &(conn->connInfo);
+	copyAttributes(ci, INI_SERVER, "localhost");
+	copyAttributes(ci, INI_PORT, argv[1]);
+	copyAttributes(ci, INI_DATABASE, "check");
+	copyAttributes(ci, INI_USERNAME, "check");
+	copyAttributes(ci, INI_PROTOCOL, "7.4");
+	copyAttributes(ci, INI_SSLMODE, argv[2]);
+	copyCommonAttributes(ci, INI_DRIVERSSL, "1");
+	getDSNdefaults(ci);
+	CC_initialize_pg_version(conn);
+
+	ret = CC_connect(conn, AUTH_REQ_OK, NULL);
+	if (0 == ret)
+		result = "fail";
+	else if (NULL != conn->sock && NULL != conn->sock->ssl)
+		result = "ssl";
+	else
+		result = "nossl";
+	printf("sslmode=%s: %s", argv[2], result);
+	if (0 == ret)
+		printf(" (%s)", CC_get_errormsg(conn));
+	if (0 != strcmp(result, argv[3]))
+		printf(", expected %s\n", argv[3]);
+	else
+		printf("\n");
+	CC_Destructor(conn);
+	return 0 == strcmp(result, argv[3]) ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+/*
+ * Microbenchmark for the SQL_NUMERIC_STRUCT conversions of convert.c.
+ *
+ * The base 10000 conversions of the driver are compared with the digit
+ * and bit at a time loops they replaced, which are kept here as the
+ * reference, and the results of both are checked to be identical.  The
+ * binary numeric format sent for the parameters is decoded the way the
+ * server prints it, and checked against the text conversion.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <arpa/inet.h>
+
+#include "bench.h"
+#include "convert.h"
+
+#define	NVALUES		1000
+
+/* The previous implementations */
+static BOOL
+old_ResolveNumericParam(const SQL_NUMERIC_STRUCT *ns, char *chrform)
+{
+	static const int prec[] = {1, 3, 5, 8, 10, 13, 15, 17, 20, 22, 25, 27, 29, 32, 34, 37, 39};
+	Int4	i, j, k, ival, vlen, len, newlen;
+	UCHAR		calv[40];
+	const UCHAR	*val = (const UCHAR *) ns->val;
+	BOOL	next_figure;
+
+	if (0 == ns->precision)
+	{
+		strcpy(chrform, "0");
+		return TRUE;
+	}
+	else if (ns->precision < prec[sizeof(Int4)])
+	{
+		for (i = 0, ival = 0; i < sizeof(Int4) && prec[i] <= ns->precision; i++)
+		{
+			ival += (val[i] << (8 * i)); /* ns->val is little endian */
+		}
+		if (0 == ns->scale)
+		{
+			if (0 == ns->sign)
+				ival *= -1;
+			sprintf(chrform, "%d", ival);
+		}
+		else if (ns->scale > 0)
+		{
+			Int4	i, div, o1val, o2val;
+
+			for (i = 0, div = 1; i < ns->scale; i++)
+				div *= 10;
+			o1val = ival / div;
+			o2val = ival % div;
+			if (0 == ns->sign)
+				sprintf(chrform, "-%d.%0*d", o1val, ns->scale, o2val);
+			else
+				sprintf(chrform, "%d.%0*d", o1val, ns->scale, o2val);
+		}
+		return TRUE;
+	}
+
+	for (i = 0; i < SQL_MAX_NUMERIC_LEN && prec[i] <= ns->precision; i++)
+		;
+	vlen = i;
+	len = 0;
+	memset(calv, 0, sizeof(calv));
+	for (i = vlen - 1; i >= 0; i--)
+	{
+		for (j = len - 1; j >= 0; j--)
+		{
+			if (!calv[j])
+				continue;
+			ival = (((Int4)calv[j]) << 8);
+			calv[j] = (ival % 10);
+			ival /= 10;
+			calv[j + 1] += (ival % 10);
+			ival /= 10;
+			calv[j + 2] += (ival % 10);
+			ival /= 10;
+			calv[j + 3] += ival;
+			for (k = j;; k++)
+			{
+				next_figure = FALSE;
+				if (calv[k] > 0)
+				{
+					if (k >= len)
+						len = k + 1;
+					while (calv[k] > 9)
+					{
+						calv[k + 1]++;
+						calv[k] -= 10;
+						next_figure = TRUE;
+					}
+				}
+				if (k >= j + 3 && !next_figure)
+					break;
+			}
+		}
+		ival = val[i];
+		if (!ival)
+			continue;
+		calv[0] += (ival % 10);
+		ival /= 10;
+		calv[1] += (ival % 10);
+		ival /= 10;
+		calv[2] += ival;
+		for (j = 0;; j++)
+		{
+			next_figure = FALSE;
+			if (calv[j] > 0)
+			{
+				if (j >= len)
+					len = j + 1;
+				while (calv[j] > 9)
+				{
+					calv[j + 1]++;
+					calv[j] -= 10;
+					next_figure = TRUE;
+				}
+			}
+			if (j >= 2 && !next_figure)
+				break;
+		}
+	}
+	newlen = 0;
+	if (0 == ns->sign)
+		chrform[newlen++] = '-';
+	if (i = len - 1, i < ns->scale)
+		i = ns->scale;
+	for (; i >= ns->scale; i--)
+		chrform[newlen++] = calv[i] + '0';
+	if (ns->scale > 0)
+	{
+		chrform[newlen++] = '.';
+		for (; i >= 0; i--)
+			chrform[newlen++] = calv[i] + '0';
+	}
+	if (0 == len)
+		chrform[newlen++] = '0';
+	chrform[newlen] = '\0';
+	return TRUE;
+}
+
+/* The SQL_C_NUMERIC case of copy_and_convert_field() */
+static void
+old_string_to_numeric(const char *neut_str, SQL_NUMERIC_STRUCT *ns)
+{
+	int	i, nlen, bit, hval, tv, dig, sta, olen;
+	char	calv[SQL_MAX_NUMERIC_LEN * 3];
+	const char *wv;
+	BOOL	dot_exist;
+
+	for (wv = neut_str; *wv && isspace(*wv); wv++)
+		;
+	ns->sign = 1;
+	if (*wv == '-')
+	{
+		ns->sign = 0;
+		wv++;
+	}
+	else if (*wv == '+')
+		wv++;
+	while (*wv == '0') wv++;
+	ns->precision = 0;
+	ns->scale = 0;
+	for (nlen = 0, dot_exist = FALSE;; wv++) 
+	{
+		if (*wv == '.')
+		{
+			if (dot_exist)
+				break;
+			dot_exist = TRUE;
+		}
+		else if (!isdigit(*wv))
+				break;
+		else
+		{
+			if (dot_exist)
+				ns->scale++;
+			ns->precision++;
+			calv[nlen++] = *wv;
+		}
+	}
+	memset(ns->val, 0, sizeof(ns->val));
+	for (hval = 0, bit = 1L, sta = 0, olen = 0; sta < nlen;)
+	{
+		for (dig = 0, i = sta; i < nlen; i++)
+		{
+			tv = dig * 10 + calv[i] - '0';
+			dig = tv % 2;
+			calv[i] = tv / 2 + '0';
+			if (i == sta && tv < 2)
+				sta++;
+		}
+		if (dig > 0)
+			hval |= bit;
+		bit <<= 1;
+		if (bit >= (1L << 8))
+		{
+			ns->val[olen++] = hval;
+			hval = 0;
+			bit = 1L;
+			if (olen >= SQL_MAX_NUMERIC_LEN - 1)
+			{
+				ns->scale = sta - ns->precision;
+				break;
+			}
+		} 
+	}
+	if (hval && olen < SQL_MAX_NUMERIC_LEN - 1)
+		ns->val[olen++] = hval;
+}
+
+/* Print the binary numeric the way the server's numeric_out() does */
+static void
+binary_to_string(const char *binform, char *str)
+{
+	unsigned short	header[4], dig;
+	short	ndigits, weight, dscale, i, d;
+	int	len = 0;
+
+	memcpy(header, binform, sizeof(header));
+	ndigits = ntohs(header[0]);
+	weight = ntohs(header[1]);
+	dscale = ntohs(header[3]);
+	if (0x4000 == ntohs(header[2]))
+		str[len++] = '-';
+	if (weight < 0)
+		str[len++] = '0';
+	for (d = 0; d <= weight; d++)
+	{
+		dig = 0;
+		if (d < ndigits)
+			memcpy(&dig, binform + sizeof(header) + 2 * d, 2);
+		dig = ntohs(dig);
+		len += sprintf(str + len, 0 == d ? "%u" : "%04u", dig);
+	}
+	if (dscale > 0)
+	{
+		str[len++] = '.';
+		for (i = 0; i < dscale; i += 4, d++)
+		{
+			dig = 0;
+			if (d >= 0 && d < ndigits)
+				memcpy(&dig, binform + sizeof(header) + 2 * d, 2);
+			len += sprintf(str + len, "%04u", ntohs(dig));
+		}
+		len -= i - dscale;
+	}
+	str[len] = '\0';
+}
+
+int main(int argc, char **argv)
+{
+	static char	strings[NVALUES][48];
+	static SQL_NUMERIC_STRUCT	numerics[NVALUES];
+	SQL_NUMERIC_STRUCT	ns;
+	char	str[64], str_old[64], binform[NUMERIC_BINARY_MAXLEN];
+	int	i, j, n, ndigits, scale;
+	size_t	slen = 0;
+	BENCH_TIMER	timer;
+
+	srand(1);
+	for (i = 0; i < NVALUES; i++)
+	{
+		/* the old code only used 14 bytes safely */
+		ndigits = 1 + rand() % 33;
+		scale = rand() % (ndigits + 1);
+		n = 0;
+		/* the binary format has no negative zero */
+		if (rand() % 2 && ndigits > scale)
+			strings[i][n++] = '-';
+		for (j = 0; j < ndigits - scale; j++)
+			strings[i][n++] = '0' + (0 == j ? 1 + rand() % 9 : rand() % 10);
+		if (0 == j)
+			strings[i][n++] = '0';
+		if (scale > 0)
+		{
+			strings[i][n++] = '.';
+			for (j = 0; j < scale; j++)
+				strings[i][n++] = '0' + rand() % 10;
+		}
+		strings[i][n] = '\0';
+		slen += n;
+	}
+
+	for (i = 0; i < NVALUES; i++)
+	{
+		old_string_to_numeric(strings[i], &ns);
+		if (!string_to_numeric(strings[i], &numerics[i]) ||
+		    0 != memcmp(&ns, &numerics[i], sizeof(ns)))
+		{
+			fprintf(stderr, "string_to_numeric: results differ for %s\n", strings[i]);
+			exit(1);
+		}
+		old_ResolveNumericParam(&ns, str_old);
+		if (!ResolveNumericParam(&ns, str, sizeof(str)) ||
+		    0 != strcmp(str, str_old))
+		{
+			fprintf(stderr, "ResolveNumericParam: results differ for %s: %s\n", str_old, str);
+			exit(1);
+		}
+		ResolveNumericBinary(&ns, binform);
+		binary_to_string(binform, str);
+		if (0 != strcmp(str, str_old))
+		{
+			fprintf(stderr, "ResolveNumericBinary: results differ for %s: %s\n", str_old, str);
+			exit(1);
+		}
+	}
+
+	n = 0;
+	BENCH_LOOP(timer, "text to numeric (old)", slen / NVALUES,
+			   old_string_to_numeric(strings[n++ % NVALUES], &ns));
+	n = 0;
+	BENCH_LOOP(timer, "string_to_numeric", slen / NVALUES,
+			   string_to_numeric(strings[n++ % NVALUES], &ns));
+	n = 0;
+	BENCH_LOOP(timer, "numeric to text (old)", 0,
+			   old_ResolveNumericParam(&numerics[n++ % NVALUES], str_old));
+	n = 0;
+	BENCH_LOOP(timer, "ResolveNumericParam", 0,
+			   ResolveNumericParam(&numerics[n++ % NVALUES], str, sizeof(str)));
+	n = 0;
+	BENCH_LOOP(timer, "ResolveNumericBinary", 0,
+			   ResolveNumericBinary(&numerics[n++ % NVALUES], binform));
+
+	return 0;
+}
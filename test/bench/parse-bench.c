@@ -0,0 +1,206 @@
+/*
+ * Microbenchmark for the parsers of the date/time and floating point
+ * text values of convert.c.
+ *
+ * The driver's locale-free parsers are compared with the sscanf() and
+ * atof() based code they replaced, which is kept here as the reference,
+ * and the results of both are checked to be identical.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <locale.h>
+
+#include "bench.h"
+#include "convert.h"
+
+#define	NVALUES		1000
+
+/*
+ * The previous implementations.  The time zone handling of
+ * timestamp2stime() is left out, the driver always skips it.
+ */
+static BOOL
+old_timestamp2stime(const char *str, SIMPLE_TIME *st)
+{
+	char		rest[64], bc[16],
+			   *ptr;
+	int			scnt,
+				i;
+
+	st->fr = 0;
+	st->infinity = 0;
+	rest[0] = '\0';
+	bc[0] = '\0';
+	if ((scnt = sscanf(str, "%4d-%2d-%2d %2d:%2d:%2d%32s %16s", &st->y, &st->m, &st->d, &st->hh, &st->mm, &st->ss, rest, bc)) < 6)
+		return FALSE;
+	else if (scnt == 6)
+		return TRUE;
+	switch (rest[0])
+	{
+		case '.':
+			if ((ptr = strchr(rest, '+')) != NULL)
+				*ptr = '\0';
+			else if ((ptr = strchr(rest, '-')) != NULL)
+				*ptr = '\0';
+			for (i = 1; i < 10; i++)
+			{
+				if (!isdigit((UCHAR) rest[i]))
+					break;
+			}
+			for (; i < 10; i++)
+				rest[i] = '0';
+			rest[i] = '\0';
+			st->fr = atoi(&rest[1]);
+			break;
+		case 'B':
+			if (strcasecmp(rest, "BC") == 0)
+				st->y *= -1;
+			return TRUE;
+		case '+':
+		case '-':
+			break;
+		default:
+			return TRUE;
+	}
+	if (strcasecmp(bc, "BC") == 0)
+		st->y *= -1;
+	return TRUE;
+}
+
+static void
+old_set_client_decimal_point(char *num)
+{
+	const char	*decimal_point = localeconv()->decimal_point;
+	char		*str;
+
+	if ('.' == *decimal_point)
+		return;
+	for (str = num; '\0' != *str; str++)
+	{
+		if (*str == '.')
+		{
+			*str = *decimal_point;
+			break;
+		}
+	}
+}
+
+static double
+old_get_double_value(char *str)
+{
+	old_set_client_decimal_point(str);
+	if (strcasecmp(str, "NaN") == 0)
+		return 0;
+	else if (strcasecmp(str, "Infinity") == 0)
+		return 1;
+	else if (strcasecmp(str, "-Infinity") == 0)
+		return -1;
+	return atof(str);
+}
+
+static void
+check_same_time(const char *what, const SIMPLE_TIME *a, const SIMPLE_TIME *b)
+{
+	if (a->y != b->y || a->m != b->m || a->d != b->d ||
+	    a->hh != b->hh || a->mm != b->mm || a->ss != b->ss ||
+	    a->fr != b->fr)
+	{
+		fprintf(stderr, "%s: results differ\n", what);
+		exit(1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	static char	timestamps[NVALUES][40], timestamptzs[NVALUES][40];
+	static char	dates[NVALUES][16], doubles[NVALUES][32];
+	SIMPLE_TIME	st, st_old;
+	BOOL		bZone;
+	int			zone, i, n;
+	double		dval, dsum;
+	size_t		tslen = 0, dlen = 0;
+	BENCH_TIMER	timer;
+
+	setlocale(LC_ALL, "");
+	srand(1);
+	for (i = 0; i < NVALUES; i++)
+	{
+		int	y = 1970 + rand() % 60, m = 1 + rand() % 12, d = 1 + rand() % 28;
+		int	hh = rand() % 24, mm = rand() % 60, ss = rand() % 60;
+
+		snprintf(dates[i], sizeof(dates[i]), "%04d-%02d-%02d", y, m, d);
+		/* the server omits the trailing zeros of the fraction */
+		if (0 == i % 4)
+			snprintf(timestamps[i], sizeof(timestamps[i]), "%s %02d:%02d:%02d", dates[i], hh, mm, ss);
+		else
+			snprintf(timestamps[i], sizeof(timestamps[i]), "%s %02d:%02d:%02d.%0*d", dates[i], hh, mm, ss, i % 4 + 2, rand() % 10000);
+		snprintf(timestamptzs[i], sizeof(timestamptzs[i]), "%s+09", timestamps[i]);
+		snprintf(doubles[i], sizeof(doubles[i]), "%.*g", 1 + rand() % 15, (rand() - RAND_MAX / 2) / 1000.0);
+		tslen += strlen(timestamps[i]);
+		dlen += strlen(doubles[i]);
+	}
+
+	for (i = 0; i < NVALUES; i++)
+	{
+		char	buf[32];
+
+		bZone = FALSE;
+		old_timestamp2stime(timestamps[i], &st_old);
+		timestamp2stime(timestamps[i], &st, &bZone, &zone);
+		check_same_time("timestamp2stime", &st, &st_old);
+		old_timestamp2stime(timestamptzs[i], &st_old);
+		timestamp2stime(timestamptzs[i], &st, &bZone, &zone);
+		check_same_time("timestamp2stime with zone", &st, &st_old);
+		strcpy(buf, doubles[i]);
+		if (!parse_iso_double(doubles[i], &dval) ||
+		    dval != old_get_double_value(buf))
+		{
+			fprintf(stderr, "parse_iso_double: results differ for %s\n", doubles[i]);
+			exit(1);
+		}
+	}
+
+	n = 0;
+	BENCH_LOOP(timer, "timestamp (old)", tslen / NVALUES,
+			   old_timestamp2stime(timestamps[n++ % NVALUES], &st_old));
+	n = 0;
+	BENCH_LOOP(timer, "timestamp2stime", tslen / NVALUES,
+			   (bZone = FALSE, timestamp2stime(timestamps[n++ % NVALUES], &st, &bZone, &zone)));
+	n = 0;
+	BENCH_LOOP(timer, "timestamptz (old)", 0,
+			   old_timestamp2stime(timestamptzs[n++ % NVALUES], &st_old));
+	n = 0;
+	BENCH_LOOP(timer, "timestamp2stime with zone", 0,
+			   (bZone = FALSE, timestamp2stime(timestamptzs[n++ % NVALUES], &st, &bZone, &zone)));
+	n = 0;
+	BENCH_LOOP(timer, "date (old)", 0,
+			   sscanf(dates[n++ % NVALUES], "%4d-%2d-%2d", &st_old.y, &st_old.m, &st_old.d));
+	n = 0;
+	BENCH_LOOP(timer, "parse_iso_date", 0,
+			   parse_iso_date(dates[n++ % NVALUES], &st));
+
+	dsum = 0;
+	n = 0;
+	BENCH_LOOP(timer, "double (old)", dlen / NVALUES,
+			   {
+				   char	buf[32];
+
+				   strcpy(buf, doubles[n++ % NVALUES]);
+				   dsum += old_get_double_value(buf);
+			   });
+	n = 0;
+	BENCH_LOOP(timer, "parse_iso_double", dlen / NVALUES,
+			   {
+				   char	buf[32];
+
+				   strcpy(buf, doubles[n++ % NVALUES]);
+				   if (parse_iso_double(buf, &dval))
+					   dsum += dval;
+			   });
+	if (dsum == 1.2345)
+		printf("%g\n", dsum);	/* don't let the loops be optimized away */
+
+	return 0;
+}
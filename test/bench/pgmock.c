@@ -0,0 +1,1811 @@
+/*
+ * pgmock: a stand-in for the PostgreSQL server, to exercise the driver
+ * where a real server can't be set up as needed (see hba-check.c).
+ *
+ * It speaks the frontend/backend protocol 3.0, simple and extended
+ * query, trusts every user and answers from memory:
+ *
+ *	SELECT * FROM mock_rows(rows, cols [, 'types' [, width]])
+ *		returns rows synthetic rows of cols columns.  types is a comma
+ *		separated list of int4, int8, float8, numeric, bool, date,
+ *		timestamp, text, varchar and bytea used in turn for the columns,
+ *		or "mixed" for all of them (int4 by default).  width is the
+ *		length of the text and bytea values (16 by default).
+ *	Queries matching an entry of the script file (-s), see below.
+ *	SELECT ... FROM the pg_ catalogs returns -c rows (none by default)
+ *		with values made up from the column names.
+ *	Other SELECTs without FROM return one row of the literals, the
+ *		parameters and a few functions like version(); with FROM they
+ *		return no rows.
+ *	SHOW returns the usual values of a few settings.
+ *	Anything else succeeds with the command tag it would have.
+ *
+ * The script file has entries like this, the rows being separated by
+ * '|' with \N for NULL:
+ *
+ *	> select name, id from
+ *	: name text, id int4
+ *	foo|1
+ *	bar|\N
+ *
+ * The queries starting with the text after '>' (ignoring case) return
+ * the rows of the entry.
+ *
+ * SSL is refused unless a certificate and its key are given (-C, -K).
+ * -r ssl or -r nossl rejects the SSL or the other connections at startup
+ * like a pg_hba.conf without an entry for them.
+ *
+ * Usage: pgmock [-p port] [-s script] [-c catalog_rows]
+ *		[-C certfile -K keyfile] [-r ssl|nossl]
+ *
+ * Each connection is served by a child process.  Unix only.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#define	DEFAULT_PORT		54329
+#define	SERVER_VERSION		"9.6.0"
+#define	MAX_COLUMNS		256
+#define	MAX_PREPARED		256
+#define	MAX_PORTALS		16
+#define	NAME_LEN		64
+#define	DISTINCT_ROWS		100		/* the synthetic rows repeat */
+#define	DEFAULT_WIDTH		16
+#define	FLUSH_SIZE		(256 * 1024)
+
+#define	SSL_REQUEST_CODE	80877103
+#define	CANCEL_REQUEST_CODE	80877102
+#define	PROTOCOL_3		196608
+
+/* type oids */
+#define	BOOLOID			16
+#define	BYTEAOID		17
+#define	INT8OID			20
+#define	INT4OID			23
+#define	TEXTOID			25
+#define	FLOAT8OID		701
+#define	VARCHAROID		1043
+#define	DATEOID			1082
+#define	TIMESTAMPOID		1114
+#define	NUMERICOID		1700
+
+typedef struct
+{
+	const char	*name;
+	int		oid;
+	int		len;
+} MOCK_TYPE;
+
+static const MOCK_TYPE	mock_types[] =
+{
+	{"int4", INT4OID, 4},
+	{"int8", INT8OID, 8},
+	{"float8", FLOAT8OID, 8},
+	{"numeric", NUMERICOID, -1},
+	{"bool", BOOLOID, 1},
+	{"date", DATEOID, 4},
+	{"timestamp", TIMESTAMPOID, 8},
+	{"text", TEXTOID, -1},
+	{"varchar", VARCHAROID, -1},
+	{"bytea", BYTEAOID, -1},
+	{NULL, 0, 0}
+};
+#define	TYPE_INT4	(&mock_types[0])
+#define	TYPE_NUMERIC	(&mock_types[3])
+#define	TYPE_BOOL	(&mock_types[4])
+#define	TYPE_TIMESTAMP	(&mock_types[6])
+#define	TYPE_TEXT	(&mock_types[7])
+
+typedef struct SCRIPT_ENTRY_
+{
+	char		*prefix;
+	int		ncols;
+	char		names[MAX_COLUMNS][NAME_LEN];
+	const MOCK_TYPE	*types[MAX_COLUMNS];
+	int		nrows;
+	char		***rows;	/* [row][col], NULL for NULL */
+	struct SCRIPT_ENTRY_	*next;
+} SCRIPT_ENTRY;
+
+enum
+{
+	RESULT_COMMAND,			/* no rows, just the tag */
+	RESULT_SYNTHETIC,		/* mock_rows() */
+	RESULT_SCRIPT,			/* an entry of the script */
+	RESULT_CATALOG,			/* made up catalog rows */
+	RESULT_VALUES			/* one row of the select list */
+};
+
+/* What a query returns */
+typedef struct
+{
+	int		kind;
+	char		tag[NAME_LEN];
+	char		tx_status;	/* after the command, 0 if unchanged */
+	int		ncols;
+	char		names[MAX_COLUMNS][NAME_LEN];
+	const MOCK_TYPE	*types[MAX_COLUMNS];
+	long		nrows;
+	int		width;
+	SCRIPT_ENTRY	*script;
+	char		*values[MAX_COLUMNS];	/* RESULT_VALUES */
+	char		*rowdata;		/* RESULT_SYNTHETIC, encoded DataRows */
+	size_t		rowoffs[DISTINCT_ROWS + 1];
+} RESULT;
+
+typedef struct
+{
+	char		name[NAME_LEN];
+	char		*query;
+	int		nparams;
+	int		*ptypes;
+} PREPARED;
+
+typedef struct
+{
+	char		name[NAME_LEN];
+	PREPARED	*stmt;
+	int		nparams;
+	char		**params;	/* the values, NULL for NULL */
+	RESULT		*result;
+	long		pos;		/* rows sent */
+} PORTAL;
+
+static int	catalog_rows = 0;
+static SCRIPT_ENTRY	*script = NULL;
+static char	user_name[NAME_LEN] = "", database_name[NAME_LEN] = "";
+static char	tx_status = 'I';
+static int	client_fd = -1;
+static SSL_CTX	*ssl_ctx = NULL;
+static SSL	*ssl = NULL;		/* of the client, if it asked for it */
+static const char	*reject_hba = NULL;	/* "ssl" or "nossl" */
+
+static PREPARED	*prepared[MAX_PREPARED];
+static PORTAL	*portals[MAX_PORTALS];
+
+/*
+ *	Output buffer
+ */
+static char	*outbuf = NULL;
+static size_t	outlen = 0, outsize = 0;
+
+static void
+flush_out(void)
+{
+	size_t		pos = 0;
+	ssize_t		n;
+
+	while (pos < outlen)
+	{
+		if (ssl)
+		{
+			if ((n = SSL_write(ssl, outbuf + pos, (int) (outlen - pos))) <= 0)
+				exit(0);
+		}
+		else if ((n = write(client_fd, outbuf + pos, outlen - pos)) < 0)
+		{
+			if (EINTR == errno)
+				continue;
+			exit(0);
+		}
+		pos += n;
+	}
+	outlen = 0;
+}
+
+static void
+put_bytes(const void *data, size_t len)
+{
+	if (outlen + len > outsize)
+	{
+		while (outlen + len > outsize)
+			outsize = outsize ? outsize * 2 : FLUSH_SIZE * 2;
+		if (NULL == (outbuf = realloc(outbuf, outsize)))
+		{
+			perror("pgmock");
+			exit(1);
+		}
+	}
+	memcpy(outbuf + outlen, data, len);
+	outlen += len;
+}
+
+static void
+put_byte(char c)
+{
+	put_bytes(&c, 1);
+}
+
+static void
+put_int16(int v)
+{
+	unsigned short	n = htons((unsigned short) v);
+
+	put_bytes(&n, 2);
+}
+
+static void
+put_int32(int v)
+{
+	unsigned int	n = htonl((unsigned int) v);
+
+	put_bytes(&n, 4);
+}
+
+static void
+put_string(const char *s)
+{
+	put_bytes(s, strlen(s) + 1);
+}
+
+/* Starts a message, returns the position of its length */
+static size_t
+begin_msg(char type)
+{
+	size_t		pos;
+
+	put_byte(type);
+	pos = outlen;
+	put_int32(0);
+	return pos;
+}
+
+static void
+end_msg(size_t pos)
+{
+	unsigned int	n = htonl((unsigned int) (outlen - pos));
+
+	memcpy(outbuf + pos, &n, 4);
+}
+
+static void
+put_value(const char *value, int len)
+{
+	if (NULL == value)
+		put_int32(-1);
+	else
+	{
+		if (len < 0)
+			len = (int) strlen(value);
+		put_int32(len);
+		put_bytes(value, len);
+	}
+}
+
+static void
+send_error_severity(const char *severity, const char *sqlstate, const char *message)
+{
+	size_t		pos = begin_msg('E');
+
+	put_byte('S');
+	put_string(severity);
+	put_byte('C');
+	put_string(sqlstate);
+	put_byte('M');
+	put_string(message);
+	put_byte('\0');
+	end_msg(pos);
+}
+
+static void
+send_error(const char *sqlstate, const char *message)
+{
+	send_error_severity("ERROR", sqlstate, message);
+}
+
+/*
+ *	Input
+ */
+static char	*inbuf = NULL;
+static size_t	inlen = 0, inpos = 0, insize = 0;
+
+static void
+read_n(void *dst, size_t n)
+{
+	ssize_t		got;
+
+	while (inlen - inpos < n)
+	{
+		if (inpos > 0)
+		{
+			memmove(inbuf, inbuf + inpos, inlen - inpos);
+			inlen -= inpos;
+			inpos = 0;
+		}
+		if (inlen + n > insize || insize - inlen < 8192)
+		{
+			insize = (inlen + n) * 2 + 65536;
+			if (NULL == (inbuf = realloc(inbuf, insize)))
+			{
+				perror("pgmock");
+				exit(1);
+			}
+		}
+		if (ssl)
+		{
+			if ((got = SSL_read(ssl, inbuf + inlen, (int) (insize - inlen))) <= 0)
+				exit(0);
+		}
+		else if ((got = read(client_fd, inbuf + inlen, insize - inlen)) <= 0)
+		{
+			if (got < 0 && EINTR == errno)
+				continue;
+			exit(0);
+		}
+		inlen += got;
+	}
+	memcpy(dst, inbuf + inpos, n);
+	inpos += n;
+}
+
+/* A message body, with getters advancing through it */
+typedef struct
+{
+	char		*p, *end;
+} MSG;
+
+static char	*msgbuf = NULL;
+static size_t	msgsize = 0;
+
+static void
+read_body(MSG *msg, int len)
+{
+	if (len < 0 || len > 1024 * 1024 * 1024)
+		exit(0);
+	if ((size_t) len + 1 > msgsize)
+	{
+		msgsize = len + 1 + 4096;
+		if (NULL == (msgbuf = realloc(msgbuf, msgsize)))
+		{
+			perror("pgmock");
+			exit(1);
+		}
+	}
+	read_n(msgbuf, len);
+	msgbuf[len] = '\0';
+	msg->p = msgbuf;
+	msg->end = msgbuf + len;
+}
+
+static int
+get_int32(MSG *msg)
+{
+	unsigned int	n = 0;
+
+	if (msg->p + 4 <= msg->end)
+		memcpy(&n, msg->p, 4);
+	msg->p += 4;
+	return (int) ntohl(n);
+}
+
+static int
+get_int16(MSG *msg)
+{
+	unsigned short	n = 0;
+
+	if (msg->p + 2 <= msg->end)
+		memcpy(&n, msg->p, 2);
+	msg->p += 2;
+	return (short) ntohs(n);
+}
+
+static const char *
+get_string(MSG *msg)
+{
+	const char	*s = msg->p;
+
+	if (msg->p >= msg->end)
+		return "";
+	msg->p += strlen(s) + 1;
+	return s;
+}
+
+/*
+ *	Scanning the queries
+ */
+#define	IS_IDENT_CHAR(c)	(isalnum((unsigned char) (c)) || '_' == (c) || '$' == (c))
+
+static const char *
+skip_space(const char *p)
+{
+	for (;;)
+	{
+		while (isspace((unsigned char) *p))
+			p++;
+		if ('-' == p[0] && '-' == p[1])
+		{
+			while (*p && '\n' != *p)
+				p++;
+		}
+		else if ('/' == p[0] && '*' == p[1])
+		{
+			const char	*e = strstr(p + 2, "*/");
+
+			p = e ? e + 2 : p + strlen(p);
+		}
+		else
+			return p;
+	}
+}
+
+/* p is at a quote, returns the position after the quoted text */
+static const char *
+skip_quoted(const char *p)
+{
+	char		quote = *p++;
+
+	for (; *p; p++)
+	{
+		if (*p == quote)
+		{
+			if (p[1] != quote)
+				return p + 1;
+			p++;
+		}
+	}
+	return p;
+}
+
+/* Is the word at p the keyword ? */
+static int
+word_is(const char *p, const char *word)
+{
+	size_t		len = strlen(word);
+
+	return 0 == strncasecmp(p, word, len) && !IS_IDENT_CHAR(p[len]);
+}
+
+static const MOCK_TYPE *
+lookup_type(const char *name, size_t len)
+{
+	static const struct
+	{
+		const char	*alias;
+		int		index;
+	} aliases[] =
+	{
+		{"integer", 0}, {"int", 0}, {"smallint", 0}, {"int2", 0},
+		{"bigint", 1}, {"float4", 2}, {"real", 2}, {"boolean", 4},
+		{"name", 7}, {"bpchar", 8}, {"char", 8}, {NULL, 0}
+	};
+	int		i;
+
+	for (i = 0; mock_types[i].name; i++)
+	{
+		if (strlen(mock_types[i].name) == len &&
+		    0 == strncasecmp(mock_types[i].name, name, len))
+			return &mock_types[i];
+	}
+	for (i = 0; aliases[i].alias; i++)
+	{
+		if (strlen(aliases[i].alias) == len &&
+		    0 == strncasecmp(aliases[i].alias, name, len))
+			return &mock_types[aliases[i].index];
+	}
+	return NULL;
+}
+
+static const MOCK_TYPE *
+lookup_type_oid(int oid)
+{
+	int		i;
+
+	for (i = 0; mock_types[i].name; i++)
+	{
+		if (mock_types[i].oid == oid)
+			return &mock_types[i];
+	}
+	return TYPE_TEXT;
+}
+
+/* The number of the parameters, the highest $n */
+static int
+count_params(const char *query)
+{
+	const char	*p;
+	int		n = 0;
+
+	for (p = query; *p;)
+	{
+		if ('\'' == *p || '"' == *p)
+			p = skip_quoted(p);
+		else if ('$' == *p && isdigit((unsigned char) p[1]) &&
+				 (p == query || !IS_IDENT_CHAR(p[-1])))
+		{
+			int		i = atoi(p + 1);
+
+			if (i > n)
+				n = i;
+			p++;
+		}
+		else
+			p++;
+	}
+	return n;
+}
+
+/*
+ * Splits the select list starting at p, returns where it ends.  The
+ * items aren't NUL terminated, lens has their lengths.
+ */
+static const char *
+split_select_list(const char *p, const char **items, size_t *lens, int *nitems)
+{
+	static const char *const	ends[] = {"from", "where", "union", "intersect", "except", "order", "group", "having", "limit", "offset", "for", "into", NULL};
+	const char	*start = p;
+	int		depth = 0, i;
+
+	*nitems = 0;
+	while (*p)
+	{
+		if ('\'' == *p || '"' == *p)
+		{
+			p = skip_quoted(p);
+			continue;
+		}
+		if ('(' == *p)
+			depth++;
+		else if (')' == *p)
+		{
+			if (--depth < 0)
+				break;
+		}
+		else if (0 == depth && ';' == *p)
+			break;
+		else if (0 == depth && ',' == *p)
+		{
+			if (*nitems < MAX_COLUMNS)
+			{
+				items[*nitems] = start;
+				lens[(*nitems)++] = p - start;
+			}
+			start = p + 1;
+		}
+		else if (0 == depth && isalpha((unsigned char) *p) &&
+				 !IS_IDENT_CHAR(p[-1]))
+		{
+			for (i = 0; ends[i]; i++)
+			{
+				if (word_is(p, ends[i]))
+					break;
+			}
+			if (ends[i])
+				break;
+			while (IS_IDENT_CHAR(*p))
+				p++;
+			continue;
+		}
+		p++;
+	}
+	if (p > start && *nitems < MAX_COLUMNS)
+	{
+		items[*nitems] = start;
+		lens[(*nitems)++] = p - start;
+	}
+	/* drop the empty ones, like the one of "select from" */
+	for (i = 0; i < *nitems;)
+	{
+		const char	*s = skip_space(items[i]);
+
+		if (s >= items[i] + lens[i])
+		{
+			memmove(items + i, items + i + 1, (*nitems - i - 1) * sizeof(items[0]));
+			memmove(lens + i, lens + i + 1, (*nitems - i - 1) * sizeof(lens[0]));
+			(*nitems)--;
+		}
+		else
+		{
+			lens[i] -= s - items[i];
+			items[i] = s;
+			while (lens[i] > 0 && isspace((unsigned char) items[i][lens[i] - 1]))
+				lens[i]--;
+			i++;
+		}
+	}
+	return p;
+}
+
+static void
+copy_name(char *dst, const char *src, size_t len)
+{
+	if ('"' == *src && len >= 2)
+	{
+		src++;
+		len -= 2;
+	}
+	if (len >= NAME_LEN)
+		len = NAME_LEN - 1;
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+}
+
+/*
+ * The column name of a select list item: its alias, the last part of
+ * a column reference or the function name.
+ */
+static void
+item_name(const char *item, size_t len, char *name)
+{
+	const char	*p, *end = item + len, *as = NULL, *last = item;
+	int		depth = 0;
+
+	for (p = item; p < end;)
+	{
+		if ('\'' == *p || '"' == *p)
+		{
+			p = skip_quoted(p);
+			continue;
+		}
+		if ('(' == *p)
+			depth++;
+		else if (')' == *p)
+			depth--;
+		else if (0 == depth && (p == item || !IS_IDENT_CHAR(p[-1])) && word_is(p, "as"))
+			as = p;
+		p++;
+	}
+	if (as)
+	{
+		as = skip_space(as + 2);
+		copy_name(name, as, end - as);
+		return;
+	}
+	for (p = item; p < end && (IS_IDENT_CHAR(*p) || '.' == *p || '"' == *p); p++)
+	{
+		if ('.' == *p)
+			last = p + 1;
+	}
+	if (p == end && p > last && '$' != *item && !isdigit((unsigned char) *item) &&
+		!word_is(item, "null"))
+		copy_name(name, last, end - last);
+	else if (p < end && '(' == *skip_space(p) && p > last)
+		copy_name(name, last, p - last);
+	else
+		strcpy(name, "?column?");
+}
+
+/* The value of a select list item without FROM */
+static const MOCK_TYPE *
+item_value(const char *item, size_t len, char **params, int nparams, const int *ptypes, char **value)
+{
+	const MOCK_TYPE	*type = TYPE_TEXT, *cast = NULL;
+	const char	*p, *end = item + len, *cast_at = NULL;
+	char		name[NAME_LEN];
+	int		depth = 0;
+
+	/* a trailing ::type */
+	for (p = item; p < end;)
+	{
+		if ('\'' == *p || '"' == *p)
+		{
+			p = skip_quoted(p);
+			continue;
+		}
+		if ('(' == *p)
+			depth++;
+		else if (')' == *p)
+			depth--;
+		else if (0 == depth && ':' == p[0] && ':' == p[1])
+			cast_at = p;
+		p++;
+	}
+	if (cast_at)
+	{
+		const char	*t = cast_at + 2, *te;
+
+		for (te = t; te < end && IS_IDENT_CHAR(*te); te++)
+			;
+		cast = lookup_type(t, te - t);
+		end = cast_at;
+	}
+
+	*value = NULL;
+	if ('\'' == *item)
+	{
+		char	*v = malloc(end - item);
+		size_t	n = 0;
+
+		for (p = item + 1; p < end; p++)
+		{
+			if ('\'' == *p)
+			{
+				if (p + 1 < end && '\'' == p[1])
+					p++;
+				else
+					break;
+			}
+			v[n++] = *p;
+		}
+		v[n] = '\0';
+		*value = v;
+	}
+	else if ('$' == *item)
+	{
+		int	i = atoi(item + 1) - 1;
+
+		if (i >= 0 && i < nparams)
+		{
+			if (params[i])
+				*value = strdup(params[i]);
+			if (ptypes && ptypes[i])
+				type = lookup_type_oid(ptypes[i]);
+		}
+	}
+	else if (isdigit((unsigned char) *item) || ('-' == *item && isdigit((unsigned char) item[1])))
+	{
+		*value = strndup(item, end - item);
+		type = (NULL == strchr(*value, '.') && end - item < 10) ? TYPE_INT4 : TYPE_NUMERIC;
+	}
+	else if (word_is(item, "true") || word_is(item, "false"))
+	{
+		*value = strdup(word_is(item, "true") ? "t" : "f");
+		type = TYPE_BOOL;
+	}
+	else if (word_is(item, "null"))
+		;
+	else
+	{
+		item_name(item, end - item, name);
+		if (0 == strcasecmp(name, "version"))
+			*value = strdup("PostgreSQL " SERVER_VERSION " on pgmock");
+		else if (0 == strcasecmp(name, "pg_client_encoding"))
+			*value = strdup("UTF8");
+		else if (0 == strcasecmp(name, "current_schema"))
+			*value = strdup("public");
+		else if (0 == strcasecmp(name, "current_database"))
+			*value = strdup(database_name);
+		else if (0 == strcasecmp(name, "current_user") ||
+				 0 == strcasecmp(name, "session_user") ||
+				 0 == strcasecmp(name, "user"))
+			*value = strdup(user_name);
+		else if (0 == strcasecmp(name, "now") ||
+				 0 == strcasecmp(name, "current_timestamp"))
+		{
+			*value = strdup("2020-01-01 00:00:00");
+			type = TYPE_TIMESTAMP;
+		}
+		else if (0 == strcasecmp(name, "count"))
+		{
+			*value = strdup("1");
+			type = TYPE_INT4;
+		}
+	}
+	return cast ? cast : type;
+}
+
+static const char *
+show_value(const char *name)
+{
+	static const char *const	settings[][2] =
+	{
+		{"max_identifier_length", "63"},
+		{"transaction_isolation", "read committed"},
+		{"default_transaction_isolation", "read committed"},
+		{"server_version", SERVER_VERSION},
+		{"server_encoding", "UTF8"},
+		{"client_encoding", "UTF8"},
+		{"DateStyle", "ISO, MDY"},
+		{"standard_conforming_strings", "on"},
+		{"integer_datetimes", "on"},
+		{NULL, NULL}
+	};
+	int		i;
+
+	for (i = 0; settings[i][0]; i++)
+	{
+		if (0 == strcasecmp(settings[i][0], name))
+			return settings[i][1];
+	}
+	return "";
+}
+
+/*
+ *	Synthetic rows
+ */
+static int
+synthetic_value(const MOCK_TYPE *type, long row, int col, int width, char *buf, size_t buflen)
+{
+	long		v = row * 7919 + col * 104729;
+	int		i, n;
+
+	switch (type->oid)
+	{
+		case INT4OID:
+			return snprintf(buf, buflen, "%ld", v % 2000000 - 1000000);
+		case INT8OID:
+			return snprintf(buf, buflen, "%ld", v * 1000000007L);
+		case FLOAT8OID:
+			return snprintf(buf, buflen, "%.15g", (v % 100000) / 3.0);
+		case NUMERICOID:
+			return snprintf(buf, buflen, "%ld.%04ld", v % 1000000, v % 10000);
+		case BOOLOID:
+			return snprintf(buf, buflen, "%c", (row + col) % 2 ? 't' : 'f');
+		case DATEOID:
+			return snprintf(buf, buflen, "%04ld-%02ld-%02ld", 2000 + v % 30, 1 + v % 12, 1 + v % 28);
+		case TIMESTAMPOID:
+			return snprintf(buf, buflen, "%04ld-%02ld-%02ld %02ld:%02ld:%02ld.%06ld", 2000 + v % 30, 1 + v % 12, 1 + v % 28, v % 24, v % 60, (v / 60) % 60, v % 1000000);
+		case BYTEAOID:
+			n = snprintf(buf, buflen, "\\x");
+			for (i = 0; i < width && n + 3 < (int) buflen; i++)
+				n += snprintf(buf + n, buflen - n, "%02x", (int) ((v + i) & 0xff));
+			return n;
+		default:
+			for (i = 0; i < width && i + 1 < (int) buflen; i++)
+				buf[i] = 'a' + (v + i) % 26;
+			buf[i] = '\0';
+			return i;
+	}
+}
+
+/* Encodes the DataRows of the synthetic result once */
+static void
+build_synthetic_rows(RESULT *res)
+{
+	size_t		saved = outlen;
+	char		buf[4096];
+	long		row;
+	int		col, n;
+
+	for (row = 0; row < DISTINCT_ROWS; row++)
+	{
+		size_t	pos;
+
+		res->rowoffs[row] = outlen - saved;
+		pos = begin_msg('D');
+		put_int16(res->ncols);
+		for (col = 0; col < res->ncols; col++)
+		{
+			n = synthetic_value(res->types[col], row, col, res->width, buf, sizeof(buf));
+			if (n >= (int) sizeof(buf))
+				n = sizeof(buf) - 1;
+			put_value(buf, n);
+		}
+		end_msg(pos);
+	}
+	res->rowoffs[row] = outlen - saved;
+	res->rowdata = malloc(outlen - saved);
+	memcpy(res->rowdata, outbuf + saved, outlen - saved);
+	outlen = saved;
+}
+
+/* mock_rows(rows, cols [, 'types' [, width]]) */
+static void
+parse_mock_rows(const char *p, RESULT *res)
+{
+	const MOCK_TYPE	*types[MAX_COLUMNS];
+	int		ntypes = 0, i;
+	char		*end;
+
+	res->kind = RESULT_SYNTHETIC;
+	res->width = DEFAULT_WIDTH;
+	res->nrows = strtol(skip_space(p), &end, 10);
+	p = skip_space(end);
+	if (',' == *p)
+		p++;
+	res->ncols = (int) strtol(skip_space(p), &end, 10);
+	if (res->ncols < 1)
+		res->ncols = 1;
+	else if (res->ncols > MAX_COLUMNS)
+		res->ncols = MAX_COLUMNS;
+	p = skip_space(end);
+	if (',' == *p && '\'' == *(p = skip_space(p + 1)))
+	{
+		for (p++; *p && '\'' != *p;)
+		{
+			const char	*t = p;
+
+			while (*p && ',' != *p && '\'' != *p)
+				p++;
+			if (5 == p - t && 0 == strncasecmp(t, "mixed", 5))
+			{
+				for (i = 0; mock_types[i].name && ntypes < MAX_COLUMNS; i++)
+					types[ntypes++] = &mock_types[i];
+			}
+			else if (ntypes < MAX_COLUMNS &&
+					 NULL != (types[ntypes] = lookup_type(t, p - t)))
+				ntypes++;
+			if (',' == *p)
+				p++;
+		}
+		if ('\'' == *p)
+			p++;
+		p = skip_space(p);
+		if (',' == *p)
+			res->width = atoi(skip_space(p + 1));
+	}
+	if (0 == ntypes)
+		types[ntypes++] = TYPE_INT4;
+	for (i = 0; i < res->ncols; i++)
+	{
+		res->types[i] = types[i % ntypes];
+		snprintf(res->names[i], NAME_LEN, "c%d", i + 1);
+	}
+	build_synthetic_rows(res);
+}
+
+/* A made up value for the catalog column */
+static int
+catalog_value(const char *name, long row, char *buf, size_t buflen)
+{
+	size_t		len = strlen(name);
+
+	if (len >= 4 && 0 == strcasecmp(name + len - 4, "kind"))
+		return snprintf(buf, buflen, "r");
+	if (NULL != strstr(name, "name") || NULL != strstr(name, "NAME"))
+		return snprintf(buf, buflen, "%s%ld", name, row + 1);
+	return snprintf(buf, buflen, "%ld", row + 1);
+}
+
+static SCRIPT_ENTRY *
+lookup_script(const char *query)
+{
+	SCRIPT_ENTRY	*e;
+
+	for (e = script; e; e = e->next)
+	{
+		if (0 == strncasecmp(query, e->prefix, strlen(e->prefix)))
+			return e;
+	}
+	return NULL;
+}
+
+/* The command tag of a query not returning rows */
+static void
+command_tag(const char *query, RESULT *res)
+{
+	const char	*p = query, *q;
+	char		*t;
+
+	res->kind = RESULT_COMMAND;
+	if (word_is(p, "insert"))
+		strcpy(res->tag, "INSERT 0 1");
+	else if (word_is(p, "update"))
+		strcpy(res->tag, "UPDATE 1");
+	else if (word_is(p, "delete"))
+		strcpy(res->tag, "DELETE 1");
+	else if (word_is(p, "begin") || word_is(p, "start"))
+	{
+		strcpy(res->tag, word_is(p, "begin") ? "BEGIN" : "START TRANSACTION");
+		res->tx_status = 'T';
+	}
+	else if (word_is(p, "commit") || word_is(p, "end"))
+	{
+		strcpy(res->tag, "COMMIT");
+		res->tx_status = 'I';
+	}
+	else if (word_is(p, "rollback"))
+	{
+		strcpy(res->tag, "ROLLBACK");
+		if (!word_is(skip_space(p + 8), "to"))
+			res->tx_status = 'I';
+	}
+	else if (word_is(p, "declare"))
+		strcpy(res->tag, "DECLARE CURSOR");
+	else if (word_is(p, "close"))
+		strcpy(res->tag, "CLOSE CURSOR");
+	else
+	{
+		/* the first word, and the second one of CREATE TABLE etc. */
+		for (q = p; IS_IDENT_CHAR(*q); q++)
+			;
+		if (word_is(p, "create") || word_is(p, "drop") || word_is(p, "alter"))
+		{
+			for (q = skip_space(q); IS_IDENT_CHAR(*q); q++)
+				;
+		}
+		if (q - p >= NAME_LEN)
+			q = p + NAME_LEN - 1;
+		memcpy(res->tag, p, q - p);
+		res->tag[q - p] = '\0';
+		for (t = res->tag; *t; t++)
+		{
+			if (isspace((unsigned char) *t))
+				*t = ' ';
+			*t = toupper((unsigned char) *t);
+		}
+	}
+}
+
+/* What the query (a single statement) returns */
+static RESULT *
+describe_query(const char *query, char **params, int nparams, const int *ptypes)
+{
+	RESULT		*res = calloc(1, sizeof(RESULT));
+	const char	*p = skip_space(query), *m;
+	const char	*items[MAX_COLUMNS];
+	size_t		lens[MAX_COLUMNS];
+	int		i;
+
+	if (NULL != (res->script = lookup_script(p)))
+	{
+		res->kind = RESULT_SCRIPT;
+		res->ncols = res->script->ncols;
+		memcpy(res->names, res->script->names, sizeof(res->names));
+		memcpy(res->types, res->script->types, sizeof(res->types));
+		res->nrows = res->script->nrows;
+	}
+	else if (NULL != (m = strstr(p, "mock_rows(")) ||
+			 NULL != (m = strstr(p, "MOCK_ROWS(")))
+		parse_mock_rows(m + 10, res);
+	else if (word_is(p, "show"))
+	{
+		p = skip_space(p + 4);
+		for (m = p; IS_IDENT_CHAR(*m); m++)
+			;
+		res->kind = RESULT_VALUES;
+		res->ncols = 1;
+		copy_name(res->names[0], p, m - p);
+		res->types[0] = TYPE_TEXT;
+		res->values[0] = strdup(show_value(res->names[0]));
+		res->nrows = 1;
+	}
+	else if (word_is(p, "select"))
+	{
+		p = skip_space(p + 6);
+		if (word_is(p, "distinct") || word_is(p, "all"))
+			p = skip_space(p + (word_is(p, "all") ? 3 : 8));
+		p = skip_space(split_select_list(p, items, lens, &res->ncols));
+		for (i = 0; i < res->ncols; i++)
+			item_name(items[i], lens[i], res->names[i]);
+		if (!word_is(p, "from"))
+		{
+			res->kind = RESULT_VALUES;
+			res->nrows = 1;
+			for (i = 0; i < res->ncols; i++)
+				res->types[i] = item_value(items[i], lens[i], params, nparams, ptypes, &res->values[i]);
+		}
+		else
+		{
+			res->kind = RESULT_CATALOG;
+			for (i = 0; i < res->ncols; i++)
+				res->types[i] = TYPE_TEXT;
+			if (NULL != strstr(p, "pg_") || NULL != strstr(p, "information_schema"))
+				res->nrows = catalog_rows;
+		}
+	}
+	else
+		command_tag(p, res);
+	return res;
+}
+
+static void
+free_result(RESULT *res)
+{
+	int		i;
+
+	if (NULL == res)
+		return;
+	for (i = 0; i < res->ncols; i++)
+		free(res->values[i]);
+	free(res->rowdata);
+	free(res);
+}
+
+static void
+send_row_description(const RESULT *res)
+{
+	size_t		pos;
+	int		i;
+
+	if (RESULT_COMMAND == res->kind)
+	{
+		pos = begin_msg('n');		/* NoData */
+		end_msg(pos);
+		return;
+	}
+	pos = begin_msg('T');
+	put_int16(res->ncols);
+	for (i = 0; i < res->ncols; i++)
+	{
+		put_string(res->names[i]);
+		put_int32(0);			/* table oid */
+		put_int16(0);			/* column number */
+		put_int32(res->types[i]->oid);
+		put_int16(res->types[i]->len);
+		put_int32(-1);			/* typmod */
+		put_int16(0);			/* text format */
+	}
+	end_msg(pos);
+}
+
+static void
+send_row(const RESULT *res, long row)
+{
+	char		buf[256];
+	size_t		pos;
+	int		i;
+
+	switch (res->kind)
+	{
+		case RESULT_SYNTHETIC:
+			put_bytes(res->rowdata + res->rowoffs[row % DISTINCT_ROWS],
+					  res->rowoffs[row % DISTINCT_ROWS + 1] - res->rowoffs[row % DISTINCT_ROWS]);
+			return;
+		case RESULT_SCRIPT:
+			pos = begin_msg('D');
+			put_int16(res->ncols);
+			for (i = 0; i < res->ncols; i++)
+				put_value(res->script->rows[row][i], -1);
+			end_msg(pos);
+			return;
+		case RESULT_CATALOG:
+			pos = begin_msg('D');
+			put_int16(res->ncols);
+			for (i = 0; i < res->ncols; i++)
+				put_value(buf, catalog_value(res->names[i], row, buf, sizeof(buf)));
+			end_msg(pos);
+			return;
+		case RESULT_VALUES:
+			pos = begin_msg('D');
+			put_int16(res->ncols);
+			for (i = 0; i < res->ncols; i++)
+				put_value(res->values[i], -1);
+			end_msg(pos);
+			return;
+	}
+}
+
+/*
+ * Sends the rows from *pos on, at most maxrows of them if maxrows > 0.
+ * Returns 0 if some rows are left.
+ */
+static int
+send_rows(const RESULT *res, long *pos, long maxrows)
+{
+	size_t		msgpos;
+	long		end = res->nrows;
+
+	if (maxrows > 0 && *pos + maxrows < end)
+		end = *pos + maxrows;
+	for (; *pos < end; (*pos)++)
+	{
+		send_row(res, *pos);
+		if (outlen >= FLUSH_SIZE)
+			flush_out();
+	}
+	if (*pos < res->nrows)
+		return 0;
+	msgpos = begin_msg('C');
+	if (RESULT_COMMAND == res->kind)
+	{
+		put_string(res->tag);
+		if (res->tx_status)
+			tx_status = res->tx_status;
+	}
+	else
+	{
+		char	tag[NAME_LEN];
+
+		snprintf(tag, sizeof(tag), "SELECT %ld", res->nrows);
+		put_string(tag);
+	}
+	end_msg(msgpos);
+	return 1;
+}
+
+/*
+ *	The script file
+ */
+static void
+load_script(const char *path)
+{
+	FILE		*fp;
+	char		line[65536];
+	SCRIPT_ENTRY	*e = NULL, **tail = &script;
+	int		lineno = 0;
+
+	if (NULL == (fp = fopen(path, "r")))
+	{
+		perror(path);
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), fp))
+	{
+		char	*p = line + strlen(line), *s;
+
+		lineno++;
+		while (p > line && ('\n' == p[-1] || '\r' == p[-1]))
+			*--p = '\0';
+		if ('>' == line[0])
+		{
+			e = calloc(1, sizeof(SCRIPT_ENTRY));
+			e->prefix = strdup(skip_space(line + 1));
+			*tail = e;
+			tail = &e->next;
+		}
+		else if (':' == line[0] && e)
+		{
+			for (p = line + 1; *(p = (char *) skip_space(p)) && e->ncols < MAX_COLUMNS;)
+			{
+				for (s = p; IS_IDENT_CHAR(*p); p++)
+					;
+				copy_name(e->names[e->ncols], s, p - s);
+				for (s = p = (char *) skip_space(p); IS_IDENT_CHAR(*p); p++)
+					;
+				if (NULL == (e->types[e->ncols] = lookup_type(s, p - s)))
+					e->types[e->ncols] = TYPE_TEXT;
+				e->ncols++;
+				p = (char *) skip_space(p);
+				if (',' == *p)
+					p++;
+			}
+		}
+		else if ('\0' != line[0] && '#' != line[0] && e)
+		{
+			char	**row = calloc(e->ncols, sizeof(char *));
+			int		i;
+
+			for (i = 0, p = line; i < e->ncols; i++)
+			{
+				if (NULL != (s = strchr(p, '|')))
+					*s = '\0';
+				row[i] = strcmp(p, "\\N") ? strdup(p) : NULL;
+				if (NULL == s && i + 1 < e->ncols)
+				{
+					fprintf(stderr, "%s:%d: %d values expected\n", path, lineno, e->ncols);
+					exit(1);
+				}
+				p = s + 1;
+			}
+			e->rows = realloc(e->rows, (e->nrows + 1) * sizeof(char **));
+			e->rows[e->nrows++] = row;
+		}
+	}
+	fclose(fp);
+}
+
+/*
+ *	Simple query: the statements separated by ';', each one gets its
+ *	result and one ReadyForQuery follows.
+ */
+static void
+simple_query(const char *query)
+{
+	const char	*p = query, *start;
+	int		nstmts = 0;
+
+	while (*(p = skip_space(p)))
+	{
+		RESULT	*res;
+		char	*stmt;
+		long	pos = 0;
+
+		for (start = p; *p && ';' != *p;)
+		{
+			if ('\'' == *p || '"' == *p)
+				p = skip_quoted(p);
+			else
+				p++;
+		}
+		stmt = strndup(start, p - start);
+		if (';' == *p)
+			p++;
+		if ('\0' == *skip_space(stmt))
+		{
+			free(stmt);
+			continue;
+		}
+		res = describe_query(stmt, NULL, 0, NULL);
+		if (RESULT_COMMAND != res->kind)
+			send_row_description(res);
+		send_rows(res, &pos, 0);
+		free_result(res);
+		free(stmt);
+		nstmts++;
+	}
+	if (0 == nstmts)
+	{
+		size_t	pos = begin_msg('I');		/* EmptyQueryResponse */
+
+		end_msg(pos);
+	}
+}
+
+/*
+ *	Extended query
+ */
+static PREPARED **
+find_prepared(const char *name, int add)
+{
+	int		i, empty = -1;
+
+	for (i = 0; i < MAX_PREPARED; i++)
+	{
+		if (NULL == prepared[i])
+		{
+			if (empty < 0)
+				empty = i;
+		}
+		else if (0 == strcmp(prepared[i]->name, name))
+			return &prepared[i];
+	}
+	return (add && empty >= 0) ? &prepared[empty] : NULL;
+}
+
+static PORTAL **
+find_portal(const char *name, int add)
+{
+	int		i, empty = -1;
+
+	for (i = 0; i < MAX_PORTALS; i++)
+	{
+		if (NULL == portals[i])
+		{
+			if (empty < 0)
+				empty = i;
+		}
+		else if (0 == strcmp(portals[i]->name, name))
+			return &portals[i];
+	}
+	return (add && empty >= 0) ? &portals[empty] : NULL;
+}
+
+static void
+free_prepared(PREPARED *stmt)
+{
+	if (NULL == stmt)
+		return;
+	free(stmt->query);
+	free(stmt->ptypes);
+	free(stmt);
+}
+
+static void
+free_portal(PORTAL *portal)
+{
+	int		i;
+
+	if (NULL == portal)
+		return;
+	for (i = 0; i < portal->nparams; i++)
+		free(portal->params[i]);
+	free(portal->params);
+	free_result(portal->result);
+	free(portal);
+}
+
+/* Returns 0 on error */
+static int
+parse_message(MSG *msg)
+{
+	const char	*name = get_string(msg), *query = get_string(msg);
+	PREPARED	**slot, *stmt;
+	int		n, i;
+	size_t		pos;
+
+	if (NULL == (slot = find_prepared(name, 1)))
+	{
+		send_error("53000", "too many prepared statements");
+		return 0;
+	}
+	free_prepared(*slot);
+	stmt = *slot = calloc(1, sizeof(PREPARED));
+	copy_name(stmt->name, name, strlen(name));
+	stmt->query = strdup(query);
+	n = get_int16(msg);
+	stmt->nparams = count_params(query);
+	if (n > stmt->nparams)
+		stmt->nparams = n;
+	stmt->ptypes = calloc(stmt->nparams + 1, sizeof(int));
+	for (i = 0; i < n; i++)
+		stmt->ptypes[i] = get_int32(msg);
+	pos = begin_msg('1');		/* ParseComplete */
+	end_msg(pos);
+	return 1;
+}
+
+static int
+bind_message(MSG *msg)
+{
+	const char	*pname = get_string(msg), *sname = get_string(msg);
+	PREPARED	**stmt;
+	PORTAL		**slot, *portal;
+	int		nfmts, n, i, len;
+	size_t		pos;
+
+	if (NULL == (stmt = find_prepared(sname, 0)))
+	{
+		send_error("26000", "prepared statement does not exist");
+		return 0;
+	}
+	if (NULL == (slot = find_portal(pname, 1)))
+	{
+		send_error("53000", "too many portals");
+		return 0;
+	}
+	free_portal(*slot);
+	portal = *slot = calloc(1, sizeof(PORTAL));
+	copy_name(portal->name, pname, strlen(pname));
+	portal->stmt = *stmt;
+	nfmts = get_int16(msg);
+	msg->p += 2 * nfmts;
+	n = get_int16(msg);
+	portal->nparams = n;
+	portal->params = calloc(n + 1, sizeof(char *));
+	for (i = 0; i < n; i++)
+	{
+		len = get_int32(msg);
+		if (len >= 0 && msg->p + len <= msg->end)
+		{
+			portal->params[i] = strndup(msg->p, len);
+			msg->p += len;
+		}
+	}
+	/* the result formats are ignored, everything is text */
+	pos = begin_msg('2');		/* BindComplete */
+	end_msg(pos);
+	return 1;
+}
+
+static RESULT *
+portal_result(PORTAL *portal)
+{
+	if (NULL == portal->result)
+		portal->result = describe_query(portal->stmt->query, portal->params, portal->nparams, portal->stmt->ptypes);
+	return portal->result;
+}
+
+static int
+describe_message(MSG *msg)
+{
+	char		kind = *msg->p++;
+	const char	*name = get_string(msg);
+	size_t		pos;
+	int		i;
+
+	if ('S' == kind)
+	{
+		PREPARED	**stmt = find_prepared(name, 0);
+		RESULT		*res;
+
+		if (NULL == stmt)
+		{
+			send_error("26000", "prepared statement does not exist");
+			return 0;
+		}
+		pos = begin_msg('t');		/* ParameterDescription */
+		put_int16((*stmt)->nparams);
+		for (i = 0; i < (*stmt)->nparams; i++)
+			put_int32((*stmt)->ptypes[i] ? (*stmt)->ptypes[i] : TEXTOID);
+		end_msg(pos);
+		res = describe_query((*stmt)->query, NULL, 0, (*stmt)->ptypes);
+		send_row_description(res);
+		free_result(res);
+	}
+	else
+	{
+		PORTAL	**portal = find_portal(name, 0);
+
+		if (NULL == portal)
+		{
+			send_error("34000", "portal does not exist");
+			return 0;
+		}
+		send_row_description(portal_result(*portal));
+	}
+	return 1;
+}
+
+static int
+execute_message(MSG *msg)
+{
+	const char	*name = get_string(msg);
+	long		maxrows = get_int32(msg);
+	PORTAL		**portal = find_portal(name, 0);
+	size_t		pos;
+
+	if (NULL == portal)
+	{
+		send_error("34000", "portal does not exist");
+		return 0;
+	}
+	if (!send_rows(portal_result(*portal), &(*portal)->pos, maxrows))
+	{
+		pos = begin_msg('s');		/* PortalSuspended */
+		end_msg(pos);
+	}
+	return 1;
+}
+
+static int
+close_message(MSG *msg)
+{
+	char		kind = *msg->p++;
+	const char	*name = get_string(msg);
+	size_t		pos;
+	int		i;
+
+	if ('S' == kind)
+	{
+		PREPARED	**stmt = find_prepared(name, 0);
+
+		if (stmt)
+		{
+			/* the portals of the statement go with it */
+			for (i = 0; i < MAX_PORTALS; i++)
+			{
+				if (portals[i] && portals[i]->stmt == *stmt)
+				{
+					free_portal(portals[i]);
+					portals[i] = NULL;
+				}
+			}
+			free_prepared(*stmt);
+			*stmt = NULL;
+		}
+	}
+	else
+	{
+		PORTAL	**portal = find_portal(name, 0);
+
+		if (portal)
+		{
+			free_portal(*portal);
+			*portal = NULL;
+		}
+	}
+	pos = begin_msg('3');		/* CloseComplete */
+	end_msg(pos);
+	return 1;
+}
+
+static void
+ready_for_query(void)
+{
+	size_t		pos = begin_msg('Z');
+
+	put_byte(tx_status);
+	end_msg(pos);
+	flush_out();
+}
+
+static void
+parameter_status(const char *name, const char *value)
+{
+	size_t		pos = begin_msg('S');
+
+	put_string(name);
+	put_string(value);
+	end_msg(pos);
+}
+
+/* Returns 0 if the connection is to be closed */
+static int
+startup(void)
+{
+	static const char *const	params[] = {"server_version", "server_encoding", "client_encoding", "DateStyle", "standard_conforming_strings", "integer_datetimes", NULL};
+	MSG		msg;
+	int		len, code, i;
+	size_t		pos;
+
+	for (;;)
+	{
+		read_n(&len, 4);
+		read_body(&msg, (int) ntohl(len) - 4);
+		code = get_int32(&msg);
+		if (SSL_REQUEST_CODE == code)
+		{
+			if (NULL == ssl_ctx || NULL != ssl)
+			{
+				put_byte('N');
+				flush_out();
+				continue;
+			}
+			put_byte('S');
+			flush_out();
+			if (NULL == (ssl = SSL_new(ssl_ctx)) ||
+			    !SSL_set_fd(ssl, client_fd) ||
+			    SSL_accept(ssl) <= 0)
+			{
+				ERR_print_errors_fp(stderr);
+				return 0;
+			}
+			continue;
+		}
+		if (CANCEL_REQUEST_CODE == code)
+			return 0;
+		if (PROTOCOL_3 != code)
+		{
+			send_error("0A000", "unsupported frontend protocol");
+			flush_out();
+			return 0;
+		}
+		break;
+	}
+	while (msg.p < msg.end && '\0' != *msg.p)
+	{
+		const char	*name = get_string(&msg), *value = get_string(&msg);
+
+		if (0 == strcmp(name, "user"))
+			copy_name(user_name, value, strlen(value));
+		else if (0 == strcmp(name, "database"))
+			copy_name(database_name, value, strlen(value));
+	}
+	if ('\0' == database_name[0])
+		strcpy(database_name, user_name);
+	if (NULL != reject_hba &&
+	    (NULL != ssl) == (0 == strcmp(reject_hba, "ssl")))
+	{
+		char	message[256];
+
+		snprintf(message, sizeof(message), "no pg_hba.conf entry for host \"127.0.0.1\", user \"%s\", database \"%s\", %s",
+				 user_name, database_name, ssl ? "SSL on" : "SSL off");
+		send_error_severity("FATAL", "28000", message);
+		flush_out();
+		return 0;
+	}
+
+	pos = begin_msg('R');		/* AuthenticationOk */
+	put_int32(0);
+	end_msg(pos);
+	for (i = 0; params[i]; i++)
+		parameter_status(params[i], show_value(params[i]));
+	pos = begin_msg('K');		/* BackendKeyData */
+	put_int32((int) getpid());
+	put_int32(0);
+	end_msg(pos);
+	ready_for_query();
+	return 1;
+}
+
+static void
+serve(void)
+{
+	MSG		msg;
+	char		type;
+	int		len, failed = 0;
+
+	if (!startup())
+		return;
+	for (;;)
+	{
+		read_n(&type, 1);
+		read_n(&len, 4);
+		read_body(&msg, (int) ntohl(len) - 4);
+		/* after an error, the extended query messages are skipped up to Sync */
+		if (failed && 'S' != type)
+			continue;
+		switch (type)
+		{
+			case 'Q':
+				simple_query(msg.p);
+				ready_for_query();
+				break;
+			case 'P':
+				failed = !parse_message(&msg);
+				break;
+			case 'B':
+				failed = !bind_message(&msg);
+				break;
+			case 'D':
+				failed = !describe_message(&msg);
+				break;
+			case 'E':
+				failed = !execute_message(&msg);
+				break;
+			case 'C':
+				failed = !close_message(&msg);
+				break;
+			case 'H':
+				flush_out();
+				break;
+			case 'S':
+				failed = 0;
+				ready_for_query();
+				break;
+			case 'X':
+				return;
+			default:
+				send_error("0A000", "message type not supported by pgmock");
+				failed = 1;
+				break;
+		}
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	struct sockaddr_in	addr;
+	int		port = DEFAULT_PORT, listen_fd, c, on = 1;
+	const char	*certfile = NULL, *keyfile = NULL;
+
+	while ((c = getopt(argc, argv, "p:s:c:C:K:r:")) != -1)
+	{
+		switch (c)
+		{
+			case 'p':
+				port = atoi(optarg);
+				break;
+			case 's':
+				load_script(optarg);
+				break;
+			case 'c':
+				catalog_rows = atoi(optarg);
+				break;
+			case 'C':
+				certfile = optarg;
+				break;
+			case 'K':
+				keyfile = optarg;
+				break;
+			case 'r':
+				if (0 == strcmp(optarg, "ssl") || 0 == strcmp(optarg, "nossl"))
+				{
+					reject_hba = optarg;
+					break;
+				}
+				/* fall through */
+			default:
+				fprintf(stderr, "usage: %s [-p port] [-s script] [-c catalog_rows] [-C certfile -K keyfile] [-r ssl|nossl]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (NULL != certfile && NULL != keyfile)
+	{
+		if (NULL == (ssl_ctx = SSL_CTX_new(TLS_server_method())) ||
+		    SSL_CTX_use_certificate_file(ssl_ctx, certfile, SSL_FILETYPE_PEM) <= 0 ||
+		    SSL_CTX_use_PrivateKey_file(ssl_ctx, keyfile, SSL_FILETYPE_PEM) <= 0)
+		{
+			ERR_print_errors_fp(stderr);
+			return 1;
+		}
+	}
+
+	if ((listen_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+	{
+		perror("socket");
+		return 1;
+	}
+	setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+	    listen(listen_fd, 64) < 0)
+	{
+		perror("bind");
+		return 1;
+	}
+	signal(SIGCHLD, SIG_IGN);
+	fprintf(stderr, "pgmock listening on port %d\n", port);
+
+	for (;;)
+	{
+		if ((client_fd = accept(listen_fd, NULL, NULL)) < 0)
+		{
+			if (EINTR == errno)
+				continue;
+			perror("accept");
+			return 1;
+		}
+		switch (fork())
+		{
+			case 0:
+				close(listen_fd);
+				setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+				serve();
+				flush_out();
+				_exit(0);
+			case -1:
+				perror("fork");
+				break;
+		}
+		close(client_fd);
+	}
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Check of the TLS session cache of the driver's own SSL connections,
+ * see SOCK_start_ssl() and SOCK_cache_ssl_session() in socket.c.
+ *
+ * The handshakes are made against "openssl s_server" (see the sslcheck
+ * target of the Makefile) rather than a PostgreSQL server, so the
+ * SSLRequest exchange is skipped and the driver's socket routines are
+ * called directly through the shared library.  PGSSLROOTCERT must name
+ * the certificate of the server, which is issued for "localhost".
+ *
+ * Usage: sslsession-check <port>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "psqlodbc.h"
+#include "socket.h"
+#include "dlg_specific.h"
+
+static int	failures = 0;
+
+/*
+ * Do one handshake with the given sslmode, and check whether it resumed
+ * a cached session as expected.
+ */
+static void
+handshake(const char *port, const char *sslmode, int expect_resumed)
+{
+	SocketClass *sock;
+	UInt4		hits, misses, hits_after, misses_after;
+	int			resumed;
+
+	SOCK_get_ssl_session_stats(&hits, &misses);
+	if (NULL == (sock = SOCK_Constructor(NULL)))
+	{
+		fprintf(stderr, "SOCK_Constructor failed\n");
+		exit(1);
+	}
+	if (!SOCK_connect_to(sock, (unsigned short) atoi(port), "localhost", 10))
+	{
+		fprintf(stderr, "could not connect to port %s: %s\n", port, SOCK_get_errmsg(sock));
+		exit(1);
+	}
+	if (!SOCK_start_ssl(sock, sslmode, port, "user"))
+	{
+		printf("%s: handshake failed: %s\n", sslmode, SOCK_get_errmsg(sock));
+		failures++;
+		SOCK_Destructor(sock);
+		return;
+	}
+	SOCK_cache_ssl_session(sock);
+	SOCK_get_ssl_session_stats(&hits_after, &misses_after);
+	resumed = (hits_after > hits);
+	printf("%s: %s", sslmode, resumed ? "resumed" : "full handshake");
+	if (hits_after + misses_after != hits + misses + 1)
+	{
+		printf(", not counted");
+		failures++;
+	}
+	else if (resumed != expect_resumed)
+	{
+		printf(", expected %s", expect_resumed ? "resumed" : "full handshake");
+		failures++;
+	}
+	printf("\n");
+	SOCK_Destructor(sock);
+}
+
+int main(int argc, char **argv)
+{
+	const char *port;
+
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s <port>\n", argv[0]);
+		exit(1);
+	}
+	port = argv[1];
+
+	handshake(port, SSLMODE_REQUIRE, 0);
+	handshake(port, SSLMODE_REQUIRE, 1);
+	/* a session of sslmode=require is not good enough for verify-ca */
+	handshake(port, SSLMODE_VERIFY_CA, 0);
+	handshake(port, SSLMODE_VERIFY_CA, 1);
+	handshake(port, SSLMODE_VERIFY_FULL, 0);
+	handshake(port, SSLMODE_VERIFY_FULL, 1);
+
+	if (failures)
+	{
+		printf("%d failures\n", failures);
+		exit(1);
+	}
+	printf("ok\n");
+	return 0;
+}
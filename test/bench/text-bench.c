@@ -0,0 +1,180 @@
+/*
+ * Microbenchmark for the scans of the text values and the queries:
+ * convert_linefeeds() and convert_special_chars() of convert.c, which
+ * every text value fetched or sent as a literal goes through, and
+ * SC_scanQueryAndCountParams() of statement.c, which every query goes
+ * through.
+ *
+ * The inputs are synthetic ASCII and multibyte texts, short and large.
+ * The routines are called the way the driver calls them, once to
+ * compute the length of the result and once to build it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "psqlodbc.h"
+#include "connection.h"
+#include "statement.h"
+#include "convert.h"
+#include "multibyte.h"
+
+#define	SHORT_SIZE	32
+#define	LARGE_SIZE	(256 * 1024)
+
+/* as in convert.c */
+#define	FLGB_CONVERT_LF		(1L << 7)
+
+static const char *ascii_words[] = {
+	"the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ", "dog's ",
+	"back ", "42 ", "\n"
+};
+static const char *mb_words[] = {
+	"\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e ",	/* Japanese */
+	"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 ",	/* Russian */
+	"caf\xc3\xa9 ", "O'Neil ", "\xf0\x9f\x98\x80 ", "\xe4\xb8\xad\xe6\x96\x87 ", "\n"
+};
+
+/* Fill buf with size bytes of the words in turn, CR/LF for the newlines if crlf */
+static char *
+make_text(size_t size, const char **words, int nwords, BOOL crlf)
+{
+	char	   *buf = malloc(size + 1);
+	size_t		len = 0;
+	int			i = 0;
+
+	if (!buf)
+	{
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	for (;;)
+	{
+		const char *word = words[i++ % nwords];
+		size_t		wlen = strlen(word);
+
+		if (crlf && '\n' == word[0])
+		{
+			word = "\r\n";
+			wlen = 2;
+		}
+		if (len + wlen > size)
+			break;
+		memcpy(buf + len, word, wlen);
+		len += wlen;
+	}
+	buf[len] = '\0';
+	return buf;
+}
+
+/* Count the length first, as the driver does, then convert */
+static size_t
+linefeeds(const char *text, char *dst)
+{
+	BOOL	changed;
+	size_t	len;
+
+	len = convert_linefeeds(text, NULL, 0, TRUE, &changed);
+	convert_linefeeds(text, dst, len + 1, TRUE, &changed);
+	return len;
+}
+
+static size_t
+special_chars(const char *text, char *dst, int ccsc)
+{
+	size_t	len;
+
+	len = convert_special_chars(text, NULL, SQL_NTS, FLGB_CONVERT_LF, ccsc, '\\');
+	convert_special_chars(text, dst, SQL_NTS, FLGB_CONVERT_LF, ccsc, '\\');
+	return len;
+}
+
+static void
+bench_text(const char *label, const char *text, int ccsc)
+{
+	BENCH_TIMER	timer;
+	char		name[64];
+	size_t		len = strlen(text);
+	char	   *dst = malloc(2 * len + 1);
+
+	snprintf(name, sizeof(name), "convert_linefeeds, %s", label);
+	BENCH_LOOP(timer, name, len, linefeeds(text, dst));
+	snprintf(name, sizeof(name), "convert_special_chars, %s", label);
+	BENCH_LOOP(timer, name, len, special_chars(text, dst, ccsc));
+	free(dst);
+}
+
+static void
+bench_query(ConnectionClass *conn, const char *label, const char *query)
+{
+	BENCH_TIMER	timer;
+	char		name[64];
+	Int4		next_cmd;
+	SQLSMALLINT	num_params;
+	po_ind_t	multi, proc_return;
+
+	snprintf(name, sizeof(name), "SC_scanQueryAndCountParams, %s", label);
+	BENCH_LOOP(timer, name, strlen(query),
+			   SC_scanQueryAndCountParams(query, conn, &next_cmd, &num_params, &multi, &proc_return));
+}
+
+/* A query of about size bytes, with a literal, a comment and a parameter per line */
+static char *
+make_query(size_t size, const char *literal)
+{
+	char	   *query = malloc(size + 256);
+	size_t		len;
+	int			i;
+
+	len = sprintf(query, "SELECT id, name FROM bench_tab WHERE id IN (?");
+	for (i = 0; len < size; i++)
+		len += sprintf(query + len, ",\n ? /* %d */, '%s', $$%d$$", i, literal, i);
+	strcpy(query + len, ")");
+	return query;
+}
+
+int main(int argc, char **argv)
+{
+	ConnectionClass *conn;
+	char	   *text, *query;
+
+	conn = CC_Constructor();
+	if (!conn)
+	{
+		fprintf(stderr, "CC_Constructor failed\n");
+		exit(1);
+	}
+	conn->ccsc = UTF8;
+	conn->mb_maxbyte_per_char = 4;
+	conn->escape_in_literal = '\\';
+
+	text = make_text(SHORT_SIZE, ascii_words, sizeof(ascii_words) / sizeof(ascii_words[0]), FALSE);
+	bench_text("short ASCII", text, UTF8);
+	free(text);
+	text = make_text(LARGE_SIZE, ascii_words, sizeof(ascii_words) / sizeof(ascii_words[0]), FALSE);
+	bench_text("large ASCII", text, UTF8);
+	free(text);
+	text = make_text(LARGE_SIZE, ascii_words, sizeof(ascii_words) / sizeof(ascii_words[0]), TRUE);
+	bench_text("large ASCII CR/LF", text, UTF8);
+	free(text);
+	text = make_text(SHORT_SIZE, mb_words, sizeof(mb_words) / sizeof(mb_words[0]), FALSE);
+	bench_text("short UTF-8", text, UTF8);
+	free(text);
+	text = make_text(LARGE_SIZE, mb_words, sizeof(mb_words) / sizeof(mb_words[0]), FALSE);
+	bench_text("large UTF-8", text, UTF8);
+	free(text);
+
+	bench_query(conn, "short", "SELECT id, name FROM bench_tab WHERE id = ?");
+	bench_query(conn, "batch", "INSERT INTO bench_tab VALUES (?, ?); UPDATE bench_tab SET name = ? WHERE id = ?; SELECT count(*) FROM bench_tab");
+	query = make_query(LARGE_SIZE, "it''s");
+	bench_query(conn, "large ASCII", query);
+	free(query);
+	query = make_query(LARGE_SIZE, "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e");
+	bench_query(conn, "large UTF-8", query);
+	free(query);
+
+	CC_Destructor(conn);
+
+	return 0;
+}
@@ -0,0 +1,398 @@
+/*
+ * Microbenchmark for the UTF-8 <-> UCS-2 conversions of win_unicode.c,
+ * which the Unicode driver applies to all the SQL_C_WCHAR data.
+ *
+ * The driver's routines are compared with the versions they replaced,
+ * which are kept here as the reference, on texts in a few scripts, and
+ * the results of both are checked to be identical.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "bench.h"
+#include "psqlodbc.h"
+
+#define	TEXT_SIZE	(256 * 1024)
+
+/*
+ * The previous implementations.
+ */
+#define	byte3check	0xfffff800
+#define	byte2_base	0x80c0
+#define	byte2_mask1	0x07c0
+#define	byte2_mask2	0x003f
+#define	byte3_base	0x8080e0
+#define	byte3_mask1	0xf000
+#define	byte3_mask2	0x0fc0
+#define	byte3_mask3	0x003f
+
+#define	surrog_check	0xfc00
+#define	surrog1_bits	0xd800
+#define	surrog2_bits	0xdc00
+#define	byte4_base	0x808080f0
+#define	byte4_sr1_mask1	0x0700
+#define	byte4_sr1_mask2	0x00fc
+#define	byte4_sr1_mask3	0x0003
+#define	byte4_sr2_mask1	0x03c0
+#define	byte4_sr2_mask2	0x003f
+#define	surrogate_adjust	(0x10000 >> 10)
+
+static int little_endian = -1;
+
+static SQLULEN
+old_ucs2strlen(const SQLWCHAR *ucs2str)
+{
+	SQLULEN	len;
+	for (len = 0; ucs2str[len]; len++)
+		;
+	return len;
+}
+
+static char *
+old_ucs2_to_utf8(const SQLWCHAR *ucs2str, SQLLEN ilen, SQLLEN *olen, BOOL lower_identifier)
+{
+	char *	utf8str;
+/*mylog("ucs2_to_utf8 %p ilen=%d ", ucs2str, ilen);*/
+
+	if (!ucs2str)
+	{
+		*olen = SQL_NULL_DATA;
+		return NULL;
+	}
+	if (little_endian < 0)
+	{
+		int	crt = 1;
+		little_endian = (0 != ((char *) &crt)[0]);
+	}
+	if (SQL_NTS == ilen)
+		ilen = old_ucs2strlen(ucs2str);
+/*mylog(" newlen=%d", ilen);*/
+	utf8str = (char *) malloc(ilen * 4 + 1);
+	if (utf8str)
+	{
+		int	i, len = 0;
+		UInt2	byte2code;
+		Int4	byte4code, surrd1, surrd2;
+		const SQLWCHAR	*wstr;
+
+		for (i = 0, wstr = ucs2str; i < ilen; i++, wstr++)
+		{
+			if (!*wstr)
+				break;
+			else if (0 == (*wstr & 0xffffff80)) /* ASCII */
+			{
+				if (lower_identifier)
+					utf8str[len++] = (char) tolower(*wstr);
+				else
+					utf8str[len++] = (char) *wstr;
+			}
+			else if ((*wstr & byte3check) == 0)
+			{
+				byte2code = byte2_base |
+					    ((byte2_mask1 & *wstr) >> 6) |
+					    ((byte2_mask2 & *wstr) << 8);
+				if (little_endian)
+					memcpy(utf8str + len, (char *) &byte2code, sizeof(byte2code));
+				else
+				{
+					utf8str[len] = ((char *) &byte2code)[1];
+					utf8str[len + 1] = ((char *) &byte2code)[0];
+				}
+				len += sizeof(byte2code); 
+			}
+			/* surrogate pair check for non ucs-2 code */ 
+			else if (surrog1_bits == (*wstr & surrog_check))
+			{
+				surrd1 = (*wstr & ~surrog_check) + surrogate_adjust;
+				wstr++;
+				i++;
+				surrd2 = (*wstr & ~surrog_check);
+				byte4code = byte4_base |
+					   ((byte4_sr1_mask1 & surrd1) >> 8) |
+					   ((byte4_sr1_mask2 & surrd1) << 6) |
+					   ((byte4_sr1_mask3 & surrd1) << 20) |
+					   ((byte4_sr2_mask1 & surrd2) << 10) |
+					   ((byte4_sr2_mask2 & surrd2) << 24);
+				if (little_endian)
+					memcpy(utf8str + len, (char *) &byte4code, sizeof(byte4code));
+				else
+				{
+					utf8str[len] = ((char *) &byte4code)[3];
+					utf8str[len + 1] = ((char *) &byte4code)[2];
+					utf8str[len + 2] = ((char *) &byte4code)[1];
+					utf8str[len + 3] = ((char *) &byte4code)[0];
+				}
+				len += sizeof(byte4code);
+			}
+			else
+			{
+				byte4code = byte3_base |
+					    ((byte3_mask1 & *wstr) >> 12) | 
+					    ((byte3_mask2 & *wstr) << 2) | 
+					    ((byte3_mask3 & *wstr) << 16);
+				if (little_endian)
+					memcpy(utf8str + len, (char *) &byte4code, 3);
+				else
+				{
+					utf8str[len] = ((char *) &byte4code)[3];
+					utf8str[len + 1] = ((char *) &byte4code)[2];
+					utf8str[len + 2] = ((char *) &byte4code)[1];
+				}
+				len += 3;
+			}
+		} 
+		utf8str[len] = '\0';
+		if (olen)
+			*olen = len;
+	}
+/*mylog(" olen=%d %s\n", *olen, utf8str ? utf8str : "");*/
+	return utf8str;
+}
+
+#define	byte3_m1	0x0f
+#define	byte3_m2	0x3f
+#define	byte3_m3	0x3f
+#define	byte2_m1	0x1f
+#define	byte2_m2	0x3f
+#define	byte4_m1	0x07
+#define	byte4_m2	0x3f
+#define	byte4_m31	0x30
+#define	byte4_m32	0x0f
+#define	byte4_m4	0x3f
+
+#define def_utf2ucs(errcheck) \
+static SQLULEN \
+old_utf8_to_ucs2_lf##errcheck(const char *utf8str, SQLLEN ilen, BOOL lfconv, SQLWCHAR *ucs2str, SQLULEN bufcount) \
+{ \
+	int	i; \
+	SQLULEN	rtn, ocount, wcode; \
+	const UCHAR *str; \
+\
+/*mylog("utf8_to_ucs2 ilen=%d bufcount=%d", ilen, bufcount);*/ \
+	if (!utf8str) \
+		return 0; \
+/*mylog(" string=%s\n", utf8str);*/ \
+	if (little_endian < 0) \
+	{ \
+		int	crt = 1; \
+		little_endian = (0 != ((char *) &crt)[0]); \
+	} \
+	if (!bufcount) \
+		ucs2str = NULL; \
+	else if (!ucs2str) \
+		bufcount = 0; \
+	if (ilen < 0) \
+		ilen = strlen(utf8str); \
+	for (i = 0, ocount = 0, str = utf8str; i < ilen && *str;) \
+	{ \
+		/* if (iswascii(*str)) */ \
+		if (isascii(*str)) \
+		{ \
+			if (lfconv && PG_LINEFEED == *str && \
+			    (i == 0 || PG_CARRIAGE_RETURN != str[-1])) \
+			{ \
+				if (ocount < bufcount) \
+					ucs2str[ocount] = PG_CARRIAGE_RETURN; \
+				ocount++; \
+			} \
+			if (ocount < bufcount) \
+				ucs2str[ocount] = *str; \
+			ocount++; \
+			i++; \
+			str++; \
+		} \
+		else if (0xf8 == (*str & 0xf8)) /* more than 5 byte code */ \
+		{ \
+			ocount = (SQLULEN) -1; \
+			goto cleanup; \
+		} \
+		else if (0xf0 == (*str & 0xf8)) /* 4 byte code */ \
+		{ \
+			if (01 == 0##errcheck) \
+			{ \
+				if (i + 4 > ilen || \
+				    0 == (str[1] & 0x80) || \
+				    0 == (str[2] & 0x80) || \
+				    0 == (str[3] & 0x80)) \
+				{ \
+					ocount = (SQLULEN) -1; \
+					goto cleanup; \
+				} \
+			} \
+			if (ocount < bufcount) \
+			{ \
+				wcode = (surrog1_bits | \
+					((((UInt4) *str) & byte4_m1) << 8) | \
+					((((UInt4) str[1]) & byte4_m2) << 2) | \
+					((((UInt4) str[2]) & byte4_m31) >> 4)) \
+					- surrogate_adjust; \
+				ucs2str[ocount] = (SQLWCHAR) wcode; \
+			} \
+			ocount++; \
+			if (ocount < bufcount) \
+			{ \
+				wcode = surrog2_bits | \
+					((((UInt4) str[2]) & byte4_m32) << 6) | \
+					(((UInt4) str[3]) & byte4_m4); \
+				ucs2str[ocount] = (SQLWCHAR) wcode; \
+			} \
+			ocount++; \
+			i += 4; \
+			str += 4; \
+		} \
+		else if (0xe0 == (*str & 0xf0)) /* 3 byte code */ \
+		{ \
+			if (01 == 0##errcheck) \
+			{ \
+				if (i + 3 > ilen || \
+				    0 == (str[1] & 0x80) || \
+				    0 == (str[2] & 0x80)) \
+				{ \
+					ocount = (SQLULEN) -1; \
+					goto cleanup; \
+				} \
+			} \
+			if (ocount < bufcount) \
+			{ \
+				wcode = ((((UInt4) *str) & byte3_m1) << 12) | \
+					((((UInt4) str[1]) & byte3_m2) << 6) | \
+				 	(((UInt4) str[2]) & byte3_m3); \
+				ucs2str[ocount] = (SQLWCHAR) wcode; \
+			} \
+			ocount++; \
+			i += 3; \
+			str += 3; \
+		} \
+		else if (0xc0 == (*str & 0xe0)) /* 2 byte code */ \
+		{ \
+			if (01 == 0##errcheck) \
+			{ \
+				if (i + 2 > ilen || \
+				    0 == (str[1] & 0x80)) \
+				{ \
+					ocount = (SQLULEN) -1; \
+					goto cleanup; \
+				} \
+			} \
+			if (ocount < bufcount) \
+			{ \
+				wcode = ((((UInt4) *str) & byte2_m1) << 6) | \
+				 	(((UInt4) str[1]) & byte2_m2); \
+				ucs2str[ocount] = (SQLWCHAR) wcode; \
+			} \
+			ocount++; \
+			i += 2; \
+			str += 2; \
+		} \
+		else \
+		{ \
+			ocount = (SQLULEN) -1; \
+			goto cleanup; \
+		} \
+	} \
+cleanup: \
+	rtn = ocount; \
+	if (ocount == (SQLULEN) -1) \
+	{ \
+		if (00 == 0##errcheck) \
+			rtn = 0; \
+		ocount = 0; \
+	} \
+	if (ocount < bufcount && ucs2str) \
+		ucs2str[ocount] = 0; \
+/*mylog(" ocount=%d\n", ocount);*/ \
+	return rtn; \
+}
+
+def_utf2ucs(0)
+
+/*
+ * Texts of about TEXT_SIZE bytes, made of repeated sample sentences.
+ */
+static const struct
+{
+	const char *name;
+	const char *sample;
+} samples[] =
+{
+	{"ascii", "The quick brown fox jumps over the lazy dog. 0123456789\n"},
+	{"latin", "Voix ambigu\xc3\xab d'un c\xc5\x93ur qui, au z\xc3\xa9phyr, pr\xc3\xa9" "f\xc3\xa8re les jattes de kiwis.\n"},
+	{"cyrillic", "\xd0\xa1\xd1\x8a\xd0\xb5\xd1\x88\xd1\x8c \xd0\xb6\xd0\xb5 \xd0\xb5\xd1\x89\xd1\x91 \xd1\x8d\xd1\x82\xd0\xb8\xd1\x85 id=42 \xd0\xb1\xd1\x83\xd0\xbb\xd0\xbe\xd0\xba.\n"},
+	{"cjk", "\xe6\x9d\xb1\xe4\xba\xac\xe9\x83\xbd 2024\xe5\xb9\xb4 \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88\n"},
+	{"emoji", "ok \xf0\x9f\x98\x80 status=done \xf0\x9f\x9a\x80\n"},
+	{NULL, NULL}
+};
+
+static char *
+make_text(const char *sample)
+{
+	char	   *text = malloc(TEXT_SIZE + 1);
+	size_t		len = strlen(sample), o;
+
+	for (o = 0; o + len <= TEXT_SIZE; o += len)
+		memcpy(text + o, sample, len);
+	text[o] = '\0';
+	return text;
+}
+
+static void
+check_same(const char *what, const void *a, size_t alen, const void *b, size_t blen)
+{
+	if (alen != blen || memcmp(a, b, alen) != 0)
+	{
+		fprintf(stderr, "%s: results differ\n", what);
+		exit(1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int			i;
+	char		name[64];
+	char	   *text, *utf8, *utf8_old;
+	SQLWCHAR   *wtext, *wtext_old;
+	SQLULEN		wlen, wlen_old;
+	SQLLEN		len, len_old;
+	BENCH_TIMER	timer;
+
+	wtext = malloc((2 * TEXT_SIZE + 1) * sizeof(SQLWCHAR));
+	wtext_old = malloc((2 * TEXT_SIZE + 1) * sizeof(SQLWCHAR));
+	for (i = 0; samples[i].name; i++)
+	{
+		text = make_text(samples[i].sample);
+
+		snprintf(name, sizeof(name), "utf8_to_ucs2 %s (old)", samples[i].name);
+		BENCH_LOOP(timer, name, strlen(text),
+				   wlen_old = old_utf8_to_ucs2_lf0(text, SQL_NTS, FALSE, wtext_old, 2 * TEXT_SIZE + 1));
+		snprintf(name, sizeof(name), "utf8_to_ucs2 %s", samples[i].name);
+		BENCH_LOOP(timer, name, strlen(text),
+				   wlen = utf8_to_ucs2_lf0(text, SQL_NTS, FALSE, wtext, 2 * TEXT_SIZE + 1));
+		check_same(name, wtext, wlen * sizeof(SQLWCHAR), wtext_old, wlen_old * sizeof(SQLWCHAR));
+
+		snprintf(name, sizeof(name), "utf8_to_ucs2_lf %s (old)", samples[i].name);
+		BENCH_LOOP(timer, name, strlen(text),
+				   wlen_old = old_utf8_to_ucs2_lf0(text, SQL_NTS, TRUE, wtext_old, 2 * TEXT_SIZE + 1));
+		snprintf(name, sizeof(name), "utf8_to_ucs2_lf %s", samples[i].name);
+		BENCH_LOOP(timer, name, strlen(text),
+				   wlen = utf8_to_ucs2_lf0(text, SQL_NTS, TRUE, wtext, 2 * TEXT_SIZE + 1));
+		check_same(name, wtext, wlen * sizeof(SQLWCHAR), wtext_old, wlen_old * sizeof(SQLWCHAR));
+
+		/* back again, from the text without linefeed conversion */
+		wlen = utf8_to_ucs2_lf0(text, SQL_NTS, FALSE, wtext, 2 * TEXT_SIZE + 1);
+		snprintf(name, sizeof(name), "ucs2_to_utf8 %s (old)", samples[i].name);
+		BENCH_LOOP(timer, name, strlen(text),
+				   utf8_old = old_ucs2_to_utf8(wtext, wlen, &len_old, FALSE); free(utf8_old));
+		snprintf(name, sizeof(name), "ucs2_to_utf8 %s", samples[i].name);
+		BENCH_LOOP(timer, name, strlen(text),
+				   utf8 = ucs2_to_utf8(wtext, wlen, &len, FALSE); free(utf8));
+		utf8 = ucs2_to_utf8(wtext, wlen, &len, FALSE);
+		check_same(name, utf8, len, text, strlen(text));
+		free(utf8);
+
+		free(text);
+	}
+
+	return 0;
+}
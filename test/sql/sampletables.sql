@@ -23,3 +23,5 @@ INSERT INTO booltab VALUES (2, 'yes', true);
 INSERT INTO booltab VALUES (3, 'true', true);
 INSERT INTO booltab VALUES (4, 'false', false);
 INSERT INTO booltab VALUES (5, 'not', false);
+-- The large object type that the driver looks for
+CREATE DOMAIN lo AS oid;
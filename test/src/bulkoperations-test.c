@@ -0,0 +1,112 @@
+/*
+ * SQLBulkOperations(SQL_ADD) tests.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+#define ROWSET_SIZE 10
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+	char *sql;
+	int i;
+
+	SQLINTEGER id_array[ROWSET_SIZE];
+	SQLLEN id_ind_array[ROWSET_SIZE];
+	SQLCHAR t_array[ROWSET_SIZE][20];
+	SQLLEN t_ind_array[ROWSET_SIZE];
+	SQLUSMALLINT status_array[ROWSET_SIZE];
+	SQLULEN nprocessed;
+
+	test_connect_ext("UpdatableCursors=1");
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	sql = "CREATE TEMPORARY TABLE bulktab (id int4, t text DEFAULT 'default')";
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed while creating temp table", hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Open an updatable keyset-driven cursor on the table */
+	rc = SQLSetStmtAttr(hstmt, SQL_ATTR_CONCURRENCY,
+						(SQLPOINTER) SQL_CONCUR_ROWVER, 0);
+	CHECK_STMT_RESULT(rc, "SQLSetStmtAttr failed", hstmt);
+	rc = SQLSetStmtAttr(hstmt, SQL_ATTR_CURSOR_TYPE,
+						(SQLPOINTER) SQL_CURSOR_KEYSET_DRIVEN, 0);
+	CHECK_STMT_RESULT(rc, "SQLSetStmtAttr failed", hstmt);
+	rc = SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE,
+						(SQLPOINTER) ROWSET_SIZE, 0);
+	CHECK_STMT_RESULT(rc, "SQLSetStmtAttr failed", hstmt);
+	rc = SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_STATUS_PTR, status_array, 0);
+	CHECK_STMT_RESULT(rc, "SQLSetStmtAttr failed", hstmt);
+	rc = SQLSetStmtAttr(hstmt, SQL_ATTR_ROWS_FETCHED_PTR, &nprocessed, 0);
+	CHECK_STMT_RESULT(rc, "SQLSetStmtAttr failed", hstmt);
+
+	sql = "SELECT id, t FROM bulktab";
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+
+	/*
+	 * Add a rowset of column-wise bound rows. The t column of every third
+	 * row is ignored, so the column default should be used for those.
+	 */
+	for (i = 0; i < ROWSET_SIZE; i++)
+	{
+		id_array[i] = i + 1;
+		id_ind_array[i] = 0;
+		sprintf(t_array[i], "bulk %d", i + 1);
+		t_ind_array[i] = (i % 3 == 2) ? SQL_COLUMN_IGNORE : SQL_NTS;
+	}
+	rc = SQLBindCol(hstmt, 1, SQL_C_LONG, id_array, 0, id_ind_array);
+	CHECK_STMT_RESULT(rc, "SQLBindCol failed", hstmt);
+	rc = SQLBindCol(hstmt, 2, SQL_C_CHAR, t_array, sizeof(t_array[0]), t_ind_array);
+	CHECK_STMT_RESULT(rc, "SQLBindCol failed", hstmt);
+
+	rc = SQLBulkOperations(hstmt, SQL_ADD);
+	CHECK_STMT_RESULT(rc, "SQLBulkOperations failed", hstmt);
+
+	printf("rows processed: %d\n", (int) nprocessed);
+	for (i = 0; i < ROWSET_SIZE; i++)
+	{
+		if (status_array[i] != SQL_ROW_ADDED)
+			printf("%d\tunexpected row status %d\n", i, status_array[i]);
+	}
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	rc = SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFreeHandle failed", hstmt);
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	/* Check that all the rows were inserted */
+	sql = "SELECT id, t FROM bulktab ORDER BY id";
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_result(hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
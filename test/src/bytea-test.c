@@ -0,0 +1,141 @@
+/*
+ * Tests for fetching bytea values in pieces with SQLGetData.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "common.h"
+
+/* fetch column 1 of the current row in pieces, and print each piece */
+static void
+print_pieces(HSTMT hstmt, SQLSMALLINT ctype, int bufsize)
+{
+	SQLRETURN	rc;
+	char		buf[100];
+	SQLLEN		ind;
+	int			i, got;
+
+	while ((rc = SQLGetData(hstmt, 1, ctype, buf, bufsize, &ind)) != SQL_NO_DATA)
+	{
+		CHECK_STMT_RESULT(rc, "SQLGetData failed", hstmt);
+		printf("ind %d: ", (int) ind);
+		if (ctype == SQL_C_BINARY)
+		{
+			got = (ind > bufsize) ? bufsize : (int) ind;
+			for (i = 0; i < got; i++)
+				printf("%02X", (unsigned char) buf[i]);
+			printf("\n");
+		}
+		else
+			printf("%s\n", buf);
+	}
+}
+
+/* fetch column 1 of the current row in pieces, and check the result */
+static void
+check_big_value(HSTMT hstmt, SQLSMALLINT ctype, int bufsize)
+{
+	SQLRETURN	rc;
+	char		buf[1000];
+	SQLLEN		ind;
+	int			i, got;
+	long		total = 0;
+	int			mismatch = 0;
+	/* the value is 0x00FF repeated */
+	const char *pattern = (ctype == SQL_C_BINARY) ? "\000\377" : "00FF";
+	int			patlen = (ctype == SQL_C_BINARY) ? 2 : 4;
+
+	while ((rc = SQLGetData(hstmt, 1, ctype, buf, bufsize, &ind)) != SQL_NO_DATA)
+	{
+		CHECK_STMT_RESULT(rc, "SQLGetData failed", hstmt);
+		if (ctype == SQL_C_BINARY)
+			got = (ind > bufsize) ? bufsize : (int) ind;
+		else
+			got = strlen(buf);
+		for (i = 0; i < got; i++)
+		{
+			if (toupper((unsigned char) buf[i]) != (unsigned char) pattern[(total + i) % patlen])
+				mismatch++;
+		}
+		total += got;
+	}
+	printf("total %ld, mismatched %d\n", total, mismatch);
+}
+
+static void
+run_tests(HSTMT hstmt)
+{
+	SQLRETURN	rc;
+
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT t FROM byteatab WHERE id = 1", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFetch(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFetch failed", hstmt);
+	printf("SQL_C_BINARY in pieces of 3 bytes\n");
+	print_pieces(hstmt, SQL_C_BINARY, 3);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT t FROM byteatab WHERE id = 1", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFetch(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFetch failed", hstmt);
+	/* 3 hex digits at a time, so that pieces end in the middle of bytes */
+	printf("SQL_C_CHAR in pieces of 3 digits\n");
+	print_pieces(hstmt, SQL_C_CHAR, 4);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT decode(repeat('00ff', 50000), 'hex')", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFetch(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFetch failed", hstmt);
+	printf("big value as SQL_C_BINARY\n");
+	check_big_value(hstmt, SQL_C_BINARY, 999);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT decode(repeat('00ff', 50000), 'hex')", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFetch(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFetch failed", hstmt);
+	printf("big value as SQL_C_CHAR\n");
+	check_big_value(hstmt, SQL_C_CHAR, 999);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+
+	test_connect();
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	printf("bytea_output = hex\n");
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SET bytea_output = hex", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	run_tests(hstmt);
+
+	printf("bytea_output = escape\n");
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SET bytea_output = escape", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	run_tests(hstmt);
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
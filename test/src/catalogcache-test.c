@@ -0,0 +1,93 @@
+/*
+ * Tests for the catalog result cache (CatalogCacheTTL), which must be
+ * dropped when a DDL statement is executed.  A change the driver doesn't
+ * see as DDL is not noticed until then, which shows that the cached
+ * result is really used.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+static void
+print_columns(HSTMT hstmt, const char *table)
+{
+	SQLRETURN rc;
+	char colname[64], typname[64];
+	SQLLEN ind;
+
+	rc = SQLColumns(hstmt, NULL, 0, NULL, 0,
+					(SQLCHAR *) table, SQL_NTS, (SQLCHAR *) "%", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLColumns failed", hstmt);
+
+	printf("columns of %s:\n", table);
+	while (SQL_SUCCEEDED(rc = SQLFetch(hstmt)))
+	{
+		rc = SQLGetData(hstmt, 4, SQL_C_CHAR, colname, sizeof(colname), &ind);
+		CHECK_STMT_RESULT(rc, "SQLGetData failed", hstmt);
+		rc = SQLGetData(hstmt, 6, SQL_C_CHAR, typname, sizeof(typname), &ind);
+		CHECK_STMT_RESULT(rc, "SQLGetData failed", hstmt);
+		printf("%s\t%s\n", colname, typname);
+	}
+	if (rc != SQL_NO_DATA)
+	{
+		print_diag("SQLFetch failed", SQL_HANDLE_STMT, hstmt);
+		exit(1);
+	}
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+static void
+exec_sql(HSTMT hstmt, char *sql)
+{
+	SQLRETURN rc;
+
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+
+	test_connect_ext("CatalogCacheTTL=60");
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	exec_sql(hstmt, "CREATE TEMPORARY TABLE cachetab (id int4)");
+
+	/* The second call is served from the cache */
+	print_columns(hstmt, "cachetab");
+	print_columns(hstmt, "cachetab");
+
+	/*
+	 * The column added by a DO block isn't seen, because the statement
+	 * isn't recognized as DDL and the cached result is returned.
+	 */
+	exec_sql(hstmt, "DO $$ BEGIN EXECUTE 'ALTER TABLE cachetab ADD COLUMN x int4'; END $$");
+	print_columns(hstmt, "cachetab");
+
+	/* ALTER TABLE drops the cached result */
+	exec_sql(hstmt, "ALTER TABLE cachetab ADD COLUMN t text");
+	print_columns(hstmt, "cachetab");
+
+	/* So does DROP TABLE */
+	exec_sql(hstmt, "DROP TABLE cachetab");
+	exec_sql(hstmt, "CREATE TEMPORARY TABLE cachetab (b bool)");
+	print_columns(hstmt, "cachetab");
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
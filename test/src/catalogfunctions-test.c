@@ -0,0 +1,72 @@
+/*
+ * Tests for the catalog functions, which are run as prepared statements
+ * with UseServerSidePrepare=1.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+static void
+print_columns(HSTMT hstmt, const char *table)
+{
+	SQLRETURN rc;
+	char colname[64], typname[64];
+	SQLLEN ind;
+
+	rc = SQLColumns(hstmt, NULL, 0, (SQLCHAR *) "public", SQL_NTS,
+					(SQLCHAR *) table, SQL_NTS, (SQLCHAR *) "%", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLColumns failed", hstmt);
+
+	printf("columns of %s:\n", table);
+	while (SQL_SUCCEEDED(rc = SQLFetch(hstmt)))
+	{
+		rc = SQLGetData(hstmt, 4, SQL_C_CHAR, colname, sizeof(colname), &ind);
+		CHECK_STMT_RESULT(rc, "SQLGetData failed", hstmt);
+		rc = SQLGetData(hstmt, 6, SQL_C_CHAR, typname, sizeof(typname), &ind);
+		CHECK_STMT_RESULT(rc, "SQLGetData failed", hstmt);
+		printf("%s\t%s\n", colname, typname);
+	}
+	if (rc != SQL_NO_DATA)
+	{
+		print_diag("SQLFetch failed", SQL_HANDLE_STMT, hstmt);
+		exit(1);
+	}
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+
+	test_connect_ext("UseServerSidePrepare=1");
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	/* The second and third calls reuse the prepared query */
+	print_columns(hstmt, "testtab1");
+	print_columns(hstmt, "booltab");
+	print_columns(hstmt, "testtab1");
+
+	/* The prepared query is lost, it should be prepared again */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "DEALLOCATE ALL", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	print_columns(hstmt, "booltab");
+	print_columns(hstmt, "byteatab");
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Large object tests. The object is written and read back in chunks much
+ * smaller than the driver's buffer, and bigger in total.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+#define LO_SIZE		300000
+#define PUT_CHUNK	1000
+#define GET_CHUNK	7000
+
+static char
+lo_byte(int i)
+{
+	return (char) ((i * 7 + i / 256) % 256);
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+	char *sql;
+	char buf[GET_CHUNK];
+	SQLLEN cbParam;
+	SQLLEN ind;
+	PTR paramid;
+	int total, i, mismatch;
+
+	test_connect();
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	sql = "CREATE TEMPORARY TABLE lotab (id int4, data lo)";
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed while creating temp table", hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Write the large object with data-at-execution */
+	rc = SQLPrepare(hstmt, (SQLCHAR *) "INSERT INTO lotab VALUES (1, ?)", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLPrepare failed", hstmt);
+
+	cbParam = SQL_DATA_AT_EXEC;
+	rc = SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT,
+						  SQL_C_BINARY,	/* value type */
+						  SQL_LONGVARBINARY, /* param type */
+						  LO_SIZE,		/* column size */
+						  0,			/* dec digits */
+						  (VOID *) 1,	/* param value ptr */
+						  0,			/* buffer len */
+						  &cbParam		/* StrLen_or_IndPtr */);
+	CHECK_STMT_RESULT(rc, "SQLBindParameter failed", hstmt);
+
+	rc = SQLExecute(hstmt);
+	if (rc != SQL_NEED_DATA)
+		CHECK_STMT_RESULT(rc, "SQLExecute failed", hstmt);
+
+	while ((rc = SQLParamData(hstmt, &paramid)) == SQL_NEED_DATA)
+	{
+		for (total = 0; total < LO_SIZE; total += PUT_CHUNK)
+		{
+			for (i = 0; i < PUT_CHUNK; i++)
+				buf[i] = lo_byte(total + i);
+			rc = SQLPutData(hstmt, buf, PUT_CHUNK);
+			CHECK_STMT_RESULT(rc, "SQLPutData failed", hstmt);
+		}
+	}
+	CHECK_STMT_RESULT(rc, "SQLParamData failed", hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Read it back in pieces */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT data FROM lotab WHERE id = 1", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+
+	rc = SQLFetch(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFetch failed", hstmt);
+
+	total = 0;
+	mismatch = 0;
+	while ((rc = SQLGetData(hstmt, 1, SQL_C_BINARY, buf, sizeof(buf), &ind)) != SQL_NO_DATA)
+	{
+		int		got;
+
+		CHECK_STMT_RESULT(rc, "SQLGetData failed", hstmt);
+		if (ind == SQL_NO_TOTAL || ind > (SQLLEN) sizeof(buf))
+			got = sizeof(buf);
+		else
+			got = (int) ind;
+		for (i = 0; i < got; i++)
+		{
+			if (buf[i] != lo_byte(total + i))
+				mismatch++;
+		}
+		total += got;
+	}
+
+	printf("total bytes read: %d\n", total);
+	printf("mismatched bytes: %d\n", mismatch);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Tests for reading the results of a multi-statement batch one at a time
+ * on SQLMoreResults (LazyMoreResults), which applies in manual-commit
+ * mode only.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+/* Print all the results of the batch executed on hstmt */
+static void
+print_all_results(HSTMT hstmt)
+{
+	SQLRETURN rc;
+	char sqlstate[32];
+	char message[1000];
+	SQLINTEGER nativeerror;
+	SQLSMALLINT textlen;
+
+	do
+	{
+		print_result(hstmt);
+		rc = SQLMoreResults(hstmt);
+		if (rc == SQL_ERROR)
+		{
+			/* the message text depends on the server version */
+			SQLGetDiagRec(SQL_HANDLE_STMT, hstmt, 1, sqlstate, &nativeerror,
+						  message, sizeof(message), &textlen);
+			printf("SQLMoreResults failed with %s\n", sqlstate);
+			rc = SQLMoreResults(hstmt);
+		}
+	} while (SQL_SUCCEEDED(rc));
+	if (rc != SQL_NO_DATA)
+	{
+		print_diag("SQLMoreResults failed", SQL_HANDLE_STMT, hstmt);
+		exit(1);
+	}
+}
+
+static void
+rollback(void)
+{
+	SQLRETURN rc;
+
+	rc = SQLEndTran(SQL_HANDLE_DBC, conn, SQL_ROLLBACK);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("SQLEndTran failed", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+	HSTMT hstmt2 = SQL_NULL_HSTMT;
+
+	test_connect_ext("LazyMoreResults=1");
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+	rc = SQLAllocStmt(conn, &hstmt2);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+	rc = SQLSetConnectAttr(conn, SQL_ATTR_AUTOCOMMIT,
+						   (SQLPOINTER) SQL_AUTOCOMMIT_OFF, SQL_IS_UINTEGER);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("SQLSetConnectAttr failed", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	/* Each result is read when SQLMoreResults asks for it */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 1 AS a; SELECT 'foo' AS b; SELECT 3 AS c", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_all_results(hstmt);
+
+	/* An error is reported by the SQLMoreResults call reaching it */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 1 AS a; SELECT 1/0; SELECT 3 AS c", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_all_results(hstmt);
+	rollback();
+
+	/*
+	 * Another statement using the connection reads the rest of the batch
+	 * first, the results stay available to SQLMoreResults.
+	 */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 1 AS a; SELECT 2 AS b", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLExecDirect(hstmt2, (SQLCHAR *) "SELECT 'other' AS o", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt2);
+	print_result(hstmt2);
+	rc = SQLFreeStmt(hstmt2, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt2);
+	print_all_results(hstmt);
+
+	/* Closing the statement throws away the unread results */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 1 AS a; SELECT 2 AS b", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 'after' AS x", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_all_results(hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/*
+	 * An error among them isn't reported, but it leaves the transaction
+	 * aborted.
+	 */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 1 AS a; SELECT 1/0", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 'aborted' AS x", SQL_NTS);
+	if (rc == SQL_ERROR)
+	{
+		char sqlstate[32];
+		char message[1000];
+		SQLINTEGER nativeerror;
+		SQLSMALLINT textlen;
+
+		SQLGetDiagRec(SQL_HANDLE_STMT, hstmt, 1, sqlstate, &nativeerror,
+					  message, sizeof(message), &textlen);
+		printf("SQLExecDirect failed with %s\n", sqlstate);
+	}
+	else
+		print_all_results(hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	rollback();
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * Tests for SQL_ATTR_MAX_ROWS.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+static void
+run_query(const char *connparams)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+	SQLINTEGER param = 100;
+	SQLLEN cbParam = 0;
+
+	test_connect_ext((char *) connparams);
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	rc = SQLSetStmtAttr(hstmt, SQL_ATTR_MAX_ROWS, (SQLPOINTER) 3, 0);
+	CHECK_STMT_RESULT(rc, "SQLSetStmtAttr failed", hstmt);
+
+	/* Only the first three rows should be returned */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT g FROM generate_series(1, 1000) g", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_result(hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* The same with a parameter */
+	rc = SQLPrepare(hstmt, (SQLCHAR *) "SELECT g FROM generate_series(1, ?) g", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLPrepare failed", hstmt);
+	rc = SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_LONG, SQL_INTEGER,
+						  0, 0, &param, 0, &cbParam);
+	CHECK_STMT_RESULT(rc, "SQLBindParameter failed", hstmt);
+	rc = SQLExecute(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLExecute failed", hstmt);
+	print_result(hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* The statement can be executed again */
+	rc = SQLExecute(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLExecute failed", hstmt);
+	print_result(hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	test_disconnect();
+}
+
+int main(int argc, char **argv)
+{
+	run_query("");
+	run_query("UseServerSidePrepare=1");
+	run_query("UseDeclareFetch=1;Fetch=2");
+
+	return 0;
+}
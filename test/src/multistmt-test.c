@@ -0,0 +1,183 @@
+/*
+ * Tests for the multi-statement queries with parameters and
+ * UseServerSidePrepare=1.  Each command is sent as Parse, Bind, Describe
+ * and Execute requests, and all of them are followed by one Sync.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+static HSTMT hstmt = SQL_NULL_HSTMT;
+
+/* Print all the results of the batch executed on hstmt */
+static void
+print_all_results(void)
+{
+	SQLRETURN rc;
+	SQLSMALLINT numcols;
+	char sqlstate[32];
+	char message[1000];
+	SQLINTEGER nativeerror;
+	SQLSMALLINT textlen;
+
+	do
+	{
+		rc = SQLNumResultCols(hstmt, &numcols);
+		CHECK_STMT_RESULT(rc, "SQLNumResultCols failed", hstmt);
+		if (numcols > 0)
+			print_result(hstmt);
+		else
+			printf("No result set\n");
+		rc = SQLMoreResults(hstmt);
+		if (rc == SQL_ERROR)
+		{
+			/* the message text depends on the server version */
+			SQLGetDiagRec(SQL_HANDLE_STMT, hstmt, 1, sqlstate, &nativeerror,
+						  message, sizeof(message), &textlen);
+			printf("SQLMoreResults failed with %s\n", sqlstate);
+			rc = SQLMoreResults(hstmt);
+		}
+	} while (SQL_SUCCEEDED(rc));
+	if (rc != SQL_NO_DATA)
+	{
+		print_diag("SQLMoreResults failed", SQL_HANDLE_STMT, hstmt);
+		exit(1);
+	}
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+static void
+bind_int(SQLUSMALLINT ipar, SQLINTEGER *value)
+{
+	SQLRETURN rc;
+
+	rc = SQLBindParameter(hstmt, ipar, SQL_PARAM_INPUT,
+						  SQL_C_LONG, SQL_INTEGER, 0, 0,
+						  value, 0, NULL);
+	CHECK_STMT_RESULT(rc, "SQLBindParameter failed", hstmt);
+}
+
+static void
+bind_text(SQLUSMALLINT ipar, char *value)
+{
+	SQLRETURN rc;
+	static SQLLEN nts = SQL_NTS;
+
+	rc = SQLBindParameter(hstmt, ipar, SQL_PARAM_INPUT,
+						  SQL_C_CHAR, SQL_VARCHAR, 20, 0,
+						  value, 0, &nts);
+	CHECK_STMT_RESULT(rc, "SQLBindParameter failed", hstmt);
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	SQLINTEGER id, num, zero;
+	char text1[20], text2[20];
+	unsigned char bytes[] = { 0x01, 0x00, 0xff };
+	SQLLEN byteslen = sizeof(bytes);
+
+	test_connect_ext("UseServerSidePrepare=1");
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "CREATE TEMPORARY TABLE multistmt_tab (id int4, t text)", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* The parameters of each command are bound to it */
+	id = 1;
+	strcpy(text1, "foo");
+	strcpy(text2, "bar");
+	bind_int(1, &id);
+	bind_text(2, text1);
+	bind_text(3, text2);
+	bind_int(4, &id);
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "INSERT INTO multistmt_tab VALUES (?, ?); UPDATE multistmt_tab SET t = t || ? WHERE id = ?; SELECT id, t FROM multistmt_tab", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_all_results();
+	rc = SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* A prepared batch executed again with other values */
+	rc = SQLPrepare(hstmt, (SQLCHAR *) "SELECT ? AS a; SELECT ?::text AS b", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLPrepare failed", hstmt);
+	num = 10;
+	strcpy(text1, "x");
+	bind_int(1, &num);
+	bind_text(2, text1);
+	rc = SQLExecute(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLExecute failed", hstmt);
+	print_all_results();
+	num = 20;
+	strcpy(text1, "y");
+	rc = SQLExecute(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLExecute failed", hstmt);
+	print_all_results();
+	rc = SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* A bytea parameter in the second command */
+	rc = SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT,
+						  SQL_C_BINARY, SQL_VARBINARY, sizeof(bytes), 0,
+						  bytes, sizeof(bytes), &byteslen);
+	CHECK_STMT_RESULT(rc, "SQLBindParameter failed", hstmt);
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 'first' AS a; SELECT length(?::bytea) AS len", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_all_results();
+	rc = SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/*
+	 * An error rolls back the whole batch and is reported by SQLExecDirect,
+	 * as with the simple protocol.
+	 */
+	num = 1;
+	zero = 0;
+	bind_int(1, &num);
+	bind_int(2, &zero);
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT ? AS a; SELECT 1 / ?; SELECT 3 AS c", SQL_NTS);
+	if (rc != SQL_ERROR)
+	{
+		printf("SQLExecDirect didn't fail\n");
+		exit(1);
+	}
+	{
+		char sqlstate[32];
+		char message[1000];
+		SQLINTEGER nativeerror;
+		SQLSMALLINT textlen;
+
+		/* the message text depends on the server version */
+		SQLGetDiagRec(SQL_HANDLE_STMT, hstmt, 1, sqlstate, &nativeerror,
+					  message, sizeof(message), &textlen);
+		printf("SQLExecDirect failed with %s\n", sqlstate);
+	}
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* The commands of comments only are skipped */
+	num = 5;
+	bind_int(1, &num);
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT ? AS a; /* nothing; here */ ; -- nor here\n; SELECT 'last' AS b", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_all_results();
+	rc = SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
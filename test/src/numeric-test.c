@@ -0,0 +1,125 @@
+/*
+ * Tests for the SQL_C_NUMERIC conversions, both for parameters and
+ * for the result columns.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+static void
+build_numeric(SQL_NUMERIC_STRUCT *ns, unsigned long long val, int sign,
+			  int precision, int scale)
+{
+	int i;
+
+	memset(ns, 0, sizeof(*ns));
+	ns->precision = precision;
+	ns->scale = scale;
+	ns->sign = sign;
+	for (i = 0; i < sizeof(val); i++)
+	{
+		ns->val[i] = (SQLCHAR) (val & 0xff);
+		val >>= 8;
+	}
+}
+
+static void
+print_numeric(const SQL_NUMERIC_STRUCT *ns)
+{
+	int i;
+
+	printf("sign=%d precision=%d scale=%d val=", ns->sign, ns->precision, ns->scale);
+	for (i = 0; i < SQL_MAX_NUMERIC_LEN; i++)
+		printf("%02x", ns->val[i]);
+	printf("\n");
+}
+
+static void
+test_numeric_param(HSTMT hstmt, unsigned long long val, int sign,
+				   int precision, int scale)
+{
+	SQLRETURN rc;
+	SQL_NUMERIC_STRUCT ns;
+	SQLLEN ind = sizeof(ns);
+
+	build_numeric(&ns, val, sign, precision, scale);
+	rc = SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_NUMERIC,
+						  SQL_NUMERIC, precision, scale, &ns, sizeof(ns), &ind);
+	CHECK_STMT_RESULT(rc, "SQLBindParameter failed", hstmt);
+	rc = SQLExecute(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLExecute failed", hstmt);
+	print_result(hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+static void
+test_numeric_result(HSTMT hstmt, const char *value)
+{
+	SQLRETURN rc;
+	SQL_NUMERIC_STRUCT ns;
+	SQLLEN ind;
+	char sql[200];
+	char sqlstate[32];
+	char message[1000];
+	SQLINTEGER nativeerror;
+	SQLSMALLINT textlen;
+
+	snprintf(sql, sizeof(sql), "SELECT '%s'::numeric", value);
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLFetch(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFetch failed", hstmt);
+	rc = SQLGetData(hstmt, 1, SQL_C_NUMERIC, &ns, sizeof(ns), &ind);
+	if (SQL_SUCCEEDED(rc))
+		print_numeric(&ns);
+	else
+	{
+		SQLGetDiagRec(SQL_HANDLE_STMT, hstmt, 1, sqlstate, &nativeerror,
+					  message, sizeof(message), &textlen);
+		printf("SQLGetData failed with %s\n", sqlstate);
+	}
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+
+	test_connect_ext("UseServerSidePrepare=1");
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	/* Parameters, sent in the binary format when the server allows */
+	rc = SQLPrepare(hstmt, (SQLCHAR *) "SELECT ?::numeric::text", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLPrepare failed", hstmt);
+	test_numeric_param(hstmt, 25212, 1, 5, 3);
+	test_numeric_param(hstmt, 7, 0, 1, 0);
+	test_numeric_param(hstmt, 5, 1, 3, 2);
+	test_numeric_param(hstmt, 0, 1, 5, 2);
+	test_numeric_param(hstmt, 12345, 1, 5, -3);
+	test_numeric_param(hstmt, 1234567890123456789ULL, 0, 19, 4);
+
+	/* Result columns */
+	test_numeric_result(hstmt, "-1234.5678");
+	test_numeric_result(hstmt, "0.000001");
+	test_numeric_result(hstmt, "340282366920938463463374607431768211455");
+	/* the fraction digits which don't fit are dropped */
+	test_numeric_result(hstmt, "3402823669209384634633746074317682114.5678");
+	/* too large */
+	test_numeric_result(hstmt, "340282366920938463463374607431768211456");
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
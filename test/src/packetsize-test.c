@@ -0,0 +1,114 @@
+/*
+ * Tests for SQL_ATTR_PACKET_SIZE and the growth of the socket buffer.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+	SQLCHAR str[1024];
+	SQLSMALLINT strl;
+	SQLUINTEGER packetsize;
+	SQLLEN len, ind;
+	char buf[200000];
+	char sqlstate[32];
+	char message[1000];
+	SQLINTEGER nativeerror;
+	SQLSMALLINT textlen;
+	int rows;
+
+	SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &env);
+	SQLSetEnvAttr(env, SQL_ATTR_ODBC_VERSION, (void *) SQL_OV_ODBC3, 0);
+	SQLAllocHandle(SQL_HANDLE_DBC, env, &conn);
+
+	/* The packet size can only be set before connecting */
+	rc = SQLSetConnectAttr(conn, SQL_ATTR_PACKET_SIZE, (SQLPOINTER) 1024, 0);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("SQLSetConnectAttr failed", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+	rc = SQLDriverConnect(conn, NULL, "DSN=psqlodbc_test_dsn;MaxSocketBuffer=65536", SQL_NTS,
+						  str, sizeof(str), &strl,
+						  SQL_DRIVER_COMPLETE);
+	if (SQL_SUCCEEDED(rc))
+		printf("connected\n");
+	else
+	{
+		print_diag("SQLDriverConnect failed.", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	rc = SQLGetConnectAttr(conn, SQL_ATTR_PACKET_SIZE, &packetsize, 0, NULL);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("SQLGetConnectAttr failed", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+	printf("packet size: %u\n", (unsigned int) packetsize);
+
+	rc = SQLSetConnectAttr(conn, SQL_ATTR_PACKET_SIZE, (SQLPOINTER) 8192, 0);
+	if (SQL_SUCCEEDED(rc))
+	{
+		printf("SQL_ATTR_PACKET_SIZE was changed after connecting\n");
+		exit(1);
+	}
+	rc = SQLGetDiagRec(SQL_HANDLE_DBC, conn, 1, sqlstate, &nativeerror,
+					   message, sizeof(message), &textlen);
+	if (SQL_SUCCEEDED(rc))
+		printf("SQLSetConnectAttr failed with %s\n", sqlstate);
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	/* A value much larger than the packet size */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT repeat('x', 150000)", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	rc = SQLBindCol(hstmt, 1, SQL_C_CHAR, buf, sizeof(buf), &ind);
+	CHECK_STMT_RESULT(rc, "SQLBindCol failed", hstmt);
+	rc = SQLFetch(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFetch failed", hstmt);
+	len = ind;
+	printf("fetched a value of length %d\n", (int) len);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_UNBIND);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Many small rows */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT g, 'foo' || g FROM generate_series(1, 20000) g", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	for (rows = 0; SQL_SUCCEEDED(rc = SQLFetch(hstmt)); rows++)
+		;
+	if (rc != SQL_NO_DATA)
+	{
+		print_diag("SQLFetch failed", SQL_HANDLE_STMT, hstmt);
+		exit(1);
+	}
+	printf("fetched %d rows\n", rows);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* The buffer has shrunk again, a small query still works */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 'still connected'", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_result(hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
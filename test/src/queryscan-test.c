@@ -0,0 +1,100 @@
+/*
+ * Tests for the scanning of the queries: the parameter markers, and the
+ * statement delimiters, in the quoted stuff and the comments are not
+ * taken as such.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+static HSTMT hstmt = SQL_NULL_HSTMT;
+
+/* Prepare the query, and show the number of its parameters */
+static void
+prepare_query(const char *query)
+{
+	SQLRETURN rc;
+	SQLSMALLINT nparams;
+
+	rc = SQLPrepare(hstmt, (SQLCHAR *) query, SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLPrepare failed", hstmt);
+	rc = SQLNumParams(hstmt, &nparams);
+	CHECK_STMT_RESULT(rc, "SQLNumParams failed", hstmt);
+	printf("%d parameters\n", nparams);
+}
+
+/* Execute the prepared query with the parameters 1, 2, ... and show all the results */
+static void
+execute_query(int nparams)
+{
+	SQLRETURN rc;
+	static SQLINTEGER params[10];
+	static SQLLEN ind[10];
+	int i;
+
+	for (i = 0; i < nparams; i++)
+	{
+		params[i] = i + 1;
+		ind[i] = 0;
+		rc = SQLBindParameter(hstmt, i + 1, SQL_PARAM_INPUT,
+							  SQL_C_LONG, SQL_INTEGER, 0, 0,
+							  &params[i], 0, &ind[i]);
+		CHECK_STMT_RESULT(rc, "SQLBindParameter failed", hstmt);
+	}
+	rc = SQLExecute(hstmt);
+	CHECK_STMT_RESULT(rc, "SQLExecute failed", hstmt);
+	do
+	{
+		print_result(hstmt);
+		rc = SQLMoreResults(hstmt);
+	} while (SQL_SUCCEEDED(rc));
+	if (rc != SQL_NO_DATA)
+	{
+		print_diag("SQLMoreResults failed", SQL_HANDLE_STMT, hstmt);
+		exit(1);
+	}
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_RESET_PARAMS);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+
+	test_connect();
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	/* Literals and comments */
+	prepare_query("SELECT '?;' AS a, ? AS b /* ?; */ -- ?;\n");
+	execute_query(1);
+
+	/* Dollar quotes and quoted identifiers */
+	prepare_query("SELECT $x$?;$x$ AS a, \"?;\" FROM (SELECT 2 AS \"?;\") s WHERE 1 = ?");
+	execute_query(1);
+
+	/* An escaped quote in an escape string */
+	prepare_query("SELECT E'\\'?;' AS a, ? AS b");
+	execute_query(1);
+
+	/* Nested comments */
+	prepare_query("SELECT 1 /* nested /* ?; */ ?; */ AS a");
+	execute_query(0);
+
+	/* Multiple statements */
+	prepare_query("SELECT ? AS a, '?;' AS b; SELECT ? AS c -- ?;");
+	execute_query(2);
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Tests for SQL_ATTR_QUERY_TIMEOUT.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+	char sqlstate[32];
+	char message[1000];
+	SQLINTEGER nativeerror;
+	SQLSMALLINT textlen;
+
+	test_connect();
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	rc = SQLSetStmtAttr(hstmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER) 1, 0);
+	CHECK_STMT_RESULT(rc, "SQLSetStmtAttr failed", hstmt);
+
+	/* This should be cancelled after a second */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT pg_sleep(30)", SQL_NTS);
+	if (SQL_SUCCEEDED(rc))
+	{
+		printf("pg_sleep wasn't cancelled\n");
+		exit(1);
+	}
+	rc = SQLGetDiagRec(SQL_HANDLE_STMT, hstmt, 1, sqlstate, &nativeerror,
+					   message, sizeof(message), &textlen);
+	if (SQL_SUCCEEDED(rc))
+		printf("SQLExecDirect failed with %s\n", sqlstate);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* A query within the timeout succeeds on the same connection */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT 'still connected'", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_result(hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
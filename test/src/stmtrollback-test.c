@@ -0,0 +1,112 @@
+/*
+ * Tests for statement level rollback. A failing statement in a transaction
+ * must not abort the statements before or after it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+static void
+insert_direct(HSTMT hstmt, int id)
+{
+	SQLRETURN rc;
+	char sql[100];
+
+	snprintf(sql, sizeof(sql), "INSERT INTO rbtab VALUES (%d)", id);
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	if (SQL_SUCCEEDED(rc))
+		printf("inserted %d\n", id);
+	else
+		printf("failed to insert %d\n", id);
+	SQLFreeStmt(hstmt, SQL_CLOSE);
+}
+
+static void
+insert_prepared(HSTMT hstmt, SQLINTEGER *param, int id)
+{
+	SQLRETURN rc;
+
+	*param = id;
+	rc = SQLExecute(hstmt);
+	if (SQL_SUCCEEDED(rc))
+		printf("inserted %d\n", id);
+	else
+		printf("failed to insert %d\n", id);
+	SQLFreeStmt(hstmt, SQL_CLOSE);
+}
+
+int main(int argc, char **argv)
+{
+	SQLRETURN rc;
+	HSTMT hstmt = SQL_NULL_HSTMT;
+	SQLINTEGER param;
+	SQLLEN cbParam = 0;
+
+	test_connect_ext("UseServerSidePrepare=1");
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	rc = SQLSetConnectAttr(conn, SQL_ATTR_AUTOCOMMIT,
+						   (SQLPOINTER) SQL_AUTOCOMMIT_OFF, SQL_IS_UINTEGER);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("SQLSetConnectAttr failed", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "CREATE TEMPORARY TABLE rbtab (id int4 PRIMARY KEY) ON COMMIT PRESERVE ROWS", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed while creating temp table", hstmt);
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* The second insert fails on the primary key */
+	insert_direct(hstmt, 1);
+	insert_direct(hstmt, 1);
+	insert_direct(hstmt, 2);
+
+	/* The same with a prepared statement */
+	rc = SQLPrepare(hstmt, (SQLCHAR *) "INSERT INTO rbtab VALUES (?)", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLPrepare failed", hstmt);
+	rc = SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_LONG, SQL_INTEGER,
+						  0, 0, &param, 0, &cbParam);
+	CHECK_STMT_RESULT(rc, "SQLBindParameter failed", hstmt);
+	insert_prepared(hstmt, &param, 3);
+	insert_prepared(hstmt, &param, 3);
+	insert_prepared(hstmt, &param, 4);
+
+	rc = SQLEndTran(SQL_HANDLE_DBC, conn, SQL_COMMIT);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("SQLEndTran failed", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	rc = SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+	CHECK_STMT_RESULT(rc, "SQLFreeHandle failed", hstmt);
+
+	rc = SQLAllocStmt(conn, &hstmt);
+	if (!SQL_SUCCEEDED(rc))
+	{
+		print_diag("failed to allocate stmt handle", SQL_HANDLE_DBC, conn);
+		exit(1);
+	}
+
+	/* Check that all the successful inserts were committed */
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) "SELECT id FROM rbtab ORDER BY id", SQL_NTS);
+	CHECK_STMT_RESULT(rc, "SQLExecDirect failed", hstmt);
+	print_result(hstmt);
+
+	rc = SQLFreeStmt(hstmt, SQL_CLOSE);
+	CHECK_STMT_RESULT(rc, "SQLFreeStmt failed", hstmt);
+
+	/* Clean up */
+	test_disconnect();
+
+	return 0;
+}
@@ -10,6 +10,9 @@
 #include "psqlodbc.h"
 #include <stdlib.h>
 #include <string.h>
+#ifdef	USE_SSE2
+#include <emmintrin.h>
+#endif /* USE_SSE2 */
 
 #define	byte3check	0xfffff800
 #define	byte2_base	0x80c0
@@ -46,6 +49,62 @@ int	iswascii(wchar_t c)
 
 static int little_endian = -1;
 
+#ifdef	USE_SSE2
+/*
+ *	ASCII fast paths, looking at 16 bytes at a time.  They are used only
+ *	if SQLWCHAR is 2 bytes long, and convert the leading characters of
+ *	the block which need nothing more than widening or narrowing.
+ *	The whole block may be stored, the caller must have room for it.
+ */
+
+/* the number of the trailing zero bits of a nonzero mask */
+static int
+mask_trailing_zeros(unsigned int mask)
+{
+#ifdef	__GNUC__
+	return __builtin_ctz(mask);
+#else
+	int	n;
+
+	for (n = 0; 0 == (mask & 1); n++)
+		mask >>= 1;
+	return n;
+#endif /* __GNUC__ */
+}
+
+/* A null, a non-ASCII character or (if lfconv) a linefeed stops it. */
+static int
+ascii_to_ucs2_sse2(const UCHAR *str, BOOL lfconv, SQLWCHAR *ucs2str)
+{
+	__m128i	v = _mm_loadu_si128((const __m128i *) str);
+	__m128i	zero = _mm_setzero_si128();
+	__m128i	special = _mm_cmpeq_epi8(v, zero);
+
+	if (lfconv)
+		special = _mm_or_si128(special, _mm_cmpeq_epi8(v, _mm_set1_epi8(PG_LINEFEED)));
+	if (ucs2str)
+	{
+		_mm_storeu_si128((__m128i *) ucs2str, _mm_unpacklo_epi8(v, zero));
+		_mm_storeu_si128((__m128i *) (ucs2str + 8), _mm_unpackhi_epi8(v, zero));
+	}
+	return mask_trailing_zeros(_mm_movemask_epi8(v) | _mm_movemask_epi8(special) | 0x10000);
+}
+
+/* A null or a non-ASCII character stops it; looks at 8 characters. */
+static int
+ucs2_to_ascii_sse2(const SQLWCHAR *wstr, char *str)
+{
+	__m128i	v = _mm_loadu_si128((const __m128i *) wstr);
+	__m128i	zero = _mm_setzero_si128();
+	int	plain;
+
+	plain = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short) 0xff80)), zero)) &
+		~_mm_movemask_epi8(_mm_cmpeq_epi16(v, zero));
+	_mm_storel_epi64((__m128i *) str, _mm_packus_epi16(v, v));
+	return mask_trailing_zeros((~plain & 0xffff) | 0x10000) / 2;
+}
+#endif /* USE_SSE2 */
+
 SQLULEN	ucs2strlen(const SQLWCHAR *ucs2str)
 {
 	SQLULEN	len;
@@ -75,6 +134,9 @@ char *ucs2_to_utf8(const SQLWCHAR *ucs2str, SQLLEN ilen, SQLLEN *olen, BOOL lowe
 	if (utf8str)
 	{
 		int	i, len = 0;
+#ifdef	USE_SSE2
+		int	n;
+#endif /* USE_SSE2 */
 		UInt2	byte2code;
 		Int4	byte4code, surrd1, surrd2;
 		const SQLWCHAR	*wstr;
@@ -85,6 +147,19 @@ char *ucs2_to_utf8(const SQLWCHAR *ucs2str, SQLLEN ilen, SQLLEN *olen, BOOL lowe
 				break;
 			else if (0 == (*wstr & 0xffffff80)) /* ASCII */
 			{
+#ifdef	USE_SSE2
+				if (!lower_identifier &&
+				    2 == sizeof(SQLWCHAR) &&
+				    i + 8 <= ilen &&
+				    (n = ucs2_to_ascii_sse2(wstr, utf8str + len)) > 1)
+				{
+					/* the loop steps over the last one */
+					i += n - 1;
+					wstr += n - 1;
+					len += n;
+					continue;
+				}
+#endif /* USE_SSE2 */
 				if (lower_identifier)
 					utf8str[len++] = (char) tolower(*wstr);
 				else
@@ -164,10 +239,20 @@ char *ucs2_to_utf8(const SQLWCHAR *ucs2str, SQLLEN ilen, SQLLEN *olen, BOOL lowe
 #define	byte4_m32	0x0f
 #define	byte4_m4	0x3f
 
+#ifdef	USE_SSE2
+#define	ASCII_BLOCK_TO_UCS2(str, i, ilen, lfconv, ucs2str, ocount, bufcount) \
+	((2 == sizeof(SQLWCHAR) && \
+	  i + 16 <= ilen && \
+	  (NULL == ucs2str || ocount + 16 <= bufcount)) ? \
+	 ascii_to_ucs2_sse2(str, lfconv, NULL == ucs2str ? NULL : ucs2str + ocount) : 0)
+#else
+#define	ASCII_BLOCK_TO_UCS2(str, i, ilen, lfconv, ucs2str, ocount, bufcount) 0
+#endif /* USE_SSE2 */
+
 #define def_utf2ucs(errcheck) \
 SQLULEN	utf8_to_ucs2_lf##errcheck(const char *utf8str, SQLLEN ilen, BOOL lfconv, SQLWCHAR *ucs2str, SQLULEN bufcount) \
 { \
-	int	i; \
+	int	i, n; \
 	SQLULEN	rtn, ocount, wcode; \
 	const UCHAR *str; \
 \
@@ -191,6 +276,13 @@ SQLULEN	utf8_to_ucs2_lf##errcheck(const char *utf8str, SQLLEN ilen, BOOL lfconv,
 		/* if (iswascii(*str)) */ \
 		if (isascii(*str)) \
 		{ \
+			if ((n = ASCII_BLOCK_TO_UCS2(str, i, ilen, lfconv, ucs2str, ocount, bufcount)) > 1) \
+			{ \
+				ocount += n; \
+				i += n; \
+				str += n; \
+				continue; \
+			} \
 			if (lfconv && PG_LINEFEED == *str && \
 			    (i == 0 || PG_CARRIAGE_RETURN != str[-1])) \
 			{ \